@@ -18,26 +18,37 @@ __OppServe = false
 
 __OPPSIDE = opponent(__SIDE)
 
+-- before each step, the C++ side writes the state of the match into the table __WORLD,
+-- already corrected for our side. the functions below read it from there instead of 
+-- calling into the c api for every value.
+
+-- these do not depend on the side, so we can answer them from __WORLD for every caller
+function is_ball_valid()
+	return __WORLD.ball_valid
+end
+
+function is_game_running()
+	return __WORLD.game_running
+end
+
+function get_serving_player()
+	return __WORLD.serving_player
+end
+
 -- legacy functions
 -- these function definitions make lua functions for the old api functions, which are sometimes more conveniente to use 
 -- than their c api equivalent.
 
 function posx()
-	local x, y = get_blob_pos( __SIDE )
-	if __SIDE == RIGHT_PLAYER then
-		return CONST_FIELD_WIDTH - x
-	else
-		return x
-	end
+	return __WORLD.blob_x
 end
 
 function posy()
-	local x, y = get_blob_pos( __SIDE )
-	return y
+	return __WORLD.blob_y
 end
 
 function touches()
-	return get_touches( __SIDE )
+	return __WORLD.touches
 end
 
 -- redefine the ball coordinate functions to use the cached values
@@ -57,16 +68,10 @@ function bspeedy()
 	return __bvy
 end
 
--- we need to save balldata somewhere to use it in here
-__balldata__ = balldata
--- this is the internal function that does the side correction
+-- this is the internal function that returns the exact, side corrected ball data
 function __balldata()
-	local x, y, vx, vy = __balldata__()
-	if __SIDE == RIGHT_PLAYER then
-		x = CONST_FIELD_WIDTH - x
-		vx = -vx
-	end
-	return x, y, vx, vy
+	local w = __WORLD
+	return w.ball_x, w.ball_y, w.ball_vx, w.ball_vy
 end
 
 -- this is the function to be used by bots, which includes the difficulty changes
@@ -75,9 +80,8 @@ function balldata()
 end
 
 -- redefine launched to refer to the __SIDE player
-__launched = launched
 function launched()
-	return __launched( __SIDE )
+	return __WORLD.blob_y > CONST_BLOBBY_GROUND_HEIGHT
 end
 
 function left()
@@ -113,25 +117,19 @@ function moveto(target)
 end
 
 function oppx()
-	local x, y = get_blob_pos( __OPPSIDE )
-	if __SIDE == RIGHT_PLAYER then
-		return CONST_FIELD_WIDTH - x
-	else
-		return x
-	end
+	return __WORLD.opp_x
 end
 
 function oppy()
-	local x, y = get_blob_pos( __OPPSIDE )
-	return y
+	return __WORLD.opp_y
 end
 
 function getScore()
-	return get_score( __SIDE )
+	return __WORLD.score
 end
 
 function getOppScore()
-	return get_score( __OPPSIDE )
+	return __WORLD.opp_score
 end
 
 -----------------------------------------------------------------------------------------
@@ -28,69 +28,91 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* implementation */
 
-// Blood class
-// ------------
-
-Blood::Blood(const Vector2& position, const Vector2& direction, int player):
-	mPos(position),
-	mDir(direction),
-	mPlayer(player),
-	mLastFrame(SDL_GetTicks())
+BloodManager::BloodManager(bool enabled, int capacity) :
+	mPositionX(capacity),
+	mPositionY(capacity),
+	mVelocityX(capacity),
+	mVelocityY(capacity),
+	mPlayer(capacity),
+	mCount(0),
+	mLastFrame(0),
+	mEnabled(enabled),
+	mRandomState(2463534242u)
 {
 }
 
-void Blood::step(RenderManager& renderer)
-{
-	const float GRAVITY = 3;
-	/// \todo this is the only place where we do step-rate independent calculations.
-	///			is this intended behaviour???
-	int diff = SDL_GetTicks() - mLastFrame;
-	renderer.drawParticle(mPos, mPlayer);
-	const int SPEED = 45;
-	
-	//this calculation is NOT based on physical rules
-	mDir.y += GRAVITY / SPEED * diff;
-	mPos.x += mDir.x / SPEED * diff;
-	mPos.y += mDir.y / SPEED * diff;
-	mLastFrame = SDL_GetTicks();
-}
-
-// BloodManager class
-// -------------------
-
-
-BloodManager::BloodManager(bool enabled) : mEnabled(enabled)
+void BloodManager::step(RenderManager& renderer)
 {
+	step(renderer, SDL_GetTicks());
 }
 
-void BloodManager::step(RenderManager& renderer)
+void BloodManager::step(RenderManager& renderer, unsigned int time)
 {
 	// don't do any processing if there are no particles
-	if ( !mEnabled || mParticles.empty() )
+	if ( !mEnabled || mCount == 0 )
+	{
+		mLastFrame = time;
 		return;
-	
-	// start drawing
-	renderer.startDrawParticles();
-	
-	// iterate over all particles
-	for(auto& pt : mParticles) {
-		pt.step(renderer);
 	}
 	
-	// finish drawing
-	renderer.endDrawParticles();
+	// draw all particles at once
+	renderer.drawParticles(mPositionX.data(), mPositionY.data(), mPlayer.data(), mCount);
 
-	// delete old particles
-	mParticles.erase(std::remove_if(begin(mParticles), end(mParticles), [](const Blood& particle) {
-		return particle.getPosition().y > 600;
-	}), mParticles.end());
+	/// \todo this is the only place where we do step-rate independent calculations.
+	///			is this intended behaviour???
+	//this calculation is NOT based on physical rules
+	const float GRAVITY = 3;
+	const float SPEED = 45;
+	const float delta = float(int(time - mLastFrame)) / SPEED;
+	mLastFrame = time;
+
+	float* positionX = mPositionX.data();
+	float* positionY = mPositionY.data();
+	float* velocityX = mVelocityX.data();
+	float* velocityY = mVelocityY.data();
+	const int count = mCount;
+
+	for (int i = 0; i < count; ++i)
+	{
+		velocityY[i] += GRAVITY * delta;
+		positionX[i] += velocityX[i] * delta;
+		positionY[i] += velocityY[i] * delta;
+	}
+
+	// delete old particles by moving the last ones into their places
+	for (int i = 0; i < mCount; )
+	{
+		if (positionY[i] > 600)
+		{
+			--mCount;
+			positionX[i] = positionX[mCount];
+			positionY[i] = positionY[mCount];
+			velocityX[i] = velocityX[mCount];
+			velocityY[i] = velocityY[mCount];
+			mPlayer[i] = mPlayer[mCount];
+		}
+		else
+		{
+			++i;
+		}
+	}
 }
 
 void BloodManager::spillBlood(Vector2 pos, float intensity, int player)
 {
+	spillBlood(pos, intensity, player, SDL_GetTicks());
+}
+
+void BloodManager::spillBlood(Vector2 pos, float intensity, int player, unsigned int time)
+{
+	// particles start moving when they are spilled
+	if (mCount == 0)
+		mLastFrame = time;
+
 	const double EL_X_AXIS = 30;
 	const double EL_Y_AXIS = 50;
-	for (int c = 0; c <= int(intensity*50); c++)
+	const int capacity = mPlayer.size();
+	for (int c = 0; c <= int(intensity*50) && mCount < capacity; c++)
 	{
 		/// \todo maybe we can find a better algorithm, but for now,
 		///		we just discard particles outside the ellipses
@@ -101,12 +123,20 @@ void BloodManager::spillBlood(Vector2 pos, float intensity, int player)
 		if( ( y * y / (EL_Y_AXIS * EL_Y_AXIS) + x * x / (EL_X_AXIS * EL_X_AXIS) ) > intensity * intensity)
 			continue;
 		
-		mParticles.emplace_back(pos, Vector2(x, y), player );
+		mPositionX[mCount] = pos.x;
+		mPositionY[mCount] = pos.y;
+		mVelocityX[mCount] = x;
+		mVelocityY[mCount] = y;
+		mPlayer[mCount] = player;
+		++mCount;
 	}
 }
 
 int BloodManager::random(int min, int max)
 {
-	std::uniform_int_distribution<int> dist(min, max);
-	return dist(mRng);
+	// xorshift32, good enough for blood drops and much cheaper than a distribution per call
+	mRandomState ^= mRandomState << 13;
+	mRandomState ^= mRandomState >> 17;
+	mRandomState ^= mRandomState << 5;
+	return min + int(mRandomState % std::uint32_t(max - min + 1));
 }
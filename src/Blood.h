@@ -21,72 +21,69 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include "Vector.h"
+#include <cstdint>
 #include <vector>
-#include <random>
 
 //Bleeding blobs can be a lot of fun :)
 
 class RenderManager;
 
-/*!	\class Blood
-	\brief Container to hold the data of a single drop of blood
-*/
-class Blood
-{
-	public:
-		/// \brief constructor, takes position, direction and player
-		/// \param position Position this drop starts at
-		/// \param direction initial velocity of the drop
-		///	\param player Player this blood drop started from.
-		Blood(const Vector2& position, const Vector2& direction, int player);
-		
-		/// this function has to be called each step
-		/// it updates position and velocity.
-		void step(RenderManager& renderer);
-		
-		/// gets the current position of this drop
-		const Vector2& getPosition() const { return mPos; }
-		
-	private:
-		Vector2 mPos;	///< the drops position
-		Vector2 mDir;	///< the drops current velocity
-		int mPlayer;	///< player who spilled this blood drop
-		int mLastFrame;	///< time this drop was updated for the last time
-};
+/// number of blood particles that can exist at once, if config.xml doesn't say otherwise
+const int DEFAULT_BLOOD_PARTICLES = 4096;
+/// upper limit for the blood_particles setting, the pool is allocated up front
+const int MAX_BLOOD_PARTICLES = 65536;
 
 /*!	\class BloodManager
 	\brief Manages blood effects
 	\details this class is responsible for managing blood effects, creating and deleting the particles, 
 			updating their positions etc.
+			The particles live in a pool of fixed size, one array per attribute, so moving all of them
+			is a plain loop over floats which the compiler can vectorize. When the pool is full, new
+			drops are left out.
 */
 class BloodManager
 {
 	public:
-		explicit BloodManager(bool enabled);
+		explicit BloodManager(bool enabled, int capacity = DEFAULT_BLOOD_PARTICLES);
 
 		/// update function, to be called each step.
 		void step(RenderManager& renderer);
+		/// update function for callers that don't run in real time, e.g. when rendering replays
+		/// offline. \p time is in ms, on the same clock as the one passed to spillBlood.
+		void step(RenderManager& renderer, unsigned int time);
 		
 		/// \brief creates a blood effect
 		/// \param pos Position the effect occurs
 		/// \param intensity intensity of the hit. determines the number of particles
 		/// \param player player which was hit, determines the colour of the particles
 		void spillBlood(Vector2 pos, float intensity, int player);
+		void spillBlood(Vector2 pos, float intensity, int player, unsigned int time);
 		
 		/// enables or disables blood effects
 		void enable(bool enable) { mEnabled = enable; }
 
+		/// number of drops currently flying
+		int getParticleCount() const { return mCount; }
+
 	private:
 		/// helper function which returns an integer between 
 		/// min and max, boundaries included
 		int random(int min, int max);
 		
-		/// list which contains all currently existing blood particles
-		std::vector<Blood> mParticles;
+		/// particle attributes, the first mCount entries are in use
+		std::vector<float> mPositionX;
+		std::vector<float> mPositionY;
+		std::vector<float> mVelocityX;
+		std::vector<float> mVelocityY;
+		std::vector<unsigned char> mPlayer;
+		int mCount;
+
+		/// time the particles were updated for the last time
+		unsigned int mLastFrame;
 		
 		/// true, if blood should be handled/drawn
 		bool mEnabled;
 
-		/// Random number generator
-		std::mt19937 mRng;
+		/// state of the xorshift random number generator
+		std::uint32_t mRandomState;
 };
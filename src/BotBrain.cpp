@@ -0,0 +1,361 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "BotBrain.h"
+
+/* includes */
+#include <cmath>
+#include <limits>
+#include <map>
+
+#include "DuelMatch.h"
+
+/* implementation */
+
+namespace
+{
+	const double PI = 3.14159265358979323846;
+	const double INF = std::numeric_limits<double>::infinity();
+
+	std::map<std::string, BotBrain::Factory>& getRegistry()
+	{
+		static std::map<std::string, BotBrain::Factory> registry;
+		return registry;
+	}
+}
+
+void BotBrain::registerBrain(const std::string& name, Factory factory)
+{
+	getRegistry()[name] = std::move(factory);
+}
+
+std::unique_ptr<BotBrain> BotBrain::create(const std::string& name)
+{
+	auto found = getRegistry().find(name);
+	if (found == getRegistry().end())
+		return nullptr;
+	return found->second();
+}
+
+bool BotBrain::isRegistered(const std::string& name)
+{
+	return getRegistry().count(name) != 0;
+}
+
+std::vector<std::string> BotBrain::getNames()
+{
+	std::vector<std::string> names;
+	for (const auto& entry : getRegistry())
+		names.push_back(entry.first);
+	return names;
+}
+
+BotBrain::BotBrain() = default;
+
+BotBrain::~BotBrain() = default;
+
+void BotBrain::step(const DuelMatch& match, PlayerSide side, double difficulty, std::default_random_engine& random)
+{
+	mMatch = &match;
+	mSide = side;
+	mRandom = &random;
+
+	mWantLeft = false;
+	mWantRight = false;
+	mWantJump = false;
+
+	Ball exact = toBotCoordinates(match.getBallPosition(), match.getBallVelocity());
+	if (mSide == RIGHT_PLAYER)
+	{
+		exact.x = CONST_FIELD_WIDTH - exact.x;
+		exact.vx = -exact.vx;
+	}
+	mBall = exact;
+	// add some random noise to the ball info, if we have difficulty enabled
+	if (difficulty > 0)
+	{
+		mBall.x += mError.x * difficulty;
+		mBall.y += mError.y * difficulty;
+		mBall.vx += mError.vx * difficulty;
+		mBall.vy += mError.vy * difficulty;
+	}
+
+	if (mFirstStep)
+	{
+		mLastBallSpeed = exact.vx;
+		mFirstStep = false;
+	}
+
+	// if the x velocity of the ball changed, it bounced: renew the errors and tell the bot
+	if (mLastBallSpeed != exact.vx && isBallValid())
+	{
+		mLastBallSpeed = exact.vx;
+
+		double radius = this->random();
+		radius = (radius + this->random()) * CONST_BALL_RADIUS;
+		double angle = 2 * PI * this->random();
+		mError.x = std::sin(angle) * radius;
+		mError.y = std::cos(angle) * radius;
+		radius = this->random() * 1.5;
+		angle = 2 * PI * this->random();
+		mError.vx = std::sin(angle) * radius;
+		mError.vy = std::cos(angle) * radius;
+
+		onBounce();
+	}
+
+	if (!isGameRunning())
+	{
+		// if no player is serving player, the ball is on the left
+		PlayerSide server = match.getServingPlayer();
+		if (server == NO_PLAYER)
+			server = LEFT_PLAYER;
+
+		if (server == mSide)
+			onServe(isBallValid());
+		else
+			onOpponentServe();
+	}
+	else
+	{
+		onGame();
+	}
+}
+
+void BotBrain::onOpponentServe()
+{
+}
+
+void BotBrain::onBounce()
+{
+}
+
+double BotBrain::posx() const
+{
+	double x = mMatch->getBlobPosition(mSide).x;
+	return mSide == RIGHT_PLAYER ? CONST_FIELD_WIDTH - x : x;
+}
+
+double BotBrain::posy() const
+{
+	return 600 - mMatch->getBlobPosition(mSide).y;
+}
+
+double BotBrain::oppx() const
+{
+	double x = mMatch->getBlobPosition(mSide == LEFT_PLAYER ? RIGHT_PLAYER : LEFT_PLAYER).x;
+	return mSide == RIGHT_PLAYER ? CONST_FIELD_WIDTH - x : x;
+}
+
+double BotBrain::oppy() const
+{
+	return 600 - mMatch->getBlobPosition(mSide == LEFT_PLAYER ? RIGHT_PLAYER : LEFT_PLAYER).y;
+}
+
+int BotBrain::touches() const
+{
+	return mMatch->getTouches(mSide);
+}
+
+bool BotBrain::launched() const
+{
+	return posy() > CONST_BLOBBY_GROUND_HEIGHT;
+}
+
+bool BotBrain::isBallValid() const
+{
+	return !mMatch->getBallDown();
+}
+
+bool BotBrain::isGameRunning() const
+{
+	return mMatch->getBallActive();
+}
+
+int BotBrain::getScore() const
+{
+	return mMatch->getScore(mSide);
+}
+
+int BotBrain::getOppScore() const
+{
+	return mMatch->getScore(mSide == LEFT_PLAYER ? RIGHT_PLAYER : LEFT_PLAYER);
+}
+
+void BotBrain::left()
+{
+	mWantLeft = mSide == LEFT_PLAYER;
+	mWantRight = mSide != LEFT_PLAYER;
+}
+
+void BotBrain::right()
+{
+	mWantLeft = mSide != LEFT_PLAYER;
+	mWantRight = mSide == LEFT_PLAYER;
+}
+
+void BotBrain::jump()
+{
+	mWantJump = true;
+}
+
+bool BotBrain::moveto(double target)
+{
+	double x = posx();
+	if (x < target - CONST_BLOBBY_SPEED / 2)
+	{
+		right();
+		return false;
+	}
+	else if (x > target + CONST_BLOBBY_SPEED / 2)
+	{
+		left();
+		return false;
+	}
+
+	mWantLeft = false;
+	mWantRight = false;
+	return true;
+}
+
+BotBrain::Ball BotBrain::simulate(int steps, const Ball& start)
+{
+	mDummyWorld.setBallPosition( Vector2(start.x, 600 - start.y) );
+	mDummyWorld.setBallVelocity( Vector2(start.vx, -start.vy) );
+	for(int i = 0; i < steps; ++i)
+	{
+		// set ball valid to false to ignore blobby bounces
+		mDummyWorld.step(PlayerInput(), PlayerInput(), false, true);
+	}
+
+	return toBotCoordinates(mDummyWorld.getBallPosition(), mDummyWorld.getBallVelocity());
+}
+
+int BotBrain::simulateUntil(Ball& ball, bool xAxis, double coordinate)
+{
+	// same precision as simulate_until of the lua api
+	const float target = coordinate;
+	const float initial = xAxis ? ball.x : ball.y;
+	const bool below = initial < target;
+
+	mDummyWorld.setBallPosition( Vector2(ball.x, 600 - ball.y) );
+	mDummyWorld.setBallVelocity( Vector2(ball.vx, -ball.vy) );
+
+	int steps = 0;
+	while(target != initial && steps < 75 * 5)
+	{
+		steps++;
+		// set ball valid to false to ignore blobby bounces
+		mDummyWorld.step(PlayerInput(), PlayerInput(), false, true);
+		auto pos = mDummyWorld.getBallPosition();
+		float value = xAxis ? pos.x : 600 - pos.y;
+		if( (value < target) != below )
+			break;
+	}
+
+	ball = toBotCoordinates(mDummyWorld.getBallPosition(), mDummyWorld.getBallVelocity());
+	// indicate failure
+	return steps == 75 * 5 ? -1 : steps;
+}
+
+BotBrain::Ball BotBrain::estimateAtY(double height, double* time)
+{
+	// early out: the ball never reaches this height
+	if (ballTimeToY(height) == INF)
+	{
+		if (time)
+			*time = INF;
+		return Ball{INF, INF, INF, INF};
+	}
+
+	Ball result = mBall;
+	double steps = simulateUntil(result, false, height);
+
+	// we want the ball on its way down
+	if (result.vy > 0)
+	{
+		double skipped = steps + 1;
+		result = simulate(1, result);
+		steps = simulateUntil(result, false, height) + skipped;
+	}
+
+	if (time)
+		*time = steps;
+	return result;
+}
+
+double BotBrain::ballTimeToX(double x) const
+{
+	return linearTimeFirst(mBall.x, mBall.vx, x);
+}
+
+double BotBrain::ballTimeToY(double y) const
+{
+	// this ignores net bounces
+	return parabolaTimeFirst(mBall.y, mBall.vy, CONST_BALL_GRAVITY, y);
+}
+
+double BotBrain::blobTimeToX(double x) const
+{
+	return std::abs(posx() - x) / CONST_BLOBBY_SPEED;
+}
+
+double BotBrain::parabolaTimeFirst(double pos, double vel, double grav, double destination)
+{
+	double sq = vel * vel + 2 * grav * (destination - pos);
+	if (sq < 0)
+		return INF;
+
+	sq = std::sqrt(sq);
+	double tmin = (-vel - sq) / grav;
+	double tmax = (-vel + sq) / grav;
+	if (grav < 0)
+		std::swap(tmin, tmax);
+
+	if (tmin > 0)
+		return tmin;
+	else if (tmax > 0)
+		return tmax;
+	return INF;
+}
+
+double BotBrain::linearTimeFirst(double pos, double vel, double destination)
+{
+	if (vel == 0)
+		return INF;
+	double result = (destination - pos) / vel;
+	return result < 0 ? INF : result;
+}
+
+double BotBrain::random()
+{
+	return std::uniform_real_distribution<double>(0, 1)(*mRandom);
+}
+
+int BotBrain::random(int low, int high)
+{
+	return std::uniform_int_distribution<int>(low, high)(*mRandom);
+}
+
+BotBrain::Ball BotBrain::toBotCoordinates(const Vector2& position, const Vector2& velocity)
+{
+	return Ball{position.x, 600 - position.y, velocity.x, -velocity.y};
+}
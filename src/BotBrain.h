@@ -0,0 +1,182 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/**
+ * @file BotBrain.h
+ * @brief Contains the interface of bots written in C++
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Global.h"
+#include "GameConstants.h"
+#include "PhysicWorld.h"
+
+class DuelMatch;
+
+// the constants of the lua bot api (see api.lua), in bot coordinates
+const double CONST_FIELD_WIDTH = RIGHT_PLANE;
+const double CONST_FIELD_MIDDLE = CONST_FIELD_WIDTH / 2;
+const double CONST_GROUND_HEIGHT = 600 - GROUND_PLANE_HEIGHT_MAX;
+const double CONST_BALL_RADIUS = BALL_RADIUS;
+const double CONST_BALL_GRAVITY = -BALL_GRAVITATION;
+const double CONST_BLOBBY_HEIGHT = BLOBBY_HEIGHT;
+const double CONST_BLOBBY_JUMP = BLOBBY_JUMP_ACCELERATION;
+const double CONST_BLOBBY_GRAVITY = -GRAVITATION;
+const double CONST_BLOBBY_SPEED = BLOBBY_SPEED;
+const double CONST_NET_HEIGHT = 600 - NET_SPHERE_POSITION;
+const double CONST_NET_RADIUS = NET_RADIUS;
+const double CONST_BLOBBY_GROUND_HEIGHT = CONST_GROUND_HEIGHT + CONST_BLOBBY_HEIGHT / 2;
+const double CONST_BALL_LEFT_NET = CONST_FIELD_MIDDLE - CONST_BALL_RADIUS - CONST_NET_RADIUS;
+const double CONST_BALL_RIGHT_NET = CONST_FIELD_MIDDLE + CONST_BALL_RADIUS + CONST_NET_RADIUS;
+const double CONST_BALL_BLOBBY_HEAD = CONST_GROUND_HEIGHT + CONST_BLOBBY_HEIGHT + CONST_BALL_RADIUS;
+const double CONST_BLOBBY_MAX_JUMP = CONST_BLOBBY_GROUND_HEIGHT - CONST_BLOBBY_JUMP * CONST_BLOBBY_JUMP / CONST_BLOBBY_GRAVITY;
+
+/// \class BotBrain
+/// \brief Base class of bots written in C++
+/// \details The native counterpart of a lua bot script. The protected functions provide
+/// what bot_api.lua provides to the scripts: all coordinates are seen from the left side,
+/// the ball data contains the errors of the difficulty, and the callbacks are called in
+/// the same situations as OnServe, OnOpponentServe, OnGame and OnBounce.
+/// Bots are registered by name with a static Registration object and played by
+/// NativeInputSource.
+class BotBrain
+{
+	public:
+		/// ball state in bot coordinates, y points upwards
+		struct Ball
+		{
+			double x, y, vx, vy;
+		};
+
+		typedef std::function<std::unique_ptr<BotBrain>()> Factory;
+
+		/// registers a bot under \p name
+		static void registerBrain(const std::string& name, Factory factory);
+		/// creates the bot registered under \p name, or returns nullptr if there is none
+		static std::unique_ptr<BotBrain> create(const std::string& name);
+		static bool isRegistered(const std::string& name);
+		/// sorted names of all registered bots
+		static std::vector<std::string> getNames();
+
+		/// registers the bot class \p T when constructed, for use as static object
+		template<class T>
+		struct Registration
+		{
+			explicit Registration(const std::string& name)
+			{
+				registerBrain(name, []() { return std::unique_ptr<BotBrain>(new T()); });
+			}
+		};
+
+		virtual ~BotBrain();
+
+		/// \brief decides on the input for the current step, like __OnStep does for scripts
+		/// \param difficulty how much the ball data is distorted, from 0 to 1
+		/// \param random random generator of the controlling input source
+		void step(const DuelMatch& match, PlayerSide side, double difficulty, std::default_random_engine& random);
+
+		// the decision of the last step, as absolute directions
+		bool wantsLeft() const { return mWantLeft; }
+		bool wantsRight() const { return mWantRight; }
+		bool wantsJump() const { return mWantJump; }
+
+	protected:
+		BotBrain();
+
+		// callbacks
+		virtual void onServe(bool ballReady) = 0;
+		virtual void onOpponentServe();
+		virtual void onGame() = 0;
+		virtual void onBounce();
+
+		// information about the match
+		const Ball& ball() const { return mBall; }
+		double ballx() const { return mBall.x; }
+		double bally() const { return mBall.y; }
+		double bspeedx() const { return mBall.vx; }
+		double bspeedy() const { return mBall.vy; }
+		double posx() const;
+		double posy() const;
+		double oppx() const;
+		double oppy() const;
+		int touches() const;
+		bool launched() const;
+		bool isBallValid() const;
+		bool isGameRunning() const;
+		int getScore() const;
+		int getOppScore() const;
+
+		// movement
+		void left();
+		void right();
+		void jump();
+		/// moves towards \p target, returns true once the blob stands there
+		bool moveto(double target);
+
+		// ball prediction, ignoring the blobs
+		Ball simulate(int steps, const Ball& start);
+		/// advances \p ball until it crosses \p coordinate on the x or y axis and returns the
+		/// number of steps, or -1 if it did not happen within five seconds
+		int simulateUntil(Ball& ball, bool xAxis, double coordinate);
+		/// state of the ball when it falls through \p height, like estimate_x_at_y. Everything
+		/// is infinite if the ball does not reach that height.
+		Ball estimateAtY(double height, double* time = nullptr);
+		double ballTimeToX(double x) const;
+		double ballTimeToY(double y) const;
+		double blobTimeToX(double x) const;
+
+		/// first positive time t with pos + vel*t + grav/2 * t^2 == destination, or infinity
+		static double parabolaTimeFirst(double pos, double vel, double grav, double destination);
+		/// first positive time t with pos + vel*t == destination, or infinity
+		static double linearTimeFirst(double pos, double vel, double destination);
+
+		/// random number in [0, 1)
+		double random();
+		/// random integer in [low, high]
+		int random(int low, int high);
+
+	private:
+		/// flips the y axis, but does not mirror the sides
+		static Ball toBotCoordinates(const Vector2& position, const Vector2& velocity);
+
+		const DuelMatch* mMatch = nullptr;
+		PlayerSide mSide = LEFT_PLAYER;
+		std::default_random_engine* mRandom = nullptr;
+
+		Ball mBall;
+		// the errors of the ball data, renewed at every bounce
+		Ball mError{0, 0, 0, 0};
+		double mLastBallSpeed = 0;
+		bool mFirstStep = true;
+
+		bool mWantLeft = false;
+		bool mWantRight = false;
+		bool mWantJump = false;
+
+		// we save a dummy physic world here to do simulations
+		PhysicWorld mDummyWorld;
+};
@@ -0,0 +1,80 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "BotInputSource.h"
+
+/* includes */
+#include <algorithm>
+
+#include <SDL2/SDL.h>
+
+#include "DuelMatch.h"
+
+/* implementation */
+
+BotInputSource::BotInputSource(PlayerSide side, unsigned int difficulty, unsigned int seed)
+: mDifficulty(difficulty)
+, mSide(side)
+, mRandom(seed)
+, mDelayDistribution( difficulty/3, difficulty/2 )
+{
+	mStartTime = SDL_GetTicks();
+}
+
+BotInputSource::~BotInputSource() = default;
+
+void BotInputSource::setDeterministic(int gameSpeed)
+{
+	mSimulatedSpeed = gameSpeed;
+}
+
+unsigned int BotInputSource::advanceTime()
+{
+	unsigned int elapsed = mSimulatedSpeed ? mSteps * 1000 / mSimulatedSpeed : SDL_GetTicks() - mStartTime;
+	++mSteps;
+	return elapsed;
+}
+
+PlayerInputAbs BotInputSource::restrictInput(bool left, bool right, bool jump, unsigned int elapsed)
+{
+	bool serving = !getMatch()->getBallActive() && mSide ==
+			// if no player is serving player, assume the left one is
+			(getMatch()->getServingPlayer() == NO_PLAYER ? LEFT_PLAYER : getMatch()->getServingPlayer());
+
+	if (elapsed < WAITING_TIME && serving)
+		return {};
+
+	// random jump delay depending on difficulty
+	if( jump && !mLastJump )
+	{
+		mJumpDelay--;
+		if( mJumpDelay > 0 )
+			jump = false;
+		else
+		{
+			mJumpDelay = std::max(0.0, std::min( mDelayDistribution(mRandom) , (double)mDifficulty));
+		}
+	}
+
+	mLastJump = jump;
+
+	return {left, right, jump};
+}
@@ -0,0 +1,77 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/**
+ * @file BotInputSource.h
+ * @brief Contains the common base class of all computer controlled players
+ */
+
+#pragma once
+
+#include <random>
+
+#include "Global.h"
+#include "InputSource.h"
+
+// The time the bot waits after game start
+const int WAITING_TIME = 1500;
+
+/// \class BotInputSource
+/// \brief Base class of the bots
+/// \details Handles everything that does not depend on how a bot decides on its moves:
+/// the waiting time before serving and the random jump delays which make weaker bots
+/// react later. Derived classes compute the wanted input and pass it through restrictInput.
+class BotInputSource : public InputSource
+{
+	public:
+		/// The seed initialises the random jump delays.
+		BotInputSource(PlayerSide side, unsigned int difficulty, unsigned int seed);
+		~BotInputSource() override;
+
+		/// \brief makes the bot independent of the wall clock
+		/// \details The waiting time after game start is counted in game steps, assuming
+		///			\p gameSpeed steps per second. Used for matches that are not played in real
+		///			time, possibly many at once.
+		virtual void setDeterministic(int gameSpeed);
+
+	protected:
+		/// milliseconds since the game start, has to be called exactly once per step
+		unsigned int advanceTime();
+
+		/// applies the waiting time before serving and the jump delay to the wanted input
+		PlayerInputAbs restrictInput(bool left, bool right, bool jump, unsigned int elapsed);
+
+		// ki strength values
+		int mDifficulty;
+
+		PlayerSide mSide;
+
+		std::default_random_engine mRandom;
+
+	private:
+		unsigned int mStartTime;
+		int mSimulatedSpeed = 0;
+		unsigned int mSteps = 0;
+
+		// error data
+		bool mLastJump = false;
+		double mJumpDelay = 0;
+		std::normal_distribution<double> mDelayDistribution;
+};
@@ -22,7 +22,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "FileRead.h"
 
 /* includes */
+#include <algorithm>
 #include <cassert>
+#include <iostream>
+#include <map>
+#include <mutex>
 
 #include <physfs.h>
 
@@ -40,6 +44,8 @@ extern "C"
 }
 
 #include "Global.h"
+#include "FileSystem.h"
+#include "FileWrite.h"
 
 
 /* implementation */
@@ -194,42 +200,177 @@ uint32_t FileRead::calcChecksum(uint32_t start)
 
 // reading lua script
 
-struct ReaderInfo
+namespace
 {
-	FileRead file;
-	char buffer[2048];
-};
+	/// lua chunk compiled from a script, together with the source it was compiled from
+	struct CompiledScript
+	{
+		std::string source;
+		std::string bytecode;
+	};
 
-static const char* chunkReader(lua_State* state, void* data, size_t *size)
-{
-	ReaderInfo* info = (ReaderInfo*) data;
+	// compiled scripts by chunk name. guarded by the mutex, as bots and rules are
+	// loaded from several threads in the tools and on the server
+	std::mutex gCompiledScriptsMutex;
+	std::map<std::string, std::shared_ptr<const CompiledScript>> gCompiledScripts;
+	std::string gLuaCacheDirectory;
+
+	// cache files: magic, size, crc and hash of the source, crc of the bytecode, bytecode
+	const char LUA_CACHE_MAGIC[4] = {'B', 'L', 'C', '1'};
+
+	// 64 bit FNV-1a, stored in the cache files next to the crc to identify the source
+	uint64_t hashSource(const std::string& source)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (unsigned char c : source)
+		{
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint32_t crcOf(const std::string& data)
+	{
+		boost::crc_32_type crc;
+		crc.process_bytes(data.data(), data.size());
+		return crc.checksum();
+	}
+
+	std::string getCacheFilename(const std::string& chunkname)
+	{
+		std::string name = chunkname;
+		std::replace(name.begin(), name.end(), '/', '_');
+		return gLuaCacheDirectory + "/" + name + ".luac";
+	}
 
-	int bytesRead = 2048;
-	if(info->file.length() - info->file.tell() < 2048)
+	// reads the compiled chunk of a script from the cache directory, if it was compiled
+	// from exactly this source
+	std::string readCachedBytecode(const std::string& chunkname, const std::string& source)
 	{
-		bytesRead = info->file.length() - info->file.tell();
+		try
+		{
+			std::string filename = getCacheFilename(chunkname);
+			if (!FileSystem::getSingleton().exists(filename))
+				return "";
+
+			FileRead file(filename);
+			char magic[sizeof(LUA_CACHE_MAGIC)];
+			file.readRawBytes(magic, sizeof(magic));
+			uint32_t size = file.readUInt32();
+			uint32_t crc = file.readUInt32();
+			uint64_t hash = file.readUInt32();
+			hash |= uint64_t(file.readUInt32()) << 32;
+			uint32_t bytecodeCrc = file.readUInt32();
+			if (!std::equal(magic, magic + sizeof(magic), LUA_CACHE_MAGIC) || size != source.size() ||
+				crc != crcOf(source) || hash != hashSource(source))
+			{
+				return "";
+			}
+
+			std::string bytecode(file.length() - file.tell(), '\0');
+			if (!bytecode.empty())
+				file.readRawBytes(&bytecode[0], bytecode.size());
+			// lua does not verify bytecode, so make sure the file is intact
+			return crcOf(bytecode) == bytecodeCrc ? bytecode : "";
+		}
+		catch (std::exception&)
+		{
+			// a broken cache file is no reason not to load the script
+			return "";
+		}
 	}
 
-	info->file.readRawBytes(info->buffer, bytesRead);
-	// if this doesn't throw, bytesRead is the actual number of bytes read
-	/// \todo we must do sth about this code, its just plains awful.
-	/// 		File interface has to be improved to support such buffered reading.
-	*size = bytesRead;
-	if (bytesRead == 0)
+	void writeCachedBytecode(const std::string& chunkname, const CompiledScript& script)
 	{
-		return nullptr;
+		try
+		{
+			FileWrite file(getCacheFilename(chunkname));
+			file.write(LUA_CACHE_MAGIC, sizeof(LUA_CACHE_MAGIC));
+			file.writeUInt32(script.source.size());
+			file.writeUInt32(crcOf(script.source));
+			uint64_t hash = hashSource(script.source);
+			file.writeUInt32(hash & 0xFFFFFFFF);
+			file.writeUInt32(hash >> 32);
+			file.writeUInt32(crcOf(script.bytecode));
+			file.write(script.bytecode);
+		}
+		catch (std::exception& e)
+		{
+			std::cerr << "Warning: could not cache compiled lua script " << chunkname << ": " << e.what() << std::endl;
+		}
 	}
-	else
+
+	int appendChunk(lua_State* state, const void* data, size_t size, void* target)
 	{
-		return info->buffer;
+		static_cast<std::string*>(target)->append(static_cast<const char*>(data), size);
+		return 0;
 	}
 }
 
+void FileRead::setLuaCacheDirectory(const std::string& directory)
+{
+	std::lock_guard<std::mutex> lock(gCompiledScriptsMutex);
+	gLuaCacheDirectory = directory;
+}
+
 int FileRead::readLuaScript(const std::string& filename, lua_State* mState)
 {
-	ReaderInfo info;
-	info.file.open(makeLuaFilename(filename));
-	return lua_load(mState, chunkReader, &info, filename.c_str(), nullptr);
+	std::string source;
+	{
+		FileRead file(makeLuaFilename(filename));
+		source.resize(file.length());
+		if (!source.empty())
+			file.readRawBytes(&source[0], source.size());
+	}
+
+	std::shared_ptr<const CompiledScript> compiled;
+	std::string cacheDirectory;
+	{
+		std::lock_guard<std::mutex> lock(gCompiledScriptsMutex);
+		auto found = gCompiledScripts.find(filename);
+		if (found != gCompiledScripts.end() && found->second->source == source)
+			compiled = found->second;
+		cacheDirectory = gLuaCacheDirectory;
+	}
+
+	if (!compiled && !cacheDirectory.empty())
+	{
+		std::string bytecode = readCachedBytecode(filename, source);
+		if (!bytecode.empty())
+			compiled = std::make_shared<const CompiledScript>(CompiledScript{source, std::move(bytecode)});
+	}
+
+	// the compiled chunk skips the parser. if it does not load, e.g. because it was written
+	// by another lua version, compile the source again
+	if (compiled)
+	{
+		if (luaL_loadbufferx(mState, compiled->bytecode.data(), compiled->bytecode.size(), filename.c_str(), "b") == LUA_OK)
+		{
+			std::lock_guard<std::mutex> lock(gCompiledScriptsMutex);
+			gCompiledScripts[filename] = compiled;
+			return LUA_OK;
+		}
+		lua_pop(mState, 1);
+	}
+
+	int error = luaL_loadbufferx(mState, source.data(), source.size(), filename.c_str(), nullptr);
+	if (error != LUA_OK)
+		return error;
+
+	// keep the debug information, so error messages still name the lines of the script
+	auto script = std::make_shared<CompiledScript>();
+	script->source = std::move(source);
+	lua_dump(mState, appendChunk, &script->bytecode, 0);
+
+	{
+		std::lock_guard<std::mutex> lock(gCompiledScriptsMutex);
+		gCompiledScripts[filename] = script;
+	}
+	if (!cacheDirectory.empty())
+		writeCachedBytecode(filename, *script);
+
+	return LUA_OK;
 }
 
 std::string FileRead::makeLuaFilename(std::string filename)
@@ -118,7 +118,12 @@ class FileRead : public File
 		// 								LUA/XML reading helper function
 		// -----------------------------------------------------------------------------------------
 		static std::string makeLuaFilename(std::string filename);
+		/// loads a lua script as function onto the stack, see lua_load. Compiled scripts are
+		/// cached in memory and, after setLuaCacheDirectory, on disk, so the parser only runs
+		/// for new or changed scripts.
 		static int readLuaScript(const std::string& filename, lua_State* mState);
+		/// keeps compiled lua scripts in \p directory of the write dir, which has to exist
+		static void setLuaCacheDirectory(const std::string& directory);
 		
 		static XMLDocumentPtr readXMLDocument(const std::string& filename);
 };
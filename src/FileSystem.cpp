@@ -95,16 +95,27 @@ bool FileSystem::isDirectory(const std::string& dirname) const
 	return stat.filetype == PHYSFS_FILETYPE_DIRECTORY;
 }
 
+bool FileSystem::getFileInfo(const std::string& filename, int64_t& size, int64_t& modified) const
+{
+	PHYSFS_Stat stat;
+	if ( !PHYSFS_stat(filename.c_str(), &stat) )
+		return false;
+
+	size = stat.filesize;
+	modified = stat.modtime;
+	return true;
+}
+
 bool FileSystem::mkdir(const std::string& dirname)
 {
 	return PHYSFS_mkdir(dirname.c_str());
 }
 
-void FileSystem::addToSearchPath(const std::string& dirname, bool append)
+void FileSystem::addToSearchPath(const std::string& dirname, bool append, const std::string& mountPoint)
 {
 	/// \todo check if dir exists?
 	/// \todo check return value
-	PHYSFS_mount(dirname.c_str(), nullptr, append ? 1 : 0);
+	PHYSFS_mount(dirname.c_str(), mountPoint.empty() ? nullptr : mountPoint.c_str(), append ? 1 : 0);
 }
 
 void FileSystem::removeFromSearchPath(const std::string& dirname)
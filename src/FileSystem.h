@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <boost/noncopyable.hpp>
 
 #include "FileExceptions.h"
@@ -58,13 +59,18 @@ class FileSystem : public boost::noncopyable, public ObjectCounter<FileSystem>
 		/// \brief tests whether given path is a directory
 		bool isDirectory(const std::string& dirname) const;
 
+		/// \brief gets size and last modification time of a file
+		/// \details the modification time is in seconds since the epoch, -1 if it is unknown.
+		/// \return false, if the file could not be queried
+		bool getFileInfo(const std::string& filename, int64_t& size, int64_t& modified) const;
+
 		/// \brief creates a directory and reports success/failure
 		/// \return true, if the directory could be created
 		bool mkdir(const std::string& dirname);
 
 
 		// general setup methods
-		void addToSearchPath(const std::string& dirname, bool append = true);
+		void addToSearchPath(const std::string& dirname, bool append = true, const std::string& mountPoint = "");
 		void removeFromSearchPath(const std::string& dirname);
 		/// \details automatically registers this directory as primary read directory!
 		void setWriteDir(const std::string& dirname);
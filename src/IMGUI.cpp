@@ -22,7 +22,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "IMGUI.h"
 
 /* includes */
-#include <queue>
+#include <vector>
+#include <memory>
+#include <algorithm>
 #include <cassert>
 
 #include <SDL2/SDL.h>
@@ -46,6 +48,84 @@ enum ObjectType
 	ACTIVECHAT
 };
 
+namespace
+{
+	// size of the memory blocks of the FrameArena, enough for the texts of most menus
+	const std::size_t ARENA_BLOCK_SIZE = 16 * 1024;
+}
+
+/// a string copied into the FrameArena
+struct ArenaString
+{
+	const char* data;
+	unsigned int length;
+};
+
+/*! \class FrameArena
+	\brief memory for the texts of one step
+	\details Allocating just moves a pointer forward. reset() forgets everything at once,
+			but keeps the blocks, so after the first steps the GUI doesn't allocate any more.
+			Only suitable for types that don't need a destructor.
+*/
+class FrameArena
+{
+	public:
+		FrameArena() : mCurrentBlock(0), mOffset(0)
+		{
+		}
+
+		ArenaString copy(const std::string& text)
+		{
+			char* data = allocate<char>(text.size());
+			std::copy(text.begin(), text.end(), data);
+			return ArenaString{data, (unsigned int)text.size()};
+		}
+
+		template<class T>
+		T* allocate(std::size_t count)
+		{
+			return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+		}
+
+		void reset()
+		{
+			mCurrentBlock = 0;
+			mOffset = 0;
+		}
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<char[]> memory;
+			std::size_t size;
+		};
+
+		void* allocateBytes(std::size_t size, std::size_t alignment)
+		{
+			while (mCurrentBlock < mBlocks.size())
+			{
+				std::size_t start = (mOffset + alignment - 1) & ~(alignment - 1);
+				if (start + size <= mBlocks[mCurrentBlock].size)
+				{
+					mOffset = start + size;
+					return mBlocks[mCurrentBlock].memory.get() + start;
+				}
+				++mCurrentBlock;
+				mOffset = 0;
+			}
+
+			// a new block is only needed if this step has more text than any step before
+			std::size_t blockSize = std::max(ARENA_BLOCK_SIZE, size + alignment);
+			mBlocks.push_back(Block{std::unique_ptr<char[]>(new char[blockSize]), blockSize});
+			return allocateBytes(size, alignment);
+		}
+
+		std::vector<Block> mBlocks;
+		std::size_t mCurrentBlock;
+		std::size_t mOffset;
+};
+
+/// the commands only point into the arena, so they can be copied without allocating
 struct QueueObject
 {
 	ObjectType type;
@@ -54,21 +134,45 @@ struct QueueObject
 	Vector2 pos2;
 	Color col;
 	float alpha;
-	std::string text;
-	std::vector<std::string> entries;
+	ArenaString text = {nullptr, 0};
+	const ArenaString* entries = nullptr;
+	unsigned int entryCount = 0;
 	int selected;
 	int length;
 	unsigned int flags;
 };
 
-typedef std::queue<QueueObject> RenderQueue;
+// kept until the next begin(), so several frames can be drawn from one step
+typedef std::vector<QueueObject> RenderQueue;
 
 IMGUI* IMGUI::mSingleton = nullptr;
 RenderQueue *mQueue;
+FrameArena *mArena;
+
+namespace
+{
+	// the renderers want std::string, this one is reused for all texts
+	std::string gDrawText;
+
+	const std::string& toString(const ArenaString& text)
+	{
+		gDrawText.assign(text.data, text.length);
+		return gDrawText;
+	}
+
+	const ArenaString* copyEntries(const std::vector<std::string>& entries, unsigned int first, unsigned int last)
+	{
+		ArenaString* copies = mArena->allocate<ArenaString>(last - first);
+		for (unsigned int i = first; i < last; ++i)
+			copies[i - first] = mArena->copy(entries[i]);
+		return copies;
+	}
+}
 
 IMGUI::IMGUI()
 {
 	mQueue = new RenderQueue;
+	mArena = new FrameArena;
 	mActiveButton = -1;
 	mHeldWidget = 0;
 	mLastKeyAction = NONE;
@@ -76,11 +180,13 @@ IMGUI::IMGUI()
 	mButtonReset = false;
 	mInactive = false;
 	mIdCounter = 0;
+	mDrawCursor = false;
 }
 
 IMGUI::~IMGUI()
 {
 	delete mQueue;
+	delete mArena;
 }
 
 IMGUI& IMGUI::getSingleton()
@@ -94,9 +200,10 @@ void IMGUI::begin()
 {
 	mUsingCursor = false;
 	mButtonReset = false;
+	mDrawCursor = false;
 
-	while (!mQueue->empty())
-		mQueue->pop();
+	mQueue->clear();
+	mArena->reset();
 
 
 	mLastKeyAction = NONE;
@@ -127,13 +234,12 @@ void IMGUI::end()
 	int FontSize;
 	RenderManager& rmanager = RenderManager::getSingleton();
 
-	while (!mQueue->empty())
+	for (const QueueObject& obj : *mQueue)
 	{
-		QueueObject& obj = mQueue->front();
 		switch (obj.type)
 		{
 			case IMAGE:
-				rmanager.drawImage(obj.text, obj.pos1, obj.pos2);
+				rmanager.drawImage(toString(obj.text), obj.pos1, obj.pos2);
 				break;
 
 			case OVERLAY:
@@ -141,7 +247,7 @@ void IMGUI::end()
 				break;
 
 			case TEXT:
-				rmanager.drawText(obj.text, obj.pos1, obj.flags);
+				rmanager.drawText(toString(obj.text), obj.pos1, obj.flags);
 				break;
 
 			case SCROLLBAR:
@@ -157,13 +263,13 @@ void IMGUI::end()
 			case EDITBOX:
 				FontSize = (obj.flags & TF_SMALL_FONT ? FONT_WIDTH_SMALL : FONT_WIDTH_NORMAL);
 				rmanager.drawOverlay(0.5, obj.pos1, obj.pos1 + Vector2(10+obj.length*FontSize, 10+FontSize));
-				rmanager.drawText(obj.text, obj.pos1+Vector2(5, 5), obj.flags);
+				rmanager.drawText(toString(obj.text), obj.pos1+Vector2(5, 5), obj.flags);
 				break;
 
 			case ACTIVEEDITBOX:
 				FontSize = (obj.flags & TF_SMALL_FONT ? FONT_WIDTH_SMALL : FONT_WIDTH_NORMAL);
 				rmanager.drawOverlay(0.3, obj.pos1, obj.pos1 + Vector2(10+obj.length*FontSize, 10+FontSize));
-				rmanager.drawText(obj.text, obj.pos1+Vector2(5, 5), obj.flags);
+				rmanager.drawText(toString(obj.text), obj.pos1+Vector2(5, 5), obj.flags);
 				if (obj.pos2.x >= 0)
 					rmanager.drawOverlay(1.0, Vector2((obj.pos2.x)*FontSize+obj.pos1.x+5, obj.pos1.y+5), Vector2((obj.pos2.x)*FontSize+obj.pos1.x+5+3, obj.pos1.y+5+FontSize), Color(255,255,255));
 				break;
@@ -172,12 +278,12 @@ void IMGUI::end()
 			case ACTIVESELECTBOX:
 				FontSize = (obj.flags & TF_SMALL_FONT ? (FONT_WIDTH_SMALL+LINE_SPACER_SMALL) : (FONT_WIDTH_NORMAL+LINE_SPACER_NORMAL));
 				rmanager.drawOverlay((obj.type == SELECTBOX ? 0.5 : 0.3), obj.pos1, obj.pos2);
-				for (unsigned int c = 0; c < obj.entries.size(); c++)
+				for (unsigned int c = 0; c < obj.entryCount; c++)
 				{
 					if( c == static_cast<unsigned int>(obj.selected) )
-						rmanager.drawText(obj.entries[c], Vector2(obj.pos1.x+5, obj.pos1.y+(c*FontSize)+5), obj.flags | TF_HIGHLIGHT);
+						rmanager.drawText(toString(obj.entries[c]), Vector2(obj.pos1.x+5, obj.pos1.y+(c*FontSize)+5), obj.flags | TF_HIGHLIGHT);
 					else
-						rmanager.drawText(obj.entries[c], Vector2(obj.pos1.x+5, obj.pos1.y+(c*FontSize)+5), obj.flags);
+						rmanager.drawText(toString(obj.entries[c]), Vector2(obj.pos1.x+5, obj.pos1.y+(c*FontSize)+5), obj.flags);
 				}
 				break;
 
@@ -185,12 +291,12 @@ void IMGUI::end()
 			case ACTIVECHAT:
 				FontSize = (obj.flags & TF_SMALL_FONT ? (FONT_WIDTH_SMALL+LINE_SPACER_SMALL) : (FONT_WIDTH_NORMAL+LINE_SPACER_NORMAL));
 				rmanager.drawOverlay((obj.type == CHAT ? 0.5 : 0.3), obj.pos1, obj.pos2);
-				for (unsigned int c = 0; c < obj.entries.size(); c++)
+				for (unsigned int c = 0; c < obj.entryCount; c++)
 				{
-					if (obj.text[c] == 'R' )
-						rmanager.drawText(obj.entries[c], Vector2(obj.pos1.x+5, obj.pos1.y+(c*FontSize)+5), obj.flags | TF_HIGHLIGHT);
+					if (obj.text.data[c] == 'R' )
+						rmanager.drawText(toString(obj.entries[c]), Vector2(obj.pos1.x+5, obj.pos1.y+(c*FontSize)+5), obj.flags | TF_HIGHLIGHT);
 					else
-						rmanager.drawText(obj.entries[c], Vector2(obj.pos1.x+5, obj.pos1.y+(c*FontSize)+5), obj.flags);
+						rmanager.drawText(toString(obj.entries[c]), Vector2(obj.pos1.x+5, obj.pos1.y+(c*FontSize)+5), obj.flags);
 				}
 				break;
 
@@ -201,13 +307,11 @@ void IMGUI::end()
 			default:
 				break;
 		}
-		mQueue->pop();
 	}
 #if BLOBBY_ON_DESKTOP
 	if (mDrawCursor)
 	{
 		rmanager.drawImage("gfx/cursor.bmp", InputManager::getSingleton()->position() + Vector2(24.0, 24.0));
-		mDrawCursor = false;
 	}
 #endif
 	static bool lastCursor = false;
@@ -226,8 +330,8 @@ void IMGUI::doImage(int id, const Vector2& position, const std::string& name, co
 	obj.id = id;
 	obj.pos1 = position;
 	obj.pos2 = size;
-	obj.text = name;
-	mQueue->push(obj);
+	obj.text = mArena->copy(name);
+	mQueue->push_back(obj);
 }
 
 void IMGUI::doText(int id, const Vector2& position, const std::string& text, unsigned int flags)
@@ -250,9 +354,9 @@ void IMGUI::doText(int id, const Vector2& position, const std::string& text, uns
 	}
 
 
-	obj.text = text;
+	obj.text = mArena->copy(text);
 	obj.flags = flags;
-	mQueue->push(obj);
+	mQueue->push_back(obj);
 }
 
 void IMGUI::doText(int id, const Vector2& position, TextManager::STRING text, unsigned int flags)
@@ -269,7 +373,7 @@ void IMGUI::doOverlay(int id, const Vector2& pos1, const Vector2& pos2, const Co
 	obj.pos2 = pos2;
 	obj.col = col;
 	obj.alpha = alpha;
-	mQueue->push(obj);
+	mQueue->push_back(obj);
 	RenderManager::getSingleton().redraw();
 }
 
@@ -284,7 +388,7 @@ bool IMGUI::doButton(int id, const Vector2& position, const std::string& text, u
 	QueueObject obj;
 	obj.id = id;
 	obj.pos1 = position;
-	obj.text = text;
+	obj.text = mArena->copy(text);
 	obj.type = TEXT;
 	obj.flags = flags;
 
@@ -392,7 +496,7 @@ bool IMGUI::doButton(int id, const Vector2& position, const std::string& text, u
 	}
 
 	mLastWidget = id;
-	mQueue->push(obj);
+	mQueue->push_back(obj);
 	return clicked;
 }
 
@@ -527,7 +631,7 @@ bool IMGUI::doScrollbar(int id, const Vector2& position, float& value)
 	obj.pos2.x = value;
 
 	mLastWidget = id;
-	mQueue->push(obj);
+	mQueue->push_back(obj);
 
 	return deselected;
 }
@@ -766,10 +870,10 @@ bool IMGUI::doEditbox(int id, const Vector2& position, unsigned int length, std:
 	}
 
 	obj.pos2.x = SDL_GetTicks() % 1000 >= 500 ? cpos : -1.0;
-	obj.text = text;
+	obj.text = mArena->copy(text);
 
 	mLastWidget = id;
-	mQueue->push(obj);
+	mQueue->push_back(obj);
 
 	// when content changed, it is active
 	// part of chat window hack
@@ -922,15 +1026,14 @@ SelectBoxAction IMGUI::doSelectbox(int id, const Vector2& pos1, const Vector2& p
 		if (last > entries.size())
 			last = entries.size();
 
-		obj.entries = std::vector<std::string>(entries.begin()+first, entries.begin()+last);
+		obj.entries = copyEntries(entries, first, last);
+		obj.entryCount = last - first;
 	}
-	else
-		obj.entries = std::vector<std::string>();
 
 	obj.selected = selected-first;
 
 	mLastWidget = id;
-	mQueue->push(obj);
+	mQueue->push_back(obj);
 
 	return changed;
 }
@@ -1069,22 +1172,22 @@ void IMGUI::doChatbox(int id, const Vector2& pos1, const Vector2& pos2, const st
 			last = entries.size();
 		}
 
-		obj.entries = std::vector<std::string>(entries.begin()+first, entries.begin()+last);
+		obj.entries = copyEntries(entries, first, last);
+		obj.entryCount = last - first;
 		// HACK: we use taxt to store information which text is from local player and which from
 		//			remote player.
-		obj.text = "";
+		char* sides = mArena->allocate<char>(last - first);
 		for(unsigned int i = first; i < last; ++i)
 		{
-			obj.text += local[i] ? 'L' : 'R';
+			sides[i - first] = local[i] ? 'L' : 'R';
 		}
+		obj.text = ArenaString{sides, last - first};
 	}
-	else
-		obj.entries = std::vector<std::string>();
 
 	obj.selected = selected-first;
 
 	mLastWidget = id;
-	mQueue->push(obj);
+	mQueue->push_back(obj);
 }
 
 
@@ -1095,7 +1198,7 @@ bool IMGUI::doBlob(int id, const Vector2& position, const Color& col)
 	obj.pos1 = position;
 	obj.type = BLOB;
 	obj.col = col;
-	mQueue->push(obj);
+	mQueue->push_back(obj);
 	return false;
 }
 
@@ -25,12 +25,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 
 #include "IUserConfigReader.h"
+#include "BotBrain.h"
 #include "LocalInputSource.h"
+#include "NativeInputSource.h"
 #include "ScriptedInputSource.h"
 
 std::shared_ptr<InputSource> InputSourceFactory::createInputSource( IUserConfigReader& config, PlayerSide side )
 {
 	std::string prefix = side == LEFT_PLAYER ? "left" : "right";
+	std::string bot = config.getString(prefix + "_script_name");
 	try
 	{
 		// these operations may throw, i.e., when the script is not found (should not happen)
@@ -39,9 +42,14 @@ std::shared_ptr<InputSource> InputSourceFactory::createInputSource( IUserConfigR
 		{
 			return std::make_shared<LocalInputSource>(side);
 		}
+		// native bots take precedence over scripts of the same name
+		else if (BotBrain::isRegistered(bot))
+		{
+			return std::make_shared<NativeInputSource>(bot, side, config.getInteger(prefix + "_script_strength"));
+		}
 		else
 		{
-			return std::make_shared<ScriptedInputSource>("scripts/" + config.getString(prefix + "_script_name"),
+			return std::make_shared<ScriptedInputSource>("scripts/" + bot,
 					side, config.getInteger(prefix + "_script_strength"));
 		}
 	} catch (std::exception& e)
@@ -0,0 +1,73 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "InterpolatedState.h"
+
+/* includes */
+#include <cmath>
+
+/* implementation */
+namespace
+{
+	// a bigger movement per step is a reset, e.g. after a point, and is not interpolated
+	const float MAX_INTERPOLATION_DISTANCE = 100;
+	// rotation of the ball wraps at this value, see PhysicWorld
+	const float BALL_ROTATION_PERIOD = 6.25f;
+
+	Vector2 interpolatePosition(const Vector2& a, const Vector2& b, float t, float steps)
+	{
+		if( (b - a).length() > MAX_INTERPOLATION_DISTANCE * steps )
+			return t < 0.5f ? a : b;
+		return a + (b - a) * t;
+	}
+}
+
+InterpolatedState::InterpolatedState(const DuelMatchState& state) :
+	ballPosition(state.getBallPosition()),
+	ballRotation(state.getBallRotation())
+{
+	for(auto side : {LEFT_PLAYER, RIGHT_PLAYER})
+	{
+		blobPosition[side] = state.getBlobPosition(side);
+		blobState[side] = state.getBlobState(side);
+	}
+}
+
+InterpolatedState interpolate(const InterpolatedState& a, const InterpolatedState& b, float t, float steps)
+{
+	InterpolatedState result = b;
+	result.ballPosition = interpolatePosition(a.ballPosition, b.ballPosition, t, steps);
+	for(auto side : {LEFT_PLAYER, RIGHT_PLAYER})
+	{
+		result.blobPosition[side] = interpolatePosition(a.blobPosition[side], b.blobPosition[side], t, steps);
+		result.blobState[side] = t < 0.5f ? a.blobState[side] : b.blobState[side];
+	}
+
+	// take the short way round
+	float rotation = b.ballRotation - a.ballRotation;
+	if( rotation > BALL_ROTATION_PERIOD / 2 )
+		rotation -= BALL_ROTATION_PERIOD;
+	else if( rotation < -BALL_ROTATION_PERIOD / 2 )
+		rotation += BALL_ROTATION_PERIOD;
+	result.ballRotation = std::fmod(a.ballRotation + rotation * t + BALL_ROTATION_PERIOD, BALL_ROTATION_PERIOD);
+
+	return result;
+}
@@ -0,0 +1,39 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include "DuelMatchState.h"
+
+/// \brief positions of the moving objects, as they should be drawn
+struct InterpolatedState
+{
+	explicit InterpolatedState(const DuelMatchState& state = DuelMatchState());
+
+	Vector2 ballPosition;
+	float ballRotation;
+	Vector2 blobPosition[MAX_PLAYERS];
+	float blobState[MAX_PLAYERS];
+};
+
+/// interpolates between \p a and \p b, which are \p steps game steps apart.
+/// Objects that moved further than possible in that time, e.g. because of a reset after
+/// a point, jump instead.
+InterpolatedState interpolate(const InterpolatedState& a, const InterpolatedState& b, float t, float steps = 1);
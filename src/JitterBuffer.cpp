@@ -0,0 +1,138 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "JitterBuffer.h"
+
+/* includes */
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+/* implementation */
+namespace
+{
+	const float MIN_DELAY = 1;
+	const float MAX_DELAY = 8;
+	// steps a lost state is extrapolated before the objects stop
+	const float MAX_EXTRAPOLATION = 6;
+}
+
+JitterBuffer::JitterBuffer() : mLateCount(0)
+{
+	reset();
+}
+
+void JitterBuffer::reset()
+{
+	mStates.clear();
+	mFrame = 0;
+	mSynchronized = false;
+	mOffset = 0;
+	mJitter = 0;
+	mDelay = MIN_DELAY;
+	mPlayback = 0;
+}
+
+void JitterBuffer::addState(unsigned tick, const DuelMatchState& state)
+{
+	float offset = (float)mFrame - (float)tick;
+	if( !mSynchronized )
+	{
+		mOffset = offset;
+		mPlayback = tick - mDelay;
+		mSynchronized = true;
+	}
+
+	// slowly follow the drift between local and server clock, and measure the deviation from it
+	float deviation = offset - mOffset;
+	mOffset += deviation / 32;
+	mJitter += (std::abs(deviation) - mJitter) / 16;
+
+	if( tick <= mPlayback )
+	{
+		++mLateCount;
+		return;
+	}
+
+	// packets are sequenced, so new states nearly always belong at the end
+	auto pos = mStates.end();
+	while( pos != mStates.begin() && std::prev(pos)->tick >= tick )
+		--pos;
+	if( pos != mStates.end() && pos->tick == tick )
+		return;
+
+	mStates.insert(pos, Entry{tick, state});
+}
+
+bool JitterBuffer::step(InterpolatedState& state)
+{
+	++mFrame;
+	if( mStates.empty() )
+		return false;
+
+	// resize the delay smoothly, and speed up or slow down the playback to reach it
+	float targetDelay = std::max(MIN_DELAY, std::min(MAX_DELAY, 2 * mJitter + MIN_DELAY));
+	mDelay += (targetDelay - mDelay) / 20;
+
+	float target = mFrame - mOffset - mDelay;
+	if( std::abs(target - mPlayback) > 2 * MAX_DELAY )
+		mPlayback = target;
+	else
+		mPlayback += 1 + std::max(-0.1f, std::min(0.1f, (target - mPlayback) / 10));
+
+	// the first state is needed for interpolation, older ones can go
+	while( mStates.size() > 1 && mStates[1].tick <= mPlayback )
+		mStates.pop_front();
+
+	const Entry& first = mStates.front();
+	if( first.tick >= mPlayback )
+	{
+		// nothing older available, so we can only show the first state
+		state = InterpolatedState( first.state );
+	}
+	else if( mStates.size() == 1 )
+	{
+		extrapolate(first, mPlayback - first.tick, state);
+	}
+	else
+	{
+		const Entry& second = mStates[1];
+		float steps = second.tick - first.tick;
+		float t = (mPlayback - first.tick) / steps;
+		state = interpolate( InterpolatedState(first.state), InterpolatedState(second.state), t, steps );
+	}
+
+	return true;
+}
+
+int JitterBuffer::getDepth() const
+{
+	return std::count_if(mStates.begin(), mStates.end(), [this](const Entry& e) { return e.tick > mPlayback; });
+}
+
+void JitterBuffer::extrapolate(const Entry& entry, float steps, InterpolatedState& state) const
+{
+	steps = std::min(steps, MAX_EXTRAPOLATION);
+	state = InterpolatedState( entry.state );
+	state.ballPosition += entry.state.getBallVelocity() * steps;
+	for(auto side : {LEFT_PLAYER, RIGHT_PLAYER})
+		state.blobPosition[side] += entry.state.getBlobVelocity(side) * steps;
+}
@@ -0,0 +1,78 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <deque>
+
+#include "InterpolatedState.h"
+
+/*! \class JitterBuffer
+	\brief smooths the game states received from a server
+	\details The states are sorted by the server step in which they were created and played back
+			a small delay behind the newest state, interpolating between neighbouring states.
+			The delay adapts to the jitter of the packet arrival times. If packets are missing,
+			the last state is extrapolated for a few steps.
+			step() is expected to be called once per game step, so local frames and server steps
+			have the same length.
+*/
+class JitterBuffer
+{
+	public:
+		JitterBuffer();
+
+		/// adds a state that was created by the server in step \p tick
+		void addState(unsigned tick, const DuelMatchState& state);
+
+		/// advances the playback by one step.
+		/// \return false, if there is nothing to play back yet
+		bool step(InterpolatedState& state);
+
+		/// drops all states, e.g. when the server stops sending them for some time
+		void reset();
+
+		/// number of buffered states that have not been played back yet
+		int getDepth() const;
+		/// playback delay in steps
+		float getDelay() const { return mDelay; }
+		/// number of states that arrived too late to be shown
+		unsigned getLateCount() const { return mLateCount; }
+
+	private:
+		struct Entry
+		{
+			unsigned tick;
+			DuelMatchState state;
+		};
+
+		void extrapolate(const Entry& entry, float steps, InterpolatedState& state) const;
+
+		std::deque<Entry> mStates;
+
+		unsigned mFrame;
+		bool mSynchronized;
+		// mean difference between local frame and server step at arrival, and its mean deviation
+		float mOffset;
+		float mJitter;
+		float mDelay;
+		float mPlayback;
+
+		unsigned mLateCount;
+};
@@ -0,0 +1,53 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/**
+ * @file NativeInputSource.h
+ * @brief Contains a class which allows using bots written in C++
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Global.h"
+#include "BotInputSource.h"
+
+class BotBrain;
+
+/// \class NativeInputSource
+/// \brief Controller for the bots written in C++
+/// \details Plays a BotBrain from the registry like ScriptedInputSource plays a lua
+/// script, with the same difficulty handling, but without a lua state.
+class NativeInputSource : public BotInputSource
+{
+	public:
+		/// creates the bot registered under \p name, throws std::runtime_error if
+		/// there is none. The seed initialises the random jump delays and ball errors.
+		NativeInputSource(const std::string& name, PlayerSide side, unsigned int difficulty,
+							unsigned int seed = std::default_random_engine::default_seed);
+		~NativeInputSource() override;
+
+		PlayerInputAbs getNextInput() override;
+
+	private:
+		std::unique_ptr<BotBrain> mBrain;
+};
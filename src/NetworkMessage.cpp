@@ -41,6 +41,9 @@ ServerInfo::ServerInfo(RakNet::BitStream& stream, const char* ip, uint16_t p)
 	stream.Read(name, sizeof(name));
 	stream.Read(waitingplayers);
 	stream.Read(description, sizeof(description));
+
+	// busy servers send ID_SERVER_BUSY before the server info
+	acceptsplayers = true;
 }
 
 ServerInfo::ServerInfo(const IUserConfigReader& config)
@@ -56,6 +59,7 @@ ServerInfo::ServerInfo(const IUserConfigReader& config)
 	memset(name, 0, sizeof(name));
 	memset(description, 0, sizeof(description));
 	waitingplayers = 0;
+	acceptsplayers = true;
 
 	std::string tmp;
 	tmp = config.getString("name", n);
@@ -72,6 +76,7 @@ ServerInfo::ServerInfo(const std::string& playername)
 	memset(name, 0, sizeof(name));
 	memset(description, 0, sizeof(description));
 	waitingplayers = 0;
+	acceptsplayers = true;
 
 	std::strncpy(hostname, "localhost", sizeof(hostname));
 	port = BLOBBY_PORT;
@@ -33,7 +33,7 @@ enum MessageType
 {
 	ID_GENERIC_MESSAGE = ID_RESERVED9 + 1,
 	ID_INPUT_UPDATE,	// send input data from client to server
-	ID_GAME_UPDATE,		// send game status from server to client [unreliable]
+	ID_GAME_UPDATE,		// send game status from server to client [unreliable], followed by the server step (unsigned)
 	ID_GAME_EVENTS,		// send game events from server to client [reliable]
 	ID_OPPONENT_DISCONNECTED,
 	ID_GAME_READY,
@@ -48,7 +48,11 @@ enum MessageType
 	ID_RULES_CHECKSUM,
 	ID_RULES,
 	ID_SERVER_STATUS,
-	ID_LOBBY
+	ID_LOBBY,
+	ID_SPECTATOR_READY,
+	ID_SERVER_REDIRECT,
+	ID_INPUT_HISTORY,
+	ID_SERVER_BUSY
 };
 
 // General Information:
@@ -136,6 +140,14 @@ enum MessageType
 // 		ID_BLOBBY_SERVER_PRESENT
 // 		major (int)
 // 		minor (int)
+// 	Answer Structure:
+// 		ID_BLOBBY_SERVER_PRESENT
+// 		active games (int)
+// 		name (char[32])
+// 		waiting players (int)
+// 		description (char[192])
+// 		A server that refuses new players sends ID_SERVER_BUSY right
+// 		before the answer.
 //
 // ID_VERSION_MISMATCH
 // 	Description:
@@ -160,9 +172,13 @@ enum MessageType
 // 		Sent from server to client to tell rules file checksum
 // 		Client should send ID_RULES after receiving ID_RULES_CHECKSUM
 // 			to tell server if he needs rules file transmitting
+//		The spectator flag is true if the client joined the game
+//			as a spectator. Older servers don't send it.
 // 	Structure:
 // 		ID_RULES_CHECKSUM
 //		checksum (int)
+//		score to win (int)
+//		spectator (bool)
 //
 // ID_RULES
 // 	Description:
@@ -183,6 +199,59 @@ enum MessageType
 //		ID_CHALLENGE
 //		(unsigned char) TYPE
 //
+// ID_SPECTATOR_READY
+// 	Description:
+// 		Sent from server to a spectator after the rules have been
+// 		transmitted. Replaces ID_GAME_READY for spectators, which
+// 		see both players from the servers point of view.
+// 	Structure:
+// 		ID_SPECTATOR_READY
+//		gamespeed (int)
+// 		left player name (char[16])
+//		left player color (int)
+// 		right player name (char[16])
+//		right player color (int)
+//
+// ID_SERVER_REDIRECT
+// 	Description:
+// 		Sent from server to client if the client has to continue on another
+// 		port of the same host, e.g. because its game is run by a worker
+// 		process of a server cluster. The client connects to the new port,
+// 		enters the server and sends the reservation token with a
+// 		CLAIM_RESERVATION lobby packet. A token of 0 means there is no
+// 		reservation, the client just enters the lobby of that server.
+// 	Structure:
+// 		ID_SERVER_REDIRECT
+// 		port (int)
+// 		reservation token (unsigned int)
+// 		server info as in ID_BLOBBY_SERVER_PRESENT, only if it is the
+// 		answer to an ID_BLOBBY_SERVER_PRESENT request
+//
+// ID_INPUT_HISTORY
+// 	Description:
+// 		Replaces ID_INPUT_UPDATE for servers that send their step with
+// 		ID_GAME_UPDATE. Carries the inputs of the last frames, so a lost
+// 		packet doesn't lose input. It is sent every frame while the input
+// 		changes, and less often while it doesn't. The server ignores frames
+// 		it has already seen.
+// 	Structure:
+// 		ID_INPUT_HISTORY
+// 		timestamp (unsigned int), sent back with ID_GAME_UPDATE
+// 		newest frame (unsigned int)
+// 		number of runs (unsigned char)
+// 		for each run, going back in time:
+// 			length (unsigned char)
+// 			input (PlayerInputAbs)
+//
+// ID_SERVER_BUSY
+// 	Description:
+// 		Sent from server to client right before the answer to
+// 		ID_BLOBBY_SERVER_PRESENT if the server currently refuses new
+// 		players, e.g. because it is overloaded. Older clients ignore it,
+// 		so the size of the answer stays the same for them.
+// 	Structure:
+// 		ID_SERVER_BUSY
+//
 
 enum class LobbyPacketType : unsigned char
 {
@@ -192,7 +261,10 @@ enum class LobbyPacketType : unsigned char
 	JOIN_GAME,
 	LEAVE_GAME,
 	GAME_STATUS,
-	START_GAME
+	START_GAME,
+	RUNNING_GAMES,	// list of games that can be watched, sent after SERVER_STATUS
+	SPECTATE_GAME,	// join a running game as a spectator
+	CLAIM_RESERVATION	// claim a game or spectator place after ID_SERVER_REDIRECT
 };
 
 class IUserConfigReader;
@@ -216,6 +288,9 @@ struct ServerInfo : public ObjectCounter<ServerInfo>
 	char name[32];
 	int waitingplayers;
 	char description[192];
+	// false, if the server currently refuses new players (e.g. because it is overloaded).
+	// Not part of the packet, set when the server sent ID_SERVER_BUSY.
+	bool acceptsplayers;
 
 	static const size_t BLOBBY_SERVER_PRESENT_PACKET_SIZE;
 };
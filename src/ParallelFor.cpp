@@ -0,0 +1,76 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ParallelFor.h"
+
+/* includes */
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* implementation */
+
+void parallelFor(int count, const std::function<void(int)>& job)
+{
+	parallelFor(count, 0, [&job](int index, int) { job(index); });
+}
+
+void parallelFor(int count, int threads, const std::function<void(int, int)>& job)
+{
+	std::atomic<int> nextJob(0);
+	std::exception_ptr error;
+	std::mutex errorMutex;
+
+	auto worker = [&](int thread)
+	{
+		for (int index = nextJob++; index < count; index = nextJob++)
+		{
+			try
+			{
+				job(index, thread);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error)
+					error = std::current_exception();
+			}
+		}
+	};
+
+	if (threads <= 0)
+		threads = std::thread::hardware_concurrency();
+
+	// the calling thread works too, so a single core doesn't start any thread
+	int threadCount = std::min(threads, count) - 1;
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threadCount; ++i)
+		workers.emplace_back(worker, i + 1);
+	worker(0);
+	for (auto& thread : workers)
+		thread.join();
+
+	if (error)
+		std::rethrow_exception(error);
+}
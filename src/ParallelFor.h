@@ -0,0 +1,33 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <functional>
+
+/// \brief runs job(0) to job(count - 1) on all cores and returns when all of them are done.
+/// \details The jobs must not depend on each other. If jobs throw, the first exception is
+///			rethrown on the calling thread after the remaining jobs finished.
+void parallelFor(int count, const std::function<void(int)>& job);
+
+/// \brief runs job(index, thread) for index 0 to count - 1 on at most \p threads threads.
+/// \details \p threads 0 uses all cores. thread is below the number of threads, and jobs with the
+///			same thread run one after another, so they can share per-thread resources.
+void parallelFor(int count, int threads, const std::function<void(int, int)>& job);
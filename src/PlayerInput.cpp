@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "PlayerInput.h"
 
 /* includes */
+#include <algorithm>
 #include <ostream>
 #include <cassert>
 
@@ -98,6 +99,11 @@ void PlayerInputAbs::setJump( bool v)
 		mFlags &= ~F_JUMP;
 }
 
+bool PlayerInputAbs::getJump() const
+{
+	return mFlags & F_JUMP;
+}
+
 void PlayerInputAbs::setTarget( short target, PlayerSide player )
 {
 	mFlags &= F_JUMP;	// reset everything but the jump flag, i.e. no left/right and no relative
@@ -155,6 +161,65 @@ void PlayerInputAbs::writeTo(RakNet::BitStream& stream) const
 	stream.Write( mTarget );
 }
 
+bool PlayerInputAbs::operator==(const PlayerInputAbs& other) const
+{
+	return mFlags == other.mFlags && mTarget == other.mTarget;
+}
+
+/* input history */
+void writeInputHistory(RakNet::BitStream& stream, const std::deque<TimedInput>& history)
+{
+	assert( !history.empty() );
+	assert( history.size() <= INPUT_HISTORY_LENGTH );
+
+	// newest frame first, then runs of equal input going back in time
+	std::vector<std::pair<unsigned char, PlayerInputAbs>> runs;
+	for(auto input = history.rbegin(); input != history.rend(); ++input)
+	{
+		if( !runs.empty() && runs.back().second == input->input && runs.back().first < 255 )
+			++runs.back().first;
+		else
+			runs.emplace_back( 1, input->input );
+	}
+
+	stream.Write( history.back().frame );
+	stream.Write( (unsigned char)runs.size() );
+	for(const auto& run : runs)
+	{
+		stream.Write( run.first );
+		run.second.writeTo( stream );
+	}
+}
+
+bool readInputHistory(RakNet::BitStream& stream, std::vector<TimedInput>& history)
+{
+	unsigned frame;
+	unsigned char runCount;
+	if( !stream.Read(frame) || !stream.Read(runCount) )
+		return false;
+
+	history.clear();
+	// signed, so a run reaching below frame 0 can be detected
+	long long next = frame;
+	for(int i = 0; i < runCount; ++i)
+	{
+		unsigned char length;
+		if( !stream.Read(length) || stream.GetNumberOfUnreadBits() < 24 )
+			return false;
+
+		// a client never sends empty runs or more than its history
+		if( length == 0 || history.size() + length > INPUT_HISTORY_LENGTH || length > next + 1 )
+			return false;
+
+		PlayerInputAbs input(stream);
+		for(int j = 0; j < length; ++j)
+			history.push_back( TimedInput{unsigned(next--), input} );
+	}
+
+	std::reverse(history.begin(), history.end());
+	return true;
+}
+
 
 std::ostream& operator<< (std::ostream& out, const PlayerInput& input)
 {
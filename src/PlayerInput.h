@@ -23,6 +23,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <string>
 #include <iosfwd>
+#include <deque>
+#include <vector>
 #include "BlobbyDebug.h"
 #include "Global.h"
 
@@ -74,6 +76,8 @@ class PlayerInputAbs
 		void setRight( bool v );
 		void setJump( bool v);
 
+		bool getJump() const;
+
 		void setTarget( short target, PlayerSide player );
 
 		void swapSides();
@@ -85,6 +89,8 @@ class PlayerInputAbs
 		// send via network
 		void writeTo(RakNet::BitStream& stream) const;
 
+		bool operator==(const PlayerInputAbs& other) const;
+
 
 	private:
 		enum Flags
@@ -98,6 +104,24 @@ class PlayerInputAbs
 		short mTarget;
 };
 
+/*! \struct TimedInput
+	\brief input of a single client frame, as sent in ID_INPUT_HISTORY
+*/
+struct TimedInput
+{
+	unsigned frame;
+	PlayerInputAbs input;
+};
+
+// frames of input a client repeats in every ID_INPUT_HISTORY packet
+const unsigned INPUT_HISTORY_LENGTH = 16;
+
+// writes the inputs of consecutive frames, oldest first, run length encoded to a stream
+void writeInputHistory(RakNet::BitStream& stream, const std::deque<TimedInput>& history);
+// reads inputs written by writeInputHistory, oldest first. Returns false if the stream is invalid,
+// holds more than INPUT_HISTORY_LENGTH frames or frames before frame 0.
+bool readInputHistory(RakNet::BitStream& stream, std::vector<TimedInput>& history);
+
 // This operator converts a PlayerInput structure in a packed string
 // suitable for saving
 
@@ -22,6 +22,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "RenderManager.h"
 
 /* includes */
+#include <algorithm>
+
 #include "FileRead.h"
 #include "Blood.h"
 #include "IUserConfigReader.h"
@@ -33,18 +35,29 @@ RenderManager* RenderManager::mSingleton = nullptr;
 
 RenderManager::~RenderManager() = default;
 
-RenderManager::RenderManager() :
-	mDrawGame(false),
-	mBloodMgr(new BloodManager(IUserConfigReader::createUserConfigReader("config.xml")->getBool("blood")))
+RenderManager::RenderManager() : RenderManager(true)
+{
+}
+
+RenderManager::RenderManager(bool singleton) :
+	mDrawGame(false)
 {
+	auto config = IUserConfigReader::createUserConfigReader("config.xml");
+	int bloodParticles = config->getInteger("blood_particles", DEFAULT_BLOOD_PARTICLES);
+	bloodParticles = std::min(std::max(bloodParticles, 0), MAX_BLOOD_PARTICLES);
+	mBloodMgr.reset(new BloodManager(config->getBool("blood"), bloodParticles));
+
 	//assert(!mSingleton);
-	if (mSingleton)
+	if (singleton)
 	{
-		mSingleton->deinit();
-		delete mSingleton;
-	}
+		if (mSingleton)
+		{
+			mSingleton->deinit();
+			delete mSingleton;
+		}
 
-	mSingleton = this;
+		mSingleton = this;
+	}
 	mMouseMarkerPosition = -100.0;
 	mNeedRedraw = true;
 }
@@ -92,6 +105,43 @@ SDL_Surface* RenderManager::highlightSurface(SDL_Surface* surface, int luminance
 	return newSurface;
 }
 
+SDL_Surface* RenderManager::createSpriteSurface(SDL_Surface* surface, Uint8 alpha, Uint32 format)
+{
+	SDL_Surface* formatedSurface = SDL_ConvertSurfaceFormat(surface, format, 0);
+	const SDL_PixelFormat* pixelFormat = formatedSurface->format;
+	const Uint32 colorMask = pixelFormat->Rmask | pixelFormat->Gmask | pixelFormat->Bmask;
+
+	Uint32* pixels = (Uint32*)formatedSurface->pixels;
+	for(int j = 0; j < formatedSurface->w * formatedSurface->h; j++)
+	{
+		pixels[j] &= colorMask;
+		if(pixels[j])
+			pixels[j] |= Uint32(alpha) << pixelFormat->Ashift;
+	}
+
+	return formatedSurface;
+}
+
+SDL_Surface* RenderManager::createSpecularSurface(SDL_Surface* surface, Uint32 format)
+{
+	SDL_Surface* formatedSurface = SDL_ConvertSurfaceFormat(surface, format, 0);
+	const SDL_PixelFormat* pixelFormat = formatedSurface->format;
+
+	Uint32* pixels = (Uint32*)formatedSurface->pixels;
+	for(int j = 0; j < formatedSurface->w * formatedSurface->h; j++)
+	{
+		// the bright parts of the blob shine white, whatever its color is
+		int red = (pixels[j] & pixelFormat->Rmask) >> pixelFormat->Rshift;
+		int luminance = red * 5 - 4 * 256 - 138;
+		luminance = luminance > 0 ? luminance : 0;
+		luminance = luminance < 255 ? luminance : 255;
+		pixels[j] = luminance ? Uint32(luminance) << pixelFormat->Rshift | Uint32(luminance) << pixelFormat->Gshift |
+				Uint32(luminance) << pixelFormat->Bshift | Uint32(255) << pixelFormat->Ashift : 0;
+	}
+
+	return formatedSurface;
+}
+
 SDL_Surface* RenderManager::loadSurface(const std::string& filename)
 {
 	FileRead file(filename);
@@ -342,6 +392,14 @@ void RenderManager::redraw()
 	mNeedRedraw = true;
 }
 
+void RenderManager::drawParticles(const float* x, const float* y, const unsigned char* player, int count)
+{
+	startDrawParticles();
+	for (int i = 0; i < count; ++i)
+		drawParticle(Vector2(x[i], y[i]), player[i]);
+	endDrawParticles();
+}
+
 void RenderManager::drawGame(bool draw)
 {
 	mDrawGame = draw;
@@ -142,6 +142,9 @@ class RenderManager : public ObjectCounter<RenderManager>
 
 		virtual void showShadow(bool shadow) {};
 
+		// Shows the number of draw calls per frame, if the renderer counts them
+		virtual void showDrawCalls(bool show) {};
+
 		// Takes the new balls position and its rotation in radians
 		virtual void setBall(const Vector2& position, float rotation) {};
 
@@ -173,6 +176,9 @@ class RenderManager : public ObjectCounter<RenderManager>
 		virtual void drawParticle(const Vector2& pos, int player){};
 		// Finishes drawing particles
 		virtual void endDrawParticles() {};
+		// Draws count blood particles at once. The default implementation
+		// draws them one by one with drawParticle.
+		virtual void drawParticles(const float* x, const float* y, const unsigned char* player, int count);
 
 		// This forces a redraw of the background, for example
 		// when the windows was minimized
@@ -189,10 +195,18 @@ class RenderManager : public ObjectCounter<RenderManager>
 		SDL_Window* getWindow();
 	protected:
 		RenderManager();
+		// Renderers which don't draw to the screen, e.g. in worker threads of tools, may
+		// leave the singleton alone
+		explicit RenderManager(bool singleton);
 		// Returns -1 on EOF
 		// Returns index for ? on unknown char
 		int getNextFontIndex(std::string::const_iterator& iter);
 		SDL_Surface* highlightSurface(SDL_Surface* surface, int luminance);
+		// converts a sprite to a 32 bit format with black as transparent color, the input is kept.
+		// These two don't use a renderer, so they can run on any thread.
+		static SDL_Surface* createSpriteSurface(SDL_Surface* surface, Uint8 alpha, Uint32 format = SDL_PIXELFORMAT_ABGR8888);
+		// creates the image which is added to a blob for its specular highlights
+		static SDL_Surface* createSpecularSurface(SDL_Surface* surface, Uint32 format = SDL_PIXELFORMAT_ABGR8888);
 		SDL_Surface* loadSurface(const std::string& filename);
 		SDL_Surface* createEmptySurface(unsigned int width, unsigned int height);
 
@@ -24,9 +24,27 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #if HAVE_LIBGL
 
 /* includes */
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
 #include "FileExceptions.h"
+#include "ParallelFor.h"
+#include "StartupProfile.h"
 
 /* implementation */
+namespace
+{
+	// width of the sprite atlas. Its height is chosen as needed.
+	const int ATLAS_WIDTH = 1024;
+	// free space around each sprite, so filtering never picks up a neighbour
+	const int ATLAS_PADDING = 1;
+}
+
+RenderManagerGL2D::Texture::Texture() : indices{}, w(0), h(0), texture(0)
+{
+}
+
 RenderManagerGL2D::Texture::Texture( GLuint tex, int x, int y, int width, int height, int tw, int th ) :
 		w(width), h(height), texture(tex)
 {
@@ -86,7 +104,7 @@ int RenderManagerGL2D::getNextPOT(int npot)
 	return pot;
 }
 
-GLuint RenderManagerGL2D::loadTexture(SDL_Surface *surface, bool specular)
+GLuint RenderManagerGL2D::loadTexture(SDL_Surface *surface)
 {
 	SDL_Surface* textureSurface;
 	SDL_Surface* convertedTexture;
@@ -117,15 +135,43 @@ GLuint RenderManagerGL2D::loadTexture(SDL_Surface *surface, bool specular)
 #endif
 	SDL_BlitSurface(textureSurface, nullptr, convertedTexture, &targetRect);
 
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8,
+			convertedTexture->w, convertedTexture->h, 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, convertedTexture->pixels);
+	SDL_FreeSurface(textureSurface);
+	SDL_FreeSurface(convertedTexture);
+
+	return texture;
+}
+
+SDL_Surface* RenderManagerGL2D::convertSprite(SDL_Surface* surface, bool specular)
+{
+	SDL_SetColorKey(surface, SDL_TRUE, SDL_MapRGB(surface->format, 0, 0, 0));
+	SDL_Surface* converted =
+		SDL_CreateRGBSurface(SDL_SWSURFACE,
+			surface->w, surface->h, 32,
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+			0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+#else
+			0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+#endif
+	SDL_BlitSurface(surface, nullptr, converted, nullptr);
+	SDL_FreeSurface(surface);
+
 	if (specular)
 	{
-		for (int y = 0; y < convertedTexture->h; ++y)
+		for (int y = 0; y < converted->h; ++y)
 		{
-			for (int x = 0; x < convertedTexture->w; ++x)
+			for (int x = 0; x < converted->w; ++x)
 			{
 				SDL_Color* pixel =
-					&(((SDL_Color*)convertedTexture->pixels)
-					[y * convertedTexture->w +x]);
+					&(((SDL_Color*)converted->pixels)
+					[y * converted->w +x]);
 				int luminance = int(pixel->r) * 5 - 4 * 256 - 138;
 				luminance = luminance > 0 ? luminance : 0;
 				luminance = luminance < 255 ? luminance : 255;
@@ -136,63 +182,123 @@ GLuint RenderManagerGL2D::loadTexture(SDL_Surface *surface, bool specular)
 		}
 	}
 
-	GLuint texture;
-	glGenTextures(1, &texture);
-	glBindTexture(texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8,
-			convertedTexture->w, convertedTexture->h, 0, GL_RGBA,
-			GL_UNSIGNED_BYTE, convertedTexture->pixels);
-	SDL_FreeSurface(textureSurface);
-	SDL_FreeSurface(convertedTexture);
-
-	return texture;
+	return converted;
 }
 
-void RenderManagerGL2D::drawQuad(float x, float y, float w, float h)
+std::vector<RenderManagerGL2D::Texture> RenderManagerGL2D::buildAtlas(const std::vector<SDL_Surface*>& sprites)
 {
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	// place the sprites in rows
+	std::vector<SDL_Rect> places;
+	int x = 0;
+	int y = 0;
+	int rowHeight = 0;
+	for (auto sprite : sprites)
+	{
+		if (x + sprite->w + ATLAS_PADDING > ATLAS_WIDTH)
+		{
+			x = 0;
+			y += rowHeight;
+			rowHeight = 0;
+		}
 
-	GLfloat vertices[] = {x - w / 2.f, y - h / 2.f,
-	                      x + w / 2.f, y - h / 2.f,
-	                      x + w / 2.f, y + h / 2.f,
-	                      x - w / 2.f, y + h / 2.f};
+		places.push_back( SDL_Rect{x, y, sprite->w, sprite->h} );
+		x += sprite->w + ATLAS_PADDING;
+		rowHeight = std::max(rowHeight, sprite->h + ATLAS_PADDING);
+	}
+	int height = getNextPOT(y + rowHeight);
 
-	GLfloat texCoords[] = {0.f, 0.f,
-	                       1.f, 0.f,
-	                       1.f, 1.f,
-	                       0.f, 1.f};
+	SDL_Surface* atlas =
+		SDL_CreateRGBSurface(SDL_SWSURFACE,
+			ATLAS_WIDTH, height, 32,
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+			0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+#else
+			0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+#endif
+
+	glGenTextures(1, &mAtlas);
+
+	std::vector<Texture> textures;
+	for (unsigned int i = 0; i < sprites.size(); ++i)
+	{
+		// copy the alpha channel as it is
+		SDL_SetSurfaceBlendMode(sprites[i], SDL_BLENDMODE_NONE);
+		SDL_BlitSurface(sprites[i], nullptr, atlas, &places[i]);
+		textures.emplace_back(mAtlas, places[i].x, places[i].y, sprites[i]->w, sprites[i]->h, ATLAS_WIDTH, height);
+		SDL_FreeSurface(sprites[i]);
+	}
 
-	glVertexPointer(2, GL_FLOAT, 0, vertices);
-	glTexCoordPointer(2, GL_FLOAT, 0, texCoords);
-	glDrawArrays(GL_QUADS, 0, 4);
+	glBindTexture(mAtlas);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_WIDTH, height, 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, atlas->pixels);
+	SDL_FreeSurface(atlas);
 
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	return textures;
 }
 
-void RenderManagerGL2D::drawQuad(float x, float y, const Texture& tex) {
-	glBindTexture(tex.texture);
+void RenderManagerGL2D::addQuad(float x, float y, const Texture& tex, DrawMode mode, Color color, GLubyte alpha)
+{
+	addQuad(x, y, tex.w, tex.h, tex, mode, color, alpha);
+}
 
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+void RenderManagerGL2D::addQuad(float x, float y, float w, float h, const Texture& tex, DrawMode mode, Color color, GLubyte alpha)
+{
+	if (tex.texture != mBatchTexture || mode != mBatchMode)
+	{
+		flush();
+		mBatchTexture = tex.texture;
+		mBatchMode = mode;
+	}
 
-	float w = tex.w;
-	float h = tex.h;
+	const float corners[] = {x - w / 2.f, y - h / 2.f,
+	                         x + w / 2.f, y - h / 2.f,
+	                         x + w / 2.f, y + h / 2.f,
+	                         x - w / 2.f, y + h / 2.f};
 
-	GLfloat vertices[] = {x - w / 2.f, y - h / 2.f,
-	                      x + w / 2.f, y - h / 2.f,
-	                      x + w / 2.f, y + h / 2.f,
-	                      x - w / 2.f, y + h / 2.f};
+	for (int i = 0; i < 4; ++i)
+	{
+		mVertices.push_back( Vertex{corners[2 * i], corners[2 * i + 1], tex.indices[2 * i], tex.indices[2 * i + 1],
+									{color.r, color.g, color.b, alpha}} );
+	}
+}
 
-	glVertexPointer(2, GL_FLOAT, 0, vertices);
-	glTexCoordPointer(2, GL_FLOAT, 0, tex.indices);
-	glDrawArrays(GL_QUADS, 0, 4);
+void RenderManagerGL2D::flush()
+{
+	if (mVertices.empty())
+		return;
 
-	glDisableClientState(GL_VERTEX_ARRAY);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	switch (mBatchMode)
+	{
+		case DrawMode::SOLID:
+			glDisable(GL_ALPHA_TEST);
+			glDisable(GL_BLEND);
+			break;
+		case DrawMode::MASKED:
+			glEnable(GL_ALPHA_TEST);
+			glDisable(GL_BLEND);
+			break;
+		case DrawMode::TRANSLUCENT:
+			glDisable(GL_ALPHA_TEST);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			break;
+		case DrawMode::ADDITIVE:
+			glEnable(GL_ALPHA_TEST);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+			break;
+	}
+	glBindTexture(mBatchTexture);
+
+	glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &mVertices[0].u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), mVertices[0].color);
+	glDrawArrays(GL_QUADS, 0, mVertices.size());
+
+	mVertices.clear();
+	++mDrawCalls;
 }
 
 RenderManagerGL2D::RenderManagerGL2D() = default;
@@ -241,77 +347,115 @@ void RenderManagerGL2D::init(int xResolution, int yResolution, bool fullscreen)
 	mRightBlobColor = Color(0, 255, 0);
 	glEnable(GL_TEXTURE_2D);
 
-	// Load background
-	SDL_Surface* bgSurface = loadSurface("backgrounds/strand2.bmp");
-	BufferedImage* bgBufImage = new BufferedImage;
-	bgBufImage->w = getNextPOT(bgSurface->w);
-	bgBufImage->h = getNextPOT(bgSurface->h);
-	bgBufImage->glHandle = loadTexture(bgSurface, false);
-	mBackground = bgBufImage->glHandle;
-	mImageMap["background"] = bgBufImage;
+	mBatchTexture = 0;
+	mBatchMode = DrawMode::SOLID;
+	mDrawCalls = 0;
+	mLastDrawCalls = 0;
+	mShowDrawCalls = false;
+
+	StartupProfile::endPhase("OpenGL window");
+
+	// collect all sprites for the atlas. The order has to match the distribution below.
+	// Decoding and converting them is independent for each file, so it is done in parallel,
+	// only the upload to the GL context stays on this thread.
+	const int SPRITE_COUNT = 1 + 1 + 16 + 3 * 5 + 2 * 59 + 1;
+	std::vector<SDL_Surface*> sprites(SPRITE_COUNT, nullptr);
+	SDL_Surface* bgSurface = nullptr;
+	std::vector<std::function<void()>> jobs;
+
+	jobs.push_back([&]() { bgSurface = loadSurface("backgrounds/strand2.bmp"); });
 
-	mBallShadow = loadTexture(loadSurface("gfx/schball.bmp"), false);
+	int slot = 0;
+	SDL_Surface* white = createEmptySurface(4, 4);
+	SDL_FillRect(white, nullptr, SDL_MapRGB(white->format, 255, 255, 255));
+	sprites[slot++] = convertSprite(white, false);
+
+	auto addSprite = [&](const std::string& filename, bool specular)
+	{
+		const int index = slot++;
+		jobs.push_back([this, &sprites, index, filename, specular]() {
+			sprites[index] = convertSprite(loadSurface(filename), specular);
+		});
+	};
+
+	addSprite("gfx/schball.bmp", false);
 
 	for (int i = 1; i <= 16; ++i)
 	{
 		char filename[64];
 		sprintf(filename, "gfx/ball%02d.bmp", i);
-		GLuint ballImage = loadTexture(loadSurface(filename), false);
-		mBall.push_back(ballImage);
+		addSprite(filename, false);
 	}
 
 	for (int i = 1; i <= 5; ++i)
 	{
 		char filename[64];
 		sprintf(filename, "gfx/blobbym%d.bmp", i);
-		GLuint blobImage = loadTexture(loadSurface(filename), false);
-		mBlob.push_back(blobImage);
-		sprintf(filename, "gfx/blobbym%d.bmp", i);
-		GLuint blobSpecular = loadTexture(loadSurface(filename), true);
-		mBlobSpecular.push_back(blobSpecular);
+		addSprite(filename, false);
+		addSprite(filename, true);
 		sprintf(filename, "gfx/sch1%d.bmp", i);
-		GLuint blobShadow = loadTexture(loadSurface(filename), false);
-		mBlobShadow.push_back(blobShadow);
+		addSprite(filename, false);
 	}
 
-	// create text base textures
-	SDL_Surface* textbase = createEmptySurface(2048, 32);
-	SDL_Surface* hltextbase = createEmptySurface(2048, 32);
-
-	int x = 0;
-	int sx = 0;
-
 	for (int i = 0; i <= 58; ++i)
 	{
 		char filename[64];
 		sprintf(filename, "gfx/font%02d.bmp", i);
-		SDL_Surface* fontSurface = loadSurface(filename);
+		const int index = slot;
+		slot += 2;
+		const std::string fontFile = filename;
+		jobs.push_back([this, &sprites, index, fontFile]() {
+			SDL_Surface* fontSurface = loadSurface(fontFile);
+			SDL_Surface* highlight = highlightSurface(fontSurface, 60);
+			sprites[index] = convertSprite(fontSurface, false);
+			sprites[index + 1] = convertSprite(highlight, false);
+		});
+	}
 
-		SDL_Surface* highlight = highlightSurface(fontSurface, 60);
+	addSprite("gfx/blood.bmp", false);
+	assert(slot == SPRITE_COUNT);
 
-		SDL_Rect r = {(Uint16)x, 0, (Uint16)fontSurface->w, (Uint16)fontSurface->h};
-		SDL_BlitSurface(fontSurface, nullptr, textbase, &r);
-		SDL_BlitSurface(highlight, nullptr, hltextbase, &r);
-		r.x = sx;
-		r.y = 0;
-		Texture s = Texture(0, x, 0, fontSurface->w, fontSurface->h, 2048, 32);
-		mFont.push_back(s);
-		mHighlightFont.push_back(s);
+	try
+	{
+		parallelFor(jobs.size(), [&jobs](int job) { jobs[job](); });
+	}
+	catch (...)
+	{
+		for (auto sprite : sprites)
+			SDL_FreeSurface(sprite);
+		SDL_FreeSurface(bgSurface);
+		throw;
+	}
+	StartupProfile::endPhase("decode sprites");
 
-		x += fontSurface->w;
+	// Load background
+	BufferedImage* bgBufImage = new BufferedImage;
+	bgBufImage->w = getNextPOT(bgSurface->w);
+	bgBufImage->h = getNextPOT(bgSurface->h);
+	bgBufImage->glHandle = loadTexture(bgSurface);
+	mBackground = Texture(bgBufImage->glHandle, 0, 0, bgBufImage->w, bgBufImage->h, bgBufImage->w, bgBufImage->h);
+	mImageMap["background"] = bgBufImage;
 
-		SDL_FreeSurface(fontSurface);
+	std::vector<Texture> textures = buildAtlas(sprites);
+	auto texture = textures.begin();
+	mWhite = *texture++;
+	mBallShadow = *texture++;
+	for (int i = 1; i <= 16; ++i)
+		mBall.push_back(*texture++);
+	for (int i = 1; i <= 5; ++i)
+	{
+		mBlob.push_back(*texture++);
+		mBlobSpecular.push_back(*texture++);
+		mBlobShadow.push_back(*texture++);
 	}
-
-	GLuint texture =  loadTexture(textbase, false);
-	GLuint hltexture =  loadTexture(hltextbase, false);
-	for (unsigned int i = 0; i < mFont.size(); ++i)
+	for (int i = 0; i <= 58; ++i)
 	{
-		mFont[i].texture = texture;
-		mHighlightFont[i].texture = hltexture;
+		mFont.push_back(*texture++);
+		mHighlightFont.push_back(*texture++);
 	}
-
-	mParticle = loadTexture(loadSurface("gfx/blood.bmp"), false);
+	mParticle = *texture++;
+	assert(texture == textures.end());
+	StartupProfile::endPhase("upload sprites");
 
 	glViewport(0, 0, xResolution, yResolution);
 	glMatrixMode(GL_PROJECTION);
@@ -324,26 +468,22 @@ void RenderManagerGL2D::init(int xResolution, int yResolution, bool fullscreen)
 
 	glAlphaFunc(GL_GREATER, 0.5);
 	glEnable(GL_ALPHA_TEST);
+
+	// everything is drawn from vertex arrays
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
 }
 
 void RenderManagerGL2D::deinit()
 {
-	glDeleteTextures(1, &mBackground);
-	glDeleteTextures(mBall.size(), &mBall[0]);
-	glDeleteTextures(1, &mBallShadow);
-	glDeleteTextures(mBlob.size(), &mBlob[0]);
-	glDeleteTextures(mBlobSpecular.size(), &mBlobSpecular[0]);
-	glDeleteTextures(mBlobShadow.size(), &mBlobShadow[0]);
-	glDeleteTextures(1/*mFont.size()*/, &mFont[0].texture);
-	glDeleteTextures(/*mHighlightFont.size()*/1, &mHighlightFont[0].texture);
+	glDeleteTextures(1, &mAtlas);
 
 	for (auto& iter : mImageMap) {
 		glDeleteTextures(1, &iter.second->glHandle);
 		delete iter.second;
 	}
 
-	glDeleteTextures(1, &mParticle);
-
 	SDL_GL_DeleteContext(mGlContext);
 	SDL_DestroyWindow(mWindow);
 }
@@ -354,111 +494,43 @@ void RenderManagerGL2D::draw()
 		return;
 
 	// Background
-	glDisable(GL_ALPHA_TEST);
-	glColor4f(1.0, 1.0, 1.0, 1.0);
-	glBindTexture(mBackground);
-	glLoadIdentity();
-	drawQuad(400.0, 300.0, 1024.0, 1024.0);
-
+	addQuad(400.0, 300.0, mBackground, DrawMode::SOLID);
 
 	if(mShowShadow)
 	{
-		// Generic shadow settings
-
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glEnable(GL_BLEND);
-
 		// Blob shadows
 		Vector2 pos;
 
 		pos = blobShadowPosition(mLeftBlobPosition);
-		glColor4ub(mLeftBlobColor.r, mLeftBlobColor.g, mLeftBlobColor.b, 128);
-		glBindTexture(mBlobShadow[int(mLeftBlobAnimationState)  % 5]);
-		drawQuad(pos.x, pos.y, 128.0, 32.0);
+		addQuad(pos.x, pos.y, mBlobShadow[int(mLeftBlobAnimationState)  % 5], DrawMode::TRANSLUCENT, mLeftBlobColor, 128);
 
 		pos = blobShadowPosition(mRightBlobPosition);
-		glColor4ub(mRightBlobColor.r, mRightBlobColor.g, mRightBlobColor.b, 128);
-		glBindTexture(mBlobShadow[int(mRightBlobAnimationState)  % 5]);
-		drawQuad(pos.x, pos.y, 128.0, 32.0);
+		addQuad(pos.x, pos.y, mBlobShadow[int(mRightBlobAnimationState)  % 5], DrawMode::TRANSLUCENT, mRightBlobColor, 128);
 
 		// Ball shadow
 		pos = ballShadowPosition(mBallPosition);
-		glColor4f(1.0, 1.0, 1.0, 0.5);
-		glBindTexture(mBallShadow);
-		drawQuad(pos.x, pos.y, 128.0, 32.0);
-
-		glDisable(GL_BLEND);
+		addQuad(pos.x, pos.y, mBallShadow, DrawMode::TRANSLUCENT, Color(255, 255, 255), 128);
 	}
 
-	glEnable(GL_ALPHA_TEST);
-
-	// General object settings
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 	// The Ball
-
-	glColor4f(1.0, 1.0, 1.0, 1.0);
-	glBindTexture(mBall[int(mBallRotation / M_PI / 2 * 16) % 16]);
-/*
-	float opacity = 0.0;
-	for (std::list<Vector2>::iterator iter = mLastBallStates.begin();
-		iter != mLastBallStates.end(); ++iter)
-	{
-//		glColor4f(1.0 / MotionBlurIterations,
-//			1.0 / MotionBlurIterations, 1.0 / MotionBlurIterations, 1.0 - opacity);
-		glColor4f(1.0, 1.0, 1.0, opacity);
-
-
-		Vector2& ballPosition = *iter;
-*/
-		drawQuad(mBallPosition.x, mBallPosition.y, 64.0, 64.0);
-
-/*
-		opacity += 0.1;
-	}
-	if (mLastBallStates.size() > MotionBlurIterations)
-			mLastBallStates.pop_back();
-	glDisable(GL_BLEND);
-*/
+	addQuad(mBallPosition.x, mBallPosition.y, mBall[int(mBallRotation / M_PI / 2 * 16) % 16], DrawMode::MASKED);
 
 	// blob normal
-	// left blob
-	glBindTexture(mBlob[int(mLeftBlobAnimationState)  % 5]);
-	glColor3ubv(mLeftBlobColor.val);
-	drawQuad(mLeftBlobPosition.x, mLeftBlobPosition.y, 128.0, 128.0);
-
-	// right blob
-	glBindTexture(mBlob[int(mRightBlobAnimationState)  % 5]);
-	glColor3ubv(mRightBlobColor.val);
-	drawQuad(mRightBlobPosition.x, mRightBlobPosition.y, 128.0, 128.0);
+	addQuad(mLeftBlobPosition.x, mLeftBlobPosition.y, mBlob[int(mLeftBlobAnimationState)  % 5], DrawMode::MASKED, mLeftBlobColor);
+	addQuad(mRightBlobPosition.x, mRightBlobPosition.y, mBlob[int(mRightBlobAnimationState)  % 5], DrawMode::MASKED, mRightBlobColor);
 
 	// blob specular
-	glEnable(GL_BLEND);
-	glColor4f(1.0, 1.0, 1.0, 1.0);
-	// left blob
-	glBindTexture(mBlobSpecular[int(mLeftBlobAnimationState)  % 5]);
-	drawQuad(mLeftBlobPosition.x, mLeftBlobPosition.y, 128.0, 128.0);
-
-	// right blob
-	glBindTexture(mBlobSpecular[int(mRightBlobAnimationState)  % 5]);
-	drawQuad(mRightBlobPosition.x, mRightBlobPosition.y, 128.0, 128.0);
-
-	glDisable(GL_BLEND);
-
+	addQuad(mLeftBlobPosition.x, mLeftBlobPosition.y, mBlobSpecular[int(mLeftBlobAnimationState)  % 5], DrawMode::ADDITIVE);
+	addQuad(mRightBlobPosition.x, mRightBlobPosition.y, mBlobSpecular[int(mRightBlobAnimationState)  % 5], DrawMode::ADDITIVE);
 
 	// Ball marker
-	glDisable(GL_ALPHA_TEST);
-	glDisable(GL_TEXTURE_2D);
 	GLubyte markerColor = SDL_GetTicks() % 1000 >= 500 ? 255 : 0;
-	glColor3ub(markerColor, markerColor, markerColor);
-	drawQuad(mBallPosition.x, 7.5, 5.0, 5.0);
+	addQuad(mBallPosition.x, 7.5, 5.0, 5.0, mWhite, DrawMode::SOLID, Color(markerColor, markerColor, markerColor));
 
 	// Mouse marker
 
 	// Position relativ zu BallMarker
-	drawQuad(mMouseMarkerPosition, 592.5, 5.0, 5.0);
-
-	glEnable(GL_TEXTURE_2D);
-	glEnable(GL_ALPHA_TEST);
+	addQuad(mMouseMarkerPosition, 592.5, 5.0, 5.0, mWhite, DrawMode::SOLID, Color(markerColor, markerColor, markerColor));
 }
 
 bool RenderManagerGL2D::setBackground(const std::string& filename)
@@ -466,13 +538,15 @@ bool RenderManagerGL2D::setBackground(const std::string& filename)
 	try
 	{
 		SDL_Surface* newSurface = loadSurface(filename);
-		glDeleteTextures(1, &mBackground);
+		// the old background might still be used by the current batch
+		flush();
+		glDeleteTextures(1, &mBackground.texture);
 		delete mImageMap["background"];
 		BufferedImage *imgBuffer = new BufferedImage;
 		imgBuffer->w = getNextPOT(newSurface->w);
 		imgBuffer->h = getNextPOT(newSurface->h);
-		imgBuffer->glHandle = loadTexture(newSurface, false);
-		mBackground = imgBuffer->glHandle;
+		imgBuffer->glHandle = loadTexture(newSurface);
+		mBackground = Texture(imgBuffer->glHandle, 0, 0, imgBuffer->w, imgBuffer->h, imgBuffer->w, imgBuffer->h);
 		mImageMap["background"] = imgBuffer;
 	}
 	catch (const FileLoadException&)
@@ -496,6 +570,11 @@ void RenderManagerGL2D::showShadow(bool shadow)
 	mShowShadow = shadow;
 }
 
+void RenderManagerGL2D::showDrawCalls(bool show)
+{
+	mShowDrawCalls = show;
+}
+
 void RenderManagerGL2D::setBall(const Vector2& position, float rotation)
 {
 	mBallPosition = position;
@@ -527,11 +606,6 @@ void RenderManagerGL2D::setBlob(int player, const Vector2& position, float anima
 
 void RenderManagerGL2D::drawText(const std::string& text, Vector2 position, unsigned int flags)
 {
-	glEnable(GL_TEXTURE_2D);
-	glEnable(GL_ALPHA_TEST);
-	glDisable(GL_BLEND);
-
-	glColor4f(1.0, 1.0, 1.0, 1.0);
 	int FontSize = (flags & TF_SMALL_FONT ? FONT_WIDTH_SMALL : FONT_WIDTH_NORMAL);
 
 	float x = position.x - (FontSize / 2);
@@ -546,45 +620,16 @@ void RenderManagerGL2D::drawText(const std::string& text, Vector2 position, unsi
 			index = FONT_INDEX_ASTERISK;
 
 		x += FontSize;
+		const Texture& glyph = (flags & TF_HIGHLIGHT) ? mHighlightFont[index] : mFont[index];
 		if (flags & TF_SMALL_FONT)
-		{
-			if (flags & TF_HIGHLIGHT)
-			{
-				int charWidth = mHighlightFont[index].w;
-				int charHeight = mHighlightFont[index].h;
-				mHighlightFont[index].w = FONT_WIDTH_SMALL;
-				mHighlightFont[index].h = FONT_WIDTH_SMALL;
-				drawQuad(x, y, mHighlightFont[index]);
-				mHighlightFont[index].w = charWidth;
-				mHighlightFont[index].h = charHeight;
-			}
-			else
-			{
-				int charWidth = mFont[index].w;
-				int charHeight = mFont[index].h;
-				mFont[index].w = FONT_WIDTH_SMALL;
-				mFont[index].h = FONT_WIDTH_SMALL;
-				drawQuad(x, y, mFont[index]);
-				mFont[index].w = charWidth;
-				mFont[index].h = charHeight;
-			}
-		}
+			addQuad(x, y, FONT_WIDTH_SMALL, FONT_WIDTH_SMALL, glyph, DrawMode::MASKED);
 		else
-		{
-			if (flags & TF_HIGHLIGHT)
-				drawQuad(x, y, mHighlightFont[index]);
-			else
-				drawQuad(x, y, mFont[index]);
-		}
+			addQuad(x, y, glyph, DrawMode::MASKED);
 	}
 }
 
 void RenderManagerGL2D::drawImage(const std::string& filename, Vector2 position, Vector2 size)
 {
-	glEnable(GL_TEXTURE_2D);
-	glEnable(GL_ALPHA_TEST);
-	glDisable(GL_BLEND);
-
 	BufferedImage* imageBuffer = mImageMap[filename];
 	if (!imageBuffer)
 	{
@@ -592,98 +637,67 @@ void RenderManagerGL2D::drawImage(const std::string& filename, Vector2 position,
 		SDL_Surface* newSurface = loadSurface(filename);
 		imageBuffer->w = getNextPOT(newSurface->w);
 		imageBuffer->h = getNextPOT(newSurface->h);
-		imageBuffer->glHandle = loadTexture(newSurface, false);
+		imageBuffer->glHandle = loadTexture(newSurface);
 		mImageMap[filename] = imageBuffer;
 	}
 
-	glColor4f(1.0, 1.0, 1.0, 1.0);
-	glDisable(GL_BLEND);
-	//glLoadIdentity();
-	//glTranslatef(position.x , position.y, 0.0);
-	glBindTexture(imageBuffer->glHandle);
-	drawQuad(position.x, position.y, imageBuffer->w, imageBuffer->h);
+	Texture image(imageBuffer->glHandle, 0, 0, imageBuffer->w, imageBuffer->h, imageBuffer->w, imageBuffer->h);
+	addQuad(position.x, position.y, image, DrawMode::MASKED);
 }
 
 void RenderManagerGL2D::drawOverlay(float opacity, Vector2 pos1, Vector2 pos2, Color col)
 {
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_ALPHA_TEST);
-	glEnable(GL_BLEND);
-
-	glColor4f(col.r, col.g, col.b, opacity);
-	//glLoadIdentity();
-	glBegin(GL_QUADS);
-		glVertex2f(pos1.x, pos1.y);
-		glVertex2f(pos1.x, pos2.y);
-		glVertex2f(pos2.x, pos2.y);
-		glVertex2f(pos2.x, pos1.y);
-	glEnd();
+	Vector2 center = (pos1 + pos2) / 2;
+	addQuad(center.x, center.y, pos2.x - pos1.x, pos2.y - pos1.y, mWhite, DrawMode::TRANSLUCENT, col, opacity * 255);
 }
 
 void RenderManagerGL2D::drawBlob(const Vector2& pos, const Color& col)
 {
-	glEnable(GL_TEXTURE_2D);
-	glEnable(GL_ALPHA_TEST);
-	glDisable(GL_BLEND);
-
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-
-	//glLoadIdentity();
-	//glTranslatef(pos.x, pos.y, 0.6);
-	glBindTexture(mBlob[0]);
-	glColor3ubv(col.val);
-	drawQuad(pos.x, pos.y, 128.0, 128.0);
-
-	glEnable(GL_BLEND);
-	glColor4f(1.0, 1.0, 1.0, 1.0);
-	glBindTexture(mBlobSpecular[0]);
-	drawQuad(pos.x, pos.y, 128.0, 128.0);
-	glDisable(GL_BLEND);
+	addQuad(pos.x, pos.y, mBlob[0], DrawMode::MASKED, col);
+	addQuad(pos.x, pos.y, mBlobSpecular[0], DrawMode::ADDITIVE);
 }
 
 void RenderManagerGL2D::startDrawParticles()
 {
-	glEnable(GL_TEXTURE_2D);
-	glEnable(GL_ALPHA_TEST);
-	glDisable(GL_BLEND);
-
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-	glBindTexture(mParticle);
-	glBegin(GL_QUADS);
+	// particles are batched like everything else
 }
 
 void RenderManagerGL2D::drawParticle(const Vector2& pos, int player)
 {
-	//glLoadIdentity();
-	//glTranslatef(pos.x, pos.y, 0.6);
-
+	Color color = Color(255, 0, 0);
 	if (player == LEFT_PLAYER)
-		glColor3ubv(mLeftBlobColor.val);
+		color = mLeftBlobColor;
 	if (player == RIGHT_PLAYER)
-		glColor3ubv(mRightBlobColor.val);
-	if (player > 1)
-		glColor3ubv(Color(255, 0, 0).val);
-
-	float w = 16.0;
-	float h = 16.0;
-	glTexCoord2f(0.0, 0.0);
-	glVertex2f(pos.x - w / 2.f, pos.y - h / 2.f);
-	glTexCoord2f(1.0, 0.0);
-	glVertex2f(pos.x + w / 2.f, pos.y - h / 2.f);
-	glTexCoord2f(1.0, 1.0);
-	glVertex2f(pos.x + w / 2.f, pos.y + h / 2.f);
-	glTexCoord2f(0.0, 1.0);
-	glVertex2f(pos.x - w / 2.f, pos.y + h / 2.f);
+		color = mRightBlobColor;
+
+	addQuad(pos.x, pos.y, mParticle, DrawMode::MASKED, color);
 }
 
 void RenderManagerGL2D::endDrawParticles()
 {
-	glEnd();
+}
+
+void RenderManagerGL2D::drawParticles(const float* x, const float* y, const unsigned char* player, int count)
+{
+	const Color colors[] = {mLeftBlobColor, mRightBlobColor, Color(255, 0, 0)};
+	mVertices.reserve(mVertices.size() + 4 * count);
+	for (int i = 0; i < count; ++i)
+		addQuad(x[i], y[i], mParticle, DrawMode::MASKED, colors[std::min<int>(player[i], 2)]);
 }
 
 void RenderManagerGL2D::refresh()
 {
+	if (mShowDrawCalls)
+	{
+		std::ostringstream calls;
+		calls << "draw calls " << mLastDrawCalls;
+		drawText(calls.str(), Vector2(8, 4), TF_SMALL_FONT);
+	}
+
+	flush();
+	mLastDrawCalls = mDrawCalls;
+	mDrawCalls = 0;
+
 	//std::cout << debugStateChanges << "\n";
 	SDL_GL_SwapWindow(mWindow);
 	debugStateChanges = 0;
@@ -56,6 +56,7 @@ class RenderManagerGL2D : public RenderManager
 		bool setBackground(const std::string& filename) override;
 		void setBlobColor(int player, Color color) override;
 		void showShadow(bool shadow) override;
+		void showDrawCalls(bool show) override;
 
 		void setBall(const Vector2& position, float rotation) override;
 		void setBlob(int player, const Vector2& position,
@@ -68,6 +69,7 @@ class RenderManagerGL2D : public RenderManager
 		void startDrawParticles() override;
 		void drawParticle(const Vector2& pos, int player) override;
 		void endDrawParticles() override;
+		void drawParticles(const float* x, const float* y, const unsigned char* player, int count) override;
 
 	private:
 		// Make sure this object is created before any opengl call
@@ -79,19 +81,47 @@ class RenderManagerGL2D : public RenderManager
 			float w, h ;
 			GLuint texture;
 
+			Texture();
 			Texture( GLuint tex, int x, int y, int w, int h, int tw, int th );
 		};
 
-		GLuint mBackground;
-		GLuint mBallShadow;
+		struct Vertex
+		{
+			GLfloat x, y;
+			GLfloat u, v;
+			GLubyte color[4];
+		};
 
-		std::vector<GLuint> mBall;
-		std::vector<GLuint> mBlob;
-		std::vector<GLuint> mBlobSpecular;
-		std::vector<GLuint> mBlobShadow;
+		// how quads are combined with the picture
+		enum class DrawMode
+		{
+			SOLID,			// replaces the picture
+			MASKED,			// transparent pixels are left out
+			TRANSLUCENT,	// blended with the vertex alpha
+			ADDITIVE		// added to the picture
+		};
+
+		// all sprites except background and images are packed into one texture
+		GLuint mAtlas;
+		Texture mBackground;
+		Texture mBallShadow;
+		Texture mWhite;	// untextured quads use this white area of the atlas
+
+		std::vector<Texture> mBall;
+		std::vector<Texture> mBlob;
+		std::vector<Texture> mBlobSpecular;
+		std::vector<Texture> mBlobShadow;
 		std::vector<Texture> mFont;
 		std::vector<Texture> mHighlightFont;
-		GLuint mParticle;
+		Texture mParticle;
+
+		// quads are collected until texture or draw mode change, and then drawn with one call
+		std::vector<Vertex> mVertices;
+		GLuint mBatchTexture;
+		DrawMode mBatchMode;
+		int mDrawCalls;
+		int mLastDrawCalls;
+		bool mShowDrawCalls;
 
 		std::list<Vector2> mLastBallStates;
 
@@ -107,9 +137,19 @@ class RenderManagerGL2D : public RenderManager
 		Color mLeftBlobColor;
 		Color mRightBlobColor;
 
-		void drawQuad(float x, float y, float width, float height);
-		void drawQuad(float x, float y, const Texture& tex);
-		GLuint loadTexture(SDL_Surface* surface, bool specular);
+		// adds a quad centered at x, y to the current batch
+		void addQuad(float x, float y, float width, float height, const Texture& tex, DrawMode mode,
+				Color color = Color(255, 255, 255), GLubyte alpha = 255);
+		void addQuad(float x, float y, const Texture& tex, DrawMode mode,
+				Color color = Color(255, 255, 255), GLubyte alpha = 255);
+		// draws the current batch
+		void flush();
+
+		GLuint loadTexture(SDL_Surface* surface);
+		// converts a sprite to RGBA with black as transparent color. Frees the input surface.
+		SDL_Surface* convertSprite(SDL_Surface* surface, bool specular);
+		// packs the sprites into mAtlas and frees them
+		std::vector<Texture> buildAtlas(const std::vector<SDL_Surface*>& sprites);
 		int getNextPOT(int npot);
 
 		void glEnable(unsigned int flag);
@@ -22,73 +22,35 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "RenderManagerSDL.h"
 
 /* includes */
+#include <algorithm>
+#include <functional>
+
 #include "FileExceptions.h"
+#include "ParallelFor.h"
+#include "StartupProfile.h"
 
 /* implementation */
-SDL_Surface* RenderManagerSDL::colorSurface(SDL_Surface *surface, Color color)
+namespace
 {
-	// Create new surface
-	SDL_Surface *newSurface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ABGR8888, 0);
-
-	SDL_LockSurface(newSurface);
-
-	SDL_Color pixel;
-
-	for (int p = 0; p < newSurface->w * newSurface->h; ++p)
-	{
-		SDL_GetRGBA(((Uint32*)newSurface->pixels)[p], 
-		              newSurface->format,
-		              &pixel.r,
-		              &pixel.g,
-		              &pixel.b,
-		              &pixel.a);
-
-		const bool colorkey = !(pixel.r | pixel.g | pixel.b);
-
-		if (colorkey)
-		{
-			pixel.r = 0;
-			pixel.g = 0;
-			pixel.b = 0;
-			pixel.a = 0;
-		}
-		else
-		{
-			int rr = (int(pixel.r) * int(color.r)) >> 8;
-			int rg = (int(pixel.g) * int(color.g)) >> 8;
-			int rb = (int(pixel.b) * int(color.b)) >> 8;
-			int fak = int(pixel.r) * 5 - 4 * 256 - 138;
-
-
-			if (fak > 0)
-			{
-				rr += fak;
-				rg += fak;
-				rb += fak;
-			}
-			rr = rr < 255 ? rr : 255;
-			rg = rg < 255 ? rg : 255;
-			rb = rb < 255 ? rb : 255;
-
-			// This is clamped to 1 because dark colors may would be
-			// colorkeyed otherwise
-			pixel.r = rr > 0 ? rr : 1;
-			pixel.g = rg > 0 ? rg : 1;
-			pixel.b = rb > 0 ? rb : 1;
-		}
-
-		((Uint32*)newSurface->pixels)[p] = SDL_MapRGBA(newSurface->format, 
-		                                               pixel.r, 
-		                                               pixel.g, 
-		                                               pixel.b, 
-		                                               pixel.a);
-	}
-	SDL_UnlockSurface(newSurface);
+	// number of text layouts that are kept before the cache is cleared
+	const unsigned int MAX_CACHED_TEXT_LAYOUTS = 512;
+	// flags which change the layout of a text
+	const unsigned int LAYOUT_FLAGS = TF_HIGHLIGHT | TF_SMALL_FONT | TF_OBFUSCATE;
+	// transparent space around each glyph of the font atlas, so scaled text never picks up a neighbour
+	const int ATLAS_PADDING = 1;
+}
 
-	// Use a black colorkey
-	SDL_SetColorKey(newSurface, SDL_TRUE, SDL_MapRGB(newSurface->format, 0, 0, 0));
+SDL_Texture* RenderManagerSDL::createTexture(SDL_Surface* surface, SDL_BlendMode mode)
+{
+	SDL_Texture* texture = SDL_CreateTexture(mRenderer,
+			SDL_PIXELFORMAT_ABGR8888,
+			SDL_TEXTUREACCESS_STATIC,
+			surface->w, surface->h);
+	SDL_SetTextureBlendMode(texture, mode);
+	SDL_UpdateTexture(texture, nullptr, surface->pixels, surface->pitch);
+	SDL_FreeSurface(surface);
 
-	return newSurface;
+	return texture;
 }
 
 RenderManagerSDL::RenderManagerSDL()
@@ -170,191 +132,183 @@ void RenderManagerSDL::init(int xResolution, int yResolution, bool fullscreen)
 	mMarker[1] = SDL_CreateTextureFromSurface(mRenderer, tmpSurface);
 	SDL_FreeSurface(tmpSurface);
 
-	// Load background
-	tmpSurface = loadSurface("backgrounds/strand2.bmp");
-	mBackground = SDL_CreateTextureFromSurface(mRenderer, tmpSurface);
-	BufferedImage* bgImage = new BufferedImage;
-	bgImage->w = tmpSurface->w;
-	bgImage->h = tmpSurface->h;
-	bgImage->sdlImage = mBackground;
-	SDL_FreeSurface(tmpSurface);
-	mImageMap["background"] = bgImage;
-
-	// Load ball
-	for (int i = 1; i <= 16; ++i)
+	StartupProfile::endPhase("SDL window");
+
+	// Decode and convert all images in parallel. Only the textures have to be
+	// created on this thread, as the renderer isn't thread safe.
+	SDL_Surface* backgroundSurface = nullptr;
+	SDL_Surface* ballSurfaces[16] = {};
+	SDL_Surface* ballShadowSurface = nullptr;
+	SDL_Surface* blobSurfaces[5] = {};
+	SDL_Surface* blobSpecularSurfaces[5] = {};
+	SDL_Surface* blobShadowSurfaces[5] = {};
+	SDL_Surface* flagSurface = nullptr;
+	SDL_Surface* fontSurfaces[59] = {};
+	SDL_Surface* highlightFontSurfaces[59] = {};
+	SDL_Surface* bloodSurface = nullptr;
+	std::vector<std::function<void()>> jobs;
+
+	jobs.push_back([&]() { backgroundSurface = loadSurface("backgrounds/strand2.bmp"); });
+
+	for (int i = 0; i < 16; ++i)
 	{
-		char filename[64];
-		sprintf(filename, "gfx/ball%02d.bmp", i);
-		tmpSurface = loadSurface(filename);
-		SDL_SetColorKey(tmpSurface, SDL_TRUE,
-				SDL_MapRGB(tmpSurface->format, 0, 0, 0));
+		jobs.push_back([this, &ballSurfaces, i]() {
+			char filename[64];
+			sprintf(filename, "gfx/ball%02d.bmp", i + 1);
+			ballSurfaces[i] = loadSurface(filename);
+			SDL_SetColorKey(ballSurfaces[i], SDL_TRUE, SDL_MapRGB(ballSurfaces[i]->format, 0, 0, 0));
+		});
+	}
 
-		SDL_Texture *ballTexture = SDL_CreateTextureFromSurface(mRenderer, tmpSurface);
-		SDL_FreeSurface(tmpSurface);
-		mBall.push_back(ballTexture);
+	jobs.push_back([&]() {
+		ballShadowSurface = loadSurface("gfx/schball.bmp");
+		SDL_SetColorKey(ballShadowSurface, SDL_TRUE, SDL_MapRGB(ballShadowSurface->format, 0, 0, 0));
+		SDL_SetSurfaceAlphaMod(ballShadowSurface, 127);
+	});
+
+	for (int i = 0; i < 5; ++i)
+	{
+		jobs.push_back([&, i]() {
+			char filename[64];
+			sprintf(filename, "gfx/blobbym%d.bmp", i + 1);
+			SDL_Surface* blobImage = loadSurface(filename);
+			blobSurfaces[i] = createSpriteSurface(blobImage, 255);
+			blobSpecularSurfaces[i] = createSpecularSurface(blobImage);
+			SDL_FreeSurface(blobImage);
+
+			sprintf(filename, "gfx/sch1%d.bmp", i + 1);
+			SDL_Surface* blobShadow = loadSurface(filename);
+			blobShadowSurfaces[i] = createSpriteSurface(blobShadow, 127);
+			SDL_FreeSurface(blobShadow);
+		});
 	}
 
-	// Load ball shadow
-	tmpSurface = loadSurface("gfx/schball.bmp");
-	SDL_SetColorKey(tmpSurface, SDL_TRUE,
-			SDL_MapRGB(tmpSurface->format, 0, 0, 0));
+#if !BLOBBY_FEATURE_HAS_BACKBUTTON
+	jobs.push_back([&]() {
+		flagSurface = loadSurface("gfx/flag.bmp");
+		SDL_SetColorKey(flagSurface, SDL_TRUE, SDL_MapRGB(flagSurface->format, 0, 0, 0));
+	});
+#endif
 
-	SDL_SetSurfaceAlphaMod(tmpSurface, 127);
-	mBallShadow = SDL_CreateTextureFromSurface(mRenderer, tmpSurface);
-	SDL_FreeSurface(tmpSurface);
+	for (int i = 0; i <= 58; ++i)
+	{
+		jobs.push_back([this, &fontSurfaces, &highlightFontSurfaces, i]() {
+			char filename[64];
+			sprintf(filename, "gfx/font%02d.bmp", i);
+			SDL_Surface* tempFont = loadSurface(filename);
+			SDL_SetColorKey(tempFont, SDL_TRUE, SDL_MapRGB(tempFont->format, 0, 0, 0));
+			highlightFontSurfaces[i] = highlightSurface(tempFont, 60);
+			fontSurfaces[i] = tempFont;
+		});
+	}
+
+	jobs.push_back([&]() {
+		SDL_Surface* blood = loadSurface("gfx/blood.bmp");
+		bloodSurface = createSpriteSurface(blood, 255);
+		SDL_FreeSurface(blood);
+	});
 
-	// Load blobby and shadows surface
-	// Load streamed textures for coloring
-	for (int i = 1; i <= 5; ++i)
+	try
+	{
+		parallelFor(jobs.size(), [&jobs](int job) { jobs[job](); });
+	}
+	catch (...)
 	{
-		// Load blobby surface
-		char filename[64];
-		sprintf(filename, "gfx/blobbym%d.bmp", i);
-		SDL_Surface* blobImage = loadSurface(filename);
-		SDL_Surface* formatedBlobImage = SDL_ConvertSurfaceFormat(blobImage, SDL_PIXELFORMAT_ABGR8888, 0);
-		SDL_FreeSurface(blobImage);
-
-		SDL_SetColorKey(formatedBlobImage, SDL_TRUE,
-				SDL_MapRGB(formatedBlobImage->format, 0, 0, 0));
-		for(int j = 0; j < formatedBlobImage->w * formatedBlobImage->h; j++)
+		// SDL_FreeSurface ignores nullptr
+		for (SDL_Surface* surface : {backgroundSurface, ballShadowSurface, flagSurface, bloodSurface})
+			SDL_FreeSurface(surface);
+		for (SDL_Surface* surface : ballSurfaces)
+			SDL_FreeSurface(surface);
+		for (int i = 0; i < 5; ++i)
 		{
-			SDL_Color* pixel = &(((SDL_Color*)formatedBlobImage->pixels)[j]);
-			if (!(pixel->r | pixel->g | pixel->b))
-			{
-				pixel->a = 0;
-			}
+			SDL_FreeSurface(blobSurfaces[i]);
+			SDL_FreeSurface(blobSpecularSurfaces[i]);
+			SDL_FreeSurface(blobShadowSurfaces[i]);
 		}
+		for (int i = 0; i <= 58; ++i)
+		{
+			SDL_FreeSurface(fontSurfaces[i]);
+			SDL_FreeSurface(highlightFontSurfaces[i]);
+		}
+		throw;
+	}
+	StartupProfile::endPhase("decode images");
 
-		mStandardBlob.push_back(formatedBlobImage);
+	// Load background
+	mBackground = SDL_CreateTextureFromSurface(mRenderer, backgroundSurface);
+	BufferedImage* bgImage = new BufferedImage;
+	bgImage->w = backgroundSurface->w;
+	bgImage->h = backgroundSurface->h;
+	bgImage->sdlImage = mBackground;
+	SDL_FreeSurface(backgroundSurface);
+	mImageMap["background"] = bgImage;
 
-		// Load blobby shadow surface
-		sprintf(filename, "gfx/sch1%d.bmp", i);
-		SDL_Surface* blobShadow = loadSurface(filename);
-		SDL_Surface* formatedBlobShadowImage = SDL_ConvertSurfaceFormat(blobShadow, SDL_PIXELFORMAT_ABGR8888, 0);
-		SDL_FreeSurface(blobShadow);
+	// Load ball
+	for (auto ballSurface : ballSurfaces)
+	{
+		mBall.push_back(SDL_CreateTextureFromSurface(mRenderer, ballSurface));
+		SDL_FreeSurface(ballSurface);
+	}
 
-		SDL_SetSurfaceAlphaMod(formatedBlobShadowImage, 127);
-		SDL_SetColorKey(formatedBlobShadowImage, SDL_TRUE, SDL_MapRGB(formatedBlobShadowImage->format, 0, 0, 0));
-		for(int j = 0; j < formatedBlobShadowImage->w * formatedBlobShadowImage->h; j++)
-		{
-			SDL_Color* pixel = &(((SDL_Color*)formatedBlobShadowImage->pixels)[j]);
-			if (!(pixel->r | pixel->g | pixel->b))
-			{
-				pixel->a = 0;
-			} else {
-				pixel->a = 127;
-			}
-		}
+	// Load ball shadow
+	mBallShadow = SDL_CreateTextureFromSurface(mRenderer, ballShadowSurface);
+	SDL_FreeSurface(ballShadowSurface);
 
-		mStandardBlobShadow.push_back(formatedBlobShadowImage);
-
-		// Prepare blobby textures
-		SDL_Texture* leftBlobTex = SDL_CreateTexture(mRenderer,
-				SDL_PIXELFORMAT_ABGR8888,
-				SDL_TEXTUREACCESS_STREAMING,
-				formatedBlobImage->w, formatedBlobImage->h);
-		SDL_SetTextureBlendMode(leftBlobTex, SDL_BLENDMODE_BLEND);
-		SDL_UpdateTexture(leftBlobTex, nullptr, formatedBlobImage->pixels, formatedBlobImage->pitch);
-
-		mLeftBlob.emplace_back(
-				leftBlobTex,
-				Color(255, 255, 255));
-
-		SDL_Texture* rightBlobTex = SDL_CreateTexture(mRenderer,
-				SDL_PIXELFORMAT_ABGR8888,
-				SDL_TEXTUREACCESS_STREAMING,
-				formatedBlobImage->w, formatedBlobImage->h);
-		SDL_SetTextureBlendMode(rightBlobTex, SDL_BLENDMODE_BLEND);
-		SDL_UpdateTexture(rightBlobTex, nullptr, formatedBlobImage->pixels, formatedBlobImage->pitch);
-
-		mRightBlob.emplace_back(
-				rightBlobTex,
-				Color(255, 255, 255));
-
-		// Prepare blobby shadow textures
-		SDL_Texture* leftBlobShadowTex = SDL_CreateTexture(mRenderer,
-				SDL_PIXELFORMAT_ABGR8888,
-				SDL_TEXTUREACCESS_STREAMING,
-				formatedBlobShadowImage->w, formatedBlobShadowImage->h);
-		SDL_SetTextureBlendMode(leftBlobShadowTex, SDL_BLENDMODE_BLEND);
-		mLeftBlobShadow.emplace_back(
-				leftBlobShadowTex,
-				Color(255, 255, 255));
-		SDL_UpdateTexture(leftBlobShadowTex, nullptr, formatedBlobShadowImage->pixels, formatedBlobShadowImage->pitch);
-
-		SDL_Texture* rightBlobShadowTex = SDL_CreateTexture(mRenderer,
-				SDL_PIXELFORMAT_ABGR8888,
-				SDL_TEXTUREACCESS_STREAMING,
-				formatedBlobShadowImage->w, formatedBlobShadowImage->h);
-		SDL_SetTextureBlendMode(rightBlobShadowTex, SDL_BLENDMODE_BLEND);
-		mRightBlobShadow.emplace_back(
-				rightBlobShadowTex,
-				Color(255, 255, 255));
-		SDL_UpdateTexture(rightBlobShadowTex, nullptr, formatedBlobShadowImage->pixels, formatedBlobShadowImage->pitch);
-
-		// Load specific icon to cancel a game
+	// Load blobby, specular and shadow textures
+	for (int i = 0; i < 5; ++i)
+	{
+		mBlob.push_back(createTexture(blobSurfaces[i], SDL_BLENDMODE_BLEND));
+		mBlobSpecular.push_back(createTexture(blobSpecularSurfaces[i], SDL_BLENDMODE_ADD));
+		mBlobShadow.push_back(createTexture(blobShadowSurfaces[i], SDL_BLENDMODE_BLEND));
+	}
+
+	// Load specific icon to cancel a game
 #if !BLOBBY_FEATURE_HAS_BACKBUTTON
-		tmpSurface = loadSurface("gfx/flag.bmp");
-		SDL_SetColorKey(tmpSurface, SDL_TRUE, SDL_MapRGB(tmpSurface->format, 0, 0, 0));
-		mBackFlag = SDL_CreateTextureFromSurface(mRenderer, tmpSurface);
-		SDL_FreeSurface(tmpSurface);
+	mBackFlag = SDL_CreateTextureFromSurface(mRenderer, flagSurface);
+	SDL_FreeSurface(flagSurface);
 #endif
-	}
 
 	// Load font
-	for (int i = 0; i <= 58; ++i)
+	int fontAtlasWidth = ATLAS_PADDING;
+	int fontHeight = 0;
+	for (auto tempFont : fontSurfaces)
 	{
-		char filename[64];
-		sprintf(filename, "gfx/font%02d.bmp", i);
-		SDL_Surface* tempFont = loadSurface(filename);
-
-		SDL_SetColorKey(tempFont, SDL_TRUE, SDL_MapRGB(tempFont->format, 0, 0, 0));
-		mFont.push_back(SDL_CreateTextureFromSurface(mRenderer, tempFont));
-		SDL_Surface* tempFont2 = highlightSurface(tempFont, 60);
-		mHighlightFont.push_back(SDL_CreateTextureFromSurface(mRenderer, tempFont2));
-		SDL_FreeSurface(tempFont);
-		SDL_FreeSurface(tempFont2);
+		fontAtlasWidth += tempFont->w + ATLAS_PADDING;
+		fontHeight = std::max(fontHeight, tempFont->h);
 	}
+	mHighlightRow = fontHeight + ATLAS_PADDING;
 
-	// Load blood surface
-	SDL_Surface* blobStandardBlood = loadSurface("gfx/blood.bmp");
-	SDL_Surface* formatedBlobStandardBlood = SDL_ConvertSurfaceFormat(blobStandardBlood, SDL_PIXELFORMAT_ABGR8888, 0);
-	SDL_FreeSurface(blobStandardBlood);
-
-	SDL_SetColorKey(formatedBlobStandardBlood, SDL_TRUE, SDL_MapRGB(formatedBlobStandardBlood->format, 0, 0, 0));
-	for(int j = 0; j < formatedBlobStandardBlood->w * formatedBlobStandardBlood->h; j++)
+	// Put all glyphs into one texture, so text can be drawn in one go
+	SDL_Surface* fontAtlas = SDL_CreateRGBSurface(0, fontAtlasWidth, 2 * mHighlightRow + ATLAS_PADDING, 32,
+			0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+	SDL_FillRect(fontAtlas, nullptr, SDL_MapRGB(fontAtlas->format, 0, 0, 0));
+	int glyphX = ATLAS_PADDING;
+	for (int i = 0; i <= 58; ++i)
 	{
-		SDL_Color* pixel = &(((SDL_Color*)formatedBlobStandardBlood->pixels)[j]);
-		if (!(pixel->r | pixel->g | pixel->b))
-		{
-			pixel->a = 0;
-		} else {
-			pixel->a = 255;
-		}
+		SDL_Surface* tempFont = fontSurfaces[i];
+		SDL_Surface* tempFont2 = highlightFontSurfaces[i];
+		SDL_Rect glyph = {glyphX, ATLAS_PADDING, tempFont->w, tempFont->h};
+		mGlyphs.push_back(glyph);
+
+		// copy the glyphs as they are, black becomes transparent in the atlas
+		SDL_SetColorKey(tempFont, SDL_FALSE, 0);
+		SDL_BlitSurface(tempFont, nullptr, fontAtlas, &glyph);
+		glyph.y = ATLAS_PADDING + mHighlightRow;
+		SDL_SetColorKey(tempFont2, SDL_FALSE, 0);
+		SDL_SetSurfaceBlendMode(tempFont2, SDL_BLENDMODE_NONE);
+		SDL_BlitSurface(tempFont2, nullptr, fontAtlas, &glyph);
+
+		glyphX += tempFont->w + ATLAS_PADDING;
+		SDL_FreeSurface(tempFont);
+		SDL_FreeSurface(tempFont2);
 	}
+	SDL_SetColorKey(fontAtlas, SDL_TRUE, SDL_MapRGB(fontAtlas->format, 0, 0, 0));
+	mFontAtlas = SDL_CreateTextureFromSurface(mRenderer, fontAtlas);
+	SDL_FreeSurface(fontAtlas);
 
-	mStandardBlobBlood = formatedBlobStandardBlood;
-
-	// Create streamed textures for blood
-	SDL_Texture* leftBlobBlood = SDL_CreateTexture(mRenderer,
-			SDL_PIXELFORMAT_ABGR8888,
-			SDL_TEXTUREACCESS_STREAMING,
-			formatedBlobStandardBlood->w, formatedBlobStandardBlood->h);
-	SDL_SetTextureBlendMode(leftBlobBlood, SDL_BLENDMODE_BLEND);
-	mLeftBlobBlood = DynamicColoredTexture(
-			leftBlobBlood,
-			Color(255, 0, 0));
-	SDL_UpdateTexture(leftBlobBlood, nullptr, formatedBlobStandardBlood->pixels, formatedBlobStandardBlood->pitch);
-
-	SDL_Texture* rightBlobBlood = SDL_CreateTexture(mRenderer,
-			SDL_PIXELFORMAT_ABGR8888,
-			SDL_TEXTUREACCESS_STREAMING,
-			formatedBlobStandardBlood->w, formatedBlobStandardBlood->h);
-	SDL_SetTextureBlendMode(rightBlobBlood, SDL_BLENDMODE_BLEND);
-	mRightBlobBlood = DynamicColoredTexture(
-			rightBlobBlood,
-			Color(255, 0, 0));
-	SDL_UpdateTexture(rightBlobBlood, nullptr, formatedBlobStandardBlood->pixels, formatedBlobStandardBlood->pitch);
+	// Load blood texture
+	mBlood = createTexture(bloodSurface, SDL_BLENDMODE_BLEND);
+	StartupProfile::endPhase("upload textures");
 
 SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
 }
@@ -374,25 +328,21 @@ void RenderManagerSDL::deinit()
 
 	SDL_DestroyTexture(mBallShadow);
 
-	for (unsigned int i = 0; i < mStandardBlob.size(); ++i)
+	for (unsigned int i = 0; i < mBlob.size(); ++i)
 	{
-		SDL_FreeSurface(mStandardBlob[i]);
-		SDL_FreeSurface(mStandardBlobShadow[i]);
-		SDL_DestroyTexture(mLeftBlob[i].mSDLsf);
-		SDL_DestroyTexture(mLeftBlobShadow[i].mSDLsf);
-		SDL_DestroyTexture(mRightBlob[i].mSDLsf);
-		SDL_DestroyTexture(mRightBlobShadow[i].mSDLsf);
+		SDL_DestroyTexture(mBlob[i]);
+		SDL_DestroyTexture(mBlobSpecular[i]);
+		SDL_DestroyTexture(mBlobShadow[i]);
 	}
+	mBlob.clear();
+	mBlobSpecular.clear();
+	mBlobShadow.clear();
 
-	SDL_FreeSurface(mStandardBlobBlood);
-	SDL_DestroyTexture(mLeftBlobBlood.mSDLsf);
-	SDL_DestroyTexture(mRightBlobBlood.mSDLsf);
+	SDL_DestroyTexture(mBlood);
 
-	for (unsigned int i = 0; i < mFont.size(); ++i)
-	{
-		SDL_DestroyTexture(mFont[i]);
-		SDL_DestroyTexture(mHighlightFont[i]);
-	}
+	SDL_DestroyTexture(mFontAtlas);
+	mGlyphs.clear();
+	mTextLayouts.clear();
 
 #if !BLOBBY_FEATURE_HAS_BACKBUTTON
     SDL_DestroyTexture(mBackFlag);
@@ -435,12 +385,14 @@ void RenderManagerSDL::draw()
 		// Left blob shadow
 		position = blobShadowRect(blobShadowPosition(mLeftBlobPosition));
 		animationState = int(mLeftBlobAnimationState) % 5;
-		SDL_RenderCopy(mRenderer, mLeftBlobShadow[animationState].mSDLsf, nullptr, &position);
+		SDL_SetTextureColorMod(mBlobShadow[animationState], mBlobColor[LEFT_PLAYER].r, mBlobColor[LEFT_PLAYER].g, mBlobColor[LEFT_PLAYER].b);
+		SDL_RenderCopy(mRenderer, mBlobShadow[animationState], nullptr, &position);
 
 		// Right blob shadow
 		position = blobShadowRect(blobShadowPosition(mRightBlobPosition));
 		animationState = int(mRightBlobAnimationState) % 5;
-		SDL_RenderCopy(mRenderer, mRightBlobShadow[animationState].mSDLsf, nullptr, &position);
+		SDL_SetTextureColorMod(mBlobShadow[animationState], mBlobColor[RIGHT_PLAYER].r, mBlobColor[RIGHT_PLAYER].g, mBlobColor[RIGHT_PLAYER].b);
+		SDL_RenderCopy(mRenderer, mBlobShadow[animationState], nullptr, &position);
 	}
 
 	// Restore the rod
@@ -466,19 +418,15 @@ void RenderManagerSDL::draw()
 	animationState = int(mBallRotation / M_PI / 2 * 16) % 16;
 	SDL_RenderCopy(mRenderer, mBall[animationState], nullptr, &position);
 
-	// update blob colors
-	colorizeBlobs(LEFT_PLAYER);
-	colorizeBlobs(RIGHT_PLAYER);
-
 	// Drawing left blob
 	position = blobRect(mLeftBlobPosition);
 	animationState = int(mLeftBlobAnimationState) % 5;
-	SDL_RenderCopy(mRenderer, mLeftBlob[animationState].mSDLsf, nullptr, &position);
+	drawColoredBlob(animationState, position, mBlobColor[LEFT_PLAYER]);
 
 	// Drawing right blob
 	position = blobRect(mRightBlobPosition);
 	animationState = int(mRightBlobAnimationState) % 5;
-	SDL_RenderCopy(mRenderer, mRightBlob[animationState].mSDLsf, nullptr, &position);
+	drawColoredBlob(animationState, position, mBlobColor[RIGHT_PLAYER]);
 }
 
 bool RenderManagerSDL::setBackground(const std::string& filename)
@@ -508,63 +456,17 @@ bool RenderManagerSDL::setBackground(const std::string& filename)
 
 void RenderManagerSDL::setBlobColor(int player, Color color)
 {
-	if (color != mBlobColor[player]) {
-		mBlobColor[player] = color;
-	} else {
-		return;
-	}
-
-	DynamicColoredTexture* handledBlobBlood;
-
-	if (player == LEFT_PLAYER)
-	{
-		handledBlobBlood = &mLeftBlobBlood;
-	}
-	if (player == RIGHT_PLAYER)
-	{
-		handledBlobBlood = &mRightBlobBlood;
-	}
-
-	SDL_Surface* tempSurface = colorSurface(mStandardBlobBlood, mBlobColor[player]);
-	SDL_UpdateTexture(handledBlobBlood->mSDLsf, nullptr, tempSurface->pixels, tempSurface->pitch);
-	SDL_FreeSurface(tempSurface);
+	// the color is applied when drawing, so nothing needs to be prepared here
+	mBlobColor[player] = color;
 }
 
-
-void RenderManagerSDL::colorizeBlobs(int player)
+void RenderManagerSDL::drawColoredBlob(int frame, const SDL_Rect& position, Color color)
 {
-	std::vector<DynamicColoredTexture> *handledBlob = nullptr;
-	std::vector<DynamicColoredTexture> *handledBlobShadow = nullptr;
-	int frame;
-
-	if (player == LEFT_PLAYER)
-	{
-		handledBlob = &mLeftBlob;
-		handledBlobShadow = &mLeftBlobShadow;
-		frame = mLeftBlobAnimationState;
-	}
-	if (player == RIGHT_PLAYER)
-	{
-		handledBlob = &mRightBlob;
-		handledBlobShadow = &mRightBlobShadow;
-		frame = mRightBlobAnimationState;
-	}
-
-	if( (*handledBlob)[frame].mColor != mBlobColor[player])
-	{
-		SDL_Surface* tempSurface = colorSurface(mStandardBlob[frame], mBlobColor[player]);
-		SDL_UpdateTexture((*handledBlob)[frame].mSDLsf, nullptr, tempSurface->pixels, tempSurface->pitch);
-		SDL_FreeSurface(tempSurface);
-
-		SDL_Surface* tempSurface2 = colorSurface(mStandardBlobShadow[frame], mBlobColor[player]);
-		SDL_UpdateTexture((*handledBlobShadow)[frame].mSDLsf, nullptr, tempSurface2->pixels, tempSurface2->pitch);
-		SDL_FreeSurface(tempSurface2);
-
-		(*handledBlob)[frame].mColor = mBlobColor[player];
-	}
+	SDL_SetTextureColorMod(mBlob[frame], color.r, color.g, color.b);
+	SDL_RenderCopy(mRenderer, mBlob[frame], nullptr, &position);
+	SDL_RenderCopy(mRenderer, mBlobSpecular[frame], nullptr, &position);
 }
 
-
 void RenderManagerSDL::showShadow(bool shadow)
 {
 	mShowShadow = shadow;
@@ -604,9 +506,72 @@ void RenderManagerSDL::drawText(const std::string& text, Vector2 position, unsig
 
 void RenderManagerSDL::drawTextImpl(const std::string& text, Vector2 position, unsigned int flags)
 {
+	const TextLayout& layout = getTextLayout(text, flags);
+	if (layout.empty())
+		return;
+
+	const int x = lround(position.x);
+	const int y = lround(position.y);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	int atlasWidth;
+	int atlasHeight;
+	SDL_QueryTexture(mFontAtlas, nullptr, nullptr, &atlasWidth, &atlasHeight);
+
+	mTextVertices.clear();
+	for (const auto& glyph : layout)
+	{
+		const float left = x + glyph.destination.x;
+		const float top = y + glyph.destination.y;
+		const float right = left + glyph.destination.w;
+		const float bottom = top + glyph.destination.h;
+		const float u1 = float(glyph.source.x) / atlasWidth;
+		const float v1 = float(glyph.source.y) / atlasHeight;
+		const float u2 = float(glyph.source.x + glyph.source.w) / atlasWidth;
+		const float v2 = float(glyph.source.y + glyph.source.h) / atlasHeight;
+		const SDL_Color white = {255, 255, 255, 255};
+
+		mTextVertices.push_back( SDL_Vertex{ {left, top}, white, {u1, v1} } );
+		mTextVertices.push_back( SDL_Vertex{ {right, top}, white, {u2, v1} } );
+		mTextVertices.push_back( SDL_Vertex{ {right, bottom}, white, {u2, v2} } );
+		mTextVertices.push_back( SDL_Vertex{ {left, bottom}, white, {u1, v2} } );
+	}
+
+	// the indices are the same for every text, only more of them might be needed
+	for (int quad = mTextIndices.size() / 6; quad < (int)layout.size(); ++quad)
+	{
+		for (int corner : {0, 1, 2, 0, 2, 3})
+			mTextIndices.push_back(4 * quad + corner);
+	}
+
+	SDL_RenderGeometry(mRenderer, mFontAtlas, mTextVertices.data(), mTextVertices.size(),
+			mTextIndices.data(), 6 * layout.size());
+#else
+	for (const auto& glyph : layout)
+	{
+		SDL_Rect charRect = glyph.destination;
+		charRect.x += x;
+		charRect.y += y;
+		SDL_RenderCopy(mRenderer, mFontAtlas, &glyph.source, &charRect);
+	}
+#endif
+}
+
+const RenderManagerSDL::TextLayout& RenderManagerSDL::getTextLayout(const std::string& text, unsigned int flags)
+{
+	auto key = std::make_pair(text, flags & LAYOUT_FLAGS);
+	auto cached = mTextLayouts.find(key);
+	if (cached != mTextLayouts.end())
+		return cached->second;
+
+	// texts like chat messages and scores can vary a lot, so don't let the cache grow forever
+	if (mTextLayouts.size() >= MAX_CACHED_TEXT_LAYOUTS)
+		mTextLayouts.clear();
+
 	int FontSize = (flags & TF_SMALL_FONT ? FONT_WIDTH_SMALL : FONT_WIDTH_NORMAL);
 	int length = 0;
 
+	TextLayout& layout = mTextLayouts[key];
 	for (auto iter = text.cbegin(); iter != text.cend(); )
 	{
 		int index = getNextFontIndex(iter);
@@ -614,39 +579,29 @@ void RenderManagerSDL::drawTextImpl(const std::string& text, Vector2 position, u
 		if (flags & TF_OBFUSCATE)
 			index = FONT_INDEX_ASTERISK;
 
-		SDL_Rect charRect;
-		charRect.x = lround(position.x) + length;
-		charRect.y = lround(position.y);
+		GlyphQuad glyph;
+		glyph.source = mGlyphs[index];
+		if (flags & TF_HIGHLIGHT)
+			glyph.source.y += mHighlightRow;
 
+		glyph.destination.x = length;
+		glyph.destination.y = 0;
 		if (flags & TF_SMALL_FONT)
 		{
-			charRect.w = FONT_WIDTH_SMALL;
-			charRect.h = FONT_WIDTH_SMALL;
-			if (flags & TF_HIGHLIGHT)
-			{
-				SDL_RenderCopy(mRenderer, mHighlightFont[index], nullptr, &charRect);
-			}
-			else
-			{
-				SDL_RenderCopy(mRenderer,mFont[index], nullptr, &charRect);
-			}
+			glyph.destination.w = FONT_WIDTH_SMALL;
+			glyph.destination.h = FONT_WIDTH_SMALL;
 		}
 		else
 		{
-			if (flags & TF_HIGHLIGHT)
-			{
-				SDL_QueryTexture(mHighlightFont[index], nullptr, nullptr, &charRect.w, &charRect.h);
-				SDL_RenderCopy(mRenderer, mHighlightFont[index], nullptr, &charRect);
-			}
-			else
-			{
-				SDL_QueryTexture(mHighlightFont[index], nullptr, nullptr, &charRect.w, &charRect.h);
-				SDL_RenderCopy(mRenderer,mFont[index], nullptr, &charRect);
-			}
+			glyph.destination.w = glyph.source.w;
+			glyph.destination.h = glyph.source.h;
 		}
+		layout.push_back(glyph);
 
 		length += FontSize;
 	}
+
+	return layout;
 }
 
 void RenderManagerSDL::drawImage(const std::string& filename, Vector2 position, Vector2 size)
@@ -707,36 +662,13 @@ void RenderManagerSDL::drawOverlay(float opacity, Vector2 pos1, Vector2 pos2, Co
 void RenderManagerSDL::drawBlob(const Vector2& pos, const Color& col)
 {
 	SDL_Rect position;
-	position.x = (int)lround(pos.x);
-	position.y = (int)lround(pos.y);
-
-	static int toDraw = 0;
 
-	mLeftBlobAnimationState = 0;
-	mRightBlobAnimationState = 0;
+	//  Dirty workaround to have the right position of blobs in the GUI
+	position.x = (int)lround(pos.x) - (int)(75/2);
+	position.y = (int)lround(pos.y) - (int)(89/2);
+	SDL_QueryTexture(mBlob[0], nullptr, nullptr, &position.w, &position.h);
 
-	setBlobColor(toDraw, col);
-	/// \todo this recolores the current frame (0)
-	/// + shadows; thats not exactly what we want
-	colorizeBlobs(toDraw);
-
-
-	//  Second dirty workaround in the function to have the right position of blobs in the GUI
-	position.x = position.x - (int)(75/2);
-	position.y = position.y - (int)(89/2);
-
-	if(toDraw == 1)
-	{
-		SDL_QueryTexture(mRightBlob[mRightBlobAnimationState].mSDLsf, nullptr, nullptr, &position.w, &position.h);
-		SDL_RenderCopy(mRenderer, mRightBlob[mRightBlobAnimationState].mSDLsf, nullptr, &position);
-		toDraw = 0;
-	}
-	else
-	{
-		SDL_QueryTexture(mLeftBlob[mRightBlobAnimationState].mSDLsf, nullptr, nullptr, &position.w, &position.h);
-		SDL_RenderCopy(mRenderer, mLeftBlob[mRightBlobAnimationState].mSDLsf, nullptr, &position);
-		toDraw = 1;
-	}
+	drawColoredBlob(0, position, col);
 }
 
 void RenderManagerSDL::drawParticle(const Vector2& pos, int player)
@@ -750,9 +682,47 @@ void RenderManagerSDL::drawParticle(const Vector2& pos, int player)
 		(short)9,
 	};
 
-	DynamicColoredTexture blood = player == LEFT_PLAYER ? mLeftBlobBlood : mRightBlobBlood;
+	const Color& color = mBlobColor[player == LEFT_PLAYER ? LEFT_PLAYER : RIGHT_PLAYER];
+	SDL_SetTextureColorMod(mBlood, color.r, color.g, color.b);
+	SDL_RenderCopy(mRenderer, mBlood, nullptr, &blitRect);
+}
+
+void RenderManagerSDL::drawParticles(const float* x, const float* y, const unsigned char* player, int count)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	mNeedRedraw = true;
+
+	// all drops in one call, coloured per vertex instead of per texture
+	SDL_Color colors[2];
+	for (int side = LEFT_PLAYER; side <= RIGHT_PLAYER; ++side)
+		colors[side] = SDL_Color{(Uint8)mBlobColor[side].r, (Uint8)mBlobColor[side].g, (Uint8)mBlobColor[side].b, 255};
 
-	SDL_RenderCopy(mRenderer, blood.mSDLsf, nullptr, &blitRect);
+	mParticleVertices.resize(4 * count);
+	SDL_Vertex* vertex = mParticleVertices.data();
+	for (int i = 0; i < count; ++i, vertex += 4)
+	{
+		const float left = lround(x[i] - 4.5f);
+		const float top = lround(y[i] - 4.5f);
+		const SDL_Color& color = colors[player[i] == LEFT_PLAYER ? LEFT_PLAYER : RIGHT_PLAYER];
+
+		vertex[0] = SDL_Vertex{ {left, top}, color, {0, 0} };
+		vertex[1] = SDL_Vertex{ {left + 9, top}, color, {1, 0} };
+		vertex[2] = SDL_Vertex{ {left + 9, top + 9}, color, {1, 1} };
+		vertex[3] = SDL_Vertex{ {left, top + 9}, color, {0, 1} };
+	}
+
+	for (int quad = mParticleIndices.size() / 6; quad < count; ++quad)
+	{
+		for (int corner : {0, 1, 2, 0, 2, 3})
+			mParticleIndices.push_back(4 * quad + corner);
+	}
+
+	SDL_SetTextureColorMod(mBlood, 255, 255, 255);
+	SDL_RenderGeometry(mRenderer, mBlood, mParticleVertices.data(), 4 * count,
+			mParticleIndices.data(), 6 * count);
+#else
+	RenderManager::drawParticles(x, y, player, count);
+#endif
 }
 
 void RenderManagerSDL::refresh()
@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include <SDL2/SDL.h>
+#include <map>
 #include <vector>
 
 #include "RenderManager.h"
@@ -55,40 +56,44 @@ class RenderManagerSDL : public RenderManager
 		void drawOverlay(float opacity, Vector2 pos1, Vector2 pos2, Color col) override;
 		void drawBlob(const Vector2& pos, const Color& col) override;
 		void drawParticle(const Vector2& pos, int player) override;
+		void drawParticles(const float* x, const float* y, const unsigned char* player, int count) override;
 
 	private:
-		struct DynamicColoredTexture
-		{
-			// constructors
-			// start surface is expected to have color 0xffffff
-			DynamicColoredTexture() : mSDLsf(nullptr), mColor(255, 255, 255) {};
-			explicit DynamicColoredTexture(SDL_Texture* sf) : mSDLsf(sf), mColor(255, 255, 255) {};
-
-			DynamicColoredTexture(SDL_Texture* sf, Color c) : mSDLsf(sf), mColor(c) {};
-
-			SDL_Texture* mSDLsf;
-			Color mColor;
-		};
-
-
 		SDL_Texture* mBackground;
 		SDL_Texture* mBallShadow;
 		SDL_Texture* mMarker[2];
 
 		std::vector<SDL_Texture*> mBall;
-		std::vector<SDL_Surface*> mStandardBlob;
-		std::vector<SDL_Surface*> mStandardBlobShadow;
-		SDL_Surface* mStandardBlobBlood;
-		std::vector<DynamicColoredTexture> mLeftBlob;
-		std::vector<DynamicColoredTexture> mLeftBlobShadow;
-		DynamicColoredTexture mLeftBlobBlood;
-
-		std::vector<DynamicColoredTexture> mRightBlob;
-		std::vector<DynamicColoredTexture> mRightBlobShadow;
-		DynamicColoredTexture mRightBlobBlood;
 
-		std::vector<SDL_Texture*> mFont;
-		std::vector<SDL_Texture*> mHighlightFont;
+		// blobs, their shadows and blood are white and get their color when they are drawn,
+		// the specular highlights are added afterwards
+		std::vector<SDL_Texture*> mBlob;
+		std::vector<SDL_Texture*> mBlobSpecular;
+		std::vector<SDL_Texture*> mBlobShadow;
+		SDL_Texture* mBlood;
+
+		// all glyphs in one texture, the highlighted font is in a second row below the normal one.
+		// mHighlightRow is the offset between the rows.
+		SDL_Texture* mFontAtlas;
+		std::vector<SDL_Rect> mGlyphs;
+		int mHighlightRow;
+
+		// source and destination of each character of a text, relative to the text position
+		struct GlyphQuad
+		{
+			SDL_Rect source;
+			SDL_Rect destination;
+		};
+		typedef std::vector<GlyphQuad> TextLayout;
+
+		// texts change rarely, so their layouts are kept instead of parsing them every frame
+		std::map<std::pair<std::string, unsigned int>, TextLayout> mTextLayouts;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		std::vector<SDL_Vertex> mTextVertices;
+		std::vector<int> mTextIndices;
+		std::vector<SDL_Vertex> mParticleVertices;
+		std::vector<int> mParticleIndices;
+#endif
 
 		SDL_Texture *mOverlayTexture;
 
@@ -103,18 +108,17 @@ class RenderManagerSDL : public RenderManager
 
 		bool mShowShadow;
 
-		// Store color for caching
 		Color mBlobColor[MAX_PLAYERS];
 
 		// Rendertarget to make windowmode resizeable
 		SDL_Texture* mRenderTarget;
 
-		// colors a surface
-		// the returned SDL_Surface* is already converted into DisplayFormat
-		SDL_Surface* colorSurface(SDL_Surface *surface, Color color);
+		// uploads a surface made by createSpriteSurface or createSpecularSurface and frees it
+		SDL_Texture* createTexture(SDL_Surface* surface, SDL_BlendMode mode);
 
 		void drawTextImpl(const std::string& text, Vector2 position, unsigned int flags);
-		void colorizeBlobs(int player);
+		const TextLayout& getTextLayout(const std::string& text, unsigned int flags);
+		void drawColoredBlob(int frame, const SDL_Rect& position, Color color);
 
 #if !BLOBBY_FEATURE_HAS_BACKBUTTON
         SDL_Texture* mBackFlag;
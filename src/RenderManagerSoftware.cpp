@@ -0,0 +1,300 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "RenderManagerSoftware.h"
+
+/* includes */
+#include <cmath>
+
+#include "FileExceptions.h"
+
+/* implementation */
+RenderManagerSoftware::RenderManagerSoftware(bool singleton) :
+	RenderManager(singleton),
+	mFramebuffer(nullptr),
+	mBallRotation(0.0),
+	mLeftBlobAnimationState(0.0),
+	mRightBlobAnimationState(0.0),
+	mShowShadow(true)
+{
+	mBlobColor[LEFT_PLAYER] = Color(255, 0, 0);
+	mBlobColor[RIGHT_PLAYER] = Color(0, 255, 0);
+}
+
+RenderManagerSoftware::~RenderManagerSoftware()
+{
+	if (mFramebuffer)
+		deinit();
+}
+
+SDL_Surface* RenderManagerSoftware::createSprite(SDL_Surface* surface, Uint8 alpha)
+{
+	SDL_Surface* sprite = createSpriteSurface(surface, alpha, SDL_PIXELFORMAT_ARGB8888);
+	SDL_FreeSurface(surface);
+	SDL_SetSurfaceBlendMode(sprite, SDL_BLENDMODE_BLEND);
+	return sprite;
+}
+
+void RenderManagerSoftware::init(int xResolution, int yResolution, bool fullscreen)
+{
+	// the scene is always drawn in the traditional resolution
+	mFramebuffer = SDL_CreateRGBSurfaceWithFormat(0, 800, 600, 32, SDL_PIXELFORMAT_ARGB8888);
+
+	SDL_Surface* tmpSurface;
+
+	mWhite = SDL_CreateRGBSurfaceWithFormat(0, 1, 1, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_FillRect(mWhite, nullptr, 0xFFFFFFFF);
+	SDL_SetSurfaceBlendMode(mWhite, SDL_BLENDMODE_BLEND);
+
+	tmpSurface = loadSurface("backgrounds/strand2.bmp");
+	mBackground = SDL_ConvertSurfaceFormat(tmpSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+	SDL_FreeSurface(tmpSurface);
+
+	for (int i = 1; i <= 16; ++i)
+	{
+		char filename[64];
+		sprintf(filename, "gfx/ball%02d.bmp", i);
+		mBall.push_back(createSprite(loadSurface(filename), 255));
+	}
+
+	mBallShadow = createSprite(loadSurface("gfx/schball.bmp"), 127);
+
+	for (int i = 1; i <= 5; ++i)
+	{
+		char filename[64];
+		sprintf(filename, "gfx/blobbym%d.bmp", i);
+		tmpSurface = loadSurface(filename);
+		SDL_Surface* specular = createSpecularSurface(tmpSurface, SDL_PIXELFORMAT_ARGB8888);
+		SDL_SetSurfaceBlendMode(specular, SDL_BLENDMODE_ADD);
+		mBlobSpecular.push_back(specular);
+		mBlob.push_back(createSprite(tmpSurface, 255));
+
+		sprintf(filename, "gfx/sch1%d.bmp", i);
+		mBlobShadow.push_back(createSprite(loadSurface(filename), 127));
+	}
+
+	for (int i = 0; i <= 58; ++i)
+	{
+		char filename[64];
+		sprintf(filename, "gfx/font%02d.bmp", i);
+		tmpSurface = loadSurface(filename);
+		SDL_SetColorKey(tmpSurface, SDL_TRUE, SDL_MapRGB(tmpSurface->format, 0, 0, 0));
+		mHighlightFont.push_back(createSprite(highlightSurface(tmpSurface, 60), 255));
+		mFont.push_back(createSprite(tmpSurface, 255));
+	}
+
+	mBlood = createSprite(loadSurface("gfx/blood.bmp"), 255);
+}
+
+void RenderManagerSoftware::deinit()
+{
+	SDL_FreeSurface(mFramebuffer);
+	mFramebuffer = nullptr;
+
+	SDL_FreeSurface(mWhite);
+	SDL_FreeSurface(mBackground);
+	SDL_FreeSurface(mBallShadow);
+	SDL_FreeSurface(mBlood);
+
+	for (auto& surfaces : {&mBall, &mBlob, &mBlobSpecular, &mBlobShadow, &mFont, &mHighlightFont})
+	{
+		for (auto surface : *surfaces)
+			SDL_FreeSurface(surface);
+		surfaces->clear();
+	}
+
+	for (auto& image : mImages)
+		SDL_FreeSurface(image.second);
+	mImages.clear();
+}
+
+void RenderManagerSoftware::blit(SDL_Surface* surface, SDL_Rect position)
+{
+	SDL_BlitSurface(surface, nullptr, mFramebuffer, &position);
+}
+
+void RenderManagerSoftware::blitScaled(SDL_Surface* surface, SDL_Rect position)
+{
+	SDL_BlitScaled(surface, nullptr, mFramebuffer, &position);
+}
+
+void RenderManagerSoftware::drawColoredBlob(int frame, const SDL_Rect& position, Color color)
+{
+	SDL_SetSurfaceColorMod(mBlob[frame], color.r, color.g, color.b);
+	blit(mBlob[frame], position);
+	blit(mBlobSpecular[frame], position);
+}
+
+void RenderManagerSoftware::draw()
+{
+	if (!mDrawGame)
+		return;
+
+	SDL_BlitSurface(mBackground, nullptr, mFramebuffer, nullptr);
+
+	int animationState;
+	SDL_Rect position;
+
+	// Ball marker
+	Uint32 markerColor = SDL_GetTicks() % 1000 >= 500 ? 0xFF000000 : 0xFFFFFFFF;
+	position = {(int)lround(mBallPosition.x - 2.5), 5, 5, 5};
+	SDL_FillRect(mFramebuffer, &position, markerColor);
+
+	// Mouse marker
+	position = {(int)lround(mMouseMarkerPosition - 2.5), 590, 5, 5};
+	SDL_FillRect(mFramebuffer, &position, markerColor);
+
+	if(mShowShadow)
+	{
+		blit(mBallShadow, ballShadowRect(ballShadowPosition(mBallPosition)));
+
+		animationState = int(mLeftBlobAnimationState) % 5;
+		SDL_SetSurfaceColorMod(mBlobShadow[animationState], mBlobColor[LEFT_PLAYER].r, mBlobColor[LEFT_PLAYER].g, mBlobColor[LEFT_PLAYER].b);
+		blit(mBlobShadow[animationState], blobShadowRect(blobShadowPosition(mLeftBlobPosition)));
+
+		animationState = int(mRightBlobAnimationState) % 5;
+		SDL_SetSurfaceColorMod(mBlobShadow[animationState], mBlobColor[RIGHT_PLAYER].r, mBlobColor[RIGHT_PLAYER].g, mBlobColor[RIGHT_PLAYER].b);
+		blit(mBlobShadow[animationState], blobShadowRect(blobShadowPosition(mRightBlobPosition)));
+	}
+
+	// Restore the rod
+	SDL_Rect rodPosition = {400 - 7, 300, 14, 300};
+	SDL_BlitSurface(mBackground, &rodPosition, mFramebuffer, &rodPosition);
+
+	// Drawing the Ball
+	animationState = int(mBallRotation / M_PI / 2 * 16) % 16;
+	blit(mBall[animationState], ballRect(mBallPosition));
+
+	// Drawing the blobs
+	drawColoredBlob(int(mLeftBlobAnimationState) % 5, blobRect(mLeftBlobPosition), mBlobColor[LEFT_PLAYER]);
+	drawColoredBlob(int(mRightBlobAnimationState) % 5, blobRect(mRightBlobPosition), mBlobColor[RIGHT_PLAYER]);
+}
+
+bool RenderManagerSoftware::setBackground(const std::string& filename)
+{
+	try
+	{
+		SDL_Surface* tmpSurface = loadSurface(filename);
+		SDL_FreeSurface(mBackground);
+		mBackground = SDL_ConvertSurfaceFormat(tmpSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(tmpSurface);
+	}
+	catch (const FileLoadException&)
+	{
+		return false;
+	}
+	return true;
+}
+
+void RenderManagerSoftware::setBlobColor(int player, Color color)
+{
+	mBlobColor[player] = color;
+}
+
+void RenderManagerSoftware::showShadow(bool shadow)
+{
+	mShowShadow = shadow;
+}
+
+void RenderManagerSoftware::setBall(const Vector2& position, float rotation)
+{
+	mBallPosition = position;
+	mBallRotation = rotation;
+}
+
+void RenderManagerSoftware::setBlob(int player, const Vector2& position, float animationState)
+{
+	if (player == LEFT_PLAYER)
+	{
+		mLeftBlobPosition = position;
+		mLeftBlobAnimationState = animationState;
+	}
+
+	if (player == RIGHT_PLAYER)
+	{
+		mRightBlobPosition = position;
+		mRightBlobAnimationState = animationState;
+	}
+}
+
+void RenderManagerSoftware::drawText(const std::string& text, Vector2 position, unsigned int flags)
+{
+	int FontSize = (flags & TF_SMALL_FONT ? FONT_WIDTH_SMALL : FONT_WIDTH_NORMAL);
+	int length = 0;
+
+	for (auto iter = text.cbegin(); iter != text.cend(); )
+	{
+		int index = getNextFontIndex(iter);
+
+		if (flags & TF_OBFUSCATE)
+			index = FONT_INDEX_ASTERISK;
+
+		SDL_Surface* glyph = (flags & TF_HIGHLIGHT) ? mHighlightFont[index] : mFont[index];
+		SDL_Rect charRect = {(int)lround(position.x) + length, (int)lround(position.y), glyph->w, glyph->h};
+
+		if (flags & TF_SMALL_FONT)
+		{
+			charRect.w = FONT_WIDTH_SMALL;
+			charRect.h = FONT_WIDTH_SMALL;
+			blitScaled(glyph, charRect);
+		}
+		else
+		{
+			blit(glyph, charRect);
+		}
+
+		length += FontSize;
+	}
+}
+
+void RenderManagerSoftware::drawImage(const std::string& filename, Vector2 position, Vector2 size)
+{
+	SDL_Surface*& image = mImages[filename];
+	if (!image)
+		image = createSprite(loadSurface(filename), 255);
+
+	if (size == Vector2(0,0))
+		size = Vector2(image->w, image->h);
+
+	blitScaled(image, SDL_Rect{(int)lround(position.x - size.x / 2.0), (int)lround(position.y - size.y / 2.0),
+								(int)size.x, (int)size.y});
+}
+
+void RenderManagerSoftware::drawOverlay(float opacity, Vector2 pos1, Vector2 pos2, Color col)
+{
+	SDL_SetSurfaceAlphaMod(mWhite, lround(opacity * 255));
+	SDL_SetSurfaceColorMod(mWhite, col.r, col.g, col.b);
+	blitScaled(mWhite, SDL_Rect{(int)lround(pos1.x), (int)lround(pos1.y),
+							(int)lround(pos2.x - pos1.x), (int)lround(pos2.y - pos1.y)});
+}
+
+void RenderManagerSoftware::drawBlob(const Vector2& pos, const Color& col)
+{
+	SDL_Rect position = {(int)lround(pos.x) - 75 / 2, (int)lround(pos.y) - 89 / 2, mBlob[0]->w, mBlob[0]->h};
+	drawColoredBlob(0, position, col);
+}
+
+void RenderManagerSoftware::drawParticle(const Vector2& pos, int player)
+{
+	const Color& color = mBlobColor[player == LEFT_PLAYER ? LEFT_PLAYER : RIGHT_PLAYER];
+	SDL_SetSurfaceColorMod(mBlood, color.r, color.g, color.b);
+	blit(mBlood, SDL_Rect{(int)lround(pos.x - 4.5), (int)lround(pos.y - 4.5), 9, 9});
+}
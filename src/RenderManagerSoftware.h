@@ -0,0 +1,100 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <map>
+#include <vector>
+
+#include "RenderManager.h"
+
+/*! \class RenderManagerSoftware
+	\brief Render Manager drawing into memory
+	\details This render manager draws the same picture as RenderManagerSDL, but into a
+			framebuffer in main memory, using only SDL surface blits. It needs neither a window
+			nor a graphics card, so it can be used to render replays offline, e.g. by blobby-render.
+*/
+class RenderManagerSoftware : public RenderManager
+{
+	public:
+		/// \param singleton whether this renderer becomes RenderManager::getSingleton().
+		///		Renderers in worker threads must not.
+		explicit RenderManagerSoftware(bool singleton = true);
+		~RenderManagerSoftware() override;
+
+		void init(int xResolution, int yResolution, bool fullscreen) override;
+		void deinit() override;
+		void draw() override;
+
+		bool setBackground(const std::string& filename) override;
+		void setBlobColor(int player, Color color) override;
+		void showShadow(bool shadow) override;
+
+		void setBall(const Vector2& position, float rotation) override;
+		void setBlob(int player, const Vector2& position,
+				float animationState) override;
+
+		void drawText(const std::string& text, Vector2 position, unsigned int flags = TF_NORMAL) override;
+		void drawImage(const std::string& filename, Vector2 position, Vector2 size) override;
+		void drawOverlay(float opacity, Vector2 pos1, Vector2 pos2, Color col) override;
+		void drawBlob(const Vector2& pos, const Color& col) override;
+		void drawParticle(const Vector2& pos, int player) override;
+
+		/// the picture drawn so far, in SDL_PIXELFORMAT_ARGB8888
+		const SDL_Surface* getFramebuffer() const { return mFramebuffer; }
+
+	private:
+		SDL_Surface* mFramebuffer;
+
+		SDL_Surface* mBackground;
+		SDL_Surface* mBallShadow;
+		SDL_Surface* mWhite;
+		std::vector<SDL_Surface*> mBall;
+
+		// blobs, their shadows and blood are white and are tinted when blitted
+		std::vector<SDL_Surface*> mBlob;
+		std::vector<SDL_Surface*> mBlobSpecular;
+		std::vector<SDL_Surface*> mBlobShadow;
+		SDL_Surface* mBlood;
+
+		std::vector<SDL_Surface*> mFont;
+		std::vector<SDL_Surface*> mHighlightFont;
+
+		std::map<std::string, SDL_Surface*> mImages;
+
+		Vector2 mBallPosition;
+		float mBallRotation;
+		Vector2 mLeftBlobPosition;
+		float mLeftBlobAnimationState;
+		Vector2 mRightBlobPosition;
+		float mRightBlobAnimationState;
+
+		bool mShowShadow;
+		Color mBlobColor[MAX_PLAYERS];
+
+		// converts a sprite to ARGB with black as transparent color and frees the input
+		SDL_Surface* createSprite(SDL_Surface* surface, Uint8 alpha);
+
+		// blits with the destination rect given by value, as SDL clips it
+		void blit(SDL_Surface* surface, SDL_Rect position);
+		void blitScaled(SDL_Surface* surface, SDL_Rect position);
+		void drawColoredBlob(int frame, const SDL_Rect& position, Color color);
+};
@@ -23,12 +23,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* includes */
 #include <cmath>
+#include <cstring>
 #include <algorithm>
+#include <limits>
 #include <iostream>
+#include <vector>
 #include <boost/exception/all.hpp>
 
-#include <SDL2/SDL.h>
-
 extern "C"
 {
 #include "lua/lua.h"
@@ -37,17 +38,36 @@ extern "C"
 }
 
 #include "DuelMatch.h"
+#include "GameConstants.h"
 #include "IUserConfigReader.h"
 
 /* implementation */
 
-ScriptedInputSource::ScriptedInputSource(const std::string& filename, PlayerSide playerside, unsigned int difficulty)
-: mDifficulty(difficulty)
-, mSide(playerside)
-, mDelayDistribution( difficulty/3, difficulty/2 )
+namespace
 {
-	mStartTime = SDL_GetTicks();
+	// fields of the __WORLD table, grouped by type
+	enum WorldField
+	{
+		BALL_X, BALL_Y, BALL_VX, BALL_VY,
+		BLOB_X, BLOB_Y, BLOB_VX, BLOB_VY,
+		OPP_X, OPP_Y, OPP_VX, OPP_VY,
+		TOUCHES, OPP_TOUCHES, SCORE, OPP_SCORE, SERVING_PLAYER,
+		BALL_VALID, GAME_RUNNING,
+		WORLD_FIELD_COUNT
+	};
+
+	const char* const WORLD_FIELD_NAMES[WORLD_FIELD_COUNT] = {
+		"ball_x", "ball_y", "ball_vx", "ball_vy",
+		"blob_x", "blob_y", "blob_vx", "blob_vy",
+		"opp_x", "opp_y", "opp_vx", "opp_vy",
+		"touches", "opp_touches", "score", "opp_score", "serving_player",
+		"ball_valid", "game_running"
+	};
+}
 
+ScriptedInputSource::ScriptedInputSource(const std::string& filename, PlayerSide playerside, unsigned int difficulty, unsigned int seed)
+: BotInputSource(playerside, difficulty, seed)
+{
 	// set game constants
 	setGameConstants();
 	setGameFunctions();
@@ -62,6 +82,15 @@ ScriptedInputSource::ScriptedInputSource(const std::string& filename, PlayerSide
 	lua_pushinteger(mState, mSide);
 	lua_setglobal(mState, "__SIDE");
 
+	// the table is filled anew before each step, so the script needs no calls into C++ to
+	// get the state of the match
+	lua_createtable(mState, 0, WORLD_FIELD_COUNT);
+	lua_pushvalue(mState, -1);
+	lua_setglobal(mState, "__WORLD");
+	mWorldRef = luaL_ref(mState, LUA_REGISTRYINDEX);
+	// no value of the match has the bits of nan, so the first step writes all fields
+	mWorldCache.assign(WORLD_FIELD_COUNT, std::numeric_limits<double>::quiet_NaN());
+
 	openScript("api");
 	openScript("bot_api");
 	openScript(filename);
@@ -84,9 +113,142 @@ ScriptedInputSource::ScriptedInputSource(const std::string& filename, PlayerSide
 
 ScriptedInputSource::~ScriptedInputSource() = default;
 
+void ScriptedInputSource::setDeterministic(int gameSpeed)
+{
+	BotInputSource::setDeterministic(gameSpeed);
+
+	lua_getglobal(mState, "math");
+	lua_pushlightuserdata(mState, this);
+	lua_pushcclosure(mState, &ScriptedInputSource::luaRandom, 1);
+	lua_setfield(mState, -2, "random");
+	lua_pop(mState, 1);
+
+	lua_register(mState, "pairs", &ScriptedInputSource::luaOrderedPairs);
+}
+
+int ScriptedInputSource::luaRandom(lua_State* state)
+{
+	// same arguments as the math.random of lua
+	auto* source = static_cast<ScriptedInputSource*>(lua_touserdata(state, lua_upvalueindex(1)));
+	const int arguments = lua_gettop(state);
+	if (arguments == 0)
+	{
+		lua_pushnumber(state, std::uniform_real_distribution<double>(0, 1)(source->mRandom));
+		return 1;
+	}
+
+	lua_Integer low = arguments == 1 ? 1 : luaL_checkinteger(state, 1);
+	lua_Integer high = luaL_checkinteger(state, arguments == 1 ? 1 : 2);
+	luaL_argcheck(state, low <= high, arguments == 1 ? 1 : 2, "interval is empty");
+	lua_pushinteger(state, std::uniform_int_distribution<lua_Integer>(low, high)(source->mRandom));
+	return 1;
+}
+
+int ScriptedInputSource::luaOrderedPairs(lua_State* state)
+{
+	luaL_checktype(state, 1, LUA_TTABLE);
+
+	// collect the keys, then sort them: numbers before strings, each by value,
+	// keys of other types by their type name only
+	lua_newtable(state);
+	std::vector<int> order;
+	lua_pushnil(state);
+	while (lua_next(state, 1))
+	{
+		lua_pop(state, 1);
+		lua_pushvalue(state, -1);
+		order.push_back(order.size() + 1);
+		lua_rawseti(state, 2, order.size());
+	}
+
+	std::stable_sort(order.begin(), order.end(), [state](int a, int b)
+	{
+		lua_rawgeti(state, 2, a);
+		lua_rawgeti(state, 2, b);
+		int typeA = lua_type(state, -2);
+		int typeB = lua_type(state, -1);
+		bool less = typeA != typeB ? typeA < typeB :
+					(typeA == LUA_TNUMBER || typeA == LUA_TSTRING) && lua_compare(state, -2, -1, LUA_OPLT);
+		lua_pop(state, 2);
+		return less;
+	});
+
+	lua_createtable(state, order.size(), 0);
+	for (unsigned i = 0; i < order.size(); ++i)
+	{
+		lua_rawgeti(state, 2, order[i]);
+		lua_rawseti(state, 3, i + 1);
+	}
+
+	lua_pushinteger(state, 0);
+	lua_pushcclosure(state, &ScriptedInputSource::luaOrderedNext, 2);
+	lua_pushvalue(state, 1);
+	lua_pushnil(state);
+	return 3;
+}
+
+int ScriptedInputSource::luaOrderedNext(lua_State* state)
+{
+	lua_Integer index = lua_tointeger(state, lua_upvalueindex(2)) + 1;
+	lua_pushinteger(state, index);
+	lua_replace(state, lua_upvalueindex(2));
+
+	if (lua_rawgeti(state, lua_upvalueindex(1), index) == LUA_TNIL)
+		return 1;
+	lua_pushvalue(state, -1);
+	lua_rawget(state, 1);
+	return 2;
+}
+
+void ScriptedInputSource::pushWorldState()
+{
+	const DuelMatch* match = getMatch();
+	const PlayerSide opponent = mSide == LEFT_PLAYER ? RIGHT_PLAYER : LEFT_PLAYER;
+
+	// same conversions as the api functions and bot_api.lua did: y is flipped in float
+	// precision, x is mirrored in double precision
+	double values[WORLD_FIELD_COUNT];
+	auto setVectors = [&](int field, Vector2 position, Vector2 velocity)
+	{
+		values[field] = mSide == RIGHT_PLAYER ? RIGHT_PLANE - double(position.x) : position.x;
+		values[field + 1] = 600 - position.y;
+		values[field + 2] = mSide == RIGHT_PLAYER ? -velocity.x : velocity.x;
+		values[field + 3] = -velocity.y;
+	};
+	setVectors(BALL_X, match->getBallPosition(), match->getBallVelocity());
+	setVectors(BLOB_X, match->getBlobPosition(mSide), match->getBlobVelocity(mSide));
+	setVectors(OPP_X, match->getBlobPosition(opponent), match->getBlobVelocity(opponent));
+	values[TOUCHES] = match->getTouches(mSide);
+	values[OPP_TOUCHES] = match->getTouches(opponent);
+	values[SCORE] = match->getScore(mSide);
+	values[OPP_SCORE] = match->getScore(opponent);
+	values[SERVING_PLAYER] = match->getServingPlayer();
+	values[BALL_VALID] = !match->getBallDown();
+	values[GAME_RUNNING] = match->getBallActive();
+
+	lua_rawgeti(mState, LUA_REGISTRYINDEX, mWorldRef);
+	for (int field = 0; field < WORLD_FIELD_COUNT; ++field)
+	{
+		// most values stay the same from one step to the next, so only write those that changed.
+		// compare the bits, so that the table gets -0 just like the api functions would return it
+		if (std::memcmp(&values[field], &mWorldCache[field], sizeof(double)) == 0)
+			continue;
+		mWorldCache[field] = values[field];
+
+		if (field >= BALL_VALID)
+			lua_pushboolean(mState, values[field] != 0);
+		else if (field >= TOUCHES)
+			lua_pushinteger(mState, lua_Integer(values[field]));
+		else
+			lua_pushnumber(mState, values[field]);
+		lua_setfield(mState, -2, WORLD_FIELD_NAMES[field]);
+	}
+	lua_pop(mState, 1);
+}
+
 PlayerInputAbs ScriptedInputSource::getNextInput()
 {
-	bool serving = false;
+	unsigned int elapsed = advanceTime();
 	// reset input
 	lua_pushboolean(mState, false);
 	lua_setglobal(mState, "__WANT_LEFT");
@@ -102,16 +264,10 @@ PlayerInputAbs ScriptedInputSource::getNextInput()
 	{
 		IScriptableComponent::setMatch( const_cast<DuelMatch*>(getMatch()) );
 	}
+	pushWorldState();
 	lua_getglobal(mState, "__OnStep");
 	callLuaFunction();
 
-	if (!getMatch()->getBallActive() && mSide ==
-			// if no player is serving player, assume the left one is
-			(getMatch()->getServingPlayer() == NO_PLAYER ? LEFT_PLAYER : getMatch()->getServingPlayer() ))
-	{
-		serving = true;
-	}
-
 	// read input info from lua script
 	lua_getglobal(mState, "__WANT_LEFT");
 	lua_getglobal(mState, "__WANT_RIGHT");
@@ -130,22 +286,5 @@ PlayerInputAbs ScriptedInputSource::getNextInput()
 		lua_pop(mState, stacksize);
 	}
 
-	if (mStartTime + WAITING_TIME > SDL_GetTicks() && serving)
-		return {};
-
-	// random jump delay depending on difficulty
-	if( wantjump && !mLastJump )
-	{
-		mJumpDelay--;
-		if( mJumpDelay > 0 )
-			wantjump = false;
-		else
-		{
-			mJumpDelay = std::max(0.0, std::min( mDelayDistribution(mRandom) , (double)mDifficulty));
-		}
-	}
-
-	mLastJump = wantjump;
-
-	return {wantleft, wantright, wantjump};
+	return restrictInput(wantleft, wantright, wantjump, elapsed);
 }
@@ -26,10 +26,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include <string>
-#include <random>
+#include <vector>
 
 #include "Global.h"
-#include "InputSource.h"
+#include "BotInputSource.h"
 #include "Vector.h"
 #include "IScriptableComponent.h"
 
@@ -41,36 +41,37 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /// The API documentation can now be found in doc/ScriptAPI.txt
 
-// The time the bot waits after game start
-const int WAITING_TIME = 1500;
-
 struct lua_State;
 class DuelMatch;
 
-class ScriptedInputSource : public InputSource, public IScriptableComponent
+class ScriptedInputSource : public BotInputSource, public IScriptableComponent
 {
 	public:
 		/// The constructor automatically loads and initializes the script
 		/// with the given filename. The side parameter tells the script
-		/// which side is it on.
-		ScriptedInputSource(const std::string& filename, PlayerSide side, unsigned int difficulty);
+		/// which side is it on. The seed initialises the random jump delays.
+		ScriptedInputSource(const std::string& filename, PlayerSide side, unsigned int difficulty,
+							unsigned int seed = std::default_random_engine::default_seed);
 		~ScriptedInputSource() override;
 
+		/// \brief also makes the script independent of the global random generator
+		/// \details math.random of the script draws from the seed given to the constructor
+		///			and pairs visits the keys in sorted order, as lua seeds its string hashes
+		///			differently in every state.
+		void setDeterministic(int gameSpeed) override;
+
 		PlayerInputAbs getNextInput() override;
-		using InputSource::getMatch;
+		using BotInputSource::getMatch;
 
 	private:
+		static int luaRandom(lua_State* state);
+		static int luaOrderedPairs(lua_State* state);
+		static int luaOrderedNext(lua_State* state);
 
-		unsigned int mStartTime;
-
-		// ki strength values
-		int mDifficulty;
-
-		PlayerSide mSide;
+		/// writes the side corrected state of the match into the __WORLD table of the script
+		void pushWorldState();
 
-		// error data
-		bool mLastJump = false;
-		double mJumpDelay = 0;
-		std::normal_distribution<double> mDelayDistribution;
-		std::default_random_engine mRandom;
+		// registry reference of the __WORLD table and the values last written into it
+		int mWorldRef;
+		std::vector<double> mWorldCache;
 };
@@ -23,10 +23,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* includes */
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 
 #include "Global.h"
 #include "FileRead.h"
+#include "ParallelFor.h"
 
 /* implementation */
 SoundManager* SoundManager::mSingleton;
@@ -62,7 +64,6 @@ Sound* SoundManager::loadSound(const std::string& filename) const
 		newSound->data = new Uint8[newSoundLength];
 		memcpy(newSound->data, newSoundBuffer, newSoundLength);
 		newSound->length = newSoundLength;
-		newSound->position = 0;
 		SDL_FreeWAV(newSoundBuffer);
                 return newSound;
 	}
@@ -85,7 +86,6 @@ Sound* SoundManager::loadSound(const std::string& filename) const
 		Sound *newSound = new Sound;
 		newSound->data = conversionStructure.buf;
 		newSound->length = Uint32(conversionStructure.len_cvt);
-		newSound->position = 0;
 		return newSound;
 	}
 }
@@ -107,18 +107,58 @@ bool SoundManager::playSound(const std::string& filename, float volume)
 			soundBuffer = loadSound(filename);
 			mSound[filename] = soundBuffer;
 		}
-		Sound soundInstance = Sound(*soundBuffer);
-		soundInstance.volume =
-			volume > 0.f ? (volume < 1.f ? volume : 1.f) : 0.f;
-		SDL_LockAudioDevice(mAudioDevice);
-		mPlayingSound.push_back(soundInstance);
-		SDL_UnlockAudioDevice(mAudioDevice);
+		Command play;
+		play.type = Command::PLAY;
+		play.sound = soundBuffer;
+		play.volume = volume > 0.f ? (volume < 1.f ? volume : 1.f) : 0.f;
+		return pushCommand(play);
 	}
 	catch (const FileLoadException& exception)
 	{
 		std::cerr << "Warning: " << exception.what() << std::endl;
 		return false;
 	}
+}
+
+void SoundManager::preloadSounds(const std::vector<std::string>& filenames)
+{
+	if (!mInitialised)
+		return;
+
+	std::vector<Sound*> sounds(filenames.size(), nullptr);
+	parallelFor(filenames.size(), [&](int i)
+	{
+		if (mSound.count(filenames[i]))
+			return;
+		try
+		{
+			sounds[i] = loadSound(filenames[i]);
+		}
+		catch (const FileLoadException& exception)
+		{
+			std::cerr << "Warning: " << exception.what() << std::endl;
+		}
+	});
+
+	for (unsigned i = 0; i < filenames.size(); ++i)
+	{
+		if (sounds[i])
+			mSound[filenames[i]] = sounds[i];
+	}
+}
+
+bool SoundManager::pushCommand(const Command& command)
+{
+	const unsigned written = mCommandsWritten.load(std::memory_order_relaxed);
+	if (written - mCommandsRead.load(std::memory_order_acquire) >= COMMAND_QUEUE_SIZE)
+	{
+		// the audio thread is stuck, there is no point in queueing even more sounds
+		++mDroppedSounds;
+		return false;
+	}
+
+	mCommands[written % COMMAND_QUEUE_SIZE] = command;
+	mCommandsWritten.store(written + 1, std::memory_order_release);
 	return true;
 }
 
@@ -126,19 +166,15 @@ bool SoundManager::init()
 {
 	SDL_AudioSpec desiredSpec;
 	desiredSpec.freq = 44100;
-	desiredSpec.format = AUDIO_S16LSB;
+	// the mixer works on 16 bit samples, SDL converts them if the device wants something else
+	desiredSpec.format = AUDIO_S16SYS;
 	desiredSpec.channels = 2;
 	desiredSpec.samples = 1024;
 	desiredSpec.callback = playCallback;
 	desiredSpec.userdata = mSingleton;
 
-	mAudioDevice = SDL_OpenAudioDevice(nullptr, 0, &desiredSpec, &mAudioSpec, SDL_AUDIO_ALLOW_FORMAT_CHANGE);
-
-	if (desiredSpec.format != mAudioSpec.format)
-	{
-		std::cerr << "Warning: Can't create device with desired audio spec!" << std::endl;
-		std::cerr << "Reason: " << SDL_GetError() << std::endl;
-	}
+	mAudioDevice = SDL_OpenAudioDevice(nullptr, 0, &desiredSpec, &mAudioSpec,
+			SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
 
 	if (mAudioDevice == 0)
 	{
@@ -147,42 +183,124 @@ bool SoundManager::init()
 		return false;
 	}
 
+	// allocate everything the audio thread needs before it starts
+	mMixBuffer.resize(mAudioSpec.samples * mAudioSpec.channels);
+	mLastCallback = std::chrono::steady_clock::time_point();
+
 	SDL_PauseAudioDevice(mAudioDevice, 0);
 	mInitialised = true;
 	mVolume = 1.0;
 	return true;
 }
 
-void SoundManager::playCallback(void* singleton, Uint8* stream, int length)
+void SoundManager::handleCommands()
 {
-	SDL_memset(stream, 0, length);
-	std::list<Sound>& playingSound = ((SoundManager*)singleton)->mPlayingSound;
-	int volume = int(SDL_MIX_MAXVOLUME * ((SoundManager*)singleton)->mVolume);
+	const unsigned written = mCommandsWritten.load(std::memory_order_acquire);
+	unsigned read = mCommandsRead.load(std::memory_order_relaxed);
+	const float master = mVolume.load(std::memory_order_relaxed);
 
-	for (auto iter = playingSound.begin(); iter != playingSound.end(); ++iter)
+	for (; read != written; ++read)
 	{
-		int bytesLeft = iter->length - iter->position;
-		if (bytesLeft < length)
+		const Command& command = mCommands[read % COMMAND_QUEUE_SIZE];
+		if (command.type == Command::STOP_ALL)
 		{
-			SDL_MixAudio(stream, iter->data + iter->position, bytesLeft, int(volume * iter->volume));
-			auto eraseIter = iter;
-			auto nextIter = ++iter;
-			playingSound.erase(eraseIter);
-			iter = nextIter;
-			// prevents increment of past-end-interator
-			if(iter == playingSound.end())
-				break;
+			mVoices.fill(Voice());
+			continue;
 		}
-		else
+
+		auto voice = std::find_if(mVoices.begin(), mVoices.end(), [](const Voice& v) { return v.samples == nullptr; });
+		if (voice == mVoices.end())
 		{
-			SDL_MixAudioFormat(stream, iter->data + iter->position, mSingleton->mAudioSpec.format, length, int(volume * iter->volume));
-			iter->position += length;
+			++mDroppedSounds;
+			continue;
 		}
+
+		voice->samples = reinterpret_cast<const Sint16*>(command.sound->data);
+		voice->length = command.sound->length / sizeof(Sint16);
+		voice->position = 0;
+		voice->volume = command.volume;
+		voice->gain = command.volume * master;
 	}
+
+	mCommandsRead.store(read, std::memory_order_release);
+}
+
+void SoundManager::mix(Sint16* stream, int samples)
+{
+	// SDL asks for the buffer size negotiated in init(), so this does not allocate
+	if ((int)mMixBuffer.size() < samples)
+		mMixBuffer.resize(samples);
+
+	float* mixed = mMixBuffer.data();
+	std::fill(mixed, mixed + samples, 0.f);
+
+	const float master = mVolume.load(std::memory_order_relaxed);
+	for (auto& voice : mVoices)
+	{
+		if (!voice.samples)
+			continue;
+
+		// volume changes fade over one buffer instead of jumping, which would click
+		const float start = voice.gain;
+		const float target = voice.volume * master;
+		const float step = (target - start) / samples;
+		const Sint16* source = voice.samples + voice.position;
+		const int count = std::min(samples, voice.length - voice.position);
+
+		for (int i = 0; i < count; ++i)
+			mixed[i] += source[i] * (start + step * i);
+
+		voice.gain = target;
+		voice.position += count;
+		if (voice.position >= voice.length)
+			voice = Voice();
+	}
+
+	for (int i = 0; i < samples; ++i)
+		stream[i] = Sint16(std::min(std::max(mixed[i], -32768.f), 32767.f));
+}
+
+void SoundManager::playCallback(void* singleton, Uint8* stream, int length)
+{
+	using namespace std::chrono;
+	SoundManager* manager = (SoundManager*)singleton;
+	const auto start = steady_clock::now();
+
+	// if the callback is much later than the time the last buffer lasts, the device ran dry
+	const int channels = std::max<int>(manager->mAudioSpec.channels, 1);
+	const auto bufferTime = microseconds(1000000LL * length / (sizeof(Sint16) * channels * manager->mAudioSpec.freq));
+	if (manager->mLastCallback != steady_clock::time_point() && start - manager->mLastCallback > 2 * bufferTime)
+		++manager->mUnderruns;
+	manager->mLastCallback = start;
+
+	manager->handleCommands();
+	manager->mix(reinterpret_cast<Sint16*>(stream), length / sizeof(Sint16));
+
+	const int mixTime = duration_cast<microseconds>(steady_clock::now() - start).count();
+	manager->mMixTime += mixTime;
+	int maxMixTime = manager->mMaxMixTime.load(std::memory_order_relaxed);
+	while (mixTime > maxMixTime && !manager->mMaxMixTime.compare_exchange_weak(maxMixTime, mixTime))
+		;
+	++manager->mCallbacks;
+}
+
+SoundManager::Statistics SoundManager::getStatistics() const
+{
+	Statistics statistics;
+	statistics.callbacks = mCallbacks;
+	statistics.underruns = mUnderruns;
+	statistics.droppedSounds = mDroppedSounds;
+	statistics.averageMixTime = statistics.callbacks ? int(mMixTime / statistics.callbacks) : 0;
+	statistics.maxMixTime = mMaxMixTime;
+	return statistics;
 }
 
 void SoundManager::deinit()
 {
+	// stop the audio thread before the sounds it plays are freed
+	SDL_CloseAudioDevice(mAudioDevice);
+	mInitialised = false;
+
 	for (auto& iter : mSound)
 	{
 		if (iter.second)
@@ -191,9 +309,15 @@ void SoundManager::deinit()
 			delete iter.second;
 		}
 	}
-	SDL_UnlockAudioDevice(mAudioDevice);
-	SDL_CloseAudioDevice(mAudioDevice);
-	mInitialised = false;
+	mSound.clear();
+
+	Statistics statistics = getStatistics();
+	if (statistics.underruns > 0 || statistics.droppedSounds > 0)
+	{
+		std::cerr << "Warning: " << statistics.underruns << " audio underruns in " << statistics.callbacks
+			<< " callbacks, " << statistics.droppedSounds << " sounds dropped, mixing took "
+			<< statistics.averageMixTime << "us on average and " << statistics.maxMixTime << "us at most" << std::endl;
+	}
 }
 
 SoundManager* SoundManager::createSoundManager()
@@ -201,7 +325,15 @@ SoundManager* SoundManager::createSoundManager()
 	return new SoundManager();
 }
 
-SoundManager::SoundManager()
+SoundManager::SoundManager() :
+	mVolume(1.f),
+	mCommandsWritten(0),
+	mCommandsRead(0),
+	mCallbacks(0),
+	mUnderruns(0),
+	mDroppedSounds(0),
+	mMixTime(0),
+	mMaxMixTime(0)
 {
 	mMute = false;
 	mSingleton = this;
@@ -237,20 +369,16 @@ void SoundManager::setMute(bool mute)
 	if( mute == mMute )
 		return;
 
-	static bool locked = false;
-	if (mute)
-	{
-		if (!locked)  //locking audio twice leads to a bug(??)
-		{
-			locked = true;
-			SDL_LockAudioDevice(mAudioDevice);
-		}
-	}
-	else
+	if (!mute)
 	{
-		mPlayingSound.clear();
-		SDL_UnlockAudioDevice(mAudioDevice);
-		locked = false;
+		// sounds that were playing when the game was muted are not continued
+		Command stop;
+		stop.type = Command::STOP_ALL;
+		stop.sound = nullptr;
+		stop.volume = 0;
+		pushCommand(stop);
+		// the pause is not an underrun
+		mLastCallback = std::chrono::steady_clock::time_point();
 	}
 	mMute = mute;
 	SDL_PauseAudioDevice(mAudioDevice, (int)mute);
@@ -28,7 +28,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <SDL2/SDL.h>
 #include <string>
 #include <map>
-#include <list>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
 #include "BlobbyDebug.h"
 
 /// \brief struct for holding sound data
@@ -41,26 +44,45 @@ struct Sound : public ObjectCounter<Sound>
 
 	Uint8* data;
 	Uint32 length;
-	int position;
-	float volume;
 };
 
 /*! \class SoundManager
 	\brief class managing game sound.
 	\details Managing loading, converting to target format, muting, setting volume
 			and, of couse, playing of sounds.
+			The game thread never touches the playing sounds. It sends commands through
+			a lock free queue to the audio callback, which owns a fixed number of voices
+			and mixes them as floats before clipping them to 16 bit.
 */
 class SoundManager : public ObjectCounter<SoundManager>
 {
 	public:
+		/// counters of the audio thread since init()
+		struct Statistics
+		{
+			unsigned callbacks = 0;
+			unsigned underruns = 0;		///< callbacks that came too late to keep the device fed
+			unsigned droppedSounds = 0;	///< sounds not played because the queue or all voices were full
+			int averageMixTime = 0;		///< in us
+			int maxMixTime = 0;			///< in us
+		};
+
 		static SoundManager* createSoundManager();
 		static SoundManager& getSingleton();
 
 		bool init();
 		void deinit();
 		bool playSound(const std::string& filename, float volume);
+		/// loads sounds in advance, so playing them the first time doesn't stall the game.
+		/// The files are decoded in parallel.
+		void preloadSounds(const std::vector<std::string>& filenames);
 		void setVolume(float volume);
 		void setMute(bool mute);
+
+		Statistics getStatistics() const;
+
+		/// number of sounds that can be played at the same time
+		static const int MAX_VOICES = 32;
 	private:
 		SoundManager();
 		~SoundManager();
@@ -72,12 +94,54 @@ class SoundManager : public ObjectCounter<SoundManager>
 		/// This maps filenames to sound buffers, which are always in
 		/// target format
 		std::map<std::string, Sound*> mSound;
-		std::list<Sound> mPlayingSound;
 		SDL_AudioSpec mAudioSpec;
 		bool mInitialised;
-		float mVolume;
+		std::atomic<float> mVolume;
 		bool mMute;
 
+		/// message from the game thread to the audio thread
+		struct Command
+		{
+			enum Type
+			{
+				PLAY,
+				STOP_ALL
+			};
+
+			Type type;
+			const Sound* sound;
+			float volume;
+		};
+
+		/// single producer, single consumer ring buffer of commands
+		static const unsigned COMMAND_QUEUE_SIZE = 64;
+		std::array<Command, COMMAND_QUEUE_SIZE> mCommands;
+		std::atomic<unsigned> mCommandsWritten;
+		std::atomic<unsigned> mCommandsRead;
+
+		/// a playing sound, only used by the audio thread
+		struct Voice
+		{
+			const Sint16* samples = nullptr;
+			int length = 0;			///< in samples, all channels counted
+			int position = 0;
+			float volume = 0;		///< volume requested by playSound
+			float gain = 0;			///< effective volume at the end of the last callback
+		};
+
+		std::array<Voice, MAX_VOICES> mVoices;
+		std::vector<float> mMixBuffer;
+		std::chrono::steady_clock::time_point mLastCallback;
+
+		std::atomic<unsigned> mCallbacks;
+		std::atomic<unsigned> mUnderruns;
+		std::atomic<unsigned> mDroppedSounds;
+		std::atomic<unsigned long long> mMixTime;
+		std::atomic<int> mMaxMixTime;
+
 		Sound* loadSound(const std::string& filename) const;
+		bool pushCommand(const Command& command);
+		void handleCommands();
+		void mix(Sint16* stream, int samples);
 		static void playCallback(void* singleton, Uint8* stream, int length);
 };
@@ -32,6 +32,18 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 /// accumulation errors.
 const int PRECISION_FACTOR = 1000;
 
+/// with decoupled drawing, the game steps at most this often before a frame is drawn.
+/// If it is further behind, it slows down.
+const int MAX_CATCHUP_STEPS = 5;
+
+namespace
+{
+	double getTime()
+	{
+		return 1000.0 * SDL_GetPerformanceCounter() / SDL_GetPerformanceFrequency();
+	}
+}
+
 SpeedController* SpeedController::mMainInstance = nullptr;
 
 SpeedController::SpeedController(float gameFPS)
@@ -44,6 +56,10 @@ SpeedController::SpeedController(float gameFPS)
 	mFPS = 0;
 	mBeginSecond = mOldTicks;
 	mCounter = 0;
+	mLateness = 0;
+	mRenderFPS = 0;
+	mNextStep = 0;
+	mNextFrame = 0;
 }
 
 SpeedController::~SpeedController() = default;
@@ -57,6 +73,48 @@ void SpeedController::setGameSpeed(float fps)
 	/// \todo maybe we should reset only if speed changed?
 	mBeginSecond = mOldTicks;
 	mCounter = 0;
+	mNextStep = 0;
+}
+
+void SpeedController::setRenderFPS(float fps)
+{
+	mRenderFPS = std::max(0.f, fps);
+	mNextStep = 0;
+	mFramedrop = false;
+}
+
+int SpeedController::getDueSteps()
+{
+	if (mRenderFPS <= 0)
+		return 1;
+
+	double now = getTime();
+	double stepTime = 1000.0 / mGameFPS;
+	if (mNextStep == 0)
+		mNextStep = now;
+
+	int steps = 0;
+	while (mNextStep <= now && steps < MAX_CATCHUP_STEPS)
+	{
+		mNextStep += stepTime;
+		++steps;
+	}
+
+	// too far behind to catch up
+	if (mNextStep <= now)
+		mNextStep = now + stepTime;
+
+	return steps;
+}
+
+float SpeedController::getStepFraction() const
+{
+	if (mRenderFPS <= 0)
+		return 1;
+
+	double stepTime = 1000.0 / mGameFPS;
+	double fraction = 1 - (mNextStep - getTime()) / stepTime;
+	return std::max(0.0, std::min(1.0, fraction));
 }
 
 bool SpeedController::doFramedrop() const
@@ -66,6 +124,26 @@ bool SpeedController::doFramedrop() const
 
 void SpeedController::update()
 {
+	if (mRenderFPS > 0)
+	{
+		// wait for the next step or the next frame, whichever is due first. No framedrops
+		// are necessary, as slow frames only reduce the number of frames between steps.
+		double now = getTime();
+		mNextFrame = std::max(mNextFrame + 1000.0 / mRenderFPS, now);
+		double wait = std::min(mNextFrame, mNextStep) - now;
+		if (wait >= 1)
+			SDL_Delay(static_cast<int>(wait));
+
+		mFPSCounter++;
+		if (SDL_GetTicks() >= static_cast<unsigned>(mOldTicks + 1000))
+		{
+			mOldTicks = SDL_GetTicks();
+			mFPS = mFPSCounter;
+			mFPSCounter = 0;
+		}
+		return;
+	}
+
 	int rateTicks = std::max( static_cast<int>(PRECISION_FACTOR * 1000 / mGameFPS), 1);
 	
 	static int lastTicks = SDL_GetTicks();
@@ -101,6 +179,9 @@ void SpeedController::update()
 	} else
 		mFramedrop = false;
 
+	// after waiting, the next frame should start exactly on schedule
+	mLateness = std::max(0, static_cast<int>(SDL_GetTicks() - mBeginSecond) - (mCounter + 1) * rateTicks / PRECISION_FACTOR);
+
 	mCounter++;
 
 	//calculate the FPS of drawn frames:
@@ -58,6 +58,18 @@ class SpeedController : public ObjectCounter<SpeedController>
 	/// This updates everything and waits the necessary time
 		void update();
 
+	/// Frames can be drawn more often than the game steps, up to renderFPS. Frames between
+	/// steps are interpolated. 0 draws one frame per step.
+		void setRenderFPS(float fps);
+	/// returns how many game steps are due before the next frame is drawn. Without a render
+	/// fps, this is always 1.
+		int getDueSteps();
+	/// how far the time has advanced from the last game step to the next one, between 0 and 1
+		float getStepFraction() const;
+
+	/// returns how many ms the current frame started later than scheduled by the last update
+		int getLateness() const { return mLateness; }
+
 		static void setMainInstance(SpeedController* inst) { mMainInstance = inst; }
 		static SpeedController* getMainInstance() { return mMainInstance; }
 	private:
@@ -68,6 +80,12 @@ class SpeedController : public ObjectCounter<SpeedController>
 		bool mDrawFPS;
 		static SpeedController* mMainInstance;
 		int mOldTicks;
+		int mLateness;
+
+		// decoupled drawing, times in ms
+		float mRenderFPS;
+		double mNextStep;
+		double mNextFrame;
 
 		// internal data
 		unsigned int mBeginSecond;
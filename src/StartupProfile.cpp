@@ -0,0 +1,47 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "StartupProfile.h"
+
+/* includes */
+#include <iostream>
+
+/* implementation */
+bool StartupProfile::mEnabled = false;
+std::chrono::steady_clock::time_point StartupProfile::mStart = std::chrono::steady_clock::now();
+std::chrono::steady_clock::time_point StartupProfile::mLastPhase = StartupProfile::mStart;
+
+void StartupProfile::enable(bool enable)
+{
+	mEnabled = enable;
+}
+
+void StartupProfile::endPhase(const std::string& name)
+{
+	if (!mEnabled)
+		return;
+
+	using namespace std::chrono;
+	const auto now = steady_clock::now();
+	std::cout << "startup: " << name << " " << duration_cast<milliseconds>(now - mLastPhase).count()
+		<< " ms (" << duration_cast<milliseconds>(now - mStart).count() << " ms total)" << std::endl;
+	mLastPhase = now;
+}
@@ -184,6 +184,16 @@ void TextManager::setDefault()
 	mStrings[RP_SAVE_NAME] = "name of the replay:";
 	mStrings[RP_WAIT_REPLAY] = "receiving replay...";
 	mStrings[RP_SAVE] = "save replay";
+	mStrings[RP_SORT_DATE] = "by date";
+	mStrings[RP_SORT_PLAYER] = "by player";
+	mStrings[RP_SORT_SCORE] = "by score";
+	mStrings[RP_FILTER] = "player:";
+	mStrings[RP_FILTER_WINNER] = "winner:";
+	mStrings[RP_DATE_ANY] = "all";
+	mStrings[RP_DATE_DAY] = "day";
+	mStrings[RP_DATE_WEEK] = "week";
+	mStrings[RP_DATE_MONTH] = "month";
+	mStrings[RP_DATE_YEAR] = "year";
 
 	mStrings[GAME_WIN] = "has won the game!";
 	mStrings[GAME_TRY_AGAIN] = "try again";
@@ -212,6 +222,8 @@ void TextManager::setDefault()
 	mStrings[NET_RULES_TITLE] = "rules: ";
 	mStrings[NET_RULES_BY] = " by ";
 	mStrings[NET_CHALLENGER] = "challenger: ";
+	mStrings[NET_SPECTATE] = "watch game";
+	mStrings[NET_SERVER_BUSY] = "server busy";
 
 	mStrings[OP_TOUCH_TYPE] = "touch input type:";
 	mStrings[OP_TOUCH_ARROWS] = "arrow keys";
@@ -76,6 +76,16 @@ class TextManager
 			RP_SAVE_NAME,
 			RP_WAIT_REPLAY,
 			RP_SAVE,
+			RP_SORT_DATE,
+			RP_SORT_PLAYER,
+			RP_SORT_SCORE,
+			RP_FILTER,
+			RP_FILTER_WINNER,
+			RP_DATE_ANY,
+			RP_DATE_DAY,
+			RP_DATE_WEEK,
+			RP_DATE_MONTH,
+			RP_DATE_YEAR,
 
 			// game texts
 			GAME_WIN,
@@ -106,6 +116,8 @@ class TextManager
 			NET_RULES_TITLE,
 			NET_RULES_BY,
 			NET_CHALLENGER,
+			NET_SPECTATE,
+			NET_SERVER_BUSY,
 
 			// options
 			OP_TOUCH_TYPE,
@@ -0,0 +1,160 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "BotBrain.h"
+
+/* implementation */
+
+namespace
+{
+	// character
+	const int MIN_STRENGTH = 30;
+	const int MAX_STRENGTH = 55;
+	const int BACK_LIMIT = 10;
+	// chosen so that the ball flies close to the net, but out of reach of the opponent
+	const int SERVE_OFFSET = -6;
+}
+
+/// \class Com11Brain
+/// \brief Native port of the bot com_11.lua (Combot 1.1 by Oreon, Axji & Enormator)
+/// \details Plays exactly like the script, including its quirks, so that both can
+///	be compared in blobby-tournament.
+class Com11Brain : public BotBrain
+{
+	private:
+		void onOpponentServe() override
+		{
+			moveto(130);
+			generateStrength();
+		}
+
+		void onServe(bool ballReady) override
+		{
+			mSmash = true;
+			generateStrength();
+			if (ballReady && moveto(ballx() + SERVE_OFFSET))
+				jump();
+		}
+
+		void onGame() override
+		{
+			double target = estimateAtY(CONST_BALL_BLOBBY_HEAD).x;
+			double targetNet = estimateAtY(CONST_NET_HEIGHT + CONST_NET_RADIUS).x;
+			checkSmash();
+
+			// the ball is none of our business, wait at the default position
+			if (target > CONST_FIELD_MIDDLE)
+			{
+				moveto(135);
+				generateStrength();
+				return;
+			}
+
+			// always smash balls that roll over the net
+			if (targetNet > CONST_BALL_LEFT_NET - 10 && targetNet != std::numeric_limits<double>::infinity())
+				mSmash = true;
+
+			Ball atJump = estimateAtY(CONST_BLOBBY_MAX_JUMP);
+			if (mSmash)
+			{
+				if (atJump.vx < 2)
+					jumpAttack(mStrength, atJump.x);
+				else
+					pass();
+				return;
+			}
+
+			moveto(target);
+		}
+
+		void jumpAttack(double strength, double targetJump)
+		{
+			if (oppTouchable(ballTimeToY(CONST_BLOBBY_MAX_JUMP)))
+			{
+				moveto(CONST_FIELD_MIDDLE);
+				jumpTo(383);
+				return;
+			}
+
+			// play less steep from further back, as the ball would not get across the net otherwise
+			strength = std::max(strength, MIN_STRENGTH + BACK_LIMIT * (targetJump / CONST_BALL_LEFT_NET));
+			// and less flat, as the ball would end up in the net
+			strength = std::min(strength, MAX_STRENGTH - BACK_LIMIT * (targetJump / CONST_BALL_LEFT_NET));
+			moveto(targetJump - strength);
+			jumpTo(383);
+		}
+
+		void checkSmash()
+		{
+			// no attack with the third touch or while the ball is on the other side
+			if (touches() == 3 || ballx() > CONST_FIELD_MIDDLE)
+				mSmash = false;
+			// attack after the first touch already if the ball comes in well
+			else if (touches() == 1 && std::abs(bspeedx()) < 2)
+				mSmash = true;
+			else
+				mSmash = touches() == 2;
+		}
+
+		void generateStrength()
+		{
+			mStrength = random(MIN_STRENGTH, MAX_STRENGTH);
+		}
+
+		void jumpTo(double y)
+		{
+			if (blobTimeToY(y) >= ballTimeToY(y))
+				jump();
+		}
+
+		// only valid before the jump, as the vertical blob speed is not known
+		double blobTimeToY(double y) const
+		{
+			return parabolaTimeFirst(144.5, 14.5, -0.44, y);
+		}
+
+		void pass()
+		{
+			moveto(200);
+			jumpTo(simulate(luaSteps(ballTimeToX(200)), ball()).y);
+		}
+
+		bool oppTouchable(double time)
+		{
+			return simulate(luaSteps(time), ball()).x >= CONST_BALL_RIGHT_NET - CONST_BALL_RADIUS;
+		}
+
+		// simulate of the lua api only accepts whole numbers of steps and does not simulate at all
+		// otherwise. The script relies on this without knowing, so we have to as well.
+		static int luaSteps(double time)
+		{
+			return time == std::floor(time) && time < std::numeric_limits<int>::max() ? int(time) : 0;
+		}
+
+		bool mSmash = true;
+		int mStrength = MIN_STRENGTH;
+};
+
+static BotBrain::Registration<Com11Brain> registration("com_11_native");
@@ -55,6 +55,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "SpeedController.h"
 #include "Blood.h"
 #include "FileSystem.h"
+#include "FileRead.h"
+#include "StartupProfile.h"
 #include "state/State.h"
 
 #if defined(WIN32)
@@ -195,13 +197,23 @@ void setupPHYSFS()
 
 	DEBUG_STATUS("started main");
 
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--profile-startup") == 0)
+			StartupProfile::enable(true);
+	}
+
 	FileSystem filesys(argv[0]);
 	setupPHYSFS();
+	// keep the compiled lua scripts, so that the parser only runs for changed scripts
+	filesys.probeDir("luacache");
+	FileRead::setLuaCacheDirectory("luacache");
 
 	DEBUG_STATUS("physfs initialised");
+	StartupProfile::endPhase("file system");
 
 	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_JOYSTICK);
-
+	StartupProfile::endPhase("SDL");
 
 	DEBUG_STATUS("SDL initialised");
 
@@ -241,6 +253,7 @@ void setupPHYSFS()
 		gameConfig.loadFile("config.xml");
 
 		IMGUI::getSingleton().setTextMgr(gameConfig.getString("language"));
+		StartupProfile::endPhase("config and texts");
 
 		if(gameConfig.getString("device") == "SDL")
 			rmanager = RenderManager::createRenderManagerSDL();
@@ -265,35 +278,44 @@ void setupPHYSFS()
 			rmanager->showShadow(true);
 		else
 			rmanager->showShadow(false);
+		rmanager->showDrawCalls(gameConfig.getBool("show_draw_calls", false));
 
 		SpeedController scontroller(gameConfig.getFloat("gamefps"));
 		SpeedController::setMainInstance(&scontroller);
 		scontroller.setDrawFPS(gameConfig.getBool("showfps"));
+		scontroller.setRenderFPS(gameConfig.getFloat("render_fps"));
 
 		smanager = SoundManager::createSoundManager();
 		smanager->init();
 		smanager->setVolume(gameConfig.getFloat("global_volume"));
 		smanager->setMute(gameConfig.getBool("mute"));
-		/// \todo play sound is misleading. what we actually want to do is load the sound
-		smanager->playSound("sounds/bums.wav", 0.0);
-		smanager->playSound("sounds/pfiff.wav", 0.0);
+		StartupProfile::endPhase("sound device");
+		smanager->preloadSounds({"sounds/bums.wav", "sounds/pfiff.wav", "sounds/chat.wav"});
+		StartupProfile::endPhase("sounds");
 
 		std::string bg = std::string("backgrounds/") + gameConfig.getString("background");
 		if ( FileSystem::getSingleton().exists(bg) )
 			rmanager->setBackground(bg);
+		StartupProfile::endPhase("background");
 
 		InputManager* inputmgr = InputManager::createInputManager();
 		int running = 1;
+		bool firstFrame = true;
+		StartupProfile::endPhase("input");
 
 		DEBUG_STATUS("starting mainloop");
 
 		while (running)
 		{
-			inputmgr->updateInput();
-			running = inputmgr->running();
+			// with a render fps, the game steps independently of the drawn frames
+			for (int steps = scontroller.getDueSteps(); steps > 0 && running; --steps)
+			{
+				inputmgr->updateInput();
+				running = inputmgr->running();
 
-			IMGUI::getSingleton().begin();
-			State::step();
+				IMGUI::getSingleton().begin();
+				State::step();
+			}
 			rmanager = &RenderManager::getSingleton(); //RenderManager may change
 			//draw FPS:
 			static int lastfps = 0;
@@ -330,10 +352,16 @@ void setupPHYSFS()
 
 			if (!scontroller.doFramedrop())
 			{
+				State::present(scontroller.getStepFraction());
 				rmanager->draw();
 				IMGUI::getSingleton().end();
 				rmanager->getBlood().step(*rmanager);
 				rmanager->refresh();
+				if (firstFrame)
+				{
+					StartupProfile::endPhase("first frame");
+					firstFrame = false;
+				}
 			}
 			scontroller.update();
 		}
@@ -89,6 +89,8 @@ class IReplayLoader : public ObjectCounter<IReplayLoader>
 
 
 		// Replay data interface
+		// These functions only read the loaded replay. ReplayPlayer calls them from its
+		// keyframe thread while the replay is played, so they must stay safe to call concurrently.
 
 		/// \brief gets the player input at the moment step
 		///	\param step Timestep from when the player input should be received.
@@ -25,7 +25,7 @@ struct ReplaySavePoint;
 constexpr const char legacyHeader[4] = { 'B', 'V', '2', 'R' };	//!< header of replay file
 /// \todo add warning when trying to read old files
 
-constexpr const unsigned char REPLAY_FILE_VERSION_MAJOR = 2;
+constexpr const unsigned char REPLAY_FILE_VERSION_MAJOR = 3;
 constexpr const unsigned char REPLAY_FILE_VERSION_MINOR = 0;
 
 // 10 secs for normal gamespeed
@@ -0,0 +1,122 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ReplayFormat.h"
+
+/* includes */
+#include <algorithm>
+
+/* implementation */
+std::uint32_t readReplayUInt32(const std::uint8_t* data)
+{
+	return std::uint32_t(data[0]) | std::uint32_t(data[1]) << 8 | std::uint32_t(data[2]) << 16 | std::uint32_t(data[3]) << 24;
+}
+
+void writeReplayUInt32(std::vector<std::uint8_t>& target, std::uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+		target.push_back((value >> (8 * i)) & 0xff);
+}
+
+namespace
+{
+	void readSection(const std::uint8_t*& data, ReplaySection& section)
+	{
+		section.offset = readReplayUInt32(data);
+		section.size = readReplayUInt32(data + 4);
+		data += 8;
+	}
+
+	void writeSection(std::vector<std::uint8_t>& target, const ReplaySection& section)
+	{
+		writeReplayUInt32(target, section.offset);
+		writeReplayUInt32(target, section.size);
+	}
+
+	bool isInside(const ReplaySection& section, std::size_t size)
+	{
+		return section.offset <= size && section.size <= size - section.offset;
+	}
+}
+
+bool ReplayHeaderV3::read(const std::uint8_t* data, std::size_t size)
+{
+	if (size < SIZE || !std::equal(replayHeaderV3, replayHeaderV3 + 4, data))
+		return false;
+
+	data += 4;
+	major = data[0];
+	minor = data[1];
+	flags = data[2] | data[3] << 8;
+	gameSpeed = readReplayUInt32(data + 4);
+	gameLength = readReplayUInt32(data + 8);
+	gameDuration = readReplayUInt32(data + 12);
+	gameDate = std::int64_t(std::uint64_t(readReplayUInt32(data + 16)) | std::uint64_t(readReplayUInt32(data + 20)) << 32);
+	data += 24;
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		score[player] = readReplayUInt32(data);
+		color[player] = readReplayUInt32(data + 4);
+		data += 8;
+	}
+
+	for (auto& name : names)
+		readSection(data, name);
+	readSection(data, rules);
+	readSection(data, input);
+	readSection(data, inputIndex);
+	readSection(data, savePointTable);
+	readSection(data, savePoints);
+
+	for (const ReplaySection* section : {&names[LEFT_PLAYER], &names[RIGHT_PLAYER], &rules, &input, &inputIndex, &savePointTable, &savePoints})
+	{
+		if (!isInside(*section, size))
+			return false;
+	}
+	return savePointTable.size % REPLAY_SAVE_POINT_ENTRY_SIZE == 0 && inputIndex.size % 8 == 0;
+}
+
+void ReplayHeaderV3::write(std::vector<std::uint8_t>& target) const
+{
+	target.insert(target.end(), replayHeaderV3, replayHeaderV3 + 4);
+	target.push_back(major);
+	target.push_back(minor);
+	target.push_back(flags & 0xff);
+	target.push_back(flags >> 8);
+	writeReplayUInt32(target, gameSpeed);
+	writeReplayUInt32(target, gameLength);
+	writeReplayUInt32(target, gameDuration);
+	writeReplayUInt32(target, std::uint64_t(gameDate) & 0xffffffff);
+	writeReplayUInt32(target, std::uint64_t(gameDate) >> 32);
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		writeReplayUInt32(target, score[player]);
+		writeReplayUInt32(target, color[player]);
+	}
+
+	for (const auto& name : names)
+		writeSection(target, name);
+	writeSection(target, rules);
+	writeSection(target, input);
+	writeSection(target, inputIndex);
+	writeSection(target, savePointTable);
+	writeSection(target, savePoints);
+}
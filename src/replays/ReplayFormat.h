@@ -0,0 +1,94 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/// \file ReplayFormat.h
+/// \brief layout of binary replay files (version 3)
+/// \details A version 3 replay starts with a header of fixed size. It is followed by the sections
+///			the header points to. All numbers are little endian, and nothing has to be decoded
+///			to find something in the file, so it can be used straight from memory.
+///			- names: the player names, UTF-8
+///			- rules: the lua rules script, if the EMBEDDED_RULES flag is set
+///			- input: runs of equal input packets. Each run is the packet byte followed by
+///			  the length of the run as LEB128.
+///			- input index: for every REPLAY_INPUT_INDEX_PERIOD steps, the offset of the run
+///			  containing that step and the step the run starts at (2 x uint32)
+///			- save point table: step, offset and size of every save point (3 x uint32), sorted by step
+///			- save points: the save points, serialized with GenericIO
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Global.h"
+
+constexpr const char replayHeaderV3[4] = { 'B', 'V', '3', 'R' };	//!< first bytes of a version 3 replay
+
+/// steps between two entries of the input index
+const int REPLAY_INPUT_INDEX_PERIOD = 1024;
+/// size of a save point table entry in bytes
+const int REPLAY_SAVE_POINT_ENTRY_SIZE = 12;
+
+/// part of a replay file
+struct ReplaySection
+{
+	std::uint32_t offset = 0;
+	std::uint32_t size = 0;
+};
+
+/// \brief header of a version 3 replay file
+struct ReplayHeaderV3
+{
+	enum Flags
+	{
+		EMBEDDED_RULES = 1
+	};
+
+	std::uint8_t major = 0;
+	std::uint8_t minor = 0;
+	std::uint16_t flags = 0;
+	std::uint32_t gameSpeed = 0;
+	std::uint32_t gameLength = 0;		///< in steps
+	std::uint32_t gameDuration = 0;	///< in seconds
+	std::int64_t gameDate = 0;
+	std::uint32_t score[MAX_PLAYERS] = {};
+	std::uint32_t color[MAX_PLAYERS] = {};
+
+	ReplaySection names[MAX_PLAYERS];
+	ReplaySection rules;
+	ReplaySection input;
+	ReplaySection inputIndex;
+	ReplaySection savePointTable;
+	ReplaySection savePoints;
+
+	/// size of the header in the file, the magic bytes included
+	static const std::size_t SIZE = 100;
+
+	/// \brief reads the header at the start of a replay file
+	/// \details only the first SIZE bytes of \p data are accessed, \p size is the size of the whole file.
+	/// \return false, if \p data is no version 3 replay or a section lies outside of it
+	bool read(const std::uint8_t* data, std::size_t size);
+	/// appends the header, magic bytes included, to \p target
+	void write(std::vector<std::uint8_t>& target) const;
+};
+
+std::uint32_t readReplayUInt32(const std::uint8_t* data);
+void writeReplayUInt32(std::vector<std::uint8_t>& target, std::uint32_t value);
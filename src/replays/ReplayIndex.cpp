@@ -0,0 +1,367 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ReplayIndex.h"
+
+/* includes */
+#include <algorithm>
+#include <iostream>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include "FileRead.h"
+#include "FileWrite.h"
+#include "FileSystem.h"
+#include "GenericIO.h"
+#include "IReplayLoader.h"
+#include "ReplayFormat.h"
+
+/* implementation */
+namespace
+{
+	const char* const INDEX_FILE = "replay_index.dat";
+	/// increase when the layout of ReplayInfo changes, older index files are discarded then
+	const unsigned int INDEX_VERSION = 1;
+	/// number of replays read between two notifications of the browser
+	const int PUBLISH_PERIOD = 64;
+
+	bool compareNames(const ReplayInfo& a, const ReplayInfo& b)
+	{
+		return a.name < b.name;
+	}
+
+	bool matches(const ReplayInfo& info, const ReplayFilter& filter)
+	{
+		if (info.date < filter.minDate || info.date > filter.maxDate)
+			return false;
+
+		if (!filter.player.empty() && !boost::algorithm::icontains(info.player[LEFT_PLAYER], filter.player) &&
+				!boost::algorithm::icontains(info.player[RIGHT_PLAYER], filter.player))
+			return false;
+
+		// a draw has no winner
+		if (!filter.winner.empty())
+		{
+			if (info.score[LEFT_PLAYER] == info.score[RIGHT_PLAYER])
+				return false;
+			PlayerSide winner = info.score[LEFT_PLAYER] > info.score[RIGHT_PLAYER] ? LEFT_PLAYER : RIGHT_PLAYER;
+			if (!boost::algorithm::icontains(info.player[winner], filter.winner))
+				return false;
+		}
+
+		return true;
+	}
+}
+
+USER_SERIALIZER_IMPLEMENTATION_HELPER(ReplayInfo)
+{
+	io.string(value.name);
+	io.uint32(value.size);
+	io.uint32(value.modified);
+	io.boolean(value.indexed);
+	io.boolean(value.valid);
+	for (int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+	{
+		io.string(value.player[player]);
+		io.uint32(value.score[player]);
+	}
+	io.uint32(value.date);
+	io.uint32(value.speed);
+	io.uint32(value.duration);
+}
+
+ReplayIndex::ReplayIndex()
+{
+	mThread = std::thread(&ReplayIndex::refresh, this);
+}
+
+ReplayIndex::~ReplayIndex()
+{
+	mStop = true;
+	mThread.join();
+
+	if (mChanged)
+		save();
+}
+
+std::vector<ReplayInfo> ReplayIndex::query(const ReplayFilter& filter, SortKey key) const
+{
+	std::vector<ReplayInfo> result;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& entry : mEntries)
+		{
+			if (matches(entry, filter))
+				result.push_back(entry);
+		}
+	}
+
+	// newest first, this is also the order for entries that are equal by the chosen key
+	std::sort(result.begin(), result.end(), [](const ReplayInfo& a, const ReplayInfo& b)
+	{
+		return a.date != b.date ? a.date > b.date : a.name > b.name;
+	});
+
+	switch (key)
+	{
+		case SORT_PLAYER:
+			std::stable_sort(result.begin(), result.end(), [](const ReplayInfo& a, const ReplayInfo& b)
+			{
+				if (!boost::algorithm::iequals(a.player[LEFT_PLAYER], b.player[LEFT_PLAYER]))
+					return boost::algorithm::ilexicographical_compare(a.player[LEFT_PLAYER], b.player[LEFT_PLAYER]);
+				return boost::algorithm::ilexicographical_compare(a.player[RIGHT_PLAYER], b.player[RIGHT_PLAYER]);
+			});
+			break;
+		case SORT_SCORE:
+			std::stable_sort(result.begin(), result.end(), [](const ReplayInfo& a, const ReplayInfo& b)
+			{
+				auto winner = [](const ReplayInfo& info) { return std::max(info.score[LEFT_PLAYER], info.score[RIGHT_PLAYER]); };
+				auto loser = [](const ReplayInfo& info) { return std::min(info.score[LEFT_PLAYER], info.score[RIGHT_PLAYER]); };
+				if (winner(a) != winner(b))
+					return winner(a) > winner(b);
+				return loser(a) > loser(b);
+			});
+			break;
+		default:
+			break;
+	}
+
+	return result;
+}
+
+void ReplayIndex::remove(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto found = findEntry(name);
+	if (found != mEntries.end())
+	{
+		mEntries.erase(found);
+		mChanged = true;
+		++mRevision;
+	}
+}
+
+std::vector<ReplayInfo>::iterator ReplayIndex::findEntry(const std::string& name)
+{
+	ReplayInfo key;
+	key.name = name;
+	auto found = std::lower_bound(mEntries.begin(), mEntries.end(), key, compareNames);
+	return found != mEntries.end() && found->name == name ? found : mEntries.end();
+}
+
+ReplayInfo ReplayIndex::readReplayInfo(const std::string& name)
+{
+	const std::string filename = "replays/" + name + ".bvr";
+
+	ReplayInfo info;
+	info.name = name;
+	info.indexed = true;
+
+	int64_t size, modified;
+	if (FileSystem::getSingleton().getFileInfo(filename, size, modified))
+	{
+		info.size = size;
+		info.modified = modified;
+	}
+
+	try
+	{
+		ReplayHeaderV3 header;
+		std::uint8_t headerData[ReplayHeaderV3::SIZE];
+		bool binary = false;
+		{
+			FileRead file(filename);
+			if (file.length() >= sizeof(headerData))
+			{
+				file.readRawBytes(reinterpret_cast<char*>(headerData), sizeof(headerData));
+				binary = header.read(headerData, file.length());
+			}
+
+			// the header knows where the names are, the rest of the file is not needed
+			for (int player = LEFT_PLAYER; binary && player < MAX_PLAYERS; ++player)
+			{
+				info.player[player].resize(header.names[player].size);
+				if (info.player[player].empty())
+					continue;
+				file.seek(header.names[player].offset);
+				file.readRawBytes(&info.player[player][0], info.player[player].size());
+			}
+		}
+
+		if (binary)
+		{
+			info.date = header.gameDate;
+			info.speed = header.gameSpeed;
+			info.duration = header.gameDuration;
+			for (int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+				info.score[player] = header.score[player];
+		}
+		else
+		{
+			std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader(filename));
+			for (int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+			{
+				info.player[player] = loader->getPlayerName((PlayerSide)player);
+				info.score[player] = loader->getFinalScore((PlayerSide)player);
+			}
+			info.date = loader->getDate();
+			info.speed = loader->getSpeed();
+			info.duration = loader->getDuration();
+		}
+
+		info.valid = true;
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "could not index replay " << filename << ": " << e.what() << std::endl;
+	}
+
+	return info;
+}
+
+void ReplayIndex::refresh()
+{
+	load();
+
+	std::vector<ReplayInfo> cached;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		cached = mEntries;
+	}
+
+	// first only compare size and modification time, this does not open any replay
+	std::vector<ReplayInfo> entries;
+	std::vector<std::string> pending;
+	for (const auto& name : FileSystem::getSingleton().enumerateFiles("replays", ".bvr"))
+	{
+		ReplayInfo info;
+		info.name = name;
+		int64_t size = 0, modified = 0;
+		FileSystem::getSingleton().getFileInfo("replays/" + name + ".bvr", size, modified);
+		info.size = size;
+		info.modified = modified;
+
+		auto found = std::lower_bound(cached.begin(), cached.end(), info, compareNames);
+		if (found != cached.end() && found->name == name && found->indexed &&
+				found->size == info.size && found->modified == info.modified)
+		{
+			entries.push_back(*found);
+			continue;
+		}
+
+		// until it has been read, the file date is the best guess for sorting
+		info.date = info.modified;
+		pending.push_back(name);
+		entries.push_back(info);
+	}
+	std::sort(entries.begin(), entries.end(), compareNames);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mChanged = mChanged || !pending.empty() || entries.size() != cached.size();
+		mEntries = std::move(entries);
+	}
+	++mRevision;
+
+	// then read the new and changed replays
+	// entries may be removed in the meantime, so they are looked up by name every time
+	for (std::size_t i = 0; i < pending.size() && !mStop; ++i)
+	{
+		const std::string& name = pending[i];
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (findEntry(name) == mEntries.end())
+				continue;
+		}
+
+		ReplayInfo info = readReplayInfo(name);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			auto target = findEntry(name);
+			if (target != mEntries.end())
+				*target = info;
+		}
+
+		if ((i + 1) % PUBLISH_PERIOD == 0)
+			++mRevision;
+	}
+	++mRevision;
+
+	if (!mStop)
+	{
+		bool changed;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			changed = mChanged;
+			mChanged = false;
+		}
+		if (changed)
+			save();
+	}
+}
+
+void ReplayIndex::load()
+{
+	if (!FileSystem::getSingleton().exists(INDEX_FILE))
+		return;
+
+	std::vector<ReplayInfo> entries;
+	try
+	{
+		auto in = createGenericReader(std::make_shared<FileRead>(INDEX_FILE));
+		unsigned int version;
+		in->uint32(version);
+		if (version != INDEX_VERSION)
+			return;
+		in->generic<std::vector<ReplayInfo> >(entries);
+		std::sort(entries.begin(), entries.end(), compareNames);
+	}
+	catch (std::exception& e)
+	{
+		// the index is rebuilt from the replays
+		std::cerr << "could not read " << INDEX_FILE << ": " << e.what() << std::endl;
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries = std::move(entries);
+}
+
+void ReplayIndex::save() const
+{
+	std::vector<ReplayInfo> entries;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		entries = mEntries;
+	}
+
+	try
+	{
+		auto out = createGenericWriter(std::make_shared<FileWrite>(INDEX_FILE));
+		out->uint32(INDEX_VERSION);
+		out->generic<std::vector<ReplayInfo> >(entries);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "could not write " << INDEX_FILE << ": " << e.what() << std::endl;
+	}
+}
@@ -0,0 +1,109 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Global.h"
+
+/// \brief what the replay browser needs to know about a replay
+struct ReplayInfo
+{
+	std::string name;						///< file name without directory and extension
+	unsigned int size = 0;					///< size of the file when it was indexed
+	unsigned int modified = 0;				///< modification time of the file when it was indexed
+	bool indexed = false;					///< false until the fields below have been read from the file
+	bool valid = false;						///< false if the file could not be read as a replay
+
+	std::string player[MAX_PLAYERS];
+	unsigned int date = 0;
+	unsigned int score[MAX_PLAYERS] = {};
+	unsigned int speed = 0;
+	unsigned int duration = 0;				///< in seconds
+};
+
+/// \brief which replays ReplayIndex::query returns. Empty names match every replay.
+struct ReplayFilter
+{
+	std::string player;						///< part of the name of either player, ignoring case
+	std::string winner;						///< part of the name of the winning player, ignoring case
+	unsigned int minDate = 0;				///< earliest date of the game
+	unsigned int maxDate = -1;				///< latest date of the game
+};
+
+/*! \class ReplayIndex
+	\brief Metadata of all saved replays
+	\details Keeps names, date, score, speed and duration of the replays in the replays directory
+			in an index file in the user directory, so the replay browser can list, sort and filter
+			them without opening every replay. On construction, the index file is loaded and a
+			background thread compares it against the size and modification time of the files,
+			reading only new or changed replays. Progress is published through getRevision.
+*/
+class ReplayIndex
+{
+	public:
+		enum SortKey
+		{
+			SORT_DATE,
+			SORT_PLAYER,
+			SORT_SCORE,
+			SORT_COUNT
+		};
+
+		/// loads the index file and starts refreshing it in the background
+		ReplayIndex();
+		/// stops the refresh and saves the index if it changed
+		~ReplayIndex();
+
+		/// \brief gets all replays matching \p filter
+		/// \details newest/alphabetically first/highest score first.
+		std::vector<ReplayInfo> query(const ReplayFilter& filter, SortKey key) const;
+
+		/// changes whenever the result of query may have changed
+		unsigned int getRevision() const { return mRevision; }
+
+		/// removes a replay, for example after its file has been deleted
+		void remove(const std::string& name);
+
+		/// \brief reads the info of a replay from its file
+		/// \details for version 3 replays, only the header and the player names are read.
+		static ReplayInfo readReplayInfo(const std::string& name);
+
+	private:
+		void refresh();
+		void load();
+		void save() const;
+		/// finds the entry of a replay, or returns end(). mMutex has to be locked.
+		std::vector<ReplayInfo>::iterator findEntry(const std::string& name);
+
+		mutable std::mutex mMutex;
+		/// sorted by name
+		std::vector<ReplayInfo> mEntries;
+		bool mChanged = false;
+
+		std::atomic<unsigned int> mRevision{0};
+		std::atomic<bool> mStop{false};
+		std::thread mThread;
+};
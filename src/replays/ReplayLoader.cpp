@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "IReplayLoader.h"
 
 /* includes */
+#include <algorithm>
 #include <cassert>
 #include <vector>
 #include <ctime>
@@ -37,16 +38,40 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "GenericIO.h"
 #include "base64.h"
 #include "ReplayDefs.h"
+#include "ReplayFormat.h"
 
 /* implementation */
 IReplayLoader* IReplayLoader::createReplayLoader(const std::string& filename)
 {
-	std::unique_ptr<IReplayLoader> loader(createReplayLoader(0));
+	// binary replays start with their magic bytes, older ones are xml
+	int major = 2;
+	{
+		FileRead file(filename);
+		char magic[4];
+		if(file.length() >= sizeof(magic))
+		{
+			file.readRawBytes(magic, sizeof(magic));
+			if(std::equal(magic, magic + sizeof(magic), replayHeaderV3))
+				major = 3;
+		}
+	}
+
+	std::unique_ptr<IReplayLoader> loader(createReplayLoader(major));
 	loader->initLoading(filename);
 
 	return loader.release();
 }
 
+namespace
+{
+	/// sets the inputs of both players from a replay packet
+	void setInputs(unsigned char packet, InputSource* left, InputSource* right)
+	{
+		left->setInput(PlayerInput((bool)(packet & 32), (bool)(packet & 16), (bool)(packet & 8)));
+		right->setInput(PlayerInput((bool)(packet & 4), (bool)(packet & 2), (bool)(packet & 1)));
+	}
+}
+
 //
 // -------------------------------------------------------------------------------------------------
 //
@@ -139,8 +164,7 @@ class ReplayLoader_V2X: public IReplayLoader
 			char packet = mBuffer[mReplayOffset + step];
 
 			// now read the packet data
-			left->setInput(PlayerInput((bool)(packet & 32), (bool)(packet & 16), (bool)(packet & 8)));
-			right->setInput(PlayerInput((bool)(packet & 4), (bool)(packet & 2), (bool)(packet & 1)));
+			setInputs(packet, left, right);
 		}
 
 		bool isSavePoint(int position, int& save_position) const override
@@ -150,43 +174,19 @@ class ReplayLoader_V2X: public IReplayLoader
 			return save_position != -1 && foundPos == position;
 		}
 
-		// TODO: add optional argument: int previous = 0;
-		// 		so we can start from it when calling
-		// 		getSavePoint in a row (without "jumping").
-		// 		we can save this parameter in ReplayPlayer
 		int getSavePoint(int targetPosition, int& savepoint) const override
 		{
-			// desired index can't be lower that this value,
-			// cause additional savepoints could shift it only right
-			int index = targetPosition / REPLAY_SAVEPOINT_PERIOD;
+			// the save points are sorted by step, so the last one
+			// not after targetPosition is found by bisection.
+			auto next = std::upper_bound(mSavePoints.begin(), mSavePoints.end(), targetPosition,
+					[](int position, const ReplaySavePoint& point) { return position < static_cast<int>(point.step); });
 
-			if(index >= static_cast<int>(mSavePoints.size()))
+			if(next == mSavePoints.begin())
 				return -1;
 
-			savepoint = mSavePoints[index].step;
-
-			// watch right from initial index,
-			// cause best savepoint could be there.
-			// we have no much additional savepoints,
-			// so this cycle would be fast,
-			// maybe even faster than binary search.
-			do
-			{
-				int nextIndex = index + 1;
-
-				if (nextIndex >= static_cast<int>(mSavePoints.size()))
-					break;
-
-				int nextPos = mSavePoints[nextIndex].step;
-
-				if (nextPos > targetPosition)
-					break;
-
-				index = nextIndex;
-				savepoint = nextPos;
-			} while (true);
-
-			return index;
+			--next;
+			savepoint = next->step;
+			return next - mSavePoints.begin();
 		}
 
 		void readSavePoint(int index, ReplaySavePoint& state) const override
@@ -320,7 +320,212 @@ class ReplayLoader_V2X: public IReplayLoader
 };
 
 
+//
+// -------------------------------------------------------------------------------------------------
+//
+
+/***************************************************************************************************
+			              R E P L A Y   L O A D E R    V 3.x
+***************************************************************************************************/
+
+
+/*! \class ReplayLoader_V3X
+	\brief Replay Loader V 3.x
+	\details Replay Loader for binary replays. The file is read into memory in one go and everything
+			is looked up in place when it is needed, see ReplayFormat.h for the layout.
+*/
+class ReplayLoader_V3X: public IReplayLoader
+{
+	public:
+		ReplayLoader_V3X() = default;
+
+		~ReplayLoader_V3X() override = default;
+
+		int getVersionMajor() const override { return 3; };
+		int getVersionMinor() const override { return 0; };
+
+		std::string getPlayerName(PlayerSide player) const override
+		{
+			return sectionString(mHeader.names[player]);
+		}
+
+		Color getBlobColor(PlayerSide player) const override
+		{
+			return Color(mHeader.color[player]);
+		}
+
+		int getFinalScore(PlayerSide player) const override
+		{
+			return mHeader.score[player];
+		}
+
+		int getSpeed() const override
+		{
+			return mHeader.gameSpeed;
+		};
+
+		int getDuration() const override
+		{
+			return mHeader.gameDuration;
+		};
+
+		int getLength()  const override
+		{
+			return mHeader.gameLength;
+		};
+
+		std::time_t getDate() const override
+		{
+			return mHeader.gameDate;
+		};
+
+		std::string getRules() const override
+		{
+			if(mHeader.flags & ReplayHeaderV3::EMBEDDED_RULES)
+				return sectionString(mHeader.rules);
+
+			// replays without rules were played with the default ones
+			FileRead file(FileRead::makeLuaFilename("rules/default"));
+			std::string rules(file.length(), ' ');
+			file.readRawBytes(&rules[0], rules.size());
+			return rules;
+		}
+
+		void getInputAt(int step, InputSource* left, InputSource* right) override
+		{
+			assert( step  < getLength() );
+
+			// start at the run the index points to and walk to the one containing step
+			const unsigned int entry = step / REPLAY_INPUT_INDEX_PERIOD;
+			if(entry >= mHeader.inputIndex.size / 8)
+			{
+				setInputs(0, left, right);
+				return;
+			}
+
+			const uint8_t* index = section(mHeader.inputIndex) + 8 * entry;
+			const uint8_t* run = section(mHeader.input) + std::min(readReplayUInt32(index), mHeader.input.size);
+			const uint8_t* end = section(mHeader.input) + mHeader.input.size;
+			const uint32_t gameLength = getLength();
+			uint32_t runStart = readReplayUInt32(index + 4);
+			if(runStart > gameLength)
+				throw std::runtime_error("corrupt input in replay");
+
+			unsigned char packet = 0;
+			while(run < end)
+			{
+				packet = *run++;
+
+				// a 32 bit length takes at most 5 bytes
+				uint32_t length = 0;
+				for(int bytes = 0; ; ++bytes)
+				{
+					if(run == end || bytes == 5)
+						throw std::runtime_error("corrupt input in replay");
+					length |= uint32_t(*run & 0x7f) << (7 * bytes);
+					if(!(*run++ & 0x80))
+						break;
+				}
+
+				if(length > gameLength - runStart)
+					throw std::runtime_error("corrupt input in replay");
+				if(uint32_t(step) < runStart + length)
+					break;
+				runStart += length;
+			}
+
+			setInputs(packet, left, right);
+		}
+
+		bool isSavePoint(int position, int& save_position) const override
+		{
+			int foundPos;
+			save_position = getSavePoint(position, foundPos);
+			return save_position != -1 && foundPos == position;
+		}
+
+		int getSavePoint(int targetPosition, int& savepoint) const override
+		{
+			// the table is sorted by step, find the first entry after targetPosition
+			int low = 0;
+			int high = mHeader.savePointTable.size / REPLAY_SAVE_POINT_ENTRY_SIZE;
+			while(low < high)
+			{
+				int middle = (low + high) / 2;
+				if(savePointStep(middle) <= targetPosition)
+					low = middle + 1;
+				else
+					high = middle;
+			}
+
+			if(low == 0)
+				return -1;
+
+			savepoint = savePointStep(low - 1);
+			return low - 1;
+		}
+
+		void readSavePoint(int index, ReplaySavePoint& state) const override
+		{
+			const uint8_t* entry = section(mHeader.savePointTable) + REPLAY_SAVE_POINT_ENTRY_SIZE * index;
+			uint32_t offset = readReplayUInt32(entry + 4);
+			uint32_t size = readReplayUInt32(entry + 8);
+			if(offset > mHeader.savePoints.size || size > mHeader.savePoints.size - offset)
+				throw std::runtime_error("corrupt save point in replay");
+
+			// the bit stream only reads, it does not need its own copy
+			RakNet::BitStream stream(const_cast<uint8_t*>(section(mHeader.savePoints) + offset), size, false);
+			auto convert = createGenericReader(&stream);
+			convert->generic<ReplaySavePoint> (state);
+		}
+
+	private:
+		void initLoading(std::string filename) override
+		{
+			FileRead file(filename);
+			mSize = file.length();
+			mData = file.readRawBytes(mSize);
+
+			if(!mHeader.read(reinterpret_cast<const uint8_t*>(mData.get()), mSize))
+			{
+				std::cerr << "Warning: " << filename << " is not a valid replay!" << std::endl;
+				throw std::runtime_error("");
+			}
+
+			if(mHeader.major != 3)
+				throw std::runtime_error("");
+		}
+
+		const uint8_t* section(const ReplaySection& part) const
+		{
+			return reinterpret_cast<const uint8_t*>(mData.get()) + part.offset;
+		}
+
+		std::string sectionString(const ReplaySection& part) const
+		{
+			return std::string(reinterpret_cast<const char*>(section(part)), part.size);
+		}
+
+		int savePointStep(int index) const
+		{
+			return readReplayUInt32(section(mHeader.savePointTable) + REPLAY_SAVE_POINT_ENTRY_SIZE * index);
+		}
+
+		boost::shared_array<char> mData;
+		uint32_t mSize;
+		ReplayHeaderV3 mHeader;
+};
+
+
 IReplayLoader* IReplayLoader::createReplayLoader(int major)
 {
-	return new ReplayLoader_V2X();
+	switch(major)
+	{
+		case 2:
+			return new ReplayLoader_V2X();
+		case 3:
+			return new ReplayLoader_V3X();
+		default:
+			return nullptr;
+	}
 }
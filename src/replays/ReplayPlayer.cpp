@@ -22,15 +22,30 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ReplayPlayer.h"
 
 /* includes */
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
 
 #include "IReplayLoader.h"
 #include "DuelMatch.h"
 
 /* implementation */
+namespace
+{
+	// steps between two keyframes, this is the most a seek has to simulate once they are built
+	const int KEYFRAME_PERIOD = 16;
+	// time gotoPlayingPosition may spend in one call, in ms
+	const int MAX_SEEK_TIME = 8;
+}
+
 ReplayPlayer::ReplayPlayer() = default;
 
-ReplayPlayer::~ReplayPlayer() = default;
+ReplayPlayer::~ReplayPlayer()
+{
+	stopKeyframes();
+}
 
 bool ReplayPlayer::endOfFile() const
 {
@@ -39,6 +54,7 @@ bool ReplayPlayer::endOfFile() const
 
 void ReplayPlayer::load(const std::string& filename)
 {
+	stopKeyframes();
 	loader.reset(IReplayLoader::createReplayLoader(filename));
 
 	mPlayerNames[LEFT_PLAYER] = loader->getPlayerName(LEFT_PLAYER);
@@ -83,25 +99,68 @@ std::string ReplayPlayer::getRules() const
 	return loader->getRules();
 }
 
-bool ReplayPlayer::play(DuelMatch* virtual_match)
+void ReplayPlayer::buildKeyframes(const std::string& rules)
 {
-	mPosition++;
-	if( mPosition < mLength )
-	{
+	stopKeyframes();
 
-		PlayerInput left;
-		PlayerInput right;
-		loader->getInputAt(mPosition, virtual_match->getInputSource( LEFT_PLAYER ).get(), virtual_match->getInputSource( RIGHT_PLAYER ).get() );
-		virtual_match->step();
+	// the match is created here, so the rules file is read before anybody can replace it
+	std::shared_ptr<DuelMatch> match = std::make_shared<DuelMatch>(false, rules);
+	mKeyframes.assign(mLength / KEYFRAME_PERIOD + 1, DuelMatchState());
+	mKeyframes[0] = match->getState();
+	mKeyframesReady = 1;
+	mStopKeyframes = false;
 
-		int point;
-		if(loader->isSavePoint(mPosition, point))
+	mKeyframeThread = std::thread([this, match]()
+	{
+		try
+		{
+			for(int position = 1; position < mLength && !mStopKeyframes; ++position)
+			{
+				stepMatch(match.get(), position);
+				if(position % KEYFRAME_PERIOD == 0)
+				{
+					mKeyframes[position / KEYFRAME_PERIOD] = match->getState();
+					mKeyframesReady.store(position / KEYFRAME_PERIOD + 1, std::memory_order_release);
+				}
+			}
+		}
+		catch (std::exception& e)
 		{
-			ReplaySavePoint reference;
-			loader->readSavePoint(point, reference);
-			virtual_match->setState(reference.state);
+			// a corrupt replay or broken rules must not take the game down. The keyframes
+			// built so far stay valid, seeking beyond them uses the save points.
+			std::cerr << "stopped building replay keyframes: " << e.what() << std::endl;
 		}
+	});
+}
 
+void ReplayPlayer::stopKeyframes()
+{
+	mStopKeyframes = true;
+	if(mKeyframeThread.joinable())
+		mKeyframeThread.join();
+	mKeyframesReady = 0;
+}
+
+void ReplayPlayer::stepMatch(DuelMatch* match, int position) const
+{
+	loader->getInputAt(position, match->getInputSource( LEFT_PLAYER ).get(), match->getInputSource( RIGHT_PLAYER ).get() );
+	match->step();
+
+	int point;
+	if(loader->isSavePoint(position, point))
+	{
+		ReplaySavePoint reference;
+		loader->readSavePoint(point, reference);
+		match->setState(reference.state);
+	}
+}
+
+bool ReplayPlayer::play(DuelMatch* virtual_match)
+{
+	mPosition++;
+	if( mPosition < mLength )
+	{
+		stepMatch(virtual_match, mPosition);
 
 		// everything was as expected
 		return true;
@@ -116,48 +175,55 @@ bool ReplayPlayer::gotoPlayingPosition(int rep_position, DuelMatch* virtual_matc
 	/// \todo add validity check for rep_position
 	/// \todo replay clock does not work!
 
+	// the current position can only be used when we go forward
+	int start_position = rep_position >= mPosition ? mPosition : -1;
+	const DuelMatchState* start_state = nullptr;
+
 	// find next safepoint
 	int save_position = -1;
 	int savepoint = loader->getSavePoint(rep_position, save_position);
 	// save position contains game step at which the save point is
 	// savepoint is index of save point in array
-
-	// now compare safepoint and actual position
-	// if we have to forward and save_position is nearer than current position, jump
-	if( (rep_position < mPosition || save_position > mPosition) && savepoint >= 0)
+	ReplaySavePoint state;
+	if( savepoint >= 0 && save_position > start_position )
 	{
-		// can't use mPosition
-		// set match to safepoint
-		ReplaySavePoint state;
 		loader->readSavePoint(savepoint, state);
+		start_position = save_position;
+		start_state = &state.state;
+	}
 
-		// set position and update match
-		mPosition = save_position;
-		virtual_match->setState(state.state);
+	// keyframes are denser than save points, but might not be built that far yet
+	int keyframe = std::min(rep_position / KEYFRAME_PERIOD, mKeyframesReady.load(std::memory_order_acquire) - 1);
+	if( keyframe >= 0 && keyframe * KEYFRAME_PERIOD > start_position )
+	{
+		start_position = keyframe * KEYFRAME_PERIOD;
+		start_state = &mKeyframes[keyframe];
 	}
-	// otherwise, use current position
 
 	// this is legacy code which will make fast forwarding possible even
 	// when we have no safepoint and have to go back
-	if(rep_position < mPosition)
+	if( start_position < 0 )
 	{
 		// reset the match and simulate from start!
 		virtual_match->reset();
-		mPosition = 0;
+		start_position = 0;
 	}
+	else if( start_state )
+	{
+		virtual_match->setState(*start_state);
+	}
+	mPosition = start_position;
 
-	// in the end, simulate the remaining steps
-	// maximum: 100 steps
-	for(int i = 0; i < 100; ++i)
+	// in the end, simulate the remaining steps, but not so many that the frame is late
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(MAX_SEEK_TIME);
+	while( !endOfFile() && rep_position != mPosition )
 	{
-		// check if we have to do another step
-		if(endOfFile() || rep_position == mPosition)
-			return true;
+		if( std::chrono::steady_clock::now() > deadline )
+			return false;
 
 		// do one play step
 		play(virtual_match);
-
 	}
 
-	return false;
+	return true;
 }
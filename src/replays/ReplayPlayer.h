@@ -21,12 +21,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
 
 #include <boost/scoped_ptr.hpp>
 
 #include "Global.h"
 #include "ReplayDefs.h"
 #include "PlayerInput.h"
+#include "DuelMatchState.h"
 #include "BlobbyDebug.h"
 
 class DuelMatch;
@@ -47,6 +51,13 @@ class ReplayPlayer : public ObjectCounter<ReplayPlayer>
 		void load(const std::string& filename);
 		std::string getRules() const;
 
+		/// \brief reconstructs the replay in the background
+		/// \details A match nobody sees plays the whole replay in a background thread and keeps
+		///			its state every few steps. Once a part of the replay is covered, gotoPlayingPosition
+		///			jumps anywhere into it without noticeable delay.
+		/// \param rules name of the rules file the replay is played with
+		void buildKeyframes(const std::string& rules);
+
 		// -----------------------------------------------------------------------------------------
 		// 							Replay Attributes
 		// -----------------------------------------------------------------------------------------
@@ -87,18 +98,29 @@ class ReplayPlayer : public ObjectCounter<ReplayPlayer>
 		bool play(DuelMatch* virtual_match);
 
 		/// \brief Jumps to a position in replay.
-		/// \details Goes to a certain position in replay. Simulates at most 100 steps per call
-		///			to prevent visual lags, so it is possible that this function has to be called
+		/// \details Goes to a certain position in replay. Starts from the nearest keyframe, save point
+		///			or the current position and simulates the rest. To prevent visual lags, it stops
+		///			after a few milliseconds, so it is possible that this function has to be called
 		///			several times to reach the target.
 		/// \param rep_position target position in number of physic steps.
 		/// \return True, if desired position could be reached.
 		bool gotoPlayingPosition(int rep_position, DuelMatch* virtual_match);
 
 	private:
+		/// simulates step \p position of the replay in \p match
+		void stepMatch(DuelMatch* match, int position) const;
+		void stopKeyframes();
 
 		int mPosition;
 		int mLength;
 		boost::scoped_ptr<IReplayLoader> loader;
 
 		std::string mPlayerNames[MAX_PLAYERS];
+
+		/// match states every KEYFRAME_PERIOD steps. The first mKeyframesReady ones
+		/// have been written by the keyframe thread.
+		std::vector<DuelMatchState> mKeyframes;
+		std::atomic<int> mKeyframesReady{0};
+		std::atomic<bool> mStopKeyframes{false};
+		std::thread mKeyframeThread;
 };
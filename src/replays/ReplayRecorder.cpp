@@ -27,24 +27,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <boost/algorithm/string/trim_all.hpp>
 
-#include "tinyxml2.h"
-
 #include "raknet/BitStream.h"
 
 #include "Global.h"
 #include "ReplayDefs.h"
+#include "ReplayFormat.h"
 #include "IReplayLoader.h"
 #include "PhysicState.h"
 #include "GenericIO.h"
 #include "FileRead.h"
 #include "FileWrite.h"
-#include "base64.h"
 
-#ifdef __SWITCH__
-#define SIZET_TYPE unsigned int
-#else
-#define SIZET_TYPE std::uint64_t
-#endif
 
 /* implementation */
 VersionMismatchException::VersionMismatchException(const std::string& filename, uint8_t major, uint8_t minor)
@@ -73,66 +66,101 @@ ReplayRecorder::ReplayRecorder()
 }
 
 ReplayRecorder::~ReplayRecorder() = default;
-template<class T>
-void writeAttribute(tinyxml2::XMLPrinter& printer, const char* name, const T& value)
-{
-	printer.OpenElement("var");
-	printer.PushAttribute("name", name);
-	printer.PushAttribute("value", value);
-	printer.CloseElement();
-}
 
 void ReplayRecorder::save( const std::shared_ptr<FileWrite>& file) const
 {
-	tinyxml2::XMLPrinter printer;
-	printer.PushHeader(false, true);
-	printer.OpenElement("replay");
-	printer.OpenElement("version");
-	printer.PushAttribute("major", REPLAY_FILE_VERSION_MAJOR);
-	printer.PushAttribute("minor", REPLAY_FILE_VERSION_MINOR);
-	printer.CloseElement();
-
-	// the explicit template arguments below are to prevent ambiguities on OSX where
-	// size_t = unsigned long != unsigned int != uint64_t; same for time_t
-	writeAttribute(printer, "game_speed", mGameSpeed);
-	writeAttribute<SIZET_TYPE>(printer, "game_length", mSaveData.size());
-	writeAttribute<SIZET_TYPE>(printer, "game_duration", mSaveData.size() / mGameSpeed);
-	writeAttribute<std::int64_t>(printer, "game_date", std::time(nullptr));
-
-	writeAttribute(printer, "score_left", mEndScore[LEFT_PLAYER]);
-	writeAttribute(printer, "score_right", mEndScore[RIGHT_PLAYER]);
-
-	writeAttribute(printer, "name_left", mPlayerNames[LEFT_PLAYER].c_str());
-	writeAttribute(printer, "name_right", mPlayerNames[RIGHT_PLAYER].c_str());
-
-	/// \todo would be nice if we could write the actual colors instead of integers
-	writeAttribute(printer, "color_left", mPlayerColors[LEFT_PLAYER].toInt());
-	writeAttribute(printer, "color_right", mPlayerColors[RIGHT_PLAYER].toInt());
-
-	// write the game rules
-	printer.OpenElement("rules");
-	printer.PushText(mGameRules.c_str());
-	printer.CloseElement();
-
-	// now comes the actual replay data
-	printer.OpenElement("input");
-	std::string binary = encode(mSaveData, 80);
-	printer.PushText(binary.c_str());
-	printer.CloseElement();
-
-	// finally, write the save points
-	// first, convert them into a POD
-	printer.OpenElement("states");
-	RakNet::BitStream stream;
-	auto convert = createGenericWriter(&stream);
-	convert->generic<std::vector<ReplaySavePoint> > (mSavePoints);
-
-	binary = encode((char*)stream.GetData(), (char*)stream.GetData() + stream.GetNumberOfBytesUsed(), 80);
-	printer.PushText(binary.c_str());
-	printer.CloseElement();
-
-	printer.CloseElement();  // </replay>
-	file->write(printer.CStr(), printer.CStrSize() - 1); // do not save the terminating \0 character
+	ReplayHeaderV3 header;
+	header.major = REPLAY_FILE_VERSION_MAJOR;
+	header.minor = REPLAY_FILE_VERSION_MINOR;
+	header.flags = ReplayHeaderV3::EMBEDDED_RULES;
+	header.gameSpeed = mGameSpeed;
+	header.gameLength = mSaveData.size();
+	header.gameDuration = mSaveData.size() / mGameSpeed;
+	header.gameDate = std::time(nullptr);
+	for (int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+	{
+		header.score[player] = mEndScore[player];
+		header.color[player] = mPlayerColors[player].toInt();
+	}
+
+	// everything behind the header, the sections are appended one after another
+	std::vector<uint8_t> data;
+	auto beginSection = [&](ReplaySection& section)
+	{
+		section.offset = ReplayHeaderV3::SIZE + data.size();
+	};
+	auto endSection = [&](ReplaySection& section)
+	{
+		section.size = ReplayHeaderV3::SIZE + data.size() - section.offset;
+	};
+
+	for (int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+	{
+		beginSection(header.names[player]);
+		data.insert(data.end(), mPlayerNames[player].begin(), mPlayerNames[player].end());
+		endSection(header.names[player]);
+	}
+
+	beginSection(header.rules);
+	data.insert(data.end(), mGameRules.begin(), mGameRules.end());
+	endSection(header.rules);
+
+	// players hold their keys for a while, so the input is stored as runs of equal packets
+	std::vector<uint8_t> index;
+	beginSection(header.input);
+	const std::size_t inputStart = data.size();
+	for (std::size_t step = 0; step < mSaveData.size(); )
+	{
+		std::size_t end = step;
+		while (end < mSaveData.size() && mSaveData[end] == mSaveData[step])
+			++end;
+
+		for (std::size_t entry = (step + REPLAY_INPUT_INDEX_PERIOD - 1) / REPLAY_INPUT_INDEX_PERIOD * REPLAY_INPUT_INDEX_PERIOD;
+				entry < end; entry += REPLAY_INPUT_INDEX_PERIOD)
+		{
+			writeReplayUInt32(index, data.size() - inputStart);
+			writeReplayUInt32(index, step);
+		}
+
+		data.push_back(mSaveData[step]);
+		for (std::size_t length = end - step; length > 0; length >>= 7)
+			data.push_back((length & 0x7f) | (length > 0x7f ? 0x80 : 0));
+
+		step = end;
+	}
+	endSection(header.input);
+
+	beginSection(header.inputIndex);
+	data.insert(data.end(), index.begin(), index.end());
+	endSection(header.inputIndex);
+
+	// each save point is serialized on its own, so it can be read without the others
+	std::vector<uint8_t> table;
+	std::vector<uint8_t> savePoints;
+	for (const auto& savePoint : mSavePoints)
+	{
+		RakNet::BitStream stream;
+		auto convert = createGenericWriter(&stream);
+		convert->generic<ReplaySavePoint> (savePoint);
+
+		writeReplayUInt32(table, savePoint.step);
+		writeReplayUInt32(table, savePoints.size());
+		writeReplayUInt32(table, stream.GetNumberOfBytesUsed());
+		savePoints.insert(savePoints.end(), stream.GetData(), stream.GetData() + stream.GetNumberOfBytesUsed());
+	}
+
+	beginSection(header.savePointTable);
+	data.insert(data.end(), table.begin(), table.end());
+	endSection(header.savePointTable);
+
+	beginSection(header.savePoints);
+	data.insert(data.end(), savePoints.begin(), savePoints.end());
+	endSection(header.savePoints);
+
+	std::vector<uint8_t> content;
+	header.write(content);
+	content.insert(content.end(), data.begin(), data.end());
+	file->write(reinterpret_cast<const char*>(content.data()), content.size());
 }
 
 void ReplayRecorder::send(const std::shared_ptr<GenericOut>& target) const
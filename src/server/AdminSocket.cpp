@@ -0,0 +1,253 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "AdminSocket.h"
+
+/* includes */
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/* implementation */
+
+namespace
+{
+	// limits to protect the server against misbehaving clients
+	const unsigned MAX_CONNECTIONS = 8;
+	const std::size_t MAX_LINE_LENGTH = 1024;
+
+	bool setNonBlocking(int fd)
+	{
+		int flags = fcntl(fd, F_GETFL, 0);
+		return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+	}
+
+	// checks whether a server still accepts connections on the socket at \p address
+	bool isListening(const sockaddr_un& address)
+	{
+		int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+		if( probe == -1 )
+			return false;
+		bool listening = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+		close(probe);
+		return listening;
+	}
+}
+
+AdminSocket::AdminSocket(std::string path, handler_fn handler)
+: mPath(std::move(path))
+, mHandler(std::move(handler))
+, mSocket(-1)
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if( mPath.empty() || mPath.size() >= sizeof(address.sun_path) )
+		throw std::runtime_error("invalid admin socket path " + mPath);
+	std::strncpy(address.sun_path, mPath.c_str(), sizeof(address.sun_path) - 1);
+
+	// remove the socket file of a server that was not shut down properly, but never a
+	// regular file at a mistyped path or the socket of a server that is still running
+	struct stat info;
+	if( lstat(mPath.c_str(), &info) == 0 )
+	{
+		if( !S_ISSOCK(info.st_mode) )
+			throw std::runtime_error("admin socket path " + mPath + " exists and is not a socket");
+		if( isListening(address) )
+			throw std::runtime_error("admin socket in use: " + mPath);
+		unlink(mPath.c_str());
+	}
+
+	mSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if( mSocket == -1 )
+		throw std::runtime_error(std::string("could not create admin socket: ") + std::strerror(errno));
+
+	// only the user running the server may connect
+	mode_t oldmask = umask(0077);
+	int result = bind(mSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+	umask(oldmask);
+
+	if( result == -1 || listen(mSocket, MAX_CONNECTIONS) == -1 || !setNonBlocking(mSocket) ||
+		lstat(mPath.c_str(), &info) == -1 )
+	{
+		std::string error = std::strerror(errno);
+		close(mSocket);
+		throw std::runtime_error("could not open admin socket " + mPath + ": " + error);
+	}
+
+	mDevice = info.st_dev;
+	mInode = info.st_ino;
+}
+
+AdminSocket::~AdminSocket()
+{
+	for( auto& con : mConnections )
+		close(con.fd);
+
+	close(mSocket);
+
+	// only remove the socket file if it is still the one created by this object
+	struct stat info;
+	if( lstat(mPath.c_str(), &info) == 0 && info.st_dev == mDevice && info.st_ino == mInode )
+		unlink(mPath.c_str());
+}
+
+void AdminSocket::poll()
+{
+	acceptConnections();
+
+	if( mConnections.empty() )
+		return;
+
+	std::vector<pollfd> fds(mConnections.size());
+	for( unsigned i = 0; i < mConnections.size(); ++i )
+	{
+		fds[i].fd = mConnections[i].fd;
+		fds[i].events = mConnections[i].output.empty() ? POLLIN : POLLIN | POLLOUT;
+		fds[i].revents = 0;
+	}
+
+	if( ::poll(fds.data(), fds.size(), 0) <= 0 )
+		return;
+
+	for( unsigned i = 0; i < mConnections.size(); ++i )
+	{
+		Connection& con = mConnections[i];
+		bool keep = true;
+
+		if( fds[i].revents & (POLLIN | POLLHUP) )
+			keep = readInput(con);
+		if( keep && fds[i].revents & POLLERR )
+			keep = false;
+		if( keep && !con.output.empty() )
+			keep = writeOutput(con);
+		if( keep && con.closing && con.output.empty() )
+			keep = false;
+
+		if( !keep )
+		{
+			close(con.fd);
+			con.fd = -1;
+		}
+	}
+
+	mConnections.erase( std::remove_if(mConnections.begin(), mConnections.end(),
+						[](const Connection& c) { return c.fd == -1; }), mConnections.end() );
+}
+
+void AdminSocket::acceptConnections()
+{
+	while( true )
+	{
+		int fd = accept(mSocket, nullptr, nullptr);
+		if( fd == -1 )
+			return;
+
+		if( mConnections.size() >= MAX_CONNECTIONS || !setNonBlocking(fd) )
+		{
+			close(fd);
+			continue;
+		}
+
+		mConnections.push_back( Connection{fd, "", "", false} );
+	}
+}
+
+bool AdminSocket::readInput(Connection& con)
+{
+	char buffer[512];
+	// a connection that is closing doesn't read anything more
+	while( !con.closing )
+	{
+		ssize_t count = read(con.fd, buffer, sizeof(buffer));
+		if( count > 0 )
+		{
+			con.input.append(buffer, count);
+			executeCommands(con);
+
+			// checked after every read, so a client that never sends a newline can't fill the memory
+			if( con.input.size() > MAX_LINE_LENGTH )
+			{
+				con.output += "{\"error\":\"line too long\"}\n";
+				con.closing = true;
+			}
+			continue;
+		}
+
+		if( count == 0 )
+		{
+			// the client closed its side, but still gets the replies to its last commands
+			con.closing = true;
+			break;
+		}
+
+		if( errno == EINTR )
+			continue;
+		if( errno == EAGAIN || errno == EWOULDBLOCK )
+			break;
+		return false;
+	}
+
+	return true;
+}
+
+void AdminSocket::executeCommands(Connection& con)
+{
+	std::size_t end;
+	while( (end = con.input.find('\n')) != std::string::npos )
+	{
+		std::string line = con.input.substr(0, end);
+		con.input.erase(0, end + 1);
+		if( !line.empty() && line.back() == '\r' )
+			line.pop_back();
+
+		if( !line.empty() )
+			con.output += mHandler(line) + "\n";
+	}
+}
+
+bool AdminSocket::writeOutput(Connection& con)
+{
+	while( !con.output.empty() )
+	{
+		ssize_t count = send(con.fd, con.output.data(), con.output.size(), MSG_NOSIGNAL);
+		if( count > 0 )
+		{
+			con.output.erase(0, count);
+			continue;
+		}
+
+		if( count == -1 && errno == EINTR )
+			continue;
+		if( count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+			return true;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,79 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <sys/types.h>
+
+/*! \class AdminSocket
+	\brief Unix domain control socket of the dedicated server.
+	\details Clients connect to the socket and send one command per line. Each command is
+		passed to the handler and its return value is sent back, followed by a newline.
+		The socket never blocks: poll() has to be called regularly from the thread that
+		is allowed to execute the commands, i.e. the server main loop.
+*/
+class AdminSocket
+{
+	public:
+		typedef std::function<std::string(const std::string&)> handler_fn;
+
+		/// creates the socket at \p path, replacing a stale socket file of a previous run.
+		/// \exception Throws std::runtime_error if the socket could not be created, if \p path
+		///		exists and is no socket, or if another server is listening on it.
+		AdminSocket(std::string path, handler_fn handler);
+		~AdminSocket();
+
+		AdminSocket(const AdminSocket&) = delete;
+		AdminSocket& operator=(const AdminSocket&) = delete;
+
+		/// accepts new connections, executes all complete commands that have arrived
+		/// and sends pending replies. Returns immediately if there is nothing to do.
+		void poll();
+
+		const std::string& getPath() const { return mPath; }
+
+	private:
+		struct Connection
+		{
+			int fd;
+			std::string input;
+			std::string output;
+			bool closing;	// close after all output has been written
+		};
+
+		void acceptConnections();
+		// returns false if the connection has to be closed
+		bool readInput(Connection& con);
+		// passes all complete lines of the input to the handler
+		void executeCommands(Connection& con);
+		bool writeOutput(Connection& con);
+
+		std::string mPath;
+		handler_fn mHandler;
+		int mSocket;
+		// identifies the socket file, so it is only removed if it was not replaced
+		dev_t mDevice;
+		ino_t mInode;
+		std::vector<Connection> mConnections;
+};
@@ -0,0 +1,355 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "Cluster.h"
+
+/* includes */
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "DedicatedServer.h"
+#include "GenericIO.h"
+
+#include <sys/syslog.h>
+
+/* implementation */
+
+namespace
+{
+	enum class ClusterMessage : unsigned char
+	{
+		// coordinator -> worker
+		HANDOFF_GAME,		// GameReservation
+		HANDOFF_SPECTATOR,	// game id, token
+		RELOAD_CONFIG,
+		// worker -> coordinator
+		WORKER_STATUS,		// games, clients, overloaded, lateness p99
+		GAME_ENDED			// game id
+	};
+
+	// status reports per second
+	const auto REPORT_INTERVAL = std::chrono::seconds(1);
+}
+
+// -----------------------------------------------------------------------------------------
+//    ClusterLink
+// ------------------------------
+
+ClusterLink::ClusterLink(int fd) : mSocket(fd), mOpen(true)
+{
+	int flags = fcntl(mSocket, F_GETFL, 0);
+	fcntl(mSocket, F_SETFL, flags | O_NONBLOCK);
+}
+
+ClusterLink::~ClusterLink()
+{
+	close(mSocket);
+}
+
+void ClusterLink::send(const RakNet::BitStream& message)
+{
+	if( !mOpen )
+		return;
+
+	unsigned length = message.GetNumberOfBytesUsed();
+	const unsigned char* len = reinterpret_cast<const unsigned char*>(&length);
+	mOutput.insert(mOutput.end(), len, len + sizeof(length));
+	mOutput.insert(mOutput.end(), message.GetData(), message.GetData() + length);
+	flush();
+}
+
+void ClusterLink::flush()
+{
+	while( mOpen && !mOutput.empty() )
+	{
+		ssize_t count = ::send(mSocket, mOutput.data(), mOutput.size(), MSG_NOSIGNAL);
+		if( count > 0 )
+		{
+			mOutput.erase(mOutput.begin(), mOutput.begin() + count);
+		}
+		else if( count == -1 && errno == EINTR )
+		{
+			continue;
+		}
+		else
+		{
+			// a full socket buffer is retried with the next message or receive call
+			if( count == -1 && errno != EAGAIN && errno != EWOULDBLOCK )
+				mOpen = false;
+			return;
+		}
+	}
+}
+
+bool ClusterLink::receive(const std::function<void(RakNet::BitStream&)>& handler)
+{
+	flush();
+
+	unsigned char buffer[4096];
+	while( mOpen )
+	{
+		ssize_t count = read(mSocket, buffer, sizeof(buffer));
+		if( count > 0 )
+			mInput.insert(mInput.end(), buffer, buffer + count);
+		else if( count == -1 && errno == EINTR )
+			continue;
+		else
+		{
+			if( count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK) )
+				mOpen = false;
+			break;
+		}
+	}
+
+	// both processes run on the same host, so the length is in native byte order
+	std::size_t pos = 0;
+	unsigned length;
+	while( mInput.size() - pos >= sizeof(length) )
+	{
+		std::memcpy(&length, mInput.data() + pos, sizeof(length));
+		if( mInput.size() - pos - sizeof(length) < length )
+			break;
+
+		RakNet::BitStream message(mInput.data() + pos + sizeof(length), length, false);
+		handler(message);
+		pos += sizeof(length) + length;
+	}
+	mInput.erase(mInput.begin(), mInput.begin() + pos);
+
+	return mOpen;
+}
+
+// -----------------------------------------------------------------------------------------
+//    ClusterCoordinator
+// ------------------------------
+
+ClusterCoordinator::ClusterCoordinator() = default;
+
+ClusterCoordinator::~ClusterCoordinator()
+{
+	// closing the links tells the workers to shut down
+	for( auto& worker : mWorkers )
+		worker.link.reset();
+
+	for( auto& worker : mWorkers )
+		waitpid(worker.status.pid, nullptr, 0);
+}
+
+void ClusterCoordinator::addWorker(pid_t pid, unsigned short port, int fd)
+{
+	Worker worker;
+	worker.status = WorkerStatus{pid, port, true, 0, 0, false, 0};
+	worker.link.reset( new ClusterLink(fd) );
+	mWorkers.push_back( std::move(worker) );
+}
+
+unsigned short ClusterCoordinator::handoffGame(const GameReservation& game)
+{
+	auto best = mWorkers.end();
+	for( auto it = mWorkers.begin(); it != mWorkers.end(); ++it )
+	{
+		if( !it->status.alive || it->status.overloaded )
+			continue;
+		if( best == mWorkers.end() || it->status.games < best->status.games )
+			best = it;
+	}
+
+	if( best == mWorkers.end() )
+		return 0;
+
+	RakNet::BitStream message;
+	auto out = createGenericWriter(&message);
+	out->byte( (unsigned char)ClusterMessage::HANDOFF_GAME );
+	out->uint32( game.game );
+	out->uint32( game.leftToken );
+	out->uint32( game.rightToken );
+	out->generic<PlayerSide>( game.switchSide );
+	out->string( game.rules );
+	out->uint32( game.scoreToWin );
+	out->number( game.speed );
+	best->link->send( message );
+
+	// until the next report arrives, we count the game ourselves
+	best->status.games++;
+	mGameWorker[game.game] = best - mWorkers.begin();
+	return best->status.port;
+}
+
+unsigned short ClusterCoordinator::handoffSpectator(unsigned game, unsigned token)
+{
+	auto worker = mGameWorker.find(game);
+	if( worker == mGameWorker.end() || !mWorkers[worker->second].status.alive )
+		return 0;
+
+	RakNet::BitStream message;
+	auto out = createGenericWriter(&message);
+	out->byte( (unsigned char)ClusterMessage::HANDOFF_SPECTATOR );
+	out->uint32( game );
+	out->uint32( token );
+	mWorkers[worker->second].link->send( message );
+	return mWorkers[worker->second].status.port;
+}
+
+void ClusterCoordinator::reloadConfig()
+{
+	RakNet::BitStream message;
+	message.Write( (unsigned char)ClusterMessage::RELOAD_CONFIG );
+	for( auto& worker : mWorkers )
+		worker.link->send( message );
+}
+
+void ClusterCoordinator::poll(const std::function<void(unsigned)>& gameEnded)
+{
+	for( unsigned index = 0; index < mWorkers.size(); ++index )
+	{
+		Worker& worker = mWorkers[index];
+		if( !worker.status.alive )
+			continue;
+
+		bool open = worker.link->receive([&](RakNet::BitStream& message)
+		{
+			auto in = createGenericReader(&message);
+			unsigned char type;
+			in->byte( type );
+			if( (ClusterMessage)type == ClusterMessage::WORKER_STATUS )
+			{
+				unsigned games, clients, lateness;
+				in->uint32( games );
+				in->uint32( clients );
+				in->boolean( worker.status.overloaded );
+				in->uint32( lateness );
+				worker.status.games = games;
+				worker.status.clients = clients;
+				worker.status.latenessP99 = lateness;
+			}
+			else if( (ClusterMessage)type == ClusterMessage::GAME_ENDED )
+			{
+				unsigned game;
+				in->uint32( game );
+				mGameWorker.erase( game );
+				gameEnded( game );
+			}
+		});
+
+		if( !open )
+		{
+			syslog(LOG_ERR, "Worker %d on port %d has stopped", (int)worker.status.pid, worker.status.port);
+			worker.status.alive = false;
+			waitpid(worker.status.pid, nullptr, WNOHANG);
+
+			// all its games are lost
+			for( auto it = mGameWorker.begin(); it != mGameWorker.end(); )
+			{
+				if( it->second == index )
+				{
+					gameEnded( it->first );
+					it = mGameWorker.erase( it );
+				}
+				else
+					++it;
+			}
+		}
+	}
+}
+
+std::vector<WorkerStatus> ClusterCoordinator::getWorkers() const
+{
+	std::vector<WorkerStatus> workers;
+	for( const auto& worker : mWorkers )
+		workers.push_back( worker.status );
+	return workers;
+}
+
+// -----------------------------------------------------------------------------------------
+//    ClusterWorker
+// ------------------------------
+
+ClusterWorker::ClusterWorker(int fd, DedicatedServer& server) :
+	mLink(fd), mServer(server), mLastReport(std::chrono::steady_clock::now())
+{
+}
+
+bool ClusterWorker::poll(const std::function<void()>& reload)
+{
+	bool open = mLink.receive([&](RakNet::BitStream& message)
+	{
+		auto in = createGenericReader(&message);
+		unsigned char type;
+		in->byte( type );
+		if( (ClusterMessage)type == ClusterMessage::HANDOFF_GAME )
+		{
+			GameReservation game;
+			unsigned score;
+			in->uint32( game.game );
+			in->uint32( game.leftToken );
+			in->uint32( game.rightToken );
+			in->generic<PlayerSide>( game.switchSide );
+			in->string( game.rules );
+			in->uint32( score );
+			in->number( game.speed );
+			game.scoreToWin = score;
+			mServer.reserveGame( game );
+		}
+		else if( (ClusterMessage)type == ClusterMessage::HANDOFF_SPECTATOR )
+		{
+			unsigned game, token;
+			in->uint32( game );
+			in->uint32( token );
+			mServer.reserveSpectator( game, token );
+		}
+		else if( (ClusterMessage)type == ClusterMessage::RELOAD_CONFIG )
+		{
+			reload();
+		}
+	});
+
+	auto now = std::chrono::steady_clock::now();
+	if( now - mLastReport >= REPORT_INTERVAL )
+	{
+		mLastReport = now;
+		RakNet::BitStream message;
+		auto out = createGenericWriter(&message);
+		out->byte( (unsigned char)ClusterMessage::WORKER_STATUS );
+		out->uint32( mServer.getActiveGamesCount() + mServer.getReservationCount() );
+		out->uint32( mServer.getConnectedClients() );
+		out->boolean( mServer.isOverloaded() );
+		out->uint32( mServer.getLoadReport().latenessP99 );
+		mLink.send( message );
+	}
+
+	return open;
+}
+
+void ClusterWorker::gameEnded(unsigned game)
+{
+	RakNet::BitStream message;
+	auto out = createGenericWriter(&message);
+	out->byte( (unsigned char)ClusterMessage::GAME_ENDED );
+	out->uint32( game );
+	mLink.send( message );
+}
@@ -0,0 +1,134 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include <sys/types.h>
+
+#include "raknet/BitStream.h"
+
+class DedicatedServer;
+struct GameReservation;
+
+/*! \class ClusterLink
+	\brief non-blocking message channel between two server processes
+	\details Wraps one end of a unix socket pair. Messages are BitStreams, which are
+		sent with a length prefix. Neither sending nor receiving ever blocks.
+*/
+class ClusterLink
+{
+	public:
+		explicit ClusterLink(int fd);
+		~ClusterLink();
+
+		ClusterLink(const ClusterLink&) = delete;
+		ClusterLink& operator=(const ClusterLink&) = delete;
+
+		void send(const RakNet::BitStream& message);
+		/// calls \p handler for every complete message that has arrived. Returns false,
+		/// if the other process has closed its end.
+		bool receive(const std::function<void(RakNet::BitStream&)>& handler);
+
+	private:
+		void flush();
+
+		int mSocket;
+		bool mOpen;
+		std::vector<unsigned char> mInput;
+		std::vector<unsigned char> mOutput;
+};
+
+/// load data of a worker process, as seen by the coordinator
+struct WorkerStatus
+{
+	pid_t pid;
+	unsigned short port;
+	bool alive;
+	int games;			// running and reserved games
+	int clients;
+	bool overloaded;
+	int latenessP99;
+};
+
+/*! \class ClusterCoordinator
+	\brief distributes the games of the lobby process to the worker processes.
+	\details Each worker runs its own DedicatedServer on its own port, and regularly
+		reports its load. New games are handed to the worker with the fewest games
+		that is not overloaded.
+*/
+class ClusterCoordinator
+{
+	public:
+		ClusterCoordinator();
+		~ClusterCoordinator();
+
+		void addWorker(pid_t pid, unsigned short port, int fd);
+
+		/// returns the port of the worker that plays the game, or 0 if no worker is available
+		unsigned short handoffGame(const GameReservation& game);
+		/// returns the port of the worker that plays \p game, which accepts the spectator with \p token
+		unsigned short handoffSpectator(unsigned game, unsigned token);
+		/// tells all workers to reload the config file
+		void reloadConfig();
+
+		/// processes the messages of the workers. \p gameEnded is called for each game that
+		/// has ended on a worker.
+		void poll(const std::function<void(unsigned)>& gameEnded);
+
+		std::vector<WorkerStatus> getWorkers() const;
+
+	private:
+		struct Worker
+		{
+			WorkerStatus status;
+			std::unique_ptr<ClusterLink> link;
+		};
+		std::vector<Worker> mWorkers;
+		// which worker plays which game
+		std::map<unsigned, unsigned> mGameWorker;
+};
+
+/*! \class ClusterWorker
+	\brief connection of a worker process to its coordinator
+*/
+class ClusterWorker
+{
+	public:
+		ClusterWorker(int fd, DedicatedServer& server);
+
+		/// processes the messages of the coordinator and reports the load. Returns false,
+		/// if the coordinator has shut down.
+		bool poll(const std::function<void()>& reload);
+
+		/// to be called when a game of this worker has ended
+		void gameEnded(unsigned game);
+
+	private:
+		ClusterLink mLink;
+		DedicatedServer& mServer;
+		std::chrono::steady_clock::time_point mLastReport;
+};
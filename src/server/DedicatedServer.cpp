@@ -51,10 +51,18 @@ DedicatedServer::DedicatedServer(ServerInfo info,
 								const std::vector<float>& gamespeeds,
 								int max_clients, bool local_server)
 : mConnectedClients(0)
+, mMaxClients(max_clients)
 , mServer(new RakServer())
 , mAcceptNewPlayers(true)
+, mDraining(false)
+, mOverloaded(false)
+, mLoadMonitor(std::make_shared<LoadMonitor>())
+, mLoadIntervalStart(std::chrono::steady_clock::now())
 , mPlayerHosted( local_server )
 , mServerInfo(std::move(info))
+, mGameIDCounter(0)
+, mLobbyPort(0)
+, mTokenGenerator(std::random_device()())
 {
 	if (!mServer->Start(max_clients, 1, mServerInfo.port))
 	{
@@ -66,7 +74,8 @@ DedicatedServer::DedicatedServer(ServerInfo info,
 	mMatchMaker.setSendFunction([&](const RakNet::BitStream& stream, PlayerID target){ mServer->Send(&stream, LOW_PRIORITY, RELIABLE_ORDERED, 0, target, false); });
 	mMatchMaker.setCreateGame([&](NetworkPlayer& left, NetworkPlayer& right,
 								PlayerSide switchSide, const std::string& rules, int stw, float sp){
-							createGame(left, right, switchSide, rules, stw, sp); });
+							return createGame(left, right, switchSide, rules, stw, sp); });
+	mMatchMaker.setSpectateGame([&](PlayerID spectator, unsigned game){ return spectateGame(spectator, game); });
 
 	// add gamespeeds
 	for( auto& s : gamespeeds )
@@ -107,6 +116,7 @@ void DedicatedServer::queuePackets()
 			}
 			// game progress packets
 			case ID_INPUT_UPDATE:
+			case ID_INPUT_HISTORY:
 			case ID_PAUSE:
 			case ID_UNPAUSE:
 			case ID_CHAT_MESSAGE:
@@ -153,7 +163,8 @@ void DedicatedServer::processPackets()
 				SWLS_Connections++;
 				syslog(LOG_DEBUG, "New incoming connection from %s, %d clients connected now", packet->playerId.toString().c_str(), mConnectedClients);
 
-				if ( !mAcceptNewPlayers )
+				// workers only get players the lobby server has already accepted
+				if ( !acceptsNewPlayers() && mLobbyPort == 0 )
 				{
 					RakNet::BitStream stream;
 					stream.Write( (char)ID_NO_FREE_INCOMING_CONNECTIONS );
@@ -207,7 +218,9 @@ void DedicatedServer::processPackets()
 					std::lock_guard<std::mutex> lock( mPlayerMapMutex );
 					mPlayerMap[packet->playerId] = newplayer;
 				}
-				mMatchMaker.addPlayer(packet->playerId, newplayer);
+				// players of workers wait for their reservation, they don't see a lobby
+				if( mLobbyPort == 0 )
+					mMatchMaker.addPlayer(packet->playerId, newplayer);
 				syslog(LOG_DEBUG, "New player \"%s\" connected from %s ", newplayer->getName().c_str(), packet->playerId.toString().c_str());
 
 				// if this is a locally hosted server, any player that connects automatically joins an
@@ -231,7 +244,17 @@ void DedicatedServer::processPackets()
 
 				// which player is wanted as opponent
 				RakNet::BitStream stream(packet->data, packet->length, false);
-				mMatchMaker.receiveLobbyPacket( packet->playerId, stream );
+				if( packet->length >= 2 && LobbyPacketType(packet->data[1]) == LobbyPacketType::CLAIM_RESERVATION )
+				{
+					unsigned token = 0;
+					stream.IgnoreBytes(2);
+					createGenericReader(&stream)->uint32(token);
+					claimReservation( packet->playerId, token );
+				}
+				else if( mLobbyPort == 0 )
+				{
+					mMatchMaker.receiveLobbyPacket( packet->playerId, stream );
+				}
 				break;
 			}
 			case ID_BLOBBY_SERVER_PRESENT:
@@ -253,6 +276,10 @@ void DedicatedServer::updateGames()
 	{
 		mMatchMaker.setAllowNewGames(mMatchMaker.getOpenGamesCount() == 0);
 	}
+	else
+	{
+		updateAdmission();
+	}
 
 	// this loop ensures that all games that have finished (eg because one
 	// player left) still process network packets, to let the other player
@@ -266,6 +293,8 @@ void DedicatedServer::updateGames()
 		}
 	}
 
+	removeExpiredReservations();
+
 	// remove dead games from gamelist
 	for (auto iter = mGameList.begin(); iter != mGameList.end();  )
 	{
@@ -275,6 +304,9 @@ void DedicatedServer::updateGames()
 					(*iter)->getPlayerID(LEFT_PLAYER).toString().c_str(),
 					(*iter)->getPlayerID(RIGHT_PLAYER).toString().c_str()
 					);
+			mMatchMaker.removeRunningGame( (*iter)->getID() );
+			if( mGameEnded )
+				mGameEnded( (*iter)->getID() );
 			iter = mGameList.erase(iter);
 		}
 		else
@@ -296,7 +328,9 @@ int DedicatedServer::getActiveGamesCount() const
 
 int DedicatedServer::getWaitingPlayers() const
 {
-	return mPlayerMap.size() - 2 * mGameList.size();
+	// players and spectators both have a game assigned
+	return std::count_if(mPlayerMap.begin(), mPlayerMap.end(),
+				[](const std::pair<const PlayerID, std::shared_ptr<NetworkPlayer>>& p) { return !p.second->getGame(); });
 }
 
 const ServerInfo& DedicatedServer::getServerInfo() const
@@ -314,13 +348,181 @@ void DedicatedServer::allowNewPlayers( bool allow )
 	mAcceptNewPlayers = allow;
 }
 
+bool DedicatedServer::acceptsNewPlayers() const
+{
+	return mAcceptNewPlayers && !mDraining && !mOverloaded;
+}
+
+void DedicatedServer::setDraining( bool drain )
+{
+	mDraining = drain;
+	updateAllowNewGames();
+	syslog(LOG_NOTICE, drain ? "Server is draining, no new players and games are accepted" : "Server accepts new players again");
+}
+
+bool DedicatedServer::isDraining() const
+{
+	return mDraining;
+}
+
+bool DedicatedServer::kickPlayer( const std::string& name )
+{
+	PlayerID target = UNASSIGNED_PLAYER_ID;
+	{
+		std::lock_guard<std::mutex> lock( mPlayerMapMutex );
+		// an address is unique, so it is preferred over the name
+		for(const auto& it : mPlayerMap)
+		{
+			if( it.first.toString() == name )
+			{
+				target = it.first;
+				break;
+			}
+			if( target == UNASSIGNED_PLAYER_ID && it.second->getName() == name )
+				target = it.first;
+		}
+	}
+
+	if( target == UNASSIGNED_PLAYER_ID )
+		return false;
+
+	syslog(LOG_NOTICE, "Kicking player %s", target.toString().c_str());
+	mServer->CloseConnection( target, true );
+
+	// raknet does not report connections that are closed by the server itself, so we
+	// simulate the notification to remove the player the usual way.
+	packet_ptr packet(new Packet, [](Packet* p) { delete[] p->data; delete p; });
+	packet->data = new unsigned char[1];
+	packet->data[0] = ID_DISCONNECTION_NOTIFICATION;
+	packet->length = 1;
+	packet->bitSize = 8;
+	packet->playerId = target;
+	packet->playerIndex = UNASSIGNED_PLAYER_INDEX;
+
+	std::lock_guard<std::mutex> lock( mPacketQueueMutex );
+	mPacketQueue.push_front( packet );
+	return true;
+}
+
+void DedicatedServer::setSpectatorOptions( SpectatorOptions options )
+{
+	mSpectatorOptions = options;
+}
+
+void DedicatedServer::setGameOptions( const std::vector<std::string>& rulefiles, const std::vector<float>& speeds )
+{
+	mMatchMaker.setOptions( speeds, rulefiles );
+}
+
+void DedicatedServer::setServerInfo( const ServerInfo& info )
+{
+	int port = mServerInfo.port;
+	mServerInfo = info;
+	mServerInfo.port = port;
+}
+
+void DedicatedServer::setMaximumClients( int max_clients )
+{
+	mServer->SetAllowedPlayers( std::min(max_clients, mMaxClients) );
+}
+
+void DedicatedServer::setAdmissionOptions( AdmissionOptions options )
+{
+	mAdmissionOptions = options;
+}
+
+bool DedicatedServer::isOverloaded() const
+{
+	return mOverloaded;
+}
+
+LoadMonitor::Report DedicatedServer::getLoadReport() const
+{
+	return mLoadReport;
+}
+
+void DedicatedServer::updateAdmission()
+{
+	auto now = std::chrono::steady_clock::now();
+	if( now - mLoadIntervalStart < std::chrono::seconds(mAdmissionOptions.interval) )
+		return;
+
+	mLoadIntervalStart = now;
+	mLoadReport = mLoadMonitor->collect();
+
+	if( mAdmissionOptions.latenessBudget <= 0 )
+	{
+		if( mOverloaded )
+		{
+			mOverloaded = false;
+			updateAllowNewGames();
+		}
+		return;
+	}
+
+	// the two thresholds prevent switching back and forth when the load is close to the budget
+	if( !mOverloaded && mLoadReport.latenessP99 > mAdmissionOptions.latenessBudget )
+	{
+		mOverloaded = true;
+		syslog(LOG_NOTICE, "Server overloaded (tick lateness p99 %d ms, budget %d ms, %d games), refusing new players",
+				mLoadReport.latenessP99, mAdmissionOptions.latenessBudget, getActiveGamesCount());
+		updateAllowNewGames();
+	}
+	else if( mOverloaded && mLoadReport.latenessP99 < mAdmissionOptions.resumeLateness )
+	{
+		mOverloaded = false;
+		syslog(LOG_NOTICE, "Server load normal again (tick lateness p99 %d ms, %d games), accepting new players",
+				mLoadReport.latenessP99, getActiveGamesCount());
+		updateAllowNewGames();
+	}
+}
+
+void DedicatedServer::updateAllowNewGames()
+{
+	mMatchMaker.setAllowNewGames( !mDraining && !mOverloaded );
+}
+
+std::vector<PlayerStatus> DedicatedServer::getPlayerList() const
+{
+	std::vector<PlayerStatus> players;
+
+	// the raknet thread reads the player map, so we have to lock it
+	std::lock_guard<std::mutex> lock( mPlayerMapMutex );
+	for(const auto& it : mPlayerMap)
+	{
+		PlayerStatus status{it.first.toString(), it.second->getName(), false, false, 0};
+		const auto& game = it.second->getGame();
+		if( game )
+		{
+			status.inGame = true;
+			status.game = game->getID();
+			status.spectating = game->getPlayerID(LEFT_PLAYER) != it.first && game->getPlayerID(RIGHT_PLAYER) != it.first;
+		}
+		players.push_back( status );
+	}
+	return players;
+}
+
+std::vector<NetworkGameStatus> DedicatedServer::getGameList() const
+{
+	std::vector<NetworkGameStatus> games;
+	for(const auto& game : mGameList)
+	{
+		games.push_back( game->getStatus() );
+	}
+	return games;
+}
+
 // debug
 void DedicatedServer::printAllPlayers(std::ostream& stream) const
 {
-	for(const auto & it : mPlayerMap)
+	for(const auto& player : getPlayerList())
 	{
-		stream << it.second->getID().toString() << " \"" << it.second->getName() << "\" status: ";
-		if( it.second->getGame() )
+		stream << player.id << " \"" << player.name << "\" status: ";
+		if( player.spectating )
+		{
+			stream << "watching game " << player.game << "\n";
+		} else if( player.inGame )
 		{
 			stream << "playing\n";
 		} else
@@ -377,10 +579,29 @@ void DedicatedServer::processBlobbyServerPresent( const packet_ptr& packet)
 		stream2.Write((int)BLOBBY_VERSION_MINOR);
 		mServer->Send(&stream2, LOW_PRIORITY, RELIABLE_ORDERED, 0, packet->playerId, false);
 	}
+	else if( mLobbyPort != 0 )
+	{
+		// workers have no lobby, the player has to go back to the lobby server
+		stream2.Write((unsigned char)ID_SERVER_REDIRECT);
+		stream2.Write((int)mLobbyPort);
+		stream2.Write(0u);
+		mServerInfo.writeToBitstream(stream2);
+		mServer->Send(&stream2, HIGH_PRIORITY, RELIABLE_ORDERED, 0,	packet->playerId, false);
+	}
 	else
 	{
 		mServerInfo.activegames = mGameList.size();
-		mServerInfo.waitingplayers = mPlayerMap.size() - 2 * mServerInfo.activegames;
+		mServerInfo.waitingplayers = getWaitingPlayers();
+		mServerInfo.acceptsplayers = acceptsNewPlayers();
+
+		// released clients only accept answers of the exact size, so the busy
+		// state is sent as a separate packet on the same ordered channel
+		if( !mServerInfo.acceptsplayers )
+		{
+			RakNet::BitStream busy;
+			busy.Write((unsigned char)ID_SERVER_BUSY);
+			mServer->Send(&busy, HIGH_PRIORITY, RELIABLE_ORDERED, 0, packet->playerId, false);
+		}
 
 		stream2.Write((unsigned char)ID_BLOBBY_SERVER_PRESENT);
 		mServerInfo.writeToBitstream(stream2);
@@ -389,16 +610,44 @@ void DedicatedServer::processBlobbyServerPresent( const packet_ptr& packet)
 	}
 }
 
-void DedicatedServer::createGame(NetworkPlayer& left,
+unsigned DedicatedServer::createGame(NetworkPlayer& left,
 								NetworkPlayer& right,
 								PlayerSide switchSide,
 								const std::string& rules,
 								int scoreToWin, float gamespeed)
 {
-	auto newgame = std::make_shared<NetworkGame>(*mServer, left, right,
-								switchSide, rules, scoreToWin, gamespeed);
-	left.setGame( newgame );
-	right.setGame( newgame );
+	unsigned id = mGameIDCounter++;
+
+	if( mHandoffGame )
+	{
+		GameReservation reservation{id, createToken(), createToken(), switchSide, rules, scoreToWin, gamespeed};
+		unsigned short port = mHandoffGame( reservation );
+		if( port != 0 )
+		{
+			redirectPlayer( left.getID(), port, reservation.leftToken );
+			redirectPlayer( right.getID(), port, reservation.rightToken );
+			SWLS_Games++;
+			syslog(LOG_DEBUG, "Handed off game \"%s\" vs. \"%s\" to port %d", left.getName().c_str(), right.getName().c_str(), port);
+			return id;
+		}
+		// no other process could take the game, so it is played here
+	}
+
+	startGame(id, left, right, switchSide, rules, scoreToWin, gamespeed);
+	return id;
+}
+
+void DedicatedServer::startGame(unsigned id, NetworkPlayer& left, NetworkPlayer& right,
+								PlayerSide switchSide, const std::string& rules,
+								int scoreToWin, float gamespeed)
+{
+	auto newgame = std::make_shared<NetworkGame>(*mServer, id, left, right,
+								switchSide, rules, scoreToWin, gamespeed, mSpectatorOptions, mLoadMonitor);
+	{
+		std::lock_guard<std::mutex> lock( mPlayerMapMutex );
+		left.setGame( newgame );
+		right.setGame( newgame );
+	}
 
 	SWLS_Games++;
 
@@ -407,3 +656,180 @@ void DedicatedServer::createGame(NetworkPlayer& left,
 	mGameList.push_back(newgame);
 }
 
+bool DedicatedServer::spectateGame(PlayerID spectator, unsigned gameID)
+{
+	auto player = mPlayerMap.find(spectator);
+	if( player == mPlayerMap.end() || player->second->getGame() )
+		return false;
+
+	auto game = std::find_if(mGameList.begin(), mGameList.end(),
+						[gameID](const std::shared_ptr<NetworkGame>& g) { return g->getID() == gameID; });
+
+	// the game might be played by another process
+	if( game == mGameList.end() && mHandoffSpectator )
+	{
+		unsigned token = createToken();
+		unsigned short port = mHandoffSpectator( gameID, token );
+		if( port == 0 )
+			return false;
+		redirectPlayer( spectator, port, token );
+		return true;
+	}
+
+	if( game == mGameList.end() || !(*game)->isGameValid() )
+		return false;
+
+	// the player map is read from the raknet thread to route the game packets
+	{
+		std::lock_guard<std::mutex> lock( mPlayerMapMutex );
+		player->second->setGame( *game );
+	}
+	(*game)->addSpectator( spectator );
+
+	syslog(LOG_DEBUG, "Player \"%s\" is now watching game %u, %d spectators", player->second->getName().c_str(),
+			gameID, (*game)->getSpectatorCount());
+	return true;
+}
+
+
+// cluster support
+void DedicatedServer::setHandoff( handoff_game_fn game, handoff_spectator_fn spectator )
+{
+	mHandoffGame = std::move(game);
+	mHandoffSpectator = std::move(spectator);
+}
+
+void DedicatedServer::setGameEndedCallback( std::function<void(unsigned)> callback )
+{
+	mGameEnded = std::move(callback);
+}
+
+void DedicatedServer::removeHandedOffGame( unsigned game )
+{
+	mMatchMaker.removeRunningGame( game );
+}
+
+void DedicatedServer::setLobbyPort( unsigned short lobbyPort )
+{
+	mLobbyPort = lobbyPort;
+}
+
+void DedicatedServer::reserveGame( const GameReservation& reservation )
+{
+	mReservations.push_back( Reservation{reservation, UNASSIGNED_PLAYER_ID, UNASSIGNED_PLAYER_ID,
+										std::chrono::steady_clock::now()} );
+}
+
+void DedicatedServer::reserveSpectator( unsigned game, unsigned token )
+{
+	mSpectatorReservations.push_back( SpectatorReservation{game, token, std::chrono::steady_clock::now()} );
+}
+
+int DedicatedServer::getReservationCount() const
+{
+	return mReservations.size();
+}
+
+unsigned DedicatedServer::createToken()
+{
+	// 0 means no reservation
+	unsigned token;
+	do
+	{
+		token = mTokenGenerator();
+	} while( token == 0 );
+	return token;
+}
+
+void DedicatedServer::redirectPlayer( PlayerID player, unsigned short port, unsigned token )
+{
+	RakNet::BitStream stream;
+	stream.Write((unsigned char)ID_SERVER_REDIRECT);
+	stream.Write((int)port);
+	stream.Write(token);
+	mServer->Send(&stream, HIGH_PRIORITY, RELIABLE_ORDERED, 0, player, false);
+}
+
+void DedicatedServer::claimReservation( PlayerID player, unsigned token )
+{
+	auto pl = mPlayerMap.find( player );
+	if( token == 0 || pl == mPlayerMap.end() || pl->second->getGame() )
+	{
+		syslog(LOG_ERR, "invalid reservation claim from %s", player.toString().c_str());
+		return;
+	}
+
+	auto spectator = std::find_if(mSpectatorReservations.begin(), mSpectatorReservations.end(),
+								[token](const SpectatorReservation& r) { return r.token == token; });
+	if( spectator != mSpectatorReservations.end() )
+	{
+		unsigned game = spectator->game;
+		mSpectatorReservations.erase( spectator );
+		if( !spectateGame( player, game ) )
+			syslog(LOG_ERR, "player %s could not watch game %u", player.toString().c_str(), game);
+		return;
+	}
+
+	for( auto it = mReservations.begin(); it != mReservations.end(); ++it )
+	{
+		if( it->game.leftToken == token )
+			it->left = player;
+		else if( it->game.rightToken == token )
+			it->right = player;
+		else
+			continue;
+
+		// start the game once both players have arrived
+		auto left = mPlayerMap.find( it->left );
+		auto right = mPlayerMap.find( it->right );
+		if( left != mPlayerMap.end() && right != mPlayerMap.end() )
+		{
+			GameReservation game = it->game;
+			mReservations.erase( it );
+			try
+			{
+				startGame( game.game, *left->second, *right->second, game.switchSide, game.rules, game.scoreToWin, game.speed );
+			}
+			catch( std::exception& e )
+			{
+				syslog(LOG_ERR, "could not start reserved game %u: %s", game.game, e.what());
+				if( mGameEnded )
+					mGameEnded( game.game );
+			}
+		}
+		return;
+	}
+
+	syslog(LOG_ERR, "unknown reservation claimed by %s", player.toString().c_str());
+}
+
+void DedicatedServer::removeExpiredReservations()
+{
+	/// \todo make this configurable?
+	const auto timeout = std::chrono::seconds(30);
+	auto now = std::chrono::steady_clock::now();
+
+	for( auto it = mReservations.begin(); it != mReservations.end(); )
+	{
+		if( now - it->created < timeout )
+		{
+			++it;
+			continue;
+		}
+
+		syslog(LOG_NOTICE, "reservation for game %u expired", it->game.game);
+		// the player that did arrive has nothing to do here
+		for( PlayerID player : {it->left, it->right} )
+		{
+			if( player != UNASSIGNED_PLAYER_ID && mPlayerMap.count(player) != 0 )
+				kickPlayer( player.toString() );
+		}
+		if( mGameEnded )
+			mGameEnded( it->game.game );
+		it = mReservations.erase( it );
+	}
+
+	mSpectatorReservations.erase( std::remove_if(mSpectatorReservations.begin(), mSpectatorReservations.end(),
+						[&](const SpectatorReservation& r) { return now - r.created >= timeout; }),
+						mSpectatorReservations.end() );
+}
@@ -27,12 +27,54 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <deque>
 #include <iosfwd>
 #include <memory>
+#include <chrono>
+#include <vector>
+#include <functional>
+#include <random>
 
 #include "NetworkPlayer.h"
 #include "NetworkMessage.h"
 #include "server/MatchMaker.h"
+#include "server/NetworkGame.h"
+#include "server/LoadMonitor.h"
 
 class RakServer;
+class LoadMonitor;
+
+/// settings for the automatic admission control of the server
+struct AdmissionOptions
+{
+	/// new players and games are refused when the 99th percentile of the tick lateness
+	/// of all games exceeds this value (in ms). 0 disables the admission control.
+	int latenessBudget = 25;
+	/// they are accepted again once the percentile has dropped below this value (in ms)
+	int resumeLateness = 10;
+	/// length of the measurement interval, in seconds
+	int interval = 5;
+};
+
+/// snapshot of a connected player, used by the admin interface of the server
+struct PlayerStatus
+{
+	std::string id;
+	std::string name;
+	bool inGame;		// playing or watching a game
+	bool spectating;
+	unsigned game;		// id of the game, only valid if inGame is set
+};
+
+/// a game that has been created by the lobby of one server process and is played
+/// on another one. Both players have to present their token to the second process.
+struct GameReservation
+{
+	unsigned game;		// id of the game on the lobby server
+	unsigned leftToken;
+	unsigned rightToken;
+	PlayerSide switchSide;
+	std::string rules;
+	int scoreToWin;
+	float speed;
+};
 
 // function for logging to replacing syslog
 enum {
@@ -69,6 +111,11 @@ class DedicatedServer
 
 		const ServerInfo& getServerInfo() const;
 
+		// snapshots for the admin interface. Have to be called from the thread that calls
+		// processPackets and updateGames.
+		std::vector<PlayerStatus> getPlayerList() const;
+		std::vector<NetworkGameStatus> getGameList() const;
+
 		// debug functions
 		void printAllPlayers(std::ostream& stream) const;
 		void printAllGames(std::ostream& stream) const;
@@ -76,25 +123,97 @@ class DedicatedServer
 
 		// server settings
 		void allowNewPlayers( bool allow );
+		/// false if new players are refused, because of allowNewPlayers, draining or overload
+		bool acceptsNewPlayers() const;
+		/// while draining, neither new connections nor new games are accepted. Running
+		/// games are played until they end.
+		void setDraining( bool drain );
+		bool isDraining() const;
+
+		// administration
+		/// disconnects the player with the given address or name. The player is removed
+		/// during the next processPackets call. Returns false if there is no such player.
+		bool kickPlayer( const std::string& player );
+
+		// cluster support
+		/// the handoff function is called for each new game. If it returns a port, the game is played
+		/// by another server process on that port, and the players are redirected there. If it
+		/// returns 0, the game is played here.
+		typedef std::function<unsigned short(const GameReservation&)> handoff_game_fn;
+		/// returns the port of the server that runs \p game and lets \p token watch it, or 0
+		typedef std::function<unsigned short(unsigned game, unsigned token)> handoff_spectator_fn;
+		void setHandoff( handoff_game_fn game, handoff_spectator_fn spectator );
+		/// called when a game of this server has been removed
+		void setGameEndedCallback( std::function<void(unsigned)> callback );
+		/// removes a game that has been handed off from the list of running games
+		void removeHandedOffGame( unsigned game );
+		/// turns this server into a worker without a lobby. Players only get here through
+		/// reservations, and are sent back to the lobby server at \p lobbyPort when they ask for it.
+		void setLobbyPort( unsigned short lobbyPort );
+		/// accepts the players of a game that has been handed off by the lobby server
+		void reserveGame( const GameReservation& reservation );
+		void reserveSpectator( unsigned game, unsigned token );
+		int getReservationCount() const;
+		/// settings for games created after this call
+		void setSpectatorOptions( SpectatorOptions options );
+		/// replaces the rules and speeds offered for new games. Running games keep their rules.
+		/// \exception Throws if a rules file can not be loaded. The old options are kept in that case.
+		void setGameOptions( const std::vector<std::string>& rulefiles, const std::vector<float>& speeds );
+		/// updates name and description of the server. The port can't be changed while running.
+		void setServerInfo( const ServerInfo& info );
+		/// limits the number of simultaneous connections. Clients that are already connected are
+		/// not affected. The limit can't exceed the \p max_clients passed to the constructor.
+		void setMaximumClients( int max_clients );
+		void setAdmissionOptions( AdmissionOptions options );
+		/// true, if the games can't keep their speed and new players are refused
+		bool isOverloaded() const;
+		/// load statistics of the last completed measurement interval
+		LoadMonitor::Report getLoadReport() const;
 
 	private:
 		// packet handling functions / utility functions
 		void processBlobbyServerPresent( const packet_ptr& packet );
-		// creates a new game with those players
-		// does not add the game to the active game list
-		void createGame(NetworkPlayer& left, NetworkPlayer& right,
+		// creates a new game with those players and returns its id
+		unsigned createGame(NetworkPlayer& left, NetworkPlayer& right,
 						PlayerSide switchSide, const std::string& rules, int scoreToWin, float gamespeed);
+		// adds a player as spectator to the game with the given id
+		bool spectateGame(PlayerID spectator, unsigned gameID);
 		// broadcasts the current server  status to all waiting clients
 
+		// cluster support
+		unsigned createToken();
+		void redirectPlayer( PlayerID player, unsigned short port, unsigned token );
+		void claimReservation( PlayerID player, unsigned token );
+		void removeExpiredReservations();
+		void startGame( unsigned id, NetworkPlayer& left, NetworkPlayer& right,
+						PlayerSide switchSide, const std::string& rules, int scoreToWin, float gamespeed);
+
+		// evaluates the load of the games and decides whether new players are accepted
+		void updateAdmission();
+		// applies the current admission state to the match maker
+		void updateAllowNewGames();
+
 		// member variables
 		// number of currently connected clients
 		/// \todo is this already counted by raknet?
 		unsigned int mConnectedClients;
+		// number of connections raknet has been started with
+		int mMaxClients;
 		// raknet server used
 		const std::unique_ptr<RakServer> mServer;
 
 		// true, if new players should be accepted
 		bool mAcceptNewPlayers;
+		// true, if the server is shutting down gracefully
+		bool mDraining;
+		// true, if the server refuses new players because it is overloaded
+		bool mOverloaded;
+
+		// load measurement
+		const std::shared_ptr<LoadMonitor> mLoadMonitor;
+		AdmissionOptions mAdmissionOptions;
+		LoadMonitor::Report mLoadReport;
+		std::chrono::steady_clock::time_point mLoadIntervalStart;
 		// true, if this is a player hosted local server
 		bool mPlayerHosted;
 		// server info with server config
@@ -102,12 +221,37 @@ class DedicatedServer
 
 		// containers for all games and mapping players to their games
 		std::list< std::shared_ptr<NetworkGame> > mGameList;
+		unsigned mGameIDCounter;
+		SpectatorOptions mSpectatorOptions;
 		std::map< PlayerID, std::shared_ptr<NetworkPlayer>> mPlayerMap;
-		std::mutex mPlayerMapMutex;
+		mutable std::mutex mPlayerMapMutex;
 
 		// packet queue
 		std::deque<packet_ptr> mPacketQueue;
 		std::mutex mPacketQueueMutex;
 
 		MatchMaker mMatchMaker;
+
+		// cluster support
+		handoff_game_fn mHandoffGame;
+		handoff_spectator_fn mHandoffSpectator;
+		std::function<void(unsigned)> mGameEnded;
+		unsigned short mLobbyPort;	// only set for workers
+		std::mt19937 mTokenGenerator;
+
+		struct Reservation
+		{
+			GameReservation game;
+			PlayerID left;
+			PlayerID right;
+			std::chrono::steady_clock::time_point created;
+		};
+		struct SpectatorReservation
+		{
+			unsigned game;
+			unsigned token;
+			std::chrono::steady_clock::time_point created;
+		};
+		std::vector<Reservation> mReservations;
+		std::vector<SpectatorReservation> mSpectatorReservations;
 };
@@ -0,0 +1,81 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "LoadMonitor.h"
+
+/* includes */
+#include <algorithm>
+
+/* implementation */
+
+const int LoadMonitor::MAX_LATENESS;
+
+LoadMonitor::LoadMonitor() : mCost(0)
+{
+	for( auto& bucket : mLateness )
+		bucket = 0;
+}
+
+void LoadMonitor::addTick( int lateness, int cost )
+{
+	lateness = std::max(0, std::min(lateness, MAX_LATENESS));
+	mLateness[lateness].fetch_add(1, std::memory_order_relaxed);
+	mCost.fetch_add(std::max(0, cost), std::memory_order_relaxed);
+}
+
+LoadMonitor::Report LoadMonitor::collect()
+{
+	// the counters are not reset as one atomic operation, so a tick that is added
+	// concurrently might be counted only partially. That does not matter for statistics.
+	std::array<unsigned, MAX_LATENESS + 1> histogram;
+	unsigned ticks = 0;
+	for( unsigned i = 0; i < histogram.size(); ++i )
+	{
+		histogram[i] = mLateness[i].exchange(0, std::memory_order_relaxed);
+		ticks += histogram[i];
+	}
+	unsigned long long cost = mCost.exchange(0, std::memory_order_relaxed);
+
+	Report report;
+	report.ticks = ticks;
+	if( ticks == 0 )
+		return report;
+
+	report.averageCost = cost / ticks;
+
+	// find the smallest lateness that is not exceeded by 99% of all ticks
+	unsigned limit = ticks - ticks / 100;
+	unsigned count = 0;
+	bool found = false;
+	for( unsigned i = 0; i < histogram.size(); ++i )
+	{
+		count += histogram[i];
+		if( count >= limit && !found )
+		{
+			report.latenessP99 = i;
+			found = true;
+		}
+		if( histogram[i] != 0 )
+			report.latenessMax = i;
+	}
+
+	return report;
+}
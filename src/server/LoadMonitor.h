@@ -0,0 +1,59 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <array>
+
+/*! \class LoadMonitor
+	\brief collects timing data of all game threads of a server.
+	\details Each game thread reports how late its game step started compared to the
+		schedule of its SpeedController, and how long the step took. The samples are
+		collected in a histogram of atomic counters, so the game threads never wait.
+		The server evaluates the histogram periodically with collect().
+*/
+class LoadMonitor
+{
+	public:
+		/// statistics of all ticks since the last call of collect()
+		struct Report
+		{
+			unsigned ticks = 0;
+			int latenessP99 = 0;	///< 99th percentile of tick lateness, in ms
+			int latenessMax = 0;	///< in ms, saturates at MAX_LATENESS
+			int averageCost = 0;	///< average time for one game step, in us
+		};
+
+		LoadMonitor();
+
+		/// called by the game threads after each step. \p lateness is in ms, \p cost in us
+		void addTick( int lateness, int cost );
+
+		/// returns the statistics since the last call and starts a new measurement
+		Report collect();
+
+		/// lateness values above this are counted as MAX_LATENESS
+		static const int MAX_LATENESS = 255;
+
+	private:
+		std::array<std::atomic<unsigned>, MAX_LATENESS + 1> mLateness;
+		std::atomic<unsigned long long> mCost;
+};
@@ -258,16 +258,50 @@ void MatchMaker::startGame(PlayerID host, PlayerID client)
 			switchSide = LEFT_PLAYER;
 	}
 
-	mCreateGame( *leftPlayer->second, *rightPlayer->second, switchSide,
+	unsigned id = mCreateGame( *leftPlayer->second, *rightPlayer->second, switchSide,
 				mPossibleGameRules.at(game->second.rules).file,
 				game->second.points,
 				mPossibleGameSpeeds.at(game->second.speed) );
 
-	// remove players from available player list
+	mRunningGames[id] = RunningGame{leftPlayer->second->getName() + " vs " + rightPlayer->second->getName(),
+								mPossibleGameSpeeds.at(game->second.speed),
+								mPossibleGameRules.at(game->second.rules).file, game->second.points};
+
+	// remove players from available player list. This removes the open game, too,
+	// so all waiting players get to know about the new running game.
 	removePlayer( host );
 	removePlayer( client );
 }
 
+void MatchMaker::spectateGame(PlayerID player, unsigned gameID)
+{
+	if( mRunningGames.find(gameID) == mRunningGames.end() )
+	{
+		std::cerr << "player " << player << " tried to watch game " << gameID << " which does not exist (anymore?)\n";
+		sendOpenGameList( player );
+		return;
+	}
+
+	// a spectator can't wait for a game at the same time
+	removePlayerFromAllGames( player );
+
+	if( !mSpectateGame( player, gameID ) )
+	{
+		std::cerr << "player " << player << " could not be added as spectator to game " << gameID << "\n";
+		sendOpenGameList( player );
+		return;
+	}
+
+	// no longer a waiting player
+	mPlayerMap.erase( player );
+}
+
+void MatchMaker::removeRunningGame( unsigned gameID )
+{
+	if( mRunningGames.erase( gameID ) != 0 )
+		broadcastOpenGameList();
+}
+
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void MatchMaker::receiveLobbyPacket( PlayerID player, RakNet::BitStream& stream )
@@ -312,6 +346,11 @@ void MatchMaker::receiveLobbyPacket( PlayerID player, RakNet::BitStream& stream
 
 		// try to set up the game:
 		startGame( player, target );
+	} else if ( type == LobbyPacketType::SPECTATE_GAME )
+	{
+		unsigned id;
+		reader->uint32(id);
+		spectateGame(player, id);
 	}
 }
 
@@ -364,6 +403,39 @@ void MatchMaker::sendOpenGameList( PlayerID recipient )
 
 	// send the packet
 	mSendPacket( stream, recipient );
+
+	// the running games are sent in a separate packet, so older clients can just ignore it
+	std::vector<unsigned int> rGameIDs;
+	std::vector<std::string> rGameNames;
+	std::vector<unsigned char> rGameSpeed;
+	std::vector<unsigned char> rGameRules;
+	std::vector<unsigned char> rGameScores;
+	for( const auto& game : mRunningGames )
+	{
+		// games whose settings are no longer offered can't be described to the client
+		auto speed = std::find(mPossibleGameSpeeds.begin(), mPossibleGameSpeeds.end(), game.second.speed);
+		auto rules = std::find_if(mPossibleGameRules.begin(), mPossibleGameRules.end(),
+								[&](const Rule& r) { return r.file == game.second.rules; });
+		if( speed == mPossibleGameSpeeds.end() || rules == mPossibleGameRules.end() )
+			continue;
+
+		rGameIDs.push_back( game.first );
+		rGameNames.push_back( game.second.name );
+		rGameSpeed.push_back( speed - mPossibleGameSpeeds.begin() );
+		rGameRules.push_back( rules - mPossibleGameRules.begin() );
+		rGameScores.push_back( game.second.points );
+	}
+
+	RakNet::BitStream running;
+	running.Write( (unsigned char)ID_LOBBY );
+	running.Write( (unsigned char)LobbyPacketType::RUNNING_GAMES );
+	out = createGenericWriter(&running);
+	out->generic<std::vector<unsigned int>>( rGameIDs );
+	out->generic<std::vector<std::string>>( rGameNames );
+	out->generic<std::vector<unsigned char>>( rGameSpeed );
+	out->generic<std::vector<unsigned char>>( rGameRules );
+	out->generic<std::vector<unsigned char>>( rGameScores );
+	mSendPacket( running, recipient );
 }
 
 
@@ -437,10 +509,63 @@ void MatchMaker::addGameSpeedOption( int speed )
 }
 
 void MatchMaker::addRuleOption( const std::string& file )
+{
+	mPossibleGameRules.push_back( loadRule(file) );
+}
+
+void MatchMaker::setOptions( const std::vector<float>& speeds, const std::vector<std::string>& rulefiles )
+{
+	// load everything before changing anything, so a broken rules file leaves the old options intact
+	std::vector<Rule> rules;
+	for( const auto& f : rulefiles )
+		rules.push_back( loadRule(f) );
+
+	std::vector<unsigned int> newspeeds( speeds.begin(), speeds.end() );
+
+	// the open games refer to the options by index, so they have to be translated
+	std::vector<unsigned> invalid;
+	for( auto& game : mOpenGames )
+	{
+		if( game.second.speed < 0 || game.second.speed >= (int)mPossibleGameSpeeds.size() ||
+			game.second.rules < 0 || game.second.rules >= (int)mPossibleGameRules.size() )
+		{
+			invalid.push_back( game.first );
+			continue;
+		}
+
+		auto speed = std::find(newspeeds.begin(), newspeeds.end(), mPossibleGameSpeeds[game.second.speed]);
+		auto rule = std::find_if(rules.begin(), rules.end(),
+								[&](const Rule& r) { return r.file == mPossibleGameRules[game.second.rules].file; });
+
+		if( speed == newspeeds.end() || rule == rules.end() )
+		{
+			invalid.push_back( game.first );
+			continue;
+		}
+		game.second.speed = speed - newspeeds.begin();
+		game.second.rules = rule - rules.begin();
+	}
+
+	mPossibleGameSpeeds = std::move( newspeeds );
+	mPossibleGameRules = std::move( rules );
+
+	for( auto id : invalid )
+	{
+		std::cerr << "closing game " << id << " because its settings are no longer available\n";
+		removeGame( id );
+	}
+
+	// the waiting players need the new options
+	broadcastOpenGameList();
+	for( const auto& game : mOpenGames )
+		broadcastOpenGameStatus( game.first );
+}
+
+MatchMaker::Rule MatchMaker::loadRule( const std::string& file )
 {
 	auto gamelogic = createGameLogic(file, nullptr, 1);
 	/// \todo check rule validity and load author and description
-	mPossibleGameRules.emplace_back(Rule{file, gamelogic->getTitle(), gamelogic->getAuthor(), ""});
+	return Rule{file, gamelogic->getTitle(), gamelogic->getAuthor(), ""};
 }
 
 unsigned MatchMaker::getOpenGamesCount() const
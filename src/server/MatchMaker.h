@@ -44,10 +44,15 @@ public:
 	void removePlayer( PlayerID id );
 
 	// set callback functions
-	typedef std::function<void(NetworkPlayer&, NetworkPlayer&,
+	/// the create game function returns the id of the running game
+	typedef std::function<unsigned(NetworkPlayer&, NetworkPlayer&,
 								PlayerSide, const std::string& rules, int score, float speed)> create_game_fn;
 	void setCreateGame( create_game_fn func) { mCreateGame = std::move(func);};
 
+	/// the spectate function returns true if the player could be added as a spectator of the game
+	typedef std::function<bool(PlayerID spectator, unsigned game)> spectate_fn;
+	void setSpectateGame( spectate_fn func ) { mSpectateGame = std::move(func); };
+
 	typedef std::function<void(const RakNet::BitStream& stream, PlayerID target)> send_fn;
 	void setSendFunction( send_fn func ) { mSendPacket = std::move(func); };
 
@@ -60,10 +65,18 @@ public:
 	void broadcastOpenGameStatus( unsigned gameID );
 	void broadcastOpenGameList(); // sends the game list to all players that are not in a game
 
+	/// removes a game that has been created by the create game function from the list of watchable games
+	void removeRunningGame( unsigned gameID );
+
 
 	// add settings
 	void addGameSpeedOption( int speed );
 	void addRuleOption( const std::string& file );
+	/// replaces all speed and rule options at once. Open games are kept if their settings
+	/// are still available, running games are not affected.
+	/// \exception Throws if one of the rule files can not be loaded. In that case, the old
+	///		options are kept.
+	void setOptions( const std::vector<float>& speeds, const std::vector<std::string>& rulefiles );
 	void setAllowNewGames( bool allow );
 
 	// info functions
@@ -77,6 +90,7 @@ private:
 	unsigned addGame( OpenGame game );
 	void joinGame(PlayerID player, unsigned gameID, const std::string& password = "");
 	void startGame(PlayerID host, PlayerID client);
+	void spectateGame(PlayerID player, unsigned gameID);
 
 	void removeGame( unsigned id );
 	void removePlayerFromAllGames( PlayerID player );
@@ -85,6 +99,9 @@ private:
 	/// create a new network game from the challenges id1 and id2. If either is not valid, no game is created.
 	void makeMatch( unsigned id1, unsigned id2 );
 
+	struct Rule;
+	static Rule loadRule( const std::string& file );
+
 	struct OpenGame
 	{
 		// owner
@@ -100,6 +117,17 @@ private:
 		std::vector<PlayerID> connected;
 	};
 
+	// running games keep their settings when the options are changed, so they
+	// are stored by value and not as indices into the option lists.
+	struct RunningGame
+	{
+		std::string name;
+		// settings
+		unsigned speed;
+		std::string rules;
+		int points;
+	};
+
 	struct Rule
 	{
 		std::string file;
@@ -111,6 +139,9 @@ private:
 	std::map<unsigned, OpenGame> mOpenGames;
 	unsigned int mIDCounter = 0;
 
+	// games that are played at the moment, indexed by the id returned from mCreateGame
+	std::map<unsigned, RunningGame> mRunningGames;
+
 	// waiting player map
 	std::map< PlayerID, std::shared_ptr<NetworkPlayer>> mPlayerMap;
 
@@ -121,5 +152,6 @@ private:
 
 	// callbacks
 	create_game_fn mCreateGame;
+	spectate_fn mSpectateGame;
 	send_fn mSendPacket;
 };
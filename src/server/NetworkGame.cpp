@@ -26,6 +26,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 #include <stdexcept>
 #include <cassert>
+#include <algorithm>
+#include <chrono>
 
 #include "raknet/RakServer.h"
 #include "raknet/BitStream.h"
@@ -41,23 +43,51 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "PhysicWorld.h"
 #include "NetworkPlayer.h"
 #include "InputSource.h"
+#include "LoadMonitor.h"
 
 extern int SWLS_GameSteps;
 
+namespace
+{
+	// frames of input that may wait for their step. A burst after packet loss resends at most the
+	// client history, so that is all that is kept.
+	const std::size_t MAX_QUEUED_INPUTS = INPUT_HISTORY_LENGTH;
+	// frames that may wait without being caught up, to absorb jitter
+	const std::size_t WAITING_INPUTS = 1;
+	// frames skipped per step while catching up with a backlog
+	const std::size_t MAX_CATCH_UP_FRAMES = 1;
+
+	// drops the oldest queued frame. Its jump is kept in the next frame, so a short press is not lost.
+	void skipQueuedInput(std::deque<PlayerInputAbs>& queue)
+	{
+		if( queue.size() > 1 && queue.front().getJump() )
+			queue[1].setJump(true);
+		queue.pop_front();
+	}
+}
+
 /* implementation */
 
-NetworkGame::NetworkGame(RakServer& server, NetworkPlayer& leftPlayer,
+NetworkGame::NetworkGame(RakServer& server, unsigned id, NetworkPlayer& leftPlayer,
 			NetworkPlayer& rightPlayer, PlayerSide switchedSide,
-			std::string rules, int scoreToWin, float speed) :
+			std::string rules, int scoreToWin, float speed,
+			SpectatorOptions spectatorOptions,
+			std::shared_ptr<LoadMonitor> monitor) :
 	mServer(server),
+	mID(id),
 	mMatch(new DuelMatch(false, rules, scoreToWin)),
 	mSpeedController(speed),
 	mLeftInput (new InputSource()),
 	mRightInput(new InputSource()),
 	mLeftLastTime(-1),
 	mRightLastTime(-1),
+	mLeftInputFrame(0),
+	mRightInputFrame(0),
 	mRecorder(new ReplayRecorder()),
-	mGameValid(true)
+	mGameValid(true),
+	mSpectatorOptions(spectatorOptions),
+	mStepCounter(0),
+	mLoadMonitor(std::move(monitor))
 {
 	// check that both players don't have an active game
 	if(leftPlayer.getGame())
@@ -82,23 +112,30 @@ NetworkGame::NetworkGame(RakServer& server, NetworkPlayer& leftPlayer,
 	mRecorder->setGameSpeed(mSpeedController.getGameSpeed());
 	mRecorder->setGameRules(rules);
 
+	mStatus.id = mID;
+	mStatus.leftName = leftPlayer.getName();
+	mStatus.rightName = rightPlayer.getName();
+	mStatus.scoreToWin = mMatch->getScoreToWin();
+	mStatus.speed = mSpeedController.getGameSpeed();
+
 	// read rulesfile into a string
-	int checksum = 0;
+	mRulesChecksum = 0;
 	mRulesLength = 0;
 	mRulesSent[0] = false;
 	mRulesSent[1] = false;
 
 	rules = FileRead::makeLuaFilename( rules );
 	FileRead file(std::string("rules/") + rules);
-	checksum = file.calcChecksum(0);
+	mRulesChecksum = file.calcChecksum(0);
 	mRulesLength = file.length();
 	mRulesString = file.readRawBytes(mRulesLength);
 
 	// writing rules checksum
 	RakNet::BitStream stream;
 	stream.Write((unsigned char)ID_RULES_CHECKSUM);
-	stream.Write(checksum);
+	stream.Write(mRulesChecksum);
 	stream.Write(mMatch->getScoreToWin());
+	stream.Write(false);	// not a spectator
 	/// \todo write file author and title, too; maybe add a version number in scripts, too.
 	broadcastBitstream(stream);
 
@@ -108,11 +145,20 @@ NetworkGame::NetworkGame(RakServer& server, NetworkPlayer& leftPlayer,
 		{
 			while(mGameValid)
 			{
+				auto start = std::chrono::steady_clock::now();
 				processPackets();
 				step();
+				auto cost = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+				updateStatus( cost );
 				SWLS_GameSteps++;
 				mSpeedController.update();
+
+				if( mLoadMonitor )
+					mLoadMonitor->addTick( mSpeedController.getLateness(), cost );
 			}
+
+			// spectators get everything that is still held back
+			sendSpectatorPackets(true);
 		}					);
 }
 
@@ -178,6 +224,13 @@ void NetworkGame::processPackets()
 /// this function processes a single packet received for this network game
 void NetworkGame::processPacket( const packet_ptr& packet )
 {
+	// spectators may only request the replay, everything else is handled separately
+	if( isSpectator(packet->playerId) && packet->data[0] != ID_REPLAY )
+	{
+		processSpectatorPacket( packet );
+		return;
+	}
+
 	switch(packet->data[0])
 	{
 		case ID_CONNECTION_LOST:
@@ -186,6 +239,12 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 			RakNet::BitStream stream;
 			stream.Write((unsigned char)ID_OPPONENT_DISCONNECTED);
 			broadcastBitstream(stream);
+			if( getSpectatorCount() != 0 )
+			{
+				auto spectatorStream = std::make_shared<RakNet::BitStream>();
+				spectatorStream->Write((unsigned char)ID_OPPONENT_DISCONNECTED);
+				queueForSpectators(spectatorStream, RELIABLE_ORDERED);
+			}
 			mMatch->pause();
 			mGameValid = false;
 			break;
@@ -219,21 +278,49 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 			break;
 		}
 
-		case ID_PAUSE:
+		case ID_INPUT_HISTORY:
 		{
-			RakNet::BitStream stream;
-			stream.Write((unsigned char)ID_PAUSE);
-			broadcastBitstream(stream);
-			mMatch->pause();
+			unsigned time;
+			std::vector<TimedInput> history;
+			RakNet::BitStream stream(packet->data, packet->length, false);
+
+			stream.IgnoreBytes(1);	// ID_INPUT_HISTORY
+			if( !stream.Read(time) || !readInputHistory(stream, history) )
+			{
+				printf("invalid input history received\n");
+				break;
+			}
+
+			if (packet->playerId == mLeftPlayer)
+			{
+				queueInputs(history, mLeftInputQueue, mLeftInputFrame, mSwitchedSide == LEFT_PLAYER);
+				mLeftLastTime = time;
+			}
+			if (packet->playerId == mRightPlayer)
+			{
+				queueInputs(history, mRightInputQueue, mRightInputFrame, mSwitchedSide == RIGHT_PLAYER);
+				mRightLastTime = time;
+			}
 			break;
 		}
 
+		case ID_PAUSE:
 		case ID_UNPAUSE:
 		{
 			RakNet::BitStream stream;
-			stream.Write((unsigned char)ID_UNPAUSE);
+			stream.Write(packet->data[0]);
 			broadcastBitstream(stream);
-			mMatch->unpause();
+			if( getSpectatorCount() != 0 )
+			{
+				auto spectatorStream = std::make_shared<RakNet::BitStream>();
+				spectatorStream->Write(packet->data[0]);
+				queueForSpectators(spectatorStream, RELIABLE_ORDERED);
+			}
+
+			if( packet->data[0] == ID_PAUSE )
+				mMatch->pause();
+			else
+				mMatch->unpause();
 			break;
 		}
 
@@ -332,9 +419,130 @@ bool NetworkGame::isGameValid() const
 	return mGameValid;
 }
 
+void NetworkGame::addSpectator( PlayerID spectator )
+{
+	{
+		std::lock_guard<std::mutex> lock(mSpectatorMutex);
+		mSpectators.push_back( Spectator{spectator, false} );
+	}
+
+	// the spectator answers with ID_RULES, just like the players do
+	RakNet::BitStream stream;
+	stream.Write((unsigned char)ID_RULES_CHECKSUM);
+	stream.Write(mRulesChecksum);
+	stream.Write(mMatch->getScoreToWin());
+	stream.Write(true);	// spectator
+	mServer.Send(&stream, HIGH_PRIORITY, RELIABLE_ORDERED, 0, spectator, false);
+}
+
+int NetworkGame::getSpectatorCount() const
+{
+	std::lock_guard<std::mutex> lock(mSpectatorMutex);
+	return mSpectators.size();
+}
+
+bool NetworkGame::isSpectator( PlayerID id ) const
+{
+	std::lock_guard<std::mutex> lock(mSpectatorMutex);
+	return std::find_if(mSpectators.begin(), mSpectators.end(),
+						[id](const Spectator& s) { return s.id == id; }) != mSpectators.end();
+}
+
+void NetworkGame::queueForSpectators( std::shared_ptr<RakNet::BitStream> stream, PacketReliability reliability )
+{
+	std::lock_guard<std::mutex> lock(mSpectatorMutex);
+	mSpectatorQueue.push_back( SpectatorPacket{mStepCounter, std::move(stream), reliability} );
+}
+
+void NetworkGame::sendSpectatorPackets( bool all )
+{
+	std::lock_guard<std::mutex> lock(mSpectatorMutex);
+	while( !mSpectatorQueue.empty() &&
+			(all || mSpectatorQueue.front().step + mSpectatorOptions.delay <= mStepCounter) )
+	{
+		const SpectatorPacket& packet = mSpectatorQueue.front();
+		// the same stream is sent to every spectator, it is never encoded again
+		for( const auto& spectator : mSpectators )
+		{
+			if( spectator.ready )
+				mServer.Send(packet.stream.get(), HIGH_PRIORITY, packet.reliability, 0, spectator.id, false);
+		}
+		mSpectatorQueue.pop_front();
+	}
+}
+
+void NetworkGame::processSpectatorPacket( const packet_ptr& packet )
+{
+	switch(packet->data[0])
+	{
+		case ID_CONNECTION_LOST:
+		case ID_DISCONNECTION_NOTIFICATION:
+		{
+			std::lock_guard<std::mutex> lock(mSpectatorMutex);
+			mSpectators.erase( std::remove_if(mSpectators.begin(), mSpectators.end(),
+								[&packet](const Spectator& s) { return s.id == packet->playerId; }),
+								mSpectators.end() );
+			break;
+		}
+
+		case ID_RULES:
+		{
+			RakNet::BitStream stream(packet->data, packet->length, false);
+			bool needRules;
+			stream.IgnoreBytes(1);
+			stream.Read(needRules);
+
+			if (needRules)
+			{
+				RakNet::BitStream rulesStream;
+				rulesStream.Write((unsigned char)ID_RULES);
+				rulesStream.Write( mRulesLength );
+				rulesStream.Write( mRulesString.get(), mRulesLength);
+				mServer.Send(&rulesStream, HIGH_PRIORITY, RELIABLE_ORDERED, 0, packet->playerId, false);
+			}
+
+			char name[16];
+			RakNet::BitStream readyStream;
+			readyStream.Write((unsigned char)ID_SPECTATOR_READY);
+			readyStream.Write((int)mSpeedController.getGameSpeed());
+			for( PlayerSide side : {LEFT_PLAYER, RIGHT_PLAYER} )
+			{
+				strncpy(name, mMatch->getPlayer(side).getName().c_str(), sizeof(name));
+				readyStream.Write(name, sizeof(name));
+				readyStream.Write(mMatch->getPlayer(side).getStaticColor().toInt());
+			}
+			mServer.Send(&readyStream, HIGH_PRIORITY, RELIABLE_ORDERED, 0, packet->playerId, false);
+
+			// from now on, this spectator gets the game data
+			std::lock_guard<std::mutex> lock(mSpectatorMutex);
+			for( auto& spectator : mSpectators )
+			{
+				if( spectator.id == packet->playerId )
+					spectator.ready = true;
+			}
+			break;
+		}
+
+		// spectators can't influence the game
+		case ID_INPUT_UPDATE:
+		case ID_INPUT_HISTORY:
+		case ID_PAUSE:
+		case ID_UNPAUSE:
+		case ID_CHAT_MESSAGE:
+			break;
+
+		default:
+			printf("unknown packet %d received from spectator\n",
+				int(packet->data[0]));
+			break;
+	}
+}
 
 void NetworkGame::step()
 {
+	++mStepCounter;
+	sendSpectatorPackets();
+
 	if (!isGameStarted())
 		return;
 
@@ -343,6 +551,8 @@ void NetworkGame::step()
 	{
 		mRecorder->record(mMatch->getState());
 
+		applyQueuedInput(mLeftInputQueue, *mLeftInput);
+		applyQueuedInput(mRightInputQueue, *mRightInput);
 		mMatch->step();
 
 		broadcastGameEvents();
@@ -364,10 +574,62 @@ void NetworkGame::step()
 			switchStream.Write(winning == LEFT_PLAYER ? RIGHT_PLAYER : LEFT_PLAYER);
 
 			broadcastBitstream(stream, switchStream);
+
+			if( getSpectatorCount() != 0 )
+			{
+				auto spectatorStream = std::make_shared<RakNet::BitStream>();
+				spectatorStream->Write((unsigned char)ID_WIN_NOTIFICATION);
+				spectatorStream->Write(winning);
+				queueForSpectators(spectatorStream, RELIABLE_ORDERED);
+			}
 		}
 
 		broadcastPhysicState(mMatch->getState());
+
+		// spectators get a reduced update rate. The state is encoded only once for all of them.
+		if( mStepCounter % mSpectatorOptions.updateInterval == 0 && getSpectatorCount() != 0 )
+		{
+			auto stream = std::make_shared<RakNet::BitStream>();
+			stream->Write((unsigned char)ID_GAME_UPDATE);
+			stream->Write( 0u );	// spectators don't send input, so there is no time to send back
+			createGenericWriter( stream.get() )->generic<DuelMatchState>( mMatch->getState() );
+			stream->Write( mStepCounter );
+			queueForSpectators(stream, UNRELIABLE_SEQUENCED);
+		}
+	}
+}
+
+void NetworkGame::queueInputs(const std::vector<TimedInput>& history, std::deque<PlayerInputAbs>& queue, unsigned& lastFrame, bool swapSides)
+{
+	for(const auto& input : history)
+	{
+		// the history overlaps with the previous packets. 0 is never a valid frame.
+		if( lastFrame != 0 && input.frame <= lastFrame )
+			continue;
+
+		PlayerInputAbs newInput = input.input;
+		if( swapSides )
+			newInput.swapSides();
+		queue.push_back( newInput );
+		lastFrame = input.frame;
 	}
+
+	while( queue.size() > MAX_QUEUED_INPUTS )
+		skipQueuedInput(queue);
+}
+
+void NetworkGame::applyQueuedInput(std::deque<PlayerInputAbs>& queue, InputSource& source)
+{
+	// client and server run at the same speed, so every step uses one frame of input. When several
+	// frames arrived at once, a few of them are skipped each step until the backlog is caught up.
+	if( queue.empty() )
+		return;
+
+	for(std::size_t skipped = 0; skipped < MAX_CATCH_UP_FRAMES && queue.size() > WAITING_INPUTS + 1; ++skipped)
+		skipQueuedInput(queue);
+
+	source.setInput( queue.front() );
+	queue.pop_front();
 }
 
 void NetworkGame::broadcastPhysicState(const DuelMatchState& state) const
@@ -385,6 +647,7 @@ void NetworkGame::broadcastPhysicState(const DuelMatchState& state) const
 		ms.swapSides();
 
 	out->generic<DuelMatchState> (ms);
+	stream.Write( mStepCounter );
 	mServer.Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0, mLeftPlayer, false);
 
 	// reset state and stream
@@ -399,6 +662,7 @@ void NetworkGame::broadcastPhysicState(const DuelMatchState& state) const
 		ms.swapSides();
 
 	out->generic<DuelMatchState> (ms);
+	stream.Write( mStepCounter );
 
 	mServer.Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0, mRightPlayer, false);
 }
@@ -415,7 +679,7 @@ void NetworkGame::writeEventToStream(RakNet::BitStream& stream, MatchEvent e, bo
 		stream.Write( e.intensity );
 }
 
-void NetworkGame::broadcastGameEvents() const
+void NetworkGame::broadcastGameEvents()
 {
 	RakNet::BitStream stream;
 
@@ -436,6 +700,40 @@ void NetworkGame::broadcastGameEvents() const
 		writeEventToStream(stream, e, mSwitchedSide == RIGHT_PLAYER );
 	stream.Write((char)0);
 	mServer.Send( &stream, HIGH_PRIORITY, RELIABLE_ORDERED, 0, mRightPlayer, false);
+
+	if( getSpectatorCount() != 0 )
+	{
+		auto spectatorStream = std::make_shared<RakNet::BitStream>();
+		spectatorStream->Write( (unsigned char)ID_GAME_EVENTS );
+		for(auto& e : events)
+			writeEventToStream(*spectatorStream, e, false );
+		spectatorStream->Write((char)0);
+		queueForSpectators(spectatorStream, RELIABLE_ORDERED);
+	}
+}
+
+NetworkGameStatus NetworkGame::getStatus() const
+{
+	NetworkGameStatus status;
+	{
+		std::lock_guard<std::mutex> lock(mStatusMutex);
+		status = mStatus;
+	}
+	status.spectators = getSpectatorCount();
+	return status;
+}
+
+void NetworkGame::updateStatus( int stepCost )
+{
+	std::lock_guard<std::mutex> lock(mStatusMutex);
+	// smooth the step cost, single steps are too noisy to be useful. This has to be
+	// done in floating point, integer steps of 1/16 would get stuck for small costs.
+	mStatus.stepCost += (stepCost - mStatus.stepCost) / 16.f;
+	mStatus.leftScore = mMatch->getScore(LEFT_PLAYER);
+	mStatus.rightScore = mMatch->getScore(RIGHT_PLAYER);
+	mStatus.started = isGameStarted();
+	mStatus.paused = mMatch->isPaused();
+	mStatus.steps = mStepCounter;
 }
 
 PlayerID NetworkGame::getPlayerID( PlayerSide side ) const
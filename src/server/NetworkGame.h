@@ -21,25 +21,57 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #pragma once
 
 #include <list>
+#include <deque>
+#include <vector>
 #include <mutex>
 #include <thread>
 #include <memory>
+#include <string>
 
 #include <boost/shared_array.hpp>
 
 #include "Global.h"
 #include "raknet/NetworkTypes.h"
 #include "raknet/BitStream.h"
+#include "raknet/PacketPriority.h"
 #include "SpeedController.h"
 #include "DuelMatch.h"
+#include "PlayerInput.h"
 #include "BlobbyDebug.h"
 
 class RakServer;
 class ReplayRecorder;
 class NetworkPlayer;
+class LoadMonitor;
 
 typedef std::list<packet_ptr> PacketQueue;
 
+/// settings for the data sent to spectators of a game
+struct SpectatorOptions
+{
+	/// a state update is sent every \p updateInterval game steps
+	unsigned updateInterval = 3;
+	/// number of game steps all spectator packets are held back
+	unsigned delay = 15;
+};
+
+/// snapshot of the state of a running game, used by the admin interface of the server
+struct NetworkGameStatus
+{
+	unsigned id = 0;
+	std::string leftName;
+	std::string rightName;
+	int leftScore = 0;
+	int rightScore = 0;
+	int scoreToWin = 0;
+	float speed = 0;
+	bool started = false;
+	bool paused = false;
+	unsigned steps = 0;
+	int spectators = 0;
+	float stepCost = 0;	// average time of a game step in us
+};
+
 class NetworkGame : public ObjectCounter<NetworkGame>
 {
 	public:
@@ -51,9 +83,13 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 		// decides which player is switched.
 		/// \exception Throws FileLoadException, if the desired rules file could not be loaded
 		///	\exception Throws std::runtime_error, if \p leftPlayer or \p rightPlayer are already assigned to a game.
-		NetworkGame(RakServer& server, NetworkPlayer& leftPlayer,
+		/// The \p id is used to identify the game when spectators want to join.
+		/// If a \p monitor is given, the timing of each game step is reported to it.
+		NetworkGame(RakServer& server, unsigned id, NetworkPlayer& leftPlayer,
 					NetworkPlayer& rightPlayer, PlayerSide switchedSide,
-					std::string rules, int scoreToWin, float speed);
+					std::string rules, int scoreToWin, float speed,
+					SpectatorOptions spectatorOptions = SpectatorOptions(),
+					std::shared_ptr<LoadMonitor> monitor = nullptr);
 
 		~NetworkGame();
 
@@ -70,22 +106,52 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 		/// This function processes all queued network packets.
 		void processPackets();
 
+		/// Adds a read-only spectator to this game. The spectator receives the
+		/// rules checksum immediately, and the game data after it has answered
+		/// with ID_RULES. Can be called from any thread.
+		void addSpectator( PlayerID spectator );
+
 		// game info
 		/// gets network IDs of players
 		PlayerID getPlayerID( PlayerSide side ) const;
+		unsigned getID() const { return mID; }
+		int getSpectatorCount() const;
+		/// returns a consistent snapshot of the game state. Can be called from any thread,
+		/// without waiting for the current game step.
+		NetworkGameStatus getStatus() const;
 
 	private:
 		void broadcastBitstream(const RakNet::BitStream& stream, const RakNet::BitStream& switchedstream);
 		void broadcastBitstream(const RakNet::BitStream& stream);
 		void broadcastPhysicState(const DuelMatchState& state) const;
-		void broadcastGameEvents() const;
+		void broadcastGameEvents();
 		void writeEventToStream(RakNet::BitStream& stream, MatchEvent e, bool switchSides ) const;
 		bool isGameStarted() { return mRulesSent[LEFT_PLAYER] && mRulesSent[RIGHT_PLAYER]; }
+		bool isPlayer( PlayerID id ) const { return id == mLeftPlayer || id == mRightPlayer; }
+
+		// spectator handling
+		bool isSpectator( PlayerID id ) const;
+		/// queues a packet for all spectators. Packets are encoded only once and leave the queue
+		/// after mSpectatorOptions.delay steps, in the order they were queued.
+		void queueForSpectators( std::shared_ptr<RakNet::BitStream> stream, PacketReliability reliability );
+		/// sends all packets from the spectator queue that are due. If \p all is set,
+		/// the delay is ignored.
+		void sendSpectatorPackets( bool all = false );
+		void processSpectatorPacket( const packet_ptr& packet );
 
 		// process a single packet
 		void processPacket( const packet_ptr& packet );
 
+		// adds the frames of an input history that have not been seen yet to the queue
+		static void queueInputs(const std::vector<TimedInput>& history, std::deque<PlayerInputAbs>& queue, unsigned& lastFrame, bool swapSides);
+		// sets the input for the next step
+		static void applyQueuedInput(std::deque<PlayerInputAbs>& queue, InputSource& source);
+
+		// updates the status snapshot. called from the game thread after each step
+		void updateStatus( int stepCost );
+
 		RakServer& mServer;
+		const unsigned mID;
 		PlayerID mLeftPlayer;
 		PlayerID mRightPlayer;
 		PlayerSide mSwitchedSide;
@@ -99,6 +165,11 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 		std::shared_ptr<InputSource> mRightInput;
 		unsigned mLeftLastTime;
 		unsigned mRightLastTime;
+		// inputs received with ID_INPUT_HISTORY, and the newest client frame received
+		std::deque<PlayerInputAbs> mLeftInputQueue;
+		std::deque<PlayerInputAbs> mRightInputQueue;
+		unsigned mLeftInputFrame;
+		unsigned mRightInputFrame;
 		std::thread mGameThread;
 
 		const std::unique_ptr<ReplayRecorder> mRecorder;
@@ -106,7 +177,33 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 		bool mGameValid;
 
 		bool mRulesSent[MAX_PLAYERS];
+		int mRulesChecksum;
 		int mRulesLength;
 		boost::shared_array<char> mRulesString;
+
+		// spectators
+		struct Spectator
+		{
+			PlayerID id;
+			bool ready;	// true, once the spectator has received the rules
+		};
+
+		struct SpectatorPacket
+		{
+			unsigned step;
+			std::shared_ptr<RakNet::BitStream> stream;
+			PacketReliability reliability;
+		};
+
+		const SpectatorOptions mSpectatorOptions;
+		std::vector<Spectator> mSpectators;
+		mutable std::mutex mSpectatorMutex;
+		std::deque<SpectatorPacket> mSpectatorQueue;
+		unsigned mStepCounter;
+
+		NetworkGameStatus mStatus;
+		mutable std::mutex mStatusMutex;
+
+		const std::shared_ptr<LoadMonitor> mLoadMonitor;
 };
 
@@ -23,20 +23,29 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* includes */
 #include <cstdlib>
+#include <cmath>
 #include <iostream>
 #include <cstdio>
 #include <ctime>
-#include <future>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <sstream>
+#include <algorithm>
 
 #include <cerrno>
 #include <unistd.h>
 
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/trim.hpp>
 
 #include <SDL2/SDL_timer.h>
 
 #include "DedicatedServer.h"
+#include "AdminSocket.h"
+#include "Cluster.h"
 #include "SpeedController.h"
 #include "FileSystem.h"
 #include "UserConfig.h"
@@ -46,6 +55,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #ifndef WIN32
 #include <sys/syslog.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <csignal>
 #else
 #include <cstdarg>
 #endif
@@ -71,13 +82,44 @@ void syslog(int pri, const char* format, ...);
 static bool g_run_in_foreground = false;
 static bool g_print_syslog_to_stderr = false;
 static std::string g_config_file = "server.xml";
+static std::string g_admin_socket_path;
 static std::atomic<bool> g_run_server(true); // set this variable to false to stop the server
+static std::atomic<bool> g_reload_config(false); // set by SIGHUP, handled by the main loop
+
+// cluster mode. The coordinator runs the lobby and hands the games to the workers.
+// At most one of them is set.
+static ClusterCoordinator* g_coordinator = nullptr;
+static ClusterWorker* g_worker = nullptr;
+
+// commands entered on the console. They are executed by the main loop, so they
+// don't interfere with the packet processing.
+static std::mutex g_console_mutex;
+static std::deque<std::string> g_console_commands;
 
 // ...
 void printHelp();
 void process_arguments(int argc, char** argv);
 void fork_to_background();
 void setup_physfs(char* argv0);
+void read_console();
+void console_command(DedicatedServer& server, const std::string& command);
+std::string admin_command(DedicatedServer& server, const std::string& command);
+void print_status(DedicatedServer& server, std::ostream& stream);
+int spawn_workers(ClusterCoordinator& coordinator, int count, unsigned short& port);
+
+// settings from server.xml that can be changed while the server is running
+struct ServerSettings
+{
+	int maxClients;
+	std::vector<std::string> rules;
+	std::vector<float> speeds;
+	SpectatorOptions spectatorOptions;
+	AdmissionOptions admissionOptions;
+};
+
+bool load_config(UserConfig& config);
+ServerSettings read_settings(const UserConfig& config);
+bool reload_config(DedicatedServer& server);
 
 // server workload statistics
 int SWLS_PacketCount = 0;
@@ -87,8 +129,9 @@ int SWLS_GameSteps	 = 0;
 int SWLS_RunningTime = 0;
 
 const int UPDATE_FREQUENCY = 10;
+const int MAXIMUM_CLIENTS = 150;
 
-void main_loop(DedicatedServer& server);
+void main_loop(DedicatedServer& server, AdminSocket* admin);
 
 int main(int argc, char** argv)
 {
@@ -109,84 +152,90 @@ int main(int argc, char** argv)
 
 	setup_physfs(argv[0]);
 
-	int maxClients = 100;
-	std::string rulesFile = DEFAULT_RULES_FILE;
-	std::string gameSpeeds = "75";
-
 	UserConfig config;
-	try
+	if( !load_config(config) )
 	{
-		config.loadFile(g_config_file);
-		maxClients = config.getInteger("maximum_clients");
-		rulesFile  = config.getString("rules", DEFAULT_RULES_FILE);
-		gameSpeeds = config.getString("speed", gameSpeeds);
-
-		// bring that value into a sane range
-		if(maxClients <= 0 || maxClients > 150)
-			maxClients = 150;
+		syslog(LOG_ERR, "server.xml not found. Falling back to default values.");
 	}
-	catch (std::exception& e)
+	ServerSettings settings = read_settings(config);
+	if( g_admin_socket_path.empty() )
+		g_admin_socket_path = config.getString("admin_socket", "");
+
+	// the workers have to be started before any threads are created
+	ServerInfo info(config);
+	unsigned short lobbyPort = info.port;
+	std::unique_ptr<ClusterCoordinator> coordinator;
+	int coordinatorSocket = -1;
+	int workerCount = config.getInteger("workers", 0);
+	if( workerCount > 0 )
 	{
-		syslog(LOG_ERR, "server.xml not found. Falling back to default values.");
+		coordinator.reset( new ClusterCoordinator() );
+		unsigned short port = config.getInteger("worker_port", lobbyPort + 1);
+		coordinatorSocket = spawn_workers(*coordinator, workerCount, port);
+		if( coordinatorSocket != -1 )
+		{
+			// this is a worker process
+			coordinator.reset();
+			info.port = port;
+		}
 	}
 
-	ServerInfo myinfo(config);
-	std::vector<std::string> rule_vec;
-	boost::algorithm::split(rule_vec, rulesFile, boost::algorithm::is_space(), boost::algorithm::token_compress_on);
+	// raknet reserves memory for all possible connections at startup, so we reserve
+	// the maximum here and restrict it afterwards. That way, the limit can be raised
+	// by reloading the config.
+	DedicatedServer server(info, settings.rules, settings.speeds, MAXIMUM_CLIENTS);
+	server.setMaximumClients( settings.maxClients );
+	server.setSpectatorOptions( settings.spectatorOptions );
+	server.setAdmissionOptions( settings.admissionOptions );
 
-	std::vector<std::string> speed_vec_str;
-	boost::algorithm::split(speed_vec_str, gameSpeeds, boost::algorithm::is_space(), boost::algorithm::token_compress_on);
-
-	std::vector<float> speed_vec;
-	std::transform(speed_vec_str.begin(), speed_vec_str.end(), std::back_inserter(speed_vec), [](const std::string& v ){ return std::stof(v);});
-
-	DedicatedServer server(myinfo, rule_vec, speed_vec, maxClients);
-
-	syslog(LOG_NOTICE, "Blobby Volley 2 dedicated server version %i.%i started", BLOBBY_VERSION_MAJOR, BLOBBY_VERSION_MINOR);
-
-	// main loop
-	auto serverthread = std::async(std::launch::async, [&](){main_loop(server);});
-
-	while(true)
+	std::unique_ptr<ClusterWorker> worker;
+	if( coordinator )
 	{
-		std::string command;
-
-		if (!(std::cin >> command))
-			// If we reached eof (happens immediately when server runs in background)
-			// we don't accept any input so that we have no endless loop
-			break;
-
-		std::vector<std::string> cmd_vec;
-		boost::algorithm::split(cmd_vec, command, boost::algorithm::is_space(), boost::algorithm::token_compress_on);
+		g_coordinator = coordinator.get();
+		server.setHandoff( [&](const GameReservation& game) { return coordinator->handoffGame(game); },
+						[&](unsigned game, unsigned token) { return coordinator->handoffSpectator(game, token); } );
+	}
+	else if( coordinatorSocket != -1 )
+	{
+		worker.reset( new ClusterWorker(coordinatorSocket, server) );
+		g_worker = worker.get();
+		server.setLobbyPort( lobbyPort );
+		server.setGameEndedCallback( [&](unsigned game) { worker->gameEnded(game); } );
+	}
 
+	#ifndef WIN32
+	signal(SIGHUP, [](int){ g_reload_config = true; });
+	#endif
 
-		if( cmd_vec[0] == "exit" )
-		{
-			/// \todo check for confirmation if there are still players connected!
-			g_run_server = false;
-			break;
-		}
-		else if ( cmd_vec[0] == "players" )
-		{
-			server.printAllPlayers(std::cout);
-		}
-		else if ( cmd_vec[0] == "games" )
+	// the admin socket is the only way to control a server running in background
+	std::unique_ptr<AdminSocket> admin;
+	if( !g_admin_socket_path.empty() && !g_worker )
+	{
+		try
 		{
-			server.printAllGames(std::cout);
+			admin.reset( new AdminSocket(g_admin_socket_path, [&](const std::string& cmd){ return admin_command(server, cmd); }) );
+			syslog(LOG_NOTICE, "Listening for admin commands on %s", g_admin_socket_path.c_str());
 		}
-		else if ( cmd_vec[0] == "status" )
+		catch (std::exception& e)
 		{
-			std::cout << "Blobby Server Status Report " << (SWLS_RunningTime / UPDATE_FREQUENCY / 60 / 60) << "h running \n";
-			std::cout << " packet count: " << SWLS_PacketCount << "\n";
-			std::cout << " accepted connections: " << SWLS_Connections << "\n";
-			std::cout << " started games: " << SWLS_Games << "\n";
-			std::cout << " game steps: " << SWLS_GameSteps << "\n";
+			syslog(LOG_ERR, "%s", e.what());
 		}
+	}
+
+	if( g_worker )
+		syslog(LOG_NOTICE, "Blobby Volley 2 dedicated server worker started on port %d", info.port);
+	else
+		syslog(LOG_NOTICE, "Blobby Volley 2 dedicated server version %i.%i started", BLOBBY_VERSION_MAJOR, BLOBBY_VERSION_MINOR);
 
+	// after forking, stdin is no longer connected to a terminal. Workers share the
+	// terminal of the coordinator, but don't read from it.
+	if (g_run_in_foreground && !g_worker)
+	{
+		// the console thread blocks in std::getline, so it is not joined
+		std::thread(read_console).detach();
 	}
 
-	// We wait until the dedicated server is shut down
-	serverthread.wait();
+	main_loop(server, admin.get());
 
 	syslog(LOG_NOTICE, "Blobby Volley 2 dedicated server shutting down");
 	#ifndef WIN32
@@ -197,7 +246,7 @@ int main(int argc, char** argv)
 // -----------------------------------------------------------------------------------------
 //    server main loop function
 // ------------------------------
-void main_loop( DedicatedServer& server)
+void main_loop( DedicatedServer& server, AdminSocket* admin)
 {
 	SpeedController scontroller( UPDATE_FREQUENCY );
 
@@ -211,13 +260,32 @@ void main_loop( DedicatedServer& server)
 
 		if(SWLS_RunningTime % (UPDATE_FREQUENCY * 60 * 60 /*1h*/) == 0 )
 		{
-			std::cout << "Blobby Server Status Report " << (SWLS_RunningTime / UPDATE_FREQUENCY / 60 / 60) << "h running \n";
-			std::cout << " packet count: " << SWLS_PacketCount << "\n";
-			std::cout << " accepted connections: " << SWLS_Connections << "\n";
-			std::cout << " started games: " << SWLS_Games << "\n";
-			std::cout << " game steps: " << SWLS_GameSteps << "\n";
+			print_status(server, std::cout);
 		}
 
+		// commands are executed here, where the player and game lists are modified,
+		// so they always see a consistent state.
+		std::deque<std::string> commands;
+		{
+			std::lock_guard<std::mutex> lock(g_console_mutex);
+			commands.swap(g_console_commands);
+		}
+		for(const auto& command : commands)
+			console_command(server, command);
+
+		if(g_reload_config.exchange(false))
+			reload_config(server);
+
+		if(admin)
+			admin->poll();
+
+		if(g_coordinator)
+			g_coordinator->poll( [&](unsigned game) { server.removeHandedOffGame(game); } );
+
+		// without the coordinator, there is nothing left to do for a worker
+		if(g_worker && !g_worker->poll( [&]() { reload_config(server); } ))
+			g_run_server = false;
+
 		server.processPackets();
 		server.updateGames();
 
@@ -225,6 +293,397 @@ void main_loop( DedicatedServer& server)
 	}
 }
 
+// -----------------------------------------------------------------------------------------
+//    server configuration
+// ------------------------------
+bool load_config(UserConfig& config)
+{
+	try
+	{
+		config.loadFile(g_config_file);
+		return true;
+	}
+	catch (std::exception& e)
+	{
+		return false;
+	}
+}
+
+ServerSettings read_settings(const UserConfig& config)
+{
+	ServerSettings settings;
+	settings.maxClients = config.getInteger("maximum_clients", MAXIMUM_CLIENTS);
+	// bring that value into a sane range
+	if(settings.maxClients <= 0 || settings.maxClients > MAXIMUM_CLIENTS)
+		settings.maxClients = MAXIMUM_CLIENTS;
+
+	std::string rulesFile = config.getString("rules", DEFAULT_RULES_FILE);
+	boost::algorithm::split(settings.rules, rulesFile, boost::algorithm::is_space(), boost::algorithm::token_compress_on);
+
+	// the example server.xml always used "speeds", but only "speed" was read
+	std::string gameSpeeds = config.getString("speeds", config.getString("speed", "75"));
+	std::vector<std::string> speed_vec_str;
+	boost::algorithm::split(speed_vec_str, gameSpeeds, boost::algorithm::is_space(), boost::algorithm::token_compress_on);
+	std::transform(speed_vec_str.begin(), speed_vec_str.end(), std::back_inserter(settings.speeds), [](const std::string& v ){ return std::stof(v);});
+
+	settings.spectatorOptions.updateInterval = std::max(1, config.getInteger("spectator_update_interval", settings.spectatorOptions.updateInterval));
+	settings.spectatorOptions.delay = std::max(0, config.getInteger("spectator_delay", settings.spectatorOptions.delay));
+
+	AdmissionOptions& admission = settings.admissionOptions;
+	admission.latenessBudget = config.getInteger("tick_lateness_budget", admission.latenessBudget);
+	admission.resumeLateness = std::min(admission.latenessBudget, config.getInteger("tick_lateness_resume", admission.resumeLateness));
+	admission.interval = std::max(1, config.getInteger("load_interval", admission.interval));
+	return settings;
+}
+
+// applies a changed config file. Running games are not affected. Returns false
+// if the config could not be loaded, in which case the old settings are kept.
+bool reload_config(DedicatedServer& server)
+{
+	UserConfig config;
+	if( !load_config(config) )
+	{
+		syslog(LOG_ERR, "Could not reload %s, keeping the old settings", g_config_file.c_str());
+		return false;
+	}
+
+	try
+	{
+		ServerSettings settings = read_settings(config);
+		server.setGameOptions( settings.rules, settings.speeds );
+		server.setMaximumClients( settings.maxClients );
+		server.setSpectatorOptions( settings.spectatorOptions );
+		server.setAdmissionOptions( settings.admissionOptions );
+		server.setServerInfo( ServerInfo(config) );
+	}
+	catch (std::exception& e)
+	{
+		syslog(LOG_ERR, "Could not apply %s: %s", g_config_file.c_str(), e.what());
+		return false;
+	}
+
+	syslog(LOG_NOTICE, "Reloaded %s", g_config_file.c_str());
+
+	if( g_coordinator )
+		g_coordinator->reloadConfig();
+	return true;
+}
+
+// -----------------------------------------------------------------------------------------
+//    cluster mode
+// ------------------------------
+int spawn_workers(ClusterCoordinator& coordinator, int count, unsigned short& port)
+{
+	struct Worker
+	{
+		pid_t pid;
+		unsigned short port;
+		int socket;
+	};
+	std::vector<Worker> workers;
+
+	for(int i = 0; i < count; ++i)
+	{
+		int sockets[2];
+		if( socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == -1 )
+		{
+			syslog(LOG_ERR, "Could not create socket for worker: %s", strerror(errno));
+			break;
+		}
+
+		pid_t pid = fork();
+		if( pid == -1 )
+		{
+			syslog(LOG_ERR, "Could not start worker: %s", strerror(errno));
+			close(sockets[0]);
+			close(sockets[1]);
+			break;
+		}
+
+		if( pid == 0 )
+		{
+			// the worker must not keep the other workers alive
+			for(const auto& w : workers)
+				close(w.socket);
+			close(sockets[0]);
+			port += i;
+			return sockets[1];
+		}
+
+		close(sockets[1]);
+		workers.push_back( Worker{pid, (unsigned short)(port + i), sockets[0]} );
+	}
+
+	for(const auto& w : workers)
+		coordinator.addWorker(w.pid, w.port, w.socket);
+
+	syslog(LOG_NOTICE, "Started %d workers on ports %d to %d", (int)workers.size(), port, port + (int)workers.size() - 1);
+	return -1;
+}
+
+// -----------------------------------------------------------------------------------------
+//    server commands
+// ------------------------------
+void read_console()
+{
+	std::string line;
+	// If we reached eof we don't accept any more input
+	while( g_run_server && std::getline(std::cin, line) )
+	{
+		std::lock_guard<std::mutex> lock(g_console_mutex);
+		g_console_commands.push_back(line);
+	}
+}
+
+void print_status(DedicatedServer& server, std::ostream& stream)
+{
+	stream << "Blobby Server Status Report " << (SWLS_RunningTime / UPDATE_FREQUENCY / 60 / 60) << "h running \n";
+	stream << " packet count: " << SWLS_PacketCount << "\n";
+	stream << " accepted connections: " << SWLS_Connections << "\n";
+	stream << " started games: " << SWLS_Games << "\n";
+	stream << " game steps: " << SWLS_GameSteps << "\n";
+	stream << " connected clients: " << server.getConnectedClients() << "\n";
+	stream << " running games: " << server.getActiveGamesCount() << "\n";
+	stream << " tick lateness p99: " << server.getLoadReport().latenessP99 << " ms\n";
+	if( server.isDraining() )
+		stream << " draining\n";
+	if( server.isOverloaded() )
+		stream << " overloaded\n";
+	if( g_coordinator )
+	{
+		for(const auto& worker : g_coordinator->getWorkers())
+		{
+			stream << " worker " << worker.pid << " on port " << worker.port << ": ";
+			if( worker.alive )
+				stream << worker.games << " games, " << worker.clients << " clients" << (worker.overloaded ? ", overloaded\n" : "\n");
+			else
+				stream << "stopped\n";
+		}
+	}
+	stream << std::flush;
+}
+
+std::vector<std::string> split_command(const std::string& command)
+{
+	std::vector<std::string> cmd_vec;
+	std::string trimmed = boost::algorithm::trim_copy(command);
+	boost::algorithm::split(cmd_vec, trimmed, boost::algorithm::is_space(), boost::algorithm::token_compress_on);
+	return cmd_vec;
+}
+
+// parses the argument of the drain command. no argument enables draining.
+bool parse_drain(const std::vector<std::string>& cmd_vec, bool& drain)
+{
+	drain = cmd_vec.size() < 2 || cmd_vec[1] == "on";
+	return cmd_vec.size() < 2 || cmd_vec[1] == "on" || cmd_vec[1] == "off";
+}
+
+// the player to kick is given by the rest of the line, as names may contain spaces
+std::string kick_target(const std::string& command)
+{
+	std::string trimmed = boost::algorithm::trim_copy(command);
+	auto pos = trimmed.find_first_of(" \t");
+	return pos == std::string::npos ? "" : boost::algorithm::trim_copy(trimmed.substr(pos));
+}
+
+void console_command(DedicatedServer& server, const std::string& command)
+{
+	std::vector<std::string> cmd_vec = split_command(command);
+
+	if( cmd_vec[0] == "exit" )
+	{
+		/// \todo check for confirmation if there are still players connected!
+		g_run_server = false;
+	}
+	else if ( cmd_vec[0] == "players" )
+	{
+		server.printAllPlayers(std::cout);
+	}
+	else if ( cmd_vec[0] == "games" )
+	{
+		server.printAllGames(std::cout);
+	}
+	else if ( cmd_vec[0] == "status" )
+	{
+		print_status(server, std::cout);
+	}
+	else if ( cmd_vec[0] == "kick" )
+	{
+		if( !server.kickPlayer( kick_target(command) ) )
+			std::cout << "no such player: " << kick_target(command) << std::endl;
+	}
+	else if ( cmd_vec[0] == "drain" )
+	{
+		bool drain;
+		if( parse_drain(cmd_vec, drain) )
+			server.setDraining( drain );
+		else
+			std::cout << "usage: drain [on|off]" << std::endl;
+	}
+	else if ( cmd_vec[0] == "reload" )
+	{
+		reload_config(server);
+	}
+	else if ( !cmd_vec[0].empty() )
+	{
+		std::cout << "unknown command " << cmd_vec[0] << std::endl;
+	}
+}
+
+std::string json_string(const std::string& value)
+{
+	std::ostringstream out;
+	out << '"';
+	for(char c : value)
+	{
+		switch(c)
+		{
+			case '"':  out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\r': out << "\\r"; break;
+			case '\t': out << "\\t"; break;
+			default:
+				if( (unsigned char)c < 0x20 )
+				{
+					char buffer[8];
+					std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+					out << buffer;
+				}
+				else
+					out << c;
+		}
+	}
+	out << '"';
+	return out.str();
+}
+
+const char* json_bool(bool value)
+{
+	return value ? "true" : "false";
+}
+
+// executes a command received on the admin socket and returns the reply as a single line of JSON
+std::string admin_command(DedicatedServer& server, const std::string& command)
+{
+	std::vector<std::string> cmd_vec = split_command(command);
+	std::ostringstream reply;
+
+	if( cmd_vec[0] == "stats" || cmd_vec[0] == "status" )
+	{
+		reply << "{\"uptime\":" << SWLS_RunningTime / UPDATE_FREQUENCY
+			  << ",\"packets\":" << SWLS_PacketCount
+			  << ",\"connections\":" << SWLS_Connections
+			  << ",\"started_games\":" << SWLS_Games
+			  << ",\"game_steps\":" << SWLS_GameSteps
+			  << ",\"clients\":" << server.getConnectedClients()
+			  << ",\"waiting_players\":" << server.getWaitingPlayers()
+			  << ",\"running_games\":" << server.getActiveGamesCount()
+			  << ",\"accepting\":" << json_bool(server.acceptsNewPlayers())
+			  << ",\"draining\":" << json_bool(server.isDraining())
+			  << ",\"overloaded\":" << json_bool(server.isOverloaded());
+		auto load = server.getLoadReport();
+		reply << ",\"load\":{\"ticks\":" << load.ticks
+			  << ",\"lateness_p99\":" << load.latenessP99
+			  << ",\"lateness_max\":" << load.latenessMax
+			  << ",\"step_cost\":" << load.averageCost << "}";
+		if( g_coordinator )
+		{
+			reply << ",\"workers\":[";
+			bool first = true;
+			for(const auto& worker : g_coordinator->getWorkers())
+			{
+				reply << (first ? "" : ",") << "{\"pid\":" << worker.pid
+					  << ",\"port\":" << worker.port
+					  << ",\"alive\":" << json_bool(worker.alive)
+					  << ",\"games\":" << worker.games
+					  << ",\"clients\":" << worker.clients
+					  << ",\"overloaded\":" << json_bool(worker.overloaded)
+					  << ",\"lateness_p99\":" << worker.latenessP99 << "}";
+				first = false;
+			}
+			reply << "]";
+		}
+		reply << "}";
+	}
+	else if( cmd_vec[0] == "players" )
+	{
+		reply << "{\"players\":[";
+		bool first = true;
+		for(const auto& player : server.getPlayerList())
+		{
+			reply << (first ? "" : ",") << "{\"id\":" << json_string(player.id)
+				  << ",\"name\":" << json_string(player.name) << ",\"status\":";
+			if( player.inGame )
+				reply << (player.spectating ? "\"watching\"" : "\"playing\"") << ",\"game\":" << player.game;
+			else
+				reply << "\"waiting\"";
+			reply << "}";
+			first = false;
+		}
+		reply << "]}";
+	}
+	else if( cmd_vec[0] == "games" )
+	{
+		reply << "{\"games\":[";
+		bool first = true;
+		for(const auto& game : server.getGameList())
+		{
+			reply << (first ? "" : ",") << "{\"id\":" << game.id
+				  << ",\"left\":{\"name\":" << json_string(game.leftName) << ",\"score\":" << game.leftScore << "}"
+				  << ",\"right\":{\"name\":" << json_string(game.rightName) << ",\"score\":" << game.rightScore << "}"
+				  << ",\"score_to_win\":" << game.scoreToWin
+				  << ",\"speed\":" << game.speed
+				  << ",\"started\":" << json_bool(game.started)
+				  << ",\"paused\":" << json_bool(game.paused)
+				  << ",\"steps\":" << game.steps
+				  << ",\"step_cost\":" << std::lround(game.stepCost)
+				  << ",\"spectators\":" << game.spectators << "}";
+			first = false;
+		}
+		reply << "]}";
+	}
+	else if( cmd_vec[0] == "kick" )
+	{
+		std::string target = kick_target(command);
+		if( server.kickPlayer(target) )
+			reply << "{\"kicked\":" << json_string(target) << "}";
+		else
+			reply << "{\"error\":\"no such player\",\"player\":" << json_string(target) << "}";
+	}
+	else if( cmd_vec[0] == "drain" )
+	{
+		bool drain;
+		if( parse_drain(cmd_vec, drain) )
+		{
+			server.setDraining( drain );
+			reply << "{\"draining\":" << json_bool(drain) << ",\"running_games\":" << server.getActiveGamesCount()
+				  << ",\"clients\":" << server.getConnectedClients() << "}";
+		}
+		else
+			reply << "{\"error\":\"usage: drain [on|off]\"}";
+	}
+	else if( cmd_vec[0] == "reload" )
+	{
+		if( reload_config(server) )
+			reply << "{\"reloaded\":true}";
+		else
+			reply << "{\"error\":\"could not reload config, see log\",\"reloaded\":false}";
+	}
+	else if( cmd_vec[0] == "exit" )
+	{
+		g_run_server = false;
+		reply << "{\"exit\":true}";
+	}
+	else
+	{
+		reply << "{\"error\":\"unknown command\",\"command\":" << json_string(cmd_vec[0])
+			  << ",\"commands\":[\"stats\",\"players\",\"games\",\"kick\",\"drain\",\"reload\",\"exit\"]}";
+	}
+
+	return reply.str();
+}
+
 // -----------------------------------------------------------------------------------------
 
 void printHelp()
@@ -233,12 +692,18 @@ void printHelp()
 	std::cout << "  -n, --no-daemon           Don't run as background process" << std::endl;
 	std::cout << "  -p, --print-msgs          Print messages to stderr" << std::endl;
 	std::cout << "  -c, --config-file <path>  Use custom config file instead of server.xml" << std::endl;
+	std::cout << "  -a, --admin-socket <path> Accept admin commands on this unix socket" << std::endl;
 	std::cout << "  -h, --help                This message\n" << std::endl;
 	std::cout << "during the run of the programme, the following commands can be used:\n"
 			  << "players:   print player list\n"
 			  << "games:     print game list\n"
 			  << "status:    print server status\n"
-			  << "exit:      exits server (kills all running games!)" << std::endl;
+			  << "kick <p>:  disconnect the player with address or name p\n"
+			  << "drain [on|off]: stop accepting new players and games\n"
+			  << "reload:    re-read the config file (also on SIGHUP). Running games keep their rules\n"
+			  << "exit:      exits server (kills all running games!)\n"
+			  << "the same commands are accepted on the admin socket, which replies with one line\n"
+			  << "of JSON per command. There, status is also available as stats." << std::endl;
 }
 
 
@@ -270,6 +735,18 @@ void process_arguments(int argc, char** argv)
 				g_config_file = std::string("server/") + argv[i];
 				continue;
 			}
+			if (strcmp(argv[i], "--admin-socket") == 0 || strcmp(argv[i], "-a") == 0)
+			{
+				++i;
+				if (i >= argc)
+				{
+					std::cout << "\"admin-socket\" option needs an argument" << std::endl;
+					printHelp();
+					exit(1);
+				}
+				g_admin_socket_path = argv[i];
+				continue;
+			}
 			if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
 			{
 				printHelp();
@@ -36,6 +36,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 GameState::GameState(DuelMatch* match) : mMatch(match), mSaveReplay(false)
 {
+	if(mMatch)
+	{
+		mSnapshot = InterpolatedState( mMatch->getState() );
+		mPreviousSnapshot = mSnapshot;
+	}
 }
 
 GameState::~GameState()
@@ -52,8 +57,11 @@ void GameState::presentGame()
 	RenderManager& rmanager = RenderManager::getSingleton();
 	SoundManager& smanager = SoundManager::getSingleton();
 
-	rmanager.setBlob(LEFT_PLAYER, mMatch->getBlobPosition(LEFT_PLAYER), mMatch->getWorld().getBlobState(LEFT_PLAYER));
-	rmanager.setBlob(RIGHT_PLAYER, mMatch->getBlobPosition(RIGHT_PLAYER),	mMatch->getWorld().getBlobState(RIGHT_PLAYER));
+	mPreviousSnapshot = mSnapshot;
+	mSnapshot = InterpolatedState( mMatch->getState() );
+
+	rmanager.setBlob(LEFT_PLAYER, mSnapshot.blobPosition[LEFT_PLAYER], mSnapshot.blobState[LEFT_PLAYER]);
+	rmanager.setBlob(RIGHT_PLAYER, mSnapshot.blobPosition[RIGHT_PLAYER], mSnapshot.blobState[RIGHT_PLAYER]);
 
 	if(mMatch->getPlayer(LEFT_PLAYER).getOscillating())
 	{
@@ -73,7 +81,7 @@ void GameState::presentGame()
 		rmanager.setBlobColor(RIGHT_PLAYER, mMatch->getPlayer(RIGHT_PLAYER).getStaticColor());
 	}
 
-	rmanager.setBall(mMatch->getBallPosition(), mMatch->getWorld().getBallRotation());
+	rmanager.setBall(mSnapshot.ballPosition, mSnapshot.ballRotation);
 
 	auto events = mMatch->getEvents( );
 	for(const auto& e : events )
@@ -91,6 +99,16 @@ void GameState::presentGame()
 	}
 }
 
+void GameState::present_impl(float fraction)
+{
+	InterpolatedState state = interpolate(mPreviousSnapshot, mSnapshot, fraction);
+
+	RenderManager& rmanager = RenderManager::getSingleton();
+	rmanager.setBlob(LEFT_PLAYER, state.blobPosition[LEFT_PLAYER], state.blobState[LEFT_PLAYER]);
+	rmanager.setBlob(RIGHT_PLAYER, state.blobPosition[RIGHT_PLAYER], state.blobState[RIGHT_PLAYER]);
+	rmanager.setBall(state.ballPosition, state.ballRotation);
+}
+
 void GameState::presentGameUI()
 {
 	auto& imgui = IMGUI::getSingleton();
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "State.h"
 #include "TextManager.h"
+#include "InterpolatedState.h"
 
 #include <functional>
 #include <tuple>
@@ -39,6 +40,9 @@ public:
 	// step function defines the steps actual work
 	void step_impl() override = 0;
 
+	/// interpolates the moving objects between the last two steps
+	void present_impl(float fraction) override;
+
 protected:
 
 	/// static protected helper function that
@@ -78,6 +82,10 @@ protected:
 
 	std::unique_ptr<DuelMatch> mMatch;
 
+	// positions drawn after the last two calls of presentGame. Frames between steps are interpolated.
+	InterpolatedState mSnapshot;
+	InterpolatedState mPreviousSnapshot;
+
 	// ui helper variable for storing a filename
 	bool mSaveReplay;
 
@@ -41,9 +41,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 LobbySubstate::~LobbySubstate() = default;
 
 
-LobbyState::LobbyState(ServerInfo info, PreviousState previous) :
+LobbyState::LobbyState(ServerInfo info, PreviousState previous, unsigned reservation) :
 		mClient(new RakClient(), [](RakClient* client) { client->Disconnect(25); delete client; }),
-		mInfo(std::move(info)), mPrevious( previous ),
+		mInfo(std::move(info)), mPrevious( previous ), mReservation( reservation ),
 		mLobbyState(ConnectionState::CONNECTING)
 {
 	if (!mClient->Connect(mInfo.hostname, mInfo.port, 0, 0, RAKNET_THREAD_SLEEP_TIME))
@@ -84,6 +84,17 @@ void LobbyState::step_impl()
 				makeEnterServerPacket(stream, mLocalPlayer);
 				mClient->Send(&stream, LOW_PRIORITY, RELIABLE_ORDERED, 0);
 
+				// we have been sent here by another server, so claim the game that waits for us
+				if( mReservation != 0 )
+				{
+					RakNet::BitStream claim;
+					claim.Write((unsigned char)ID_LOBBY);
+					claim.Write((unsigned char)LobbyPacketType::CLAIM_RESERVATION);
+					auto writer = createGenericWriter(&claim);
+					writer->uint32(mReservation);
+					mClient->Send(&claim, LOW_PRIORITY, RELIABLE_ORDERED, 0);
+				}
+
 				mSubState = std::make_shared<LobbyMainSubstate>(mClient, 0, 0, 3);
 				break;
 			}
@@ -173,6 +184,24 @@ void LobbyState::step_impl()
 						mSubState = std::make_shared<LobbyMainSubstate>(mClient, mPreferedSpeed, mPreferedRules, mPreferedScore);
 					}
 
+				} else if((LobbyPacketType)t == LobbyPacketType::RUNNING_GAMES)
+				{
+					std::vector<unsigned int> gameids;
+					std::vector<std::string> gamenames;
+					std::vector<unsigned char> gamespeeds;
+					std::vector<unsigned char> gamerules;
+					std::vector<unsigned char> gamescores;
+					in->generic<std::vector<unsigned int>>( gameids );
+					in->generic<std::vector<std::string>>( gamenames );
+					in->generic<std::vector<unsigned char>>( gamespeeds );
+					in->generic<std::vector<unsigned char>>( gamerules );
+					in->generic<std::vector<unsigned char>>( gamescores );
+
+					mStatus.mRunningGames.clear();
+					for( unsigned i = 0; i < gameids.size(); ++i)
+					{
+						mStatus.mRunningGames.push_back( ServerStatusData::RunningGame{ gameids.at(i), gamenames.at(i), gamerules.at(i), gamespeeds.at(i), gamescores.at(i)});
+					}
 				} else if((LobbyPacketType)t == LobbyPacketType::GAME_STATUS)
 				{
 					mSubState = std::make_shared<LobbyGameSubstate>(mClient, in);
@@ -183,18 +212,39 @@ void LobbyState::step_impl()
 				}
 				break;
 			case ID_RULES_CHECKSUM: // this packet is send when a game was created, so we probably are joining a game here.
-				// this is only a valid request if we are in the lobby game substate
-				assert(dynamic_cast<LobbyGameSubstate*>(mSubState.get()) != nullptr);
 				{
 				RakNet::BitStream stream(packet->data, packet->length, false);
 
 				stream.IgnoreBytes(1);	// ignore ID_RULES_CHECKSUM
 
 				int serverChecksum, scoreToWin;
+				bool spectator = false;
 				stream.Read(serverChecksum);
 				stream.Read(scoreToWin);
+				// older servers don't send the spectator flag
+				if( stream.GetNumberOfUnreadBits() > 0 )
+					stream.Read(spectator);
 
-				switchState( new NetworkGameState( mClient, serverChecksum, scoreToWin ) );
+				// this is only a valid request if we are in the lobby game substate, or want to watch a game,
+				// or if the game was reserved for us
+				assert(spectator || mReservation != 0 || dynamic_cast<LobbyGameSubstate*>(mSubState.get()) != nullptr);
+
+				switchState( new NetworkGameState( mClient, serverChecksum, scoreToWin, spectator ) );
+				}
+				break;
+			case ID_SERVER_REDIRECT:	// the game is hosted by another process of the server cluster
+				{
+				RakNet::BitStream stream(packet->data, packet->length, false);
+				stream.IgnoreBytes(1);	// ignore ID_SERVER_REDIRECT
+
+				int port;
+				unsigned token;
+				if( !stream.Read(port) || !stream.Read(token) )
+					break;
+
+				ServerInfo info = mInfo;
+				info.port = port;
+				switchState( new LobbyState(info, mPrevious, token) );
 				}
 				break;
 			default:
@@ -294,6 +344,11 @@ void LobbyMainSubstate::step(const ServerStatusData& status)
 	{
 		gamelist.push_back( game.name + (game.hasPassword ? "🔒" : "") );
 	}
+	// running games can be watched. they are listed after the open games
+	for ( const auto& game : status.mRunningGames)
+	{
+		gamelist.push_back( game.name );
+	}
 
 	unsigned int previousSelectedGame = mSelectedGame;
 	bool doEnterGame = imgui.doSelectbox(GEN_ID, Vector2(25.0, 90.0), Vector2(375.0, 470.0), gamelist, mSelectedGame) == SBA_DBL_CLICK;
@@ -310,7 +365,43 @@ void LobbyMainSubstate::step(const ServerStatusData& status)
 	if(mSelectedGame >= gamelist.size())
 		mSelectedGame = 0;
 
-	if(mSelectedGame != 0)
+	if(mSelectedGame > status.mOpenGames.size())
+	{
+		const auto& game = status.mRunningGames.at(mSelectedGame - 1 - status.mOpenGames.size());
+
+		// info panel
+		imgui.doOverlay(GEN_ID, Vector2(425.0, 90.0), Vector2(775.0, 470.0));
+
+		// info panel contents:
+		//  * gamespeed
+		imgui.doText(GEN_ID, Vector2(435, 100), imgui.getText(TextManager::NET_SPEED) +
+					 std::to_string(int(0.5 + 100.0 / 75.0 * status.mPossibleSpeeds.at(game.speed))) + "%");
+		//  * points
+		imgui.doText(GEN_ID, Vector2(435, 135), imgui.getText(TextManager::NET_POINTS) +
+											 std::to_string(game.score) );
+		//  * rulesfile
+		imgui.doText(GEN_ID, Vector2(435, 170), imgui.getText(TextManager::NET_RULES_TITLE) );
+		std::string rulesstring = status.mPossibleRules.at(game.rules) + imgui.getText(TextManager::NET_RULES_BY);
+		rulesstring += status.mPossibleRulesAuthor.at(game.rules);
+		for (unsigned int i = 0; i < rulesstring.length(); i += 25)
+		{
+			imgui.doText(GEN_ID, Vector2(445, 205 + i / 25 * 15), rulesstring.substr(i, 25), TF_SMALL_FONT);
+		}
+
+		// watch game button
+		if( imgui.doButton(GEN_ID, Vector2(435, 430), imgui.getText(TextManager::NET_SPECTATE) ) ||
+			doEnterGame)
+		{
+			RakNet::BitStream stream;
+			stream.Write((unsigned char)ID_LOBBY);
+			stream.Write((unsigned char)LobbyPacketType::SPECTATE_GAME);
+			auto writer = createGenericWriter(&stream);
+			writer->generic<unsigned int>(game.id);
+
+			mClient->Send(&stream, LOW_PRIORITY, RELIABLE_ORDERED, 0);
+		}
+	}
+	else if(mSelectedGame != 0)
 	{
 		unsigned gameIndex = mSelectedGame - 1;
 
@@ -31,12 +31,22 @@ struct ServerStatusData
 		bool hasPassword;
 	};
 
+	struct RunningGame
+	{
+		unsigned id;
+		std::string name;
+		unsigned rules;
+		unsigned speed;
+		unsigned score;
+	};
+
 	const OpenGame& getGame( unsigned id ) const
 	{
 		return mOpenGames.at(id);
 	}
 
 	std::vector<OpenGame> mOpenGames;
+	std::vector<RunningGame> mRunningGames;
 	std::vector<unsigned int> mPossibleSpeeds;
 	std::vector<std::string> mPossibleRules;
 	std::vector<std::string> mPossibleRulesAuthor;
@@ -59,7 +69,9 @@ public:
 class LobbyState : public State
 {
 	public:
-		LobbyState(ServerInfo info, PreviousState previous);
+		/// \param reservation token of a game or spectator slot that was reserved for us on this
+		///			server. 0 for a normal lobby connection.
+		LobbyState(ServerInfo info, PreviousState previous, unsigned reservation = 0);
 		~LobbyState() override;
 
 		void step_impl() override;
@@ -70,6 +82,7 @@ class LobbyState : public State
 		PlayerIdentity mLocalPlayer;
 		ServerInfo mInfo;
 		PreviousState mPrevious;
+		unsigned mReservation;
 
 		ConnectionState mLobbyState;
 
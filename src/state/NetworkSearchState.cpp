@@ -125,6 +125,7 @@ void NetworkSearchState::step_impl()
 					RakNet::BitStream stream(packet->data, packet->length, false);
 					stream.IgnoreBytes(1);	//ID_BLOBBY_SERVER_PRESENT
 					ServerInfo info(stream,	(*iter)->PlayerIDToDottedIP(packet->playerId), packet->playerId.port);
+					info.acceptsplayers = mBusyServers.erase(*iter) == 0;
 
 					printf("server %s at %s is a blobby server\n", info.name, info.hostname);
 
@@ -174,6 +175,12 @@ void NetworkSearchState::step_impl()
 					}
 					break;
 				}
+				case ID_SERVER_BUSY:
+				{
+					// the server info follows in the next packet
+					mBusyServers.insert(*iter);
+					break;
+				}
 				case ID_VERSION_MISMATCH:
 				{
 					// this packet is send when the client is older than the server!
@@ -194,6 +201,7 @@ void NetworkSearchState::step_impl()
 					// we must free the packet here
 					packet.reset();
 					(*iter)->Disconnect(50);
+					mBusyServers.erase(*iter);
 					delete *iter;
 					iter = mQueryClients.erase(iter);
 					if (iter == mQueryClients.end())
@@ -256,7 +264,11 @@ void NetworkSearchState::step_impl()
 	std::vector<std::string> servernames;
 	for (auto& server : mScannedServers)
 	{
-		servernames.push_back(std::string(server.name) + " (" + std::to_string(server.waitingplayers) + ")" );
+		std::string name = std::string(server.name) + " (" + std::to_string(server.waitingplayers) + ")";
+		// busy servers refuse new players, so they are marked to make players pick another one
+		if( !server.acceptsplayers )
+			name += " - " + imgui.getText(TextManager::NET_SERVER_BUSY);
+		servernames.push_back( name );
 	}
 
 	if( imgui.doSelectbox(GEN_ID, Vector2(25.0, 60.0), Vector2(775.0, 470.0), servernames, mSelectedServer) == SBA_DBL_CLICK )
@@ -329,6 +341,8 @@ void NetworkSearchState::step_impl()
 		waitingplayer << imgui.getText(TextManager::NET_WAITING_PLAYER)
 					  << mScannedServers[mSelectedServer].waitingplayers;
 		imgui.doText(GEN_ID, Vector2(50, 190), waitingplayer.str());
+		if( !mScannedServers[mSelectedServer].acceptsplayers )
+			imgui.doText(GEN_ID, Vector2(50, 220), TextManager::NET_SERVER_BUSY);
 		std::string description = mScannedServers[mSelectedServer].description;
 		for (unsigned int i = 0; i < description.length(); i += 29)
 		{
@@ -25,6 +25,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <vector>
 #include <list>
+#include <set>
 #include <future>
 #include <atomic>
 
@@ -64,6 +65,8 @@ private:
 	typedef std::list<RakClient*> ClientList;
 
 	ClientList mQueryClients;
+	// query clients whose server sent ID_SERVER_BUSY
+	std::set<RakClient*> mBusyServers;
 	RakClient* mDirectConnectClient;
 
 	std::future<void> mPingJob;
@@ -22,7 +22,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* includes */
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <sstream>
 
 #include <boost/scoped_array.hpp>
 #include <utility>
@@ -47,13 +49,26 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 // global variable to save the lag
 int CURRENT_NETWORK_LAG = -1;
 
+namespace
+{
+	// while the input doesn't change, it is only sent every few frames
+	const unsigned INPUT_HEARTBEAT_INTERVAL = 10;
+}
+
 
 /* implementation */
-NetworkGameState::NetworkGameState( std::shared_ptr<RakClient> client, int rule_checksum, int score_to_win)
+NetworkGameState::NetworkGameState( std::shared_ptr<RakClient> client, int rule_checksum, int score_to_win, bool spectator)
 	: GameState(new DuelMatch(true, DEFAULT_RULES_FILE, score_to_win))
 	, mNetworkState(WAITING_FOR_OPPONENT)
+	, mSpectator(spectator)
 	, mWaitingForReplay(false)
 	, mClient(std::move(client))
+	, mUpdateCounter(0)
+	, mLag(-1)
+	, mLastTimeBack(0)
+	, mSendInputHistory(false)
+	, mInputFrame(0)
+	, mLastInputChange(0)
 	, mWinningPlayer(NO_PLAYER)
 	, mSelectedChatmessage(0)
 	, mChatCursorPosition(0)
@@ -61,6 +76,12 @@ NetworkGameState::NetworkGameState( std::shared_ptr<RakClient> client, int rule_
 	std::shared_ptr<IUserConfigReader> config = IUserConfigReader::createUserConfigReader("config.xml");
 	mOwnSide = (PlayerSide)config->getInteger("network_side");
 	mUseRemoteColor = config->getBool("use_remote_color");
+	// spectators see the game from the servers point of view, and the names and colors are sent by the server
+	if(mSpectator)
+	{
+		mOwnSide = LEFT_PLAYER;
+		mUseRemoteColor = true;
+	}
 	mLocalInput.reset(new LocalInputSource(mOwnSide));
 	mLocalInput->setMatch(mMatch.get());
 
@@ -90,6 +111,8 @@ NetworkGameState::NetworkGameState( std::shared_ptr<RakClient> client, int rule_
 	}
 
 	mRemotePlayer->setName("");
+	if(mSpectator)
+		mLocalPlayer->setName("");
 
 	// check the rules
 	int ourChecksum = 0;
@@ -135,14 +158,33 @@ void NetworkGameState::step_impl()
 				stream.IgnoreBytes(1);	//ID_GAME_UPDATE
 				unsigned timeBack;
 				stream.Read(timeBack);
-				CURRENT_NETWORK_LAG = SDL_GetTicks() - timeBack;
+				// spectators don't send any input, so the server can't send a time back.
+				// a single sample jitters too much, so the lag is averaged. Input is not sent every
+				// frame, so only new times are samples.
+				if(!mSpectator && timeBack != mLastTimeBack)
+				{
+					mLastTimeBack = timeBack;
+					float sample = SDL_GetTicks() - timeBack;
+					mLag = mLag < 0 ? sample : mLag + (sample - mLag) / 8;
+					CURRENT_NETWORK_LAG = std::lround(mLag);
+				}
 				DuelMatchState ms;
 				/// \todo this is a performance nightmare: we create a new reader for every packet!
 				///			there should be a better way to do that
 				std::shared_ptr<GenericIn> in = createGenericReader(&stream);
 				in->generic<DuelMatchState> (ms);
+
+				// older servers don't send their step
+				unsigned tick = ++mUpdateCounter;
+				if( stream.GetNumberOfUnreadBits() >= (int)(8 * sizeof(unsigned)) )
+				{
+					stream.Read(tick);
+					mSendInputHistory = true;
+				}
+
 				// inject network data into game
 				mMatch->setState( ms );
+				mJitterBuffer.addState(tick, ms);
 				break;
 			}
 
@@ -192,6 +234,7 @@ void NetworkGameState::step_impl()
 				{
 					mNetworkState = PAUSING;
 					mMatch->pause();
+					mJitterBuffer.reset();
 				}
 				break;
 			case ID_UNPAUSE:
@@ -200,6 +243,7 @@ void NetworkGameState::step_impl()
 					SDL_StopTextInput();
 					mNetworkState = PLAYING;
 					mMatch->unpause();
+					mJitterBuffer.reset();
 				}
 				break;
 			case ID_GAME_READY:
@@ -248,6 +292,35 @@ void NetworkGameState::step_impl()
 				SoundManager::getSingleton().playSound("sounds/pfiff.wav", ROUND_START_SOUND_VOLUME);
 				break;
 			}
+			case ID_SPECTATOR_READY:
+			{
+				RakNet::BitStream stream(packet->data, packet->length, false);
+				stream.IgnoreBytes(1);	// ignore ID_SPECTATOR_READY
+
+				int speed;
+				stream.Read(speed);
+				SpeedController::getMainInstance()->setGameSpeed(speed);
+
+				for( PlayerSide side : {LEFT_PLAYER, RIGHT_PLAYER} )
+				{
+					char charName[16];
+					stream.Read(charName, sizeof(charName));
+					charName[sizeof(charName)-1] = '\0';
+
+					int color;
+					stream.Read(color);
+
+					mMatch->getPlayer(side).setName(charName);
+					mMatch->getPlayer(side).setStaticColor(Color(color));
+				}
+
+				setDefaultReplayName(mMatch->getPlayer(LEFT_PLAYER).getName(), mMatch->getPlayer(RIGHT_PLAYER).getName());
+				rmanager->redraw();
+
+				mNetworkState = PLAYING;
+				mMatch->unpause();
+				break;
+			}
 			case ID_RULES_CHECKSUM:
 			{
 				assert(0);
@@ -354,6 +427,24 @@ void NetworkGameState::step_impl()
 				}
 				break;
 			}
+			case ID_SERVER_REDIRECT:
+			{
+				// the game was hosted by a worker of a server cluster, so we stay on the server
+				// by going back to its lobby
+				RakNet::BitStream stream(packet->data, packet->length, false);
+				stream.IgnoreBytes(1);	//ID_SERVER_REDIRECT
+				int port;
+				unsigned token;
+				if( !stream.Read(port) || !stream.Read(token) )
+					break;
+
+				ServerInfo info(stream,	mClient->PlayerIDToDottedIP(packet->playerId), port);
+				if (packet->length >= ServerInfo::BLOBBY_SERVER_PRESENT_PACKET_SIZE + 2 * sizeof(int) )
+				{
+					switchState(new LobbyState(info, PreviousState::MAIN));
+				}
+				break;
+			}
 			default:
 				printf("Received unknown Packet %d\n", packet->data[0]);
 				std::cout<<packet->data<<"\n";
@@ -364,9 +455,15 @@ void NetworkGameState::step_impl()
 	// does this generate any problems if we pause at the exact moment an event is set ( i.e. the ball hit sound
 	// could be played in a loop)?
 	presentGame();
+	presentRemoteObjects();
 	presentGameUI();
 
-	if (InputManager::getSingleton()->exit() && mNetworkState != PLAYING)
+	if (InputManager::getSingleton()->exit() && mSpectator && !mSaveReplay)
+	{
+		// spectators can leave at any time
+		switchState(new MainMenuState);
+	}
+	else if (InputManager::getSingleton()->exit() && mNetworkState != PLAYING)
 	{
 		if(mNetworkState == PAUSING)
 		{
@@ -487,6 +584,9 @@ void NetworkGameState::step_impl()
 		{
 			mMatch->step();
 
+			if(mSpectator)
+				break;
+
 			mLocalInput->updateInput();
 			PlayerInputAbs input = mLocalInput->getRealInput();
 
@@ -496,6 +596,12 @@ void NetworkGameState::step_impl()
 				stream.Write((unsigned char)ID_PAUSE);
 				mClient->Send(&stream, HIGH_PRIORITY, RELIABLE_ORDERED, 0);
 			}
+			if(mSendInputHistory)
+			{
+				sendInputHistory(input);
+				break;
+			}
+
 			RakNet::BitStream stream;
 			stream.Write((unsigned char)ID_INPUT_UPDATE);
 			stream.Write( SDL_GetTicks() );
@@ -520,6 +626,13 @@ void NetworkGameState::step_impl()
 		}
 		case PAUSING:
 		{
+			if(mSpectator)
+			{
+				imgui.doOverlay(GEN_ID, Vector2(100.0, 210.0), Vector2(700.0, 310.0));
+				imgui.doText(GEN_ID, Vector2(400.0, 250.0), TextManager::GAME_PAUSED, TF_ALIGN_CENTER);
+				break;
+			}
+
 			// Query
 			displayQueryPrompt(20,
 				TextManager::GAME_PAUSED,
@@ -559,6 +672,62 @@ void NetworkGameState::step_impl()
 	}
 }
 
+void NetworkGameState::sendInputHistory(const PlayerInputAbs& input)
+{
+	// frame 0 means "nothing received" for the server
+	++mInputFrame;
+	if( mInputHistory.empty() || !(mInputHistory.back().input == input) )
+		mLastInputChange = mInputFrame;
+
+	mInputHistory.push_back( TimedInput{mInputFrame, input} );
+	if( mInputHistory.size() > INPUT_HISTORY_LENGTH )
+		mInputHistory.pop_front();
+
+	// as long as a change is within the history, every packet repeats it. After that,
+	// the heartbeat keeps the lag measurement going.
+	if( mInputFrame - mLastInputChange >= INPUT_HISTORY_LENGTH && mInputFrame % INPUT_HEARTBEAT_INTERVAL != 0 )
+		return;
+
+	RakNet::BitStream stream;
+	stream.Write((unsigned char)ID_INPUT_HISTORY);
+	stream.Write( SDL_GetTicks() );
+	writeInputHistory(stream, mInputHistory);
+	mClient->Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
+}
+
+void NetworkGameState::presentRemoteObjects()
+{
+	if( mNetworkState != PLAYING )
+		return;
+
+	InterpolatedState state;
+	if( !mJitterBuffer.step(state) )
+		return;
+
+	// our own blob is drawn as simulated, so it reacts to our input without delay
+	RenderManager& rmanager = RenderManager::getSingleton();
+	mSnapshot.ballPosition = state.ballPosition;
+	mSnapshot.ballRotation = state.ballRotation;
+	rmanager.setBall(state.ballPosition, state.ballRotation);
+	for( PlayerSide side : {LEFT_PLAYER, RIGHT_PLAYER} )
+	{
+		if( mSpectator || side != mOwnSide )
+		{
+			mSnapshot.blobPosition[side] = state.blobPosition[side];
+			mSnapshot.blobState[side] = state.blobState[side];
+			rmanager.setBlob(side, state.blobPosition[side], state.blobState[side]);
+		}
+	}
+
+	if( SpeedController::getMainInstance()->getDrawFPS() )
+	{
+		std::ostringstream stats;
+		stats << "buffer " << mJitterBuffer.getDepth() << "  delay " << std::lround(mJitterBuffer.getDelay())
+			  << "  late " << mJitterBuffer.getLateCount();
+		IMGUI::getSingleton().doText(GEN_ID, Vector2(400, 580), stats.str(), TF_SMALL_FONT | TF_ALIGN_CENTER);
+	}
+}
+
 const char* NetworkGameState::getStateName() const
 {
 	return "NetworkGameState";
@@ -23,7 +23,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "GameState.h"
 #include "NetworkMessage.h"
 #include "PlayerIdentity.h"
+#include "JitterBuffer.h"
 
+#include <deque>
 #include <vector>
 #include <memory>
 
@@ -45,13 +47,19 @@ class NetworkGameState : public GameState
 public:
 	/// create a NetworkGameState with connection to a certain server
 	/// \param client A client which has an established connection to the server we want to start the game on.
-	NetworkGameState(std::shared_ptr<RakClient> client, int rule_checksum, int score_to_win);
+	/// \param spectator If set, the game is only watched. No input is sent to the server.
+	NetworkGameState(std::shared_ptr<RakClient> client, int rule_checksum, int score_to_win, bool spectator = false);
 
 	~NetworkGameState() override;
 	void step_impl() override;
 	const char* getStateName() const override;
 
 private:
+	/// sends the input of this frame together with the previous ones, if necessary
+	void sendInputHistory(const PlayerInputAbs& input);
+	/// draws ball and remote blobs from the jitter buffer, and its statistics with the fps
+	void presentRemoteObjects();
+
 	enum
 	{
 		WAITING_FOR_OPPONENT,
@@ -68,6 +76,7 @@ private:
 	PlayerIdentity* mRemotePlayer;
 
 	bool mUseRemoteColor;
+	bool mSpectator;
 
 	std::unique_ptr<InputSource> mLocalInput;
 
@@ -75,6 +84,19 @@ private:
 
 	std::shared_ptr<RakClient> mClient;
 	PlayerSide mOwnSide;
+
+	// smooths the drawn positions of the remote objects
+	JitterBuffer mJitterBuffer;
+	// counts the updates of servers that don't send their step
+	unsigned mUpdateCounter;
+	float mLag;
+	unsigned mLastTimeBack;
+
+	// servers that send their step understand ID_INPUT_HISTORY
+	bool mSendInputHistory;
+	std::deque<TimedInput> mInputHistory;
+	unsigned mInputFrame;
+	unsigned mLastInputChange;
 	PlayerSide mWinningPlayer;
 
 	// Chat Vars
@@ -33,6 +33,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Blood.h"
 #include "IMGUI.h"
 #include "FileSystem.h"
+#include "BotBrain.h"
 
 /* implementation */
 OptionState::OptionState()
@@ -44,6 +45,8 @@ OptionState::OptionState()
 	std::string rightScript = mOptionConfig.getString("right_script_name");
 
 	mScriptNames = FileSystem::getSingleton().enumerateFiles("scripts", ".lua");
+	for (const auto& name : BotBrain::getNames())
+		mScriptNames.push_back(name);
 
 	// hack. we cant use something like push_front, though
 	mScriptNames.emplace_back("Human");
@@ -31,29 +31,75 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "TextManager.h"
 #include "SpeedController.h"
 #include "FileSystem.h"
-#include "replays/IReplayLoader.h"
 
 
 /* implementation */
+namespace
+{
+	struct DateRange
+	{
+		TextManager::STRING label;
+		unsigned int seconds;			///< how far back in time replays are listed, 0 for all
+	};
+
+	const DateRange DATE_RANGES[] = {
+		{TextManager::RP_DATE_ANY, 0},
+		{TextManager::RP_DATE_DAY, 24 * 3600},
+		{TextManager::RP_DATE_WEEK, 7 * 24 * 3600},
+		{TextManager::RP_DATE_MONTH, 31 * 24 * 3600},
+		{TextManager::RP_DATE_YEAR, 366 * 24 * 3600} };
+	const unsigned DATE_RANGE_COUNT = sizeof(DATE_RANGES) / sizeof(DATE_RANGES[0]);
+}
+
 ReplaySelectionState::ReplaySelectionState()
 {
 	mChecksumError = false;
 	mVersionError = false;
 	mShowReplayInfo = false;
 
-	mSelectedReplay = 0;
-	mReplayFiles = FileSystem::getSingleton().enumerateFiles("replays", ".bvr");
-	if (mReplayFiles.empty())
-		mSelectedReplay = -1;
-	std::sort(mReplayFiles.rbegin(), mReplayFiles.rend());
+	mSelectedReplay = -1;
+	mSortKey = ReplayIndex::SORT_DATE;
+	mFilterPosition = 0;
+	mWinnerFilterPosition = 0;
+	mDateRange = 0;
+
+	// the index is still being refreshed, the list follows it
+	updateList();
 
 	SpeedController::getMainInstance()->setGameSpeed(75);
 }
 
+void ReplaySelectionState::updateList()
+{
+	std::string selected = mSelectedReplay < mReplayFiles.size() ? mReplayFiles[mSelectedReplay] : "";
+
+	const unsigned int now = std::time(nullptr);
+	const unsigned int range = DATE_RANGES[mDateRange].seconds;
+	mFilter.minDate = range != 0 && range < now ? now - range : 0;
+
+	mIndexRevision = mIndex.getRevision();
+	mListedFilter = mFilter;
+	mReplays = mIndex.query(mFilter, mSortKey);
+	mReplayFiles.clear();
+	for (const auto& replay : mReplays)
+		mReplayFiles.push_back(replay.name);
+
+	auto found = std::find(mReplayFiles.begin(), mReplayFiles.end(), selected);
+	if (found != mReplayFiles.end())
+		mSelectedReplay = found - mReplayFiles.begin();
+	else if (mReplayFiles.empty())
+		mSelectedReplay = -1;
+	else
+		mSelectedReplay = std::min<unsigned>(mSelectedReplay, mReplayFiles.size() - 1);
+}
+
 void ReplaySelectionState::step_impl()
 {
 	IMGUI& imgui = IMGUI::getSingleton();
 
+	if (mIndex.getRevision() != mIndexRevision || mFilter.player != mListedFilter.player ||
+			mFilter.winner != mListedFilter.winner)
+		updateList();
 
 	imgui.doCursor();
 	imgui.doImage(GEN_ID, Vector2(400.0, 300.0), "background");
@@ -99,15 +145,11 @@ void ReplaySelectionState::step_impl()
 	{
 		if (!mReplayFiles.empty())
 		{
-			try
-			{
-				mReplayLoader.reset(IReplayLoader::createReplayLoader(std::string("replays/" + mReplayFiles[mSelectedReplay] + ".bvr")));
-				mShowReplayInfo = true;
-			}
-			catch (std::exception& e)
-			{
-				std::cerr << e.what() << std::endl;
-			}
+			// replays the index has not reached yet are read directly
+			mReplayInfo = mReplays[mSelectedReplay];
+			if (!mReplayInfo.indexed)
+				mReplayInfo = ReplayIndex::readReplayInfo(mReplayInfo.name);
+			mShowReplayInfo = mReplayInfo.valid;
 		}
 	}
 	if (imgui.doButton(GEN_ID, Vector2(644.0, 95.0), TextManager::RP_DELETE))
@@ -115,24 +157,40 @@ void ReplaySelectionState::step_impl()
 		if (!mReplayFiles.empty())
 		if (FileSystem::getSingleton().deleteFile("replays/" + mReplayFiles[mSelectedReplay] + ".bvr"))
 		{
-			mReplayFiles.erase(mReplayFiles.begin()+mSelectedReplay);
-			if (mSelectedReplay >= mReplayFiles.size())
-				mSelectedReplay = mReplayFiles.size()-1;
+			mIndex.remove(mReplayFiles[mSelectedReplay]);
+			updateList();
 		}
 	}
 
+	const TextManager::STRING sortLabels[ReplayIndex::SORT_COUNT] = {
+		TextManager::RP_SORT_DATE, TextManager::RP_SORT_PLAYER, TextManager::RP_SORT_SCORE };
+	if (imgui.doButton(GEN_ID, Vector2(644.0, 145.0), sortLabels[mSortKey]))
+	{
+		mSortKey = ReplayIndex::SortKey((mSortKey + 1) % ReplayIndex::SORT_COUNT);
+		updateList();
+	}
+	imgui.doText(GEN_ID, Vector2(644.0, 195.0), TextManager::RP_FILTER);
+	imgui.doEditbox(GEN_ID, Vector2(644.0, 225.0), 5, mFilter.player, mFilterPosition);
+	imgui.doText(GEN_ID, Vector2(644.0, 275.0), TextManager::RP_FILTER_WINNER);
+	imgui.doEditbox(GEN_ID, Vector2(644.0, 305.0), 5, mFilter.winner, mWinnerFilterPosition);
+	if (imgui.doButton(GEN_ID, Vector2(644.0, 355.0), DATE_RANGES[mDateRange].label))
+	{
+		mDateRange = (mDateRange + 1) % DATE_RANGE_COUNT;
+		updateList();
+	}
+
 	if(mShowReplayInfo)
 	{
 		// setup
-		std::string left =  mReplayLoader->getPlayerName(LEFT_PLAYER);
-		std::string right =  mReplayLoader->getPlayerName(RIGHT_PLAYER);
+		const std::string& left = mReplayInfo.player[LEFT_PLAYER];
+		const std::string& right = mReplayInfo.player[RIGHT_PLAYER];
 
 		const int MARGIN = std::min(std::max(int(300 - 24*(std::max(left.size(),right.size()))), 50), 150);
 
 		const int RIGHT = 800 - MARGIN;
 		imgui.doInactiveMode(false);
 		imgui.doOverlay(GEN_ID, Vector2(MARGIN, 180), Vector2(800-MARGIN, 445));
-		std::string repname = mReplayFiles[mSelectedReplay];
+		const std::string& repname = mReplayInfo.name;
 		imgui.doText(GEN_ID, Vector2(400-repname.size()*12, 190), repname);
 
 		// calculate text positions
@@ -142,7 +200,7 @@ void ReplaySelectionState::step_impl()
 		imgui.doText(GEN_ID, Vector2(400-24, 225), "vs");
 		imgui.doText(GEN_ID, Vector2(RIGHT - 20 - 24*right.size(), 225), right);
 
-		time_t rd = mReplayLoader->getDate();
+		time_t rd = mReplayInfo.date;
 		struct tm* ptm;
 		ptm = gmtime ( &rd );
 		//std::
@@ -152,23 +210,23 @@ void ReplaySelectionState::step_impl()
 		imgui.doText(GEN_ID, Vector2(400 - 12*date.size(), 255), date);
 
 		imgui.doText(GEN_ID, Vector2(MARGIN+20, 300), TextManager::OP_SPEED);
-		std::string speed = std::to_string(mReplayLoader->getSpeed() *100 / 75) + "%" ;
+		std::string speed = std::to_string(mReplayInfo.speed *100 / 75) + "%" ;
 		imgui.doText(GEN_ID, Vector2(RIGHT - 20 - 24*speed.size(), 300), speed);
 
 		imgui.doText(GEN_ID, Vector2(MARGIN+20, 335), TextManager::RP_DURATION);
 		std::string dur;
-		if(mReplayLoader->getDuration() > 99)
+		if(mReplayInfo.duration > 99)
 		{
 			// +30 because of rounding
-			dur = std::to_string((mReplayLoader->getDuration() + 30) / 60) + "min";
+			dur = std::to_string((mReplayInfo.duration + 30) / 60) + "min";
 		} else
 		{
-			dur = std::to_string(mReplayLoader->getDuration()) + "s";
+			dur = std::to_string(mReplayInfo.duration) + "s";
 		}
 		imgui.doText(GEN_ID, Vector2(RIGHT - 20 - 24*dur.size(), 335), dur);
 
 		std::string res;
-		res = std::to_string(mReplayLoader->getFinalScore(LEFT_PLAYER)) + " : " +  std::to_string(mReplayLoader->getFinalScore(RIGHT_PLAYER));
+		res = std::to_string(mReplayInfo.score[LEFT_PLAYER]) + " : " +  std::to_string(mReplayInfo.score[RIGHT_PLAYER]);
 
 		imgui.doText(GEN_ID, Vector2(MARGIN+20, 370), TextManager::RP_RESULT);
 		imgui.doText(GEN_ID, Vector2(RIGHT - 20 - 24*res.size(), 370), res);
@@ -23,11 +23,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "State.h"
 
 #include <vector>
-#include <memory>
 
-class DuelMatch;
-class ReplayPlayer;
-class IReplayLoader;
+#include "replays/ReplayIndex.h"
 
 /*! \class ReplaySelectionState
 	\brief State for replay selection screen
@@ -40,11 +37,26 @@ public:
 	const char* getStateName() const override;
 
 private:
+	/// gets the replays matching the filter from the index, keeping the selection
+	void updateList();
 
+	ReplayIndex mIndex;
+	unsigned int mIndexRevision;
+	std::vector<ReplayInfo> mReplays;
 	std::vector<std::string> mReplayFiles;
 	unsigned mSelectedReplay;
+
+	ReplayIndex::SortKey mSortKey;
+	/// the filter typed by the user, and the one the list was made with
+	ReplayFilter mFilter;
+	ReplayFilter mListedFilter;
+	unsigned mFilterPosition;
+	unsigned mWinnerFilterPosition;
+	/// index into the date ranges the user can choose from
+	unsigned mDateRange;
+
 	bool mShowReplayInfo;
-	std::unique_ptr<IReplayLoader> mReplayLoader;
+	ReplayInfo mReplayInfo;
 
 	bool mChecksumError;
 	bool mVersionError;
@@ -63,6 +63,8 @@ void ReplayState::loadReplay(const std::string& file)
 		rulesFile.write(mReplayPlayer->getRules());
 		rulesFile.close();
 		mMatch.reset(new DuelMatch(false, TEMP_RULES_NAME));
+		if (IUserConfigReader::createUserConfigReader("config.xml")->getBool("replay_keyframes", true))
+			mReplayPlayer->buildKeyframes(TEMP_RULES_NAME);
 
 		SoundManager::getSingleton().playSound(	"sounds/pfiff.wav", ROUND_START_SOUND_VOLUME);
 
@@ -179,9 +181,10 @@ void ReplayState::step_impl()
 
 		if (fast_click)
 		{
+			// up to 16 times as fast, seeking keeps up with that
 			mSpeedValue *= 2;
-			if(mSpeedValue > 64)
-				mSpeedValue = 64;
+			if(mSpeedValue > 128)
+				mSpeedValue = 128;
 		}
 
 		if (slow_click)
@@ -79,6 +79,12 @@ void State::step()
 	}
 }
 
+void State::present(float fraction)
+{
+	if(mCurrentState != nullptr)
+		mCurrentState->present_impl(fraction);
+}
+
 const char* State::getCurrenStateName()
 {
 	return mCurrentState->getStateName();
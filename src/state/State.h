@@ -48,10 +48,17 @@ public:
 	virtual void step_impl() = 0;
 	virtual const char* getStateName() const = 0;
 
+	/// updates what is drawn between two steps. \p fraction is the time that has passed since
+	/// the last step, relative to the step duration. Most states don't change between steps.
+	virtual void present_impl(float fraction) {}
+
 	// static functions
 	/// performs a step in the current state
 	static void step();
 
+	/// prepares drawing a frame of the current state, see present_impl
+	static void present(float fraction);
+
 	/// deinits the state system, deleting the current state.
 	/// this is necessary for now to ensure correct destruction order, so the debug counters are destroyed after the
 	/// state is uncounted.
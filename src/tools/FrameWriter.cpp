@@ -0,0 +1,210 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "FrameWriter.h"
+
+/* includes */
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+
+/* implementation */
+namespace
+{
+	// zlib stored blocks can't be longer than this
+	const unsigned int MAX_STORED_BLOCK = 65535;
+
+	unsigned long crc32(const unsigned char* data, size_t length, unsigned long crc = 0)
+	{
+		// several render workers write frames at once, the static initialisation is thread safe
+		static const std::array<unsigned long, 256> table = []()
+		{
+			std::array<unsigned long, 256> result;
+			for (unsigned long n = 0; n < 256; ++n)
+			{
+				unsigned long c = n;
+				for (int k = 0; k < 8; ++k)
+					c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+				result[n] = c;
+			}
+			return result;
+		}();
+
+		crc ^= 0xFFFFFFFFUL;
+		for (size_t i = 0; i < length; ++i)
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return crc ^ 0xFFFFFFFFUL;
+	}
+
+	void putBigEndian(std::vector<unsigned char>& target, unsigned long value)
+	{
+		target.push_back((value >> 24) & 0xFF);
+		target.push_back((value >> 16) & 0xFF);
+		target.push_back((value >> 8) & 0xFF);
+		target.push_back(value & 0xFF);
+	}
+
+	void writeChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data)
+	{
+		std::vector<unsigned char> chunk;
+		putBigEndian(chunk, data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		putBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+		file.write((const char*)chunk.data(), chunk.size());
+	}
+}
+
+std::unique_ptr<FrameWriter> FrameWriter::createPNGSequence(const std::string& prefix)
+{
+	return std::unique_ptr<FrameWriter>(new PNGFrameWriter(prefix));
+}
+
+std::unique_ptr<FrameWriter> FrameWriter::createY4M(const std::string& filename, int fps)
+{
+	return std::unique_ptr<FrameWriter>(new Y4MFrameWriter(filename, fps));
+}
+
+PNGFrameWriter::PNGFrameWriter(std::string prefix) : mPrefix(std::move(prefix)), mFrame(0)
+{
+}
+
+void PNGFrameWriter::writeFrame(const SDL_Surface* frame)
+{
+	char number[16];
+	snprintf(number, sizeof(number), "_%06d.png", ++mFrame);
+	std::ofstream file(mPrefix + number, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("could not open " + mPrefix + number);
+
+	static const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	file.write((const char*)signature, sizeof(signature));
+
+	std::vector<unsigned char> header;
+	putBigEndian(header, frame->w);
+	putBigEndian(header, frame->h);
+	header.push_back(8);	// bit depth
+	header.push_back(2);	// RGB
+	header.push_back(0);	// compression, filter and interlace method
+	header.push_back(0);
+	header.push_back(0);
+	writeChunk(file, "IHDR", header);
+
+	// scanlines, each starting with filter type 0
+	mImageData.clear();
+	for (int y = 0; y < frame->h; ++y)
+	{
+		const Uint32* row = (const Uint32*)((const Uint8*)frame->pixels + y * frame->pitch);
+		mImageData.push_back(0);
+		for (int x = 0; x < frame->w; ++x)
+		{
+			mImageData.push_back((row[x] >> 16) & 0xFF);
+			mImageData.push_back((row[x] >> 8) & 0xFF);
+			mImageData.push_back(row[x] & 0xFF);
+		}
+	}
+
+	// zlib stream of stored blocks
+	std::vector<unsigned char> zlib = {0x78, 0x01};
+	unsigned long a = 1;
+	unsigned long b = 0;
+	for (size_t offset = 0; offset < mImageData.size(); offset += MAX_STORED_BLOCK)
+	{
+		unsigned int length = std::min<size_t>(MAX_STORED_BLOCK, mImageData.size() - offset);
+		zlib.push_back(offset + length == mImageData.size() ? 1 : 0);
+		zlib.push_back(length & 0xFF);
+		zlib.push_back(length >> 8);
+		zlib.push_back(~length & 0xFF);
+		zlib.push_back((~length >> 8) & 0xFF);
+		zlib.insert(zlib.end(), mImageData.begin() + offset, mImageData.begin() + offset + length);
+
+		for (size_t i = offset; i < offset + length; ++i)
+		{
+			a = (a + mImageData[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+	}
+	putBigEndian(zlib, (b << 16) | a);
+	writeChunk(file, "IDAT", zlib);
+	writeChunk(file, "IEND", {});
+
+	if (!file)
+		throw std::runtime_error("could not write " + mPrefix + number);
+}
+
+Y4MFrameWriter::Y4MFrameWriter(const std::string& filename, int fps) :
+	mFile(filename, std::ios::binary), mFPS(fps), mHeaderWritten(false)
+{
+	if (!mFile)
+		throw std::runtime_error("could not open " + filename);
+}
+
+void Y4MFrameWriter::writeFrame(const SDL_Surface* frame)
+{
+	const int w = frame->w;
+	const int h = frame->h;
+
+	if (!mHeaderWritten)
+	{
+		mFile << "YUV4MPEG2 W" << w << " H" << h << " F" << mFPS << ":1 Ip A1:1 C420jpeg\n";
+		mHeaderWritten = true;
+	}
+
+	// full range BT.601, chroma is averaged over 2x2 pixels
+	mPlanes.assign(w * h + 2 * (w / 2) * (h / 2), 0);
+	unsigned char* luma = mPlanes.data();
+	unsigned char* cb = luma + w * h;
+	unsigned char* cr = cb + (w / 2) * (h / 2);
+
+	for (int y = 0; y < h; y += 2)
+	{
+		for (int x = 0; x < w; x += 2)
+		{
+			int sumR = 0;
+			int sumG = 0;
+			int sumB = 0;
+			for (int dy = 0; dy < 2; ++dy)
+			{
+				const Uint32* row = (const Uint32*)((const Uint8*)frame->pixels + (y + dy) * frame->pitch);
+				for (int dx = 0; dx < 2; ++dx)
+				{
+					int r = (row[x + dx] >> 16) & 0xFF;
+					int g = (row[x + dx] >> 8) & 0xFF;
+					int b = row[x + dx] & 0xFF;
+					luma[(y + dy) * w + x + dx] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+					sumR += r;
+					sumG += g;
+					sumB += b;
+				}
+			}
+
+			int index = (y / 2) * (w / 2) + x / 2;
+			cb[index] = (128 * 4 * 256 - 43 * sumR - 85 * sumG + 128 * sumB + 512) >> 10;
+			cr[index] = (128 * 4 * 256 + 128 * sumR - 107 * sumG - 21 * sumB + 512) >> 10;
+		}
+	}
+
+	mFile << "FRAME\n";
+	mFile.write((const char*)mPlanes.data(), mPlanes.size());
+	if (!mFile)
+		throw std::runtime_error("could not write video frame");
+}
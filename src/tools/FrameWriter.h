@@ -0,0 +1,75 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+/*! \class FrameWriter
+	\brief writes rendered frames to disk
+	\details Frames are expected in SDL_PIXELFORMAT_ARGB8888, as RenderManagerSoftware draws
+			them. Neither format needs an additional library.
+*/
+class FrameWriter
+{
+	public:
+		virtual ~FrameWriter() = default;
+
+		/// writes the next frame, throws a std::runtime_error if that fails
+		virtual void writeFrame(const SDL_Surface* frame) = 0;
+
+		/// writes each frame to its own file <prefix>_000001.png, ...
+		static std::unique_ptr<FrameWriter> createPNGSequence(const std::string& prefix);
+		/// writes all frames into one uncompressed YUV4MPEG2 video
+		static std::unique_ptr<FrameWriter> createY4M(const std::string& filename, int fps);
+};
+
+/// PNG sequence. The image data is stored without compression, which keeps
+/// writing fast and the code free of a zlib dependency.
+class PNGFrameWriter : public FrameWriter
+{
+	public:
+		explicit PNGFrameWriter(std::string prefix);
+		void writeFrame(const SDL_Surface* frame) override;
+
+	private:
+		std::string mPrefix;
+		int mFrame;
+		std::vector<unsigned char> mImageData;
+};
+
+/// YUV4MPEG2 video with 4:2:0 chroma subsampling, as read by ffmpeg and most encoders
+class Y4MFrameWriter : public FrameWriter
+{
+	public:
+		Y4MFrameWriter(const std::string& filename, int fps);
+		void writeFrame(const SDL_Surface* frame) override;
+
+	private:
+		std::ofstream mFile;
+		int mFPS;
+		bool mHeaderWritten;
+		std::vector<unsigned char> mPlanes;
+};
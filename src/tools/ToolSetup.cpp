@@ -0,0 +1,89 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ToolSetup.h"
+
+/* includes */
+#include <random>
+
+#include "FileSystem.h"
+#include "Global.h"
+
+#if BLOBBY_ON_DESKTOP
+#ifndef WIN32
+#include "config.h"
+#endif
+#endif
+
+/* implementation */
+namespace
+{
+	std::string g_prefix;
+	std::string g_rules_dir;	// private write directory, below ~/.blobby
+}
+
+void setup_tool_physfs(const std::vector<std::string>& archives)
+{
+	FileSystem& fs = FileSystem::getSingleton();
+	const std::string separator = fs.getDirSeparator();
+
+	#if BLOBBY_ON_DESKTOP
+	#ifndef WIN32
+		fs.addToSearchPath(BLOBBY_INSTALL_PREFIX  "/share/blobby");
+		for (const auto& archive : archives)
+			fs.addToSearchPath(BLOBBY_INSTALL_PREFIX  "/share/blobby/" + archive);
+	#endif
+	#endif
+	fs.addToSearchPath("data");
+	for (const auto& archive : archives)
+		fs.addToSearchPath("data" + separator + archive);
+}
+
+void create_rules_dir(const std::string& prefix)
+{
+	FileSystem& fs = FileSystem::getSingleton();
+	std::string userdir = fs.getUserDir();
+	g_prefix = prefix;
+	g_rules_dir = prefix + "_" + std::to_string(std::random_device()());
+	fs.setWriteDir(userdir);
+	fs.mkdir(".blobby/" + g_rules_dir + "/rules");
+	fs.removeFromSearchPath(userdir);
+	fs.setWriteDir(userdir + ".blobby" + fs.getDirSeparator() + g_rules_dir);
+}
+
+void remove_rules_dir(int workers)
+{
+	FileSystem& fs = FileSystem::getSingleton();
+	for (int worker = 0; worker < workers; ++worker)
+		fs.deleteFile("rules/" + rules_name(worker));
+	fs.deleteFile("rules");
+
+	std::string userdir = fs.getUserDir();
+	fs.removeFromSearchPath(userdir + ".blobby" + fs.getDirSeparator() + g_rules_dir);
+	fs.setWriteDir(userdir);
+	fs.deleteFile(".blobby/" + g_rules_dir);
+	fs.removeFromSearchPath(userdir);
+}
+
+std::string rules_name(int worker)
+{
+	return g_prefix + "_rules_" + std::to_string(worker) + ".lua";
+}
@@ -0,0 +1,39 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// setup shared by the command line tools blobby-render, blobby-replaystat and blobby-tournament
+
+/// adds the data directory of the installation and data/ to the search path, each of them
+/// followed by \p archives, e.g. "rules.zip"
+void setup_tool_physfs(const std::vector<std::string>& archives);
+
+/// \brief makes ~/.blobby/<prefix>_<random number> the write directory, with a rules directory in it
+/// \details Tools write the rules of replays there. Unlike ~/.blobby/rules, the game doesn't list
+///			them, and parallel runs don't overwrite each others files.
+void create_rules_dir(const std::string& prefix);
+/// deletes the rules files of \p workers workers and the directory made by create_rules_dir
+void remove_rules_dir(int workers);
+/// every worker needs its own copy of the rules, as they are loaded by file name
+std::string rules_name(int worker);
@@ -0,0 +1,260 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "RenderManagerSoftware.h"
+#include "Blood.h"
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "FileSystem.h"
+#include "FileWrite.h"
+#include "IUserConfigReader.h"
+#include "ParallelFor.h"
+#include "replays/ReplayPlayer.h"
+#include "tools/FrameWriter.h"
+#include "tools/ToolSetup.h"
+#include "Global.h"
+
+/* implementation */
+
+struct RenderJob
+{
+	std::string replay;		// replay file as given on the command line
+	std::string mounted;	// path of the replay in the virtual file system
+	std::string name;		// file name without directory and extension
+};
+
+static std::string g_output_dir = ".";
+static std::string g_format = "png";
+static int g_frame_step = 1;
+static unsigned g_threads = 0;
+static std::vector<RenderJob> g_jobs;
+
+static std::mutex g_output_mutex;
+
+void printHelp();
+void process_arguments(int argc, char** argv);
+bool render_replay(const RenderJob& job, int worker);
+
+int main(int argc, char** argv)
+{
+	process_arguments(argc, argv);
+
+	FileSystem fileSys(argv[0]);
+	setup_tool_physfs({"gfx.zip", "backgrounds.zip", "rules.zip"});
+
+	// each replay directory gets its own mount point, so replays with the same name don't clash
+	for (unsigned i = 0; i < g_jobs.size(); ++i)
+	{
+		RenderJob& job = g_jobs[i];
+		std::string::size_type slash = job.replay.find_last_of("/\\");
+		std::string directory = slash == std::string::npos ? "." : job.replay.substr(0, slash);
+		std::string file = slash == std::string::npos ? job.replay : job.replay.substr(slash + 1);
+
+		std::string mountPoint = "render/" + std::to_string(i);
+		fileSys.addToSearchPath(directory, true, mountPoint);
+		job.mounted = mountPoint + "/" + file;
+		job.name = file.substr(0, file.rfind(".bvr"));
+	}
+
+	// the config cache is not thread safe, so it has to be filled before the workers start
+	IUserConfigReader::createUserConfigReader("config.xml");
+
+	if (g_threads == 0)
+		g_threads = std::max(1u, std::thread::hardware_concurrency());
+	g_threads = std::min<unsigned>(g_threads, g_jobs.size());
+
+	std::atomic<int> failed(0);
+	create_rules_dir("render");
+	parallelFor(g_jobs.size(), g_threads, [&](int job, int worker)
+	{
+		if (!render_replay(g_jobs[job], worker))
+			++failed;
+	});
+	remove_rules_dir(g_threads);
+
+	return failed ? 1 : 0;
+}
+
+bool render_replay(const RenderJob& job, int worker)
+{
+	try
+	{
+		ReplayPlayer player;
+		player.load(job.mounted);
+
+		std::string rules = rules_name(worker);
+		FileWrite rulesFile("rules/" + rules);
+		rulesFile.write(player.getRules());
+		rulesFile.close();
+
+		DuelMatch match(false, rules);
+		match.setPlayers(PlayerIdentity{player.getPlayerName(LEFT_PLAYER)},
+						PlayerIdentity{player.getPlayerName(RIGHT_PLAYER)});
+		match.getPlayer(LEFT_PLAYER).setStaticColor(player.getBlobColor(LEFT_PLAYER));
+		match.getPlayer(RIGHT_PLAYER).setStaticColor(player.getBlobColor(RIGHT_PLAYER));
+
+		RenderManagerSoftware renderer(false);
+		renderer.init(BASE_RESOLUTION_X, BASE_RESOLUTION_Y, false);
+		renderer.drawGame(true);
+		renderer.setBlobColor(LEFT_PLAYER, player.getBlobColor(LEFT_PLAYER));
+		renderer.setBlobColor(RIGHT_PLAYER, player.getBlobColor(RIGHT_PLAYER));
+		BloodManager& blood = renderer.getBlood();
+
+		const int speed = player.getGameSpeed();
+		std::string output = g_output_dir + "/" + job.name;
+		std::unique_ptr<FrameWriter> writer = g_format == "y4m" ?
+				FrameWriter::createY4M(output + ".y4m", std::max(1, speed / g_frame_step)) :
+				FrameWriter::createPNGSequence(output);
+
+		int frames = 0;
+		while (player.play(&match))
+		{
+			const int position = player.getReplayPosition();
+			// blood moves in real time, so it gets the time of the replay instead of the wall clock
+			const unsigned int time = position * 1000 / speed;
+			match.getClock().setTime(position / speed);
+
+			for (const auto& e : match.getEvents())
+			{
+				if (e.event == MatchEvent::BALL_HIT_BLOB)
+				{
+					Vector2 hitPos = match.getBallPosition() + (match.getBlobPosition(e.side) - match.getBallPosition()).normalise().scale(31.5);
+					blood.spillBlood(hitPos, e.intensity, e.side, time);
+				}
+			}
+
+			if (position % g_frame_step != 0)
+				continue;
+
+			DuelMatchState state = match.getState();
+			renderer.setBlob(LEFT_PLAYER, state.worldState.blobPosition[LEFT_PLAYER], state.worldState.blobState[LEFT_PLAYER]);
+			renderer.setBlob(RIGHT_PLAYER, state.worldState.blobPosition[RIGHT_PLAYER], state.worldState.blobState[RIGHT_PLAYER]);
+			renderer.setBall(state.worldState.ballPosition, state.worldState.ballRotation);
+			renderer.draw();
+			blood.step(renderer, time);
+
+			// same layout as GameState::presentGameUI
+			char textBuffer[64];
+			snprintf(textBuffer, 8, match.getServingPlayer() == LEFT_PLAYER ? "%02d!" : "%02d ", match.getScore(LEFT_PLAYER));
+			renderer.drawText(textBuffer, Vector2(24, 24));
+			snprintf(textBuffer, 8, match.getServingPlayer() == RIGHT_PLAYER ? "%02d!" : "%02d ", match.getScore(RIGHT_PLAYER));
+			renderer.drawText(textBuffer, Vector2(800 - 24 - strlen(textBuffer) * FONT_WIDTH_NORMAL, 24));
+			const std::string& rightName = match.getPlayer(RIGHT_PLAYER).getName();
+			renderer.drawText(match.getPlayer(LEFT_PLAYER).getName(), Vector2(12, 550));
+			renderer.drawText(rightName, Vector2(788 - rightName.size() * FONT_WIDTH_NORMAL, 550));
+			std::string clock = match.getClock().getTimeString();
+			renderer.drawText(clock, Vector2(400 - clock.size() * FONT_WIDTH_NORMAL / 2, 24));
+
+			writer->writeFrame(renderer.getFramebuffer());
+			++frames;
+		}
+
+		std::lock_guard<std::mutex> lock(g_output_mutex);
+		std::cout << job.replay << ": " << frames << " frames" << std::endl;
+		return true;
+	}
+	catch (const std::exception& e)
+	{
+		std::lock_guard<std::mutex> lock(g_output_mutex);
+		std::cerr << job.replay << ": " << e.what() << std::endl;
+		return false;
+	}
+}
+
+void printHelp()
+{
+	std::cout << "Usage: blobby-render [OPTION...] REPLAY..." << std::endl;
+	std::cout << "  -o, --output <dir>        Write frames to this directory (default: .)" << std::endl;
+	std::cout << "  -f, --format <png|y4m>    PNG sequence or raw YUV4MPEG2 video (default: png)" << std::endl;
+	std::cout << "  -s, --step <n>            Render every nth game step only (default: 1)" << std::endl;
+	std::cout << "  -j, --threads <n>         Number of replays rendered at once (default: all cores)" << std::endl;
+	std::cout << "  -h, --help                This message\n" << std::endl;
+}
+
+void process_arguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		bool hasValue = option == "--output" || option == "-o" || option == "--format" || option == "-f" ||
+						option == "--step" || option == "-s" || option == "--threads" || option == "-j";
+		if (hasValue && i + 1 >= argc)
+		{
+			std::cout << "\"" << option << "\" option needs an argument" << std::endl;
+			printHelp();
+			exit(1);
+		}
+
+		if (option == "--output" || option == "-o")
+		{
+			g_output_dir = argv[++i];
+		}
+		else if (option == "--format" || option == "-f")
+		{
+			g_format = argv[++i];
+			if (g_format != "png" && g_format != "y4m")
+			{
+				std::cout << "Unknown format \"" << g_format << "\"" << std::endl;
+				printHelp();
+				exit(1);
+			}
+		}
+		else if (option == "--step" || option == "-s")
+		{
+			g_frame_step = std::max(1, atoi(argv[++i]));
+		}
+		else if (option == "--threads" || option == "-j")
+		{
+			g_threads = std::max(0, atoi(argv[++i]));
+		}
+		else if (option == "--help" || option == "-h")
+		{
+			printHelp();
+			exit(3);
+		}
+		else if (option[0] == '-')
+		{
+			std::cout << "Unknown option \"" << option << "\"" << std::endl;
+			printHelp();
+			exit(1);
+		}
+		else
+		{
+			g_jobs.push_back(RenderJob{option, "", ""});
+		}
+	}
+
+	if (g_jobs.empty())
+	{
+		printHelp();
+		exit(1);
+	}
+}
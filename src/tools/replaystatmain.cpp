@@ -0,0 +1,652 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "DuelMatch.h"
+#include "FileSystem.h"
+#include "FileWrite.h"
+#include "IUserConfigReader.h"
+#include "ParallelFor.h"
+#include "replays/IReplayLoader.h"
+#include "replays/ReplayPlayer.h"
+#include "replays/ReplaySavePoint.h"
+#include "tools/ToolSetup.h"
+#include "Global.h"
+
+/* implementation */
+
+struct StatJob
+{
+	std::string replay;		// replay file, as given on the command line or found in a directory
+	std::string mounted;	// path of the replay in the virtual file system
+};
+
+/// everything that happened between two serves
+struct RallyStats
+{
+	int start = 0;								// game step of the serve
+	int length = 0;								// in game steps
+	PlayerSide server = NO_PLAYER;
+	PlayerSide winner = NO_PLAYER;				// NO_PLAYER if the replay ended during the rally
+	bool serveIn = false;						// the serve reached the other side
+	int touches[MAX_PLAYERS] = {};
+	int netHits[MAX_PLAYERS] = {};				// attributed to the player who touched the ball last
+	float maxHitSpeed[MAX_PLAYERS] = {};		// speed of the ball after a hit, in pixels per step
+	float hitSpeedSum[MAX_PLAYERS] = {};
+};
+
+struct MatchStats
+{
+	std::string replay;
+	bool ok = false;
+	std::string player[MAX_PLAYERS];
+	int score[MAX_PLAYERS] = {};
+	int steps = 0;
+	int speed = 0;
+	std::vector<RallyStats> rallies;
+};
+
+static std::string g_output = "replaystat";
+static std::string g_format = "csv";
+static unsigned g_threads = 0;
+static bool g_verify = false;
+static std::vector<std::string> g_arguments;
+
+static std::mutex g_output_mutex;
+
+void printHelp();
+void process_arguments(int argc, char** argv);
+std::string prepare_rules(const std::string& replayRules, int worker, std::string& rules);
+MatchStats analyse_replay(const StatJob& job, int worker, std::string& rules);
+bool verify_replay(const StatJob& job, int worker, std::string& rules);
+bool write_csv(const std::vector<MatchStats>& results);
+bool write_json(const std::vector<MatchStats>& results);
+
+int main(int argc, char** argv)
+{
+	process_arguments(argc, argv);
+
+	FileSystem fileSys(argv[0]);
+	setup_tool_physfs({"rules.zip"});
+
+	// every argument gets its own mount point, so replays with the same name don't clash
+	std::vector<StatJob> jobs;
+	for (unsigned i = 0; i < g_arguments.size(); ++i)
+	{
+		const std::string& argument = g_arguments[i];
+		std::string mountPoint = "replaystat/" + std::to_string(i);
+		bool single = argument.size() > 4 && argument.compare(argument.size() - 4, 4, ".bvr") == 0;
+		if (single)
+		{
+			std::string::size_type slash = argument.find_last_of("/\\");
+			std::string directory = slash == std::string::npos ? "." : argument.substr(0, slash);
+			fileSys.addToSearchPath(directory, true, mountPoint);
+			jobs.push_back(StatJob{argument, mountPoint + "/" + argument.substr(slash + 1)});
+		}
+		else
+		{
+			fileSys.addToSearchPath(argument, true, mountPoint);
+			for (const auto& file : fileSys.enumerateFiles(mountPoint, ".bvr", true))
+				jobs.push_back(StatJob{argument + "/" + file, mountPoint + "/" + file});
+		}
+	}
+
+	if (jobs.empty())
+	{
+		std::cerr << "no replays found" << std::endl;
+		return 1;
+	}
+
+	// the config cache is not thread safe, so it has to be filled before the workers start
+	IUserConfigReader::createUserConfigReader("config.xml");
+
+	if (g_threads == 0)
+		g_threads = std::max(1u, std::thread::hardware_concurrency());
+	g_threads = std::min<unsigned>(g_threads, jobs.size());
+
+	std::vector<MatchStats> results(jobs.size());
+	// rules the rules file of each worker currently contains
+	std::vector<std::string> workerRules(g_threads);
+	std::atomic<int> diverged(0);
+	create_rules_dir("replaystat");
+	parallelFor(jobs.size(), g_threads, [&](int job, int worker)
+	{
+		if (!g_verify)
+			results[job] = analyse_replay(jobs[job], worker, workerRules[worker]);
+		else if (!verify_replay(jobs[job], worker, workerRules[worker]))
+			++diverged;
+	});
+	remove_rules_dir(g_threads);
+
+	if (g_verify)
+	{
+		std::cout << jobs.size() - diverged << " of " << jobs.size() << " replays are deterministic" << std::endl;
+		return diverged ? 1 : 0;
+	}
+
+	int failed = 0;
+	for (const auto& result : results)
+		failed += !result.ok;
+	std::cout << results.size() - failed << " replays analysed, " << failed << " failed" << std::endl;
+
+	bool written = g_format == "json" ? write_json(results) : write_csv(results);
+	return written && !failed ? 0 : 1;
+}
+
+std::string prepare_rules(const std::string& replayRules, int worker, std::string& rules)
+{
+	// most replays of a corpus share their rules, so the file is only rewritten when they change.
+	std::string rulesName = rules_name(worker);
+	if (replayRules != rules)
+	{
+		rules = replayRules;
+		FileWrite rulesFile("rules/" + rulesName);
+		rulesFile.write(rules);
+		rulesFile.close();
+	}
+	return rulesName;
+}
+
+MatchStats analyse_replay(const StatJob& job, int worker, std::string& rules)
+{
+	MatchStats stats;
+	stats.replay = job.replay;
+
+	try
+	{
+		ReplayPlayer player;
+		player.load(job.mounted);
+
+		DuelMatch match(false, prepare_rules(player.getRules(), worker, rules));
+		match.setPlayers(PlayerIdentity{player.getPlayerName(LEFT_PLAYER)},
+						PlayerIdentity{player.getPlayerName(RIGHT_PLAYER)});
+
+		stats.player[LEFT_PLAYER] = player.getPlayerName(LEFT_PLAYER);
+		stats.player[RIGHT_PLAYER] = player.getPlayerName(RIGHT_PLAYER);
+		stats.speed = player.getGameSpeed();
+
+		RallyStats rally;
+		rally.server = match.getServingPlayer();
+		bool rallyOver = false;
+		PlayerSide lastTouch = NO_PLAYER;
+
+		while (player.play(&match))
+		{
+			const int position = player.getReplayPosition();
+			for (const auto& e : match.getEvents())
+			{
+				switch (e.event)
+				{
+					case MatchEvent::BALL_HIT_BLOB:
+					{
+						if (rallyOver)
+							break;
+						// without a serving player in the rules, the first touch is the serve
+						if (rally.server == NO_PLAYER)
+							rally.server = e.side;
+						if (e.side != rally.server)
+							rally.serveIn = true;
+
+						float speed = match.getBallVelocity().length();
+						rally.touches[e.side]++;
+						rally.hitSpeedSum[e.side] += speed;
+						rally.maxHitSpeed[e.side] = std::max(rally.maxHitSpeed[e.side], speed);
+						lastTouch = e.side;
+						break;
+					}
+					case MatchEvent::BALL_HIT_NET:
+					case MatchEvent::BALL_HIT_NET_TOP:
+						if (!rallyOver && lastTouch != NO_PLAYER)
+							rally.netHits[lastTouch]++;
+						break;
+					case MatchEvent::PLAYER_ERROR:
+						if (rallyOver)
+							break;
+						rally.winner = e.side == LEFT_PLAYER ? RIGHT_PLAYER : LEFT_PLAYER;
+						// a mistake of the receiving side means the serve was fine
+						if (e.side != rally.server)
+							rally.serveIn = true;
+						rally.length = position - rally.start;
+						stats.rallies.push_back(rally);
+						rallyOver = true;
+						break;
+					case MatchEvent::RESET_BALL:
+						rally = RallyStats();
+						rally.start = position;
+						rally.server = match.getServingPlayer();
+						rallyOver = false;
+						lastTouch = NO_PLAYER;
+						break;
+					default:
+						break;
+				}
+			}
+		}
+
+		stats.steps = player.getReplayPosition();
+		if (!rallyOver && (rally.touches[LEFT_PLAYER] || rally.touches[RIGHT_PLAYER]))
+		{
+			rally.length = stats.steps - rally.start;
+			stats.rallies.push_back(rally);
+		}
+
+		stats.score[LEFT_PLAYER] = match.getScore(LEFT_PLAYER);
+		stats.score[RIGHT_PLAYER] = match.getScore(RIGHT_PLAYER);
+		stats.ok = true;
+	}
+	catch (const std::exception& e)
+	{
+		std::lock_guard<std::mutex> lock(g_output_mutex);
+		std::cerr << job.replay << ": " << e.what() << std::endl;
+	}
+
+	return stats;
+}
+
+namespace
+{
+	const char* sideName(PlayerSide side)
+	{
+		return side == LEFT_PLAYER ? "left" : side == RIGHT_PLAYER ? "right" : "";
+	}
+
+	/// describes the first field in which the states differ, empty if they are bitwise equal
+	std::string firstDifference(const DuelMatchState& expected, const DuelMatchState& actual)
+	{
+		std::ostringstream difference;
+		difference << std::setprecision(9);
+		auto number = [&](const std::string& name, float a, float b)
+		{
+			if (difference.tellp() == 0 && std::memcmp(&a, &b, sizeof(float)) != 0)
+				difference << name << ": expected " << a << ", got " << b;
+		};
+		auto integer = [&](const std::string& name, int a, int b)
+		{
+			if (difference.tellp() == 0 && a != b)
+				difference << name << ": expected " << a << ", got " << b;
+		};
+
+		const PhysicState& world = expected.worldState;
+		const PhysicState& other = actual.worldState;
+		for (int side = LEFT_PLAYER; side < MAX_PLAYERS; ++side)
+		{
+			std::string blob = std::string("blob ") + sideName(PlayerSide(side));
+			number(blob + " position x", world.blobPosition[side].x, other.blobPosition[side].x);
+			number(blob + " position y", world.blobPosition[side].y, other.blobPosition[side].y);
+			number(blob + " velocity x", world.blobVelocity[side].x, other.blobVelocity[side].x);
+			number(blob + " velocity y", world.blobVelocity[side].y, other.blobVelocity[side].y);
+			number(blob + " state", world.blobState[side], other.blobState[side]);
+		}
+		number("ball position x", world.ballPosition.x, other.ballPosition.x);
+		number("ball position y", world.ballPosition.y, other.ballPosition.y);
+		number("ball velocity x", world.ballVelocity.x, other.ballVelocity.x);
+		number("ball velocity y", world.ballVelocity.y, other.ballVelocity.y);
+		number("ball rotation", world.ballRotation, other.ballRotation);
+		number("ball angular velocity", world.ballAngularVelocity, other.ballAngularVelocity);
+
+		const GameLogicState& logic = expected.logicState;
+		const GameLogicState& otherLogic = actual.logicState;
+		integer("score left", logic.leftScore, otherLogic.leftScore);
+		integer("score right", logic.rightScore, otherLogic.rightScore);
+		for (int side = LEFT_PLAYER; side < MAX_PLAYERS; ++side)
+		{
+			std::string player = sideName(PlayerSide(side));
+			integer("hit count " + player, logic.hitCount[side], otherLogic.hitCount[side]);
+			integer("squish " + player, logic.squish[side], otherLogic.squish[side]);
+			integer("input " + player, expected.playerInput[side].getAll(), actual.playerInput[side].getAll());
+		}
+		integer("serving player", logic.servingPlayer, otherLogic.servingPlayer);
+		integer("winning player", logic.winningPlayer, otherLogic.winningPlayer);
+		integer("squish wall", logic.squishWall, otherLogic.squishWall);
+		integer("squish ground", logic.squishGround, otherLogic.squishGround);
+		integer("game running", logic.isGameRunning, otherLogic.isGameRunning);
+		integer("ball valid", logic.isBallValid, otherLogic.isBallValid);
+
+		return difference.str();
+	}
+
+	std::string csvString(const std::string& text)
+	{
+		std::string quoted = "\"";
+		for (char c : text)
+		{
+			if (c == '"')
+				quoted += '"';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	std::string jsonString(const std::string& text)
+	{
+		std::ostringstream quoted;
+		quoted << '"';
+		for (unsigned char c : text)
+		{
+			if (c == '"' || c == '\\')
+				quoted << '\\' << c;
+			else if (c < 0x20)
+				quoted << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+			else
+				quoted << c;
+		}
+		quoted << '"';
+		return quoted.str();
+	}
+
+	/// sums of the rallies of a match
+	struct MatchTotals
+	{
+		int touches[MAX_PLAYERS] = {};
+		int serves[MAX_PLAYERS] = {};
+		int servesIn[MAX_PLAYERS] = {};
+		int netHits[MAX_PLAYERS] = {};
+		float maxHitSpeed[MAX_PLAYERS] = {};
+		float hitSpeedSum[MAX_PLAYERS] = {};
+		int rallySteps = 0;
+
+		explicit MatchTotals(const MatchStats& match)
+		{
+			for (const auto& rally : match.rallies)
+			{
+				rallySteps += rally.length;
+				if (rally.server != NO_PLAYER)
+				{
+					serves[rally.server]++;
+					servesIn[rally.server] += rally.serveIn;
+				}
+				for (int side = LEFT_PLAYER; side < MAX_PLAYERS; ++side)
+				{
+					touches[side] += rally.touches[side];
+					netHits[side] += rally.netHits[side];
+					hitSpeedSum[side] += rally.hitSpeedSum[side];
+					maxHitSpeed[side] = std::max(maxHitSpeed[side], rally.maxHitSpeed[side]);
+				}
+			}
+		}
+
+		float averageRally(const MatchStats& match) const
+		{
+			return match.rallies.empty() ? 0.f : float(rallySteps) / match.rallies.size();
+		}
+
+		float averageHitSpeed(int side) const
+		{
+			return touches[side] ? hitSpeedSum[side] / touches[side] : 0.f;
+		}
+	};
+}
+
+bool verify_replay(const StatJob& job, int worker, std::string& rules)
+{
+	std::ostringstream report;
+	bool deterministic = false;
+
+	try
+	{
+		std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader(job.mounted));
+		DuelMatch match(false, prepare_rules(loader->getRules(), worker, rules));
+
+		// start from the first state, then only the inputs may drive the match.
+		// unlike ReplayPlayer, the save points are compared against, but never applied.
+		ReplaySavePoint savePoint;
+		int savePoints = 0;
+		int compared = 0;
+		int index;
+		if (loader->isSavePoint(0, index))
+		{
+			loader->readSavePoint(index, savePoint);
+			match.setState(savePoint.state);
+			++savePoints;
+		}
+
+		deterministic = true;
+		for (int step = 1; step < loader->getLength() && deterministic; ++step)
+		{
+			loader->getInputAt(step, match.getInputSource(LEFT_PLAYER).get(), match.getInputSource(RIGHT_PLAYER).get());
+			match.step();
+
+			if (!loader->isSavePoint(step, index))
+				continue;
+
+			loader->readSavePoint(index, savePoint);
+			++savePoints;
+			++compared;
+			std::string difference = firstDifference(savePoint.state, match.getState());
+			if (!difference.empty())
+			{
+				report << "diverges at step " << step << ", " << difference;
+				deterministic = false;
+			}
+		}
+
+		// without a save point after the start, nothing has been checked at all
+		if (deterministic && compared == 0)
+		{
+			report << "no save point after the first step, nothing to compare";
+			deterministic = false;
+		}
+
+		if (deterministic)
+			report << "ok, " << savePoints << " save points";
+	}
+	catch (const std::exception& e)
+	{
+		report << e.what();
+	}
+
+	std::lock_guard<std::mutex> lock(g_output_mutex);
+	(deterministic ? std::cout : std::cerr) << job.replay << ": " << report.str() << std::endl;
+	return deterministic;
+}
+
+bool write_csv(const std::vector<MatchStats>& results)
+{
+	std::ofstream matches(g_output + ".matches.csv");
+	std::ofstream rallies(g_output + ".rallies.csv");
+	if (!matches || !rallies)
+	{
+		std::cerr << "could not write " << g_output << ".*.csv" << std::endl;
+		return false;
+	}
+
+	matches << "replay,left,right,score_left,score_right,steps,speed,rallies,avg_rally_length,"
+			"touches_left,touches_right,serves_left,serves_in_left,serves_right,serves_in_right,"
+			"net_hits_left,net_hits_right,max_hit_speed_left,max_hit_speed_right,avg_hit_speed_left,avg_hit_speed_right\n";
+	rallies << "replay,rally,start,length,server,winner,serve_in,touches_left,touches_right,"
+			"net_hits_left,net_hits_right,max_hit_speed_left,max_hit_speed_right\n";
+
+	for (const auto& match : results)
+	{
+		if (!match.ok)
+			continue;
+
+		MatchTotals totals(match);
+		matches << csvString(match.replay) << ',' << csvString(match.player[LEFT_PLAYER]) << ',' << csvString(match.player[RIGHT_PLAYER]) << ','
+				<< match.score[LEFT_PLAYER] << ',' << match.score[RIGHT_PLAYER] << ',' << match.steps << ',' << match.speed << ','
+				<< match.rallies.size() << ',' << totals.averageRally(match) << ','
+				<< totals.touches[LEFT_PLAYER] << ',' << totals.touches[RIGHT_PLAYER] << ','
+				<< totals.serves[LEFT_PLAYER] << ',' << totals.servesIn[LEFT_PLAYER] << ','
+				<< totals.serves[RIGHT_PLAYER] << ',' << totals.servesIn[RIGHT_PLAYER] << ','
+				<< totals.netHits[LEFT_PLAYER] << ',' << totals.netHits[RIGHT_PLAYER] << ','
+				<< totals.maxHitSpeed[LEFT_PLAYER] << ',' << totals.maxHitSpeed[RIGHT_PLAYER] << ','
+				<< totals.averageHitSpeed(LEFT_PLAYER) << ',' << totals.averageHitSpeed(RIGHT_PLAYER) << '\n';
+
+		for (unsigned i = 0; i < match.rallies.size(); ++i)
+		{
+			const RallyStats& rally = match.rallies[i];
+			rallies << csvString(match.replay) << ',' << i << ',' << rally.start << ',' << rally.length << ','
+					<< sideName(rally.server) << ',' << sideName(rally.winner) << ',' << rally.serveIn << ','
+					<< rally.touches[LEFT_PLAYER] << ',' << rally.touches[RIGHT_PLAYER] << ','
+					<< rally.netHits[LEFT_PLAYER] << ',' << rally.netHits[RIGHT_PLAYER] << ','
+					<< rally.maxHitSpeed[LEFT_PLAYER] << ',' << rally.maxHitSpeed[RIGHT_PLAYER] << '\n';
+		}
+	}
+
+	return true;
+}
+
+bool write_json(const std::vector<MatchStats>& results)
+{
+	std::ofstream out(g_output + ".json");
+	if (!out)
+	{
+		std::cerr << "could not write " << g_output << ".json" << std::endl;
+		return false;
+	}
+
+	auto pair = [&](const char* name, float left, float right)
+	{
+		out << "\"" << name << "\": [" << left << ", " << right << "]";
+	};
+
+	out << "[\n";
+	bool first = true;
+	for (const auto& match : results)
+	{
+		if (!match.ok)
+			continue;
+		if (!first)
+			out << ",\n";
+		first = false;
+
+		MatchTotals totals(match);
+		out << "\t{\"replay\": " << jsonString(match.replay)
+			<< ", \"players\": [" << jsonString(match.player[LEFT_PLAYER]) << ", " << jsonString(match.player[RIGHT_PLAYER]) << "], ";
+		pair("score", match.score[LEFT_PLAYER], match.score[RIGHT_PLAYER]);
+		out << ", \"steps\": " << match.steps << ", \"speed\": " << match.speed
+			<< ", \"avg_rally_length\": " << totals.averageRally(match) << ", ";
+		pair("touches", totals.touches[LEFT_PLAYER], totals.touches[RIGHT_PLAYER]);
+		out << ", ";
+		pair("serves", totals.serves[LEFT_PLAYER], totals.serves[RIGHT_PLAYER]);
+		out << ", ";
+		pair("serves_in", totals.servesIn[LEFT_PLAYER], totals.servesIn[RIGHT_PLAYER]);
+		out << ", ";
+		pair("net_hits", totals.netHits[LEFT_PLAYER], totals.netHits[RIGHT_PLAYER]);
+		out << ", ";
+		pair("max_hit_speed", totals.maxHitSpeed[LEFT_PLAYER], totals.maxHitSpeed[RIGHT_PLAYER]);
+		out << ", ";
+		pair("avg_hit_speed", totals.averageHitSpeed(LEFT_PLAYER), totals.averageHitSpeed(RIGHT_PLAYER));
+		out << ",\n\t\t\"rallies\": [";
+
+		for (unsigned i = 0; i < match.rallies.size(); ++i)
+		{
+			const RallyStats& rally = match.rallies[i];
+			out << (i ? ",\n\t\t\t" : "\n\t\t\t") << "{\"start\": " << rally.start << ", \"length\": " << rally.length
+				<< ", \"server\": \"" << sideName(rally.server) << "\", \"winner\": \"" << sideName(rally.winner)
+				<< "\", \"serve_in\": " << (rally.serveIn ? "true" : "false") << ", ";
+			pair("touches", rally.touches[LEFT_PLAYER], rally.touches[RIGHT_PLAYER]);
+			out << ", ";
+			pair("net_hits", rally.netHits[LEFT_PLAYER], rally.netHits[RIGHT_PLAYER]);
+			out << ", ";
+			pair("max_hit_speed", rally.maxHitSpeed[LEFT_PLAYER], rally.maxHitSpeed[RIGHT_PLAYER]);
+			out << "}";
+		}
+		out << "]}";
+	}
+	out << "\n]\n";
+
+	return true;
+}
+
+void printHelp()
+{
+	std::cout << "Usage: blobby-replaystat [OPTION...] REPLAY|DIRECTORY..." << std::endl;
+	std::cout << "  -o, --output <name>       Write statistics to <name>.matches.csv and <name>.rallies.csv" << std::endl;
+	std::cout << "                            or <name>.json (default: replaystat)" << std::endl;
+	std::cout << "  -f, --format <csv|json>   Output format (default: csv)" << std::endl;
+	std::cout << "  -j, --threads <n>         Number of replays analysed at once (default: all cores)" << std::endl;
+	std::cout << "  -v, --verify              Check that re-simulating each replay reproduces all of its" << std::endl;
+	std::cout << "                            save points bit for bit, instead of writing statistics" << std::endl;
+	std::cout << "  -h, --help                This message\n" << std::endl;
+	std::cout << "Hit speeds are the speed of the ball after the hit in pixels per game step." << std::endl;
+}
+
+void process_arguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		bool hasValue = option == "--output" || option == "-o" || option == "--format" || option == "-f" ||
+						option == "--threads" || option == "-j";
+		if (hasValue && i + 1 >= argc)
+		{
+			std::cout << "\"" << option << "\" option needs an argument" << std::endl;
+			printHelp();
+			exit(1);
+		}
+
+		if (option == "--output" || option == "-o")
+		{
+			g_output = argv[++i];
+		}
+		else if (option == "--format" || option == "-f")
+		{
+			g_format = argv[++i];
+			if (g_format != "csv" && g_format != "json")
+			{
+				std::cout << "Unknown format \"" << g_format << "\"" << std::endl;
+				printHelp();
+				exit(1);
+			}
+		}
+		else if (option == "--threads" || option == "-j")
+		{
+			g_threads = std::max(0, atoi(argv[++i]));
+		}
+		else if (option == "--verify" || option == "-v")
+		{
+			g_verify = true;
+		}
+		else if (option == "--help" || option == "-h")
+		{
+			printHelp();
+			exit(3);
+		}
+		else if (option[0] == '-')
+		{
+			std::cout << "Unknown option \"" << option << "\"" << std::endl;
+			printHelp();
+			exit(1);
+		}
+		else
+		{
+			g_arguments.push_back(option);
+		}
+	}
+
+	if (g_arguments.empty())
+	{
+		printHelp();
+		exit(1);
+	}
+}
@@ -0,0 +1,442 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2006 Jonathan Sieber (jonathan_sieber@yahoo.de)
+Copyright (C) 2006 Daniel Knobe (daniel-knobe@web.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "DuelMatch.h"
+#include "FileSystem.h"
+#include "IUserConfigReader.h"
+#include "InputSource.h"
+#include "BotBrain.h"
+#include "NativeInputSource.h"
+#include "ParallelFor.h"
+#include "ScriptedInputSource.h"
+#include "tools/ToolSetup.h"
+#include "Global.h"
+
+/* implementation */
+
+/// one match of the tournament
+struct MatchJob
+{
+	int rules;
+	int difficulty;
+	int bot[MAX_PLAYERS];
+	unsigned int seed;
+};
+
+struct MatchResult
+{
+	bool ok = false;
+	PlayerSide winner = NO_PLAYER;		// NO_PLAYER if the match reached the step limit
+	int score[MAX_PLAYERS] = {};
+	int steps = 0;
+	double botTime[MAX_PLAYERS] = {};	// seconds spent computing the input of each bot
+};
+
+/// passes the input of a bot through and measures how long the bot needs for it
+class TimedInputSource : public InputSource
+{
+	public:
+		explicit TimedInputSource(std::shared_ptr<BotInputSource> bot) : mBot(std::move(bot))
+		{
+		}
+
+		double getTime() const
+		{
+			return mTime.count();
+		}
+
+	private:
+		PlayerInputAbs getNextInput() override
+		{
+			auto start = std::chrono::steady_clock::now();
+			mBot->updateInput();
+			mTime += std::chrono::steady_clock::now() - start;
+			return mBot->getRealInput();
+		}
+
+		std::shared_ptr<BotInputSource> mBot;
+		std::chrono::duration<double> mTime{0};
+};
+
+// matches are simulated at the default game speed
+static const int GAME_SPEED = 75;
+
+static std::vector<std::string> g_bots;
+static std::vector<std::string> g_rules;
+static std::vector<int> g_difficulties{0, 12, 25};
+static int g_games = 1;
+static int g_max_steps = GAME_SPEED * 60 * 10;
+static int g_score_to_win = 0;
+static unsigned int g_seed = 1;
+static unsigned g_threads = 0;
+static std::string g_csv;
+
+static std::mutex g_output_mutex;
+
+void printHelp();
+void process_arguments(int argc, char** argv);
+std::vector<std::string> split(const std::string& list);
+MatchResult play_match(const MatchJob& job);
+void print_report(const std::vector<MatchJob>& jobs, const std::vector<MatchResult>& results);
+bool write_csv(const std::vector<MatchJob>& jobs, const std::vector<MatchResult>& results);
+
+int main(int argc, char** argv)
+{
+	process_arguments(argc, argv);
+
+	FileSystem fileSys(argv[0]);
+	setup_tool_physfs({"scripts.zip", "rules.zip"});
+
+	if (g_bots.empty())
+	{
+		g_bots = fileSys.enumerateFiles("scripts", ".lua");
+		for (const auto& name : BotBrain::getNames())
+			g_bots.push_back(name);
+	}
+	if (g_rules.empty())
+		g_rules = fileSys.enumerateFiles("rules", ".lua");
+	if (g_bots.size() < 2 || g_rules.empty())
+	{
+		std::cerr << "a tournament needs at least two bots and one rules file" << std::endl;
+		return 1;
+	}
+
+	// every pair of bots meets on both sides, for each rules file and difficulty.
+	// the seeds only depend on the position of the match in this list.
+	std::vector<MatchJob> jobs;
+	for (unsigned rules = 0; rules < g_rules.size(); ++rules)
+		for (int difficulty : g_difficulties)
+			for (unsigned first = 0; first < g_bots.size(); ++first)
+				for (unsigned second = first + 1; second < g_bots.size(); ++second)
+					for (int game = 0; game < g_games; ++game)
+					{
+						unsigned int seed = g_seed + 2 * jobs.size();
+						jobs.push_back(MatchJob{int(rules), difficulty, {int(first), int(second)}, seed});
+						jobs.push_back(MatchJob{int(rules), difficulty, {int(second), int(first)}, seed + 1});
+					}
+
+	// the config cache is not thread safe, so it has to be filled before the workers start
+	IUserConfigReader::createUserConfigReader("config.xml");
+
+	if (g_threads == 0)
+		g_threads = std::max(1u, std::thread::hardware_concurrency());
+	g_threads = std::min<unsigned>(g_threads, jobs.size());
+	std::cout << jobs.size() << " matches on " << g_threads << " threads" << std::endl;
+
+	std::vector<MatchResult> results(jobs.size());
+	parallelFor(jobs.size(), g_threads, [&](int job, int)
+	{
+		results[job] = play_match(jobs[job]);
+	});
+
+	print_report(jobs, results);
+
+	int failed = 0;
+	for (const auto& result : results)
+		failed += !result.ok;
+
+	bool written = g_csv.empty() || write_csv(jobs, results);
+	return written && !failed ? 0 : 1;
+}
+
+MatchResult play_match(const MatchJob& job)
+{
+	MatchResult result;
+	try
+	{
+		DuelMatch match(false, g_rules[job.rules] + ".lua", g_score_to_win);
+
+		std::shared_ptr<BotInputSource> bots[MAX_PLAYERS];
+		std::shared_ptr<TimedInputSource> inputs[MAX_PLAYERS];
+		for (int side = LEFT_PLAYER; side < MAX_PLAYERS; ++side)
+		{
+			const std::string& name = g_bots[job.bot[side]];
+			unsigned int seed = job.seed * MAX_PLAYERS + side;
+			if (BotBrain::isRegistered(name))
+				bots[side] = std::make_shared<NativeInputSource>(name, PlayerSide(side), job.difficulty, seed);
+			else
+				bots[side] = std::make_shared<ScriptedInputSource>("scripts/" + name, PlayerSide(side), job.difficulty, seed);
+			bots[side]->setDeterministic(GAME_SPEED);
+			inputs[side] = std::make_shared<TimedInputSource>(bots[side]);
+		}
+		match.setPlayers(PlayerIdentity{g_bots[job.bot[LEFT_PLAYER]]}, PlayerIdentity{g_bots[job.bot[RIGHT_PLAYER]]});
+		match.setInputSources(inputs[LEFT_PLAYER], inputs[RIGHT_PLAYER]);
+		// the bots are behind the timing wrappers, so the match does not know them
+		bots[LEFT_PLAYER]->setMatch(&match);
+		bots[RIGHT_PLAYER]->setMatch(&match);
+
+		while (match.winningPlayer() == NO_PLAYER && result.steps < g_max_steps)
+		{
+			match.step();
+			++result.steps;
+			// rules see the time of the match, not the wall clock
+			match.getClock().setTime(result.steps / GAME_SPEED);
+		}
+
+		result.winner = match.winningPlayer();
+		for (int side = LEFT_PLAYER; side < MAX_PLAYERS; ++side)
+		{
+			result.score[side] = match.getScore(PlayerSide(side));
+			result.botTime[side] = inputs[side]->getTime();
+		}
+		result.ok = true;
+	}
+	catch (const std::exception& e)
+	{
+		std::lock_guard<std::mutex> lock(g_output_mutex);
+		std::cerr << g_bots[job.bot[LEFT_PLAYER]] << " vs " << g_bots[job.bot[RIGHT_PLAYER]] << " on "
+				<< g_rules[job.rules] << ": " << e.what() << std::endl;
+	}
+
+	return result;
+}
+
+void print_report(const std::vector<MatchJob>& jobs, const std::vector<MatchResult>& results)
+{
+	const unsigned bots = g_bots.size();
+
+	// elo ratings, updated match by match in the fixed order of the jobs
+	const double ELO_START = 1500;
+	const double ELO_K = 16;
+	std::vector<double> elo(bots, ELO_START);
+	std::vector<int> wins(bots), draws(bots), losses(bots), steps(bots), matches(bots);
+	std::vector<double> botTime(bots);
+	std::vector<std::vector<int> > winMatrix(bots, std::vector<int>(bots));
+	long long totalSteps = 0;
+	int played = 0;
+
+	for (unsigned i = 0; i < jobs.size(); ++i)
+	{
+		const MatchJob& job = jobs[i];
+		const MatchResult& result = results[i];
+		if (!result.ok)
+			continue;
+
+		const int left = job.bot[LEFT_PLAYER];
+		const int right = job.bot[RIGHT_PLAYER];
+		double score = result.winner == LEFT_PLAYER ? 1 : result.winner == RIGHT_PLAYER ? 0 : 0.5;
+		double expected = 1 / (1 + std::pow(10, (elo[right] - elo[left]) / 400));
+		elo[left] += ELO_K * (score - expected);
+		elo[right] -= ELO_K * (score - expected);
+
+		if (result.winner == NO_PLAYER)
+		{
+			draws[left]++;
+			draws[right]++;
+		}
+		else
+		{
+			int winner = job.bot[result.winner];
+			int loser = job.bot[result.winner == LEFT_PLAYER ? RIGHT_PLAYER : LEFT_PLAYER];
+			wins[winner]++;
+			losses[loser]++;
+			winMatrix[winner][loser]++;
+		}
+
+		for (int side = LEFT_PLAYER; side < MAX_PLAYERS; ++side)
+		{
+			steps[job.bot[side]] += result.steps;
+			matches[job.bot[side]]++;
+			botTime[job.bot[side]] += result.botTime[side];
+		}
+		totalSteps += result.steps;
+		played++;
+	}
+
+	std::cout << "\n" << played << " matches, " << std::fixed << std::setprecision(0)
+			<< (played ? double(totalSteps) / played : 0) << " steps on average\n\n";
+
+	std::cout << std::left << std::setw(20) << "bot" << std::right << std::setw(8) << "elo" << std::setw(8) << "wins"
+			<< std::setw(8) << "draws" << std::setw(8) << "losses" << std::setw(12) << "avg steps" << std::setw(12) << "us/step" << "\n";
+	for (unsigned bot = 0; bot < bots; ++bot)
+	{
+		std::cout << std::left << std::setw(20) << g_bots[bot] << std::right << std::setw(8) << elo[bot]
+				<< std::setw(8) << wins[bot] << std::setw(8) << draws[bot] << std::setw(8) << losses[bot]
+				<< std::setw(12) << (matches[bot] ? double(steps[bot]) / matches[bot] : 0)
+				<< std::setw(12) << std::setprecision(2) << (steps[bot] ? botTime[bot] * 1e6 / steps[bot] : 0)
+				<< std::setprecision(0) << "\n";
+	}
+
+	// wins of the bot in the row against the bot in the column
+	std::cout << "\nwins against\n" << std::setw(20) << "";
+	for (unsigned bot = 0; bot < bots; ++bot)
+		std::cout << std::setw(6) << bot + 1;
+	std::cout << "\n";
+	for (unsigned bot = 0; bot < bots; ++bot)
+	{
+		std::ostringstream name;
+		name << bot + 1 << " " << g_bots[bot];
+		std::cout << std::left << std::setw(20) << name.str() << std::right;
+		for (unsigned other = 0; other < bots; ++other)
+		{
+			if (other == bot)
+				std::cout << std::setw(6) << "-";
+			else
+				std::cout << std::setw(6) << winMatrix[bot][other];
+		}
+		std::cout << "\n";
+	}
+	std::cout << std::flush;
+}
+
+bool write_csv(const std::vector<MatchJob>& jobs, const std::vector<MatchResult>& results)
+{
+	std::ofstream out(g_csv);
+	if (!out)
+	{
+		std::cerr << "could not write " << g_csv << std::endl;
+		return false;
+	}
+
+	out << "rules,difficulty,seed,left,right,score_left,score_right,winner,steps,time_left,time_right\n";
+	for (unsigned i = 0; i < jobs.size(); ++i)
+	{
+		const MatchJob& job = jobs[i];
+		const MatchResult& result = results[i];
+		if (!result.ok)
+			continue;
+
+		out << g_rules[job.rules] << ',' << job.difficulty << ',' << job.seed << ','
+			<< g_bots[job.bot[LEFT_PLAYER]] << ',' << g_bots[job.bot[RIGHT_PLAYER]] << ','
+			<< result.score[LEFT_PLAYER] << ',' << result.score[RIGHT_PLAYER] << ','
+			<< (result.winner == LEFT_PLAYER ? "left" : result.winner == RIGHT_PLAYER ? "right" : "") << ','
+			<< result.steps << ',' << result.botTime[LEFT_PLAYER] << ',' << result.botTime[RIGHT_PLAYER] << '\n';
+	}
+
+	return true;
+}
+
+std::vector<std::string> split(const std::string& list)
+{
+	std::vector<std::string> parts;
+	std::istringstream stream(list);
+	std::string part;
+	while (std::getline(stream, part, ','))
+	{
+		if (!part.empty())
+			parts.push_back(part);
+	}
+	return parts;
+}
+
+void printHelp()
+{
+	std::cout << "Usage: blobby-tournament [OPTION...]" << std::endl;
+	std::cout << "  -b, --bots <a,b,...>      Scripts from scripts/ or native bots that take part (default: all)" << std::endl;
+	std::cout << "  -r, --rules <a,b,...>     Rules from rules/ that are played (default: all)" << std::endl;
+	std::cout << "  -d, --difficulties <...>  Bot difficulties from 0 to 25 (default: 0,12,25)" << std::endl;
+	std::cout << "  -g, --games <n>           Matches per pairing, side, rules and difficulty (default: 1)" << std::endl;
+	std::cout << "  -m, --max-steps <n>       Matches still running after n steps are draws (default: 45000)" << std::endl;
+	std::cout << "  -w, --score-to-win <n>    Points needed to win (default: from the configuration)" << std::endl;
+	std::cout << "  -s, --seed <n>            First random seed of the bots (default: 1)" << std::endl;
+	std::cout << "  -c, --csv <file>          Also write the result of every match to this file" << std::endl;
+	std::cout << "  -j, --threads <n>         Number of matches played at once (default: all cores)" << std::endl;
+	std::cout << "  -h, --help                This message\n" << std::endl;
+	std::cout << "us/step is the time a bot needs to decide on its input in one game step, in microseconds." << std::endl;
+}
+
+void process_arguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		bool hasValue = option == "--bots" || option == "-b" || option == "--rules" || option == "-r" ||
+						option == "--difficulties" || option == "-d" || option == "--games" || option == "-g" ||
+						option == "--max-steps" || option == "-m" || option == "--score-to-win" || option == "-w" ||
+						option == "--seed" || option == "-s" || option == "--csv" || option == "-c" ||
+						option == "--threads" || option == "-j";
+		if (hasValue && i + 1 >= argc)
+		{
+			std::cout << "\"" << option << "\" option needs an argument" << std::endl;
+			printHelp();
+			exit(1);
+		}
+
+		if (option == "--bots" || option == "-b")
+		{
+			g_bots = split(argv[++i]);
+		}
+		else if (option == "--rules" || option == "-r")
+		{
+			g_rules = split(argv[++i]);
+		}
+		else if (option == "--difficulties" || option == "-d")
+		{
+			g_difficulties.clear();
+			for (const auto& difficulty : split(argv[++i]))
+				g_difficulties.push_back(std::min(25, std::max(0, atoi(difficulty.c_str()))));
+		}
+		else if (option == "--games" || option == "-g")
+		{
+			g_games = std::max(1, atoi(argv[++i]));
+		}
+		else if (option == "--max-steps" || option == "-m")
+		{
+			g_max_steps = std::max(1, atoi(argv[++i]));
+		}
+		else if (option == "--score-to-win" || option == "-w")
+		{
+			g_score_to_win = std::max(0, atoi(argv[++i]));
+		}
+		else if (option == "--seed" || option == "-s")
+		{
+			g_seed = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (option == "--csv" || option == "-c")
+		{
+			g_csv = argv[++i];
+		}
+		else if (option == "--threads" || option == "-j")
+		{
+			g_threads = std::max(0, atoi(argv[++i]));
+		}
+		else if (option == "--help" || option == "-h")
+		{
+			printHelp();
+			exit(3);
+		}
+		else
+		{
+			std::cout << "Unknown option \"" << option << "\"" << std::endl;
+			printHelp();
+			exit(1);
+		}
+	}
+
+	if (g_difficulties.empty())
+	{
+		printHelp();
+		exit(1);
+	}
+}
@@ -0,0 +1,119 @@
+#include <boost/test/unit_test.hpp>
+
+#include <deque>
+#include <vector>
+
+#include "PlayerInput.h"
+#include "raknet/BitStream.h"
+
+namespace
+{
+	std::deque<TimedInput> makeHistory(unsigned newestFrame, const std::vector<PlayerInputAbs>& inputs)
+	{
+		std::deque<TimedInput> history;
+		unsigned frame = newestFrame + 1 - inputs.size();
+		for (const auto& input : inputs)
+			history.push_back( TimedInput{frame++, input} );
+		return history;
+	}
+
+	void checkRoundTrip(const std::deque<TimedInput>& history)
+	{
+		RakNet::BitStream stream;
+		writeInputHistory(stream, history);
+
+		std::vector<TimedInput> read;
+		BOOST_REQUIRE( readInputHistory(stream, read) );
+		BOOST_REQUIRE_EQUAL( read.size(), history.size() );
+		for (std::size_t i = 0; i < read.size(); ++i)
+		{
+			BOOST_CHECK_EQUAL( read[i].frame, history[i].frame );
+			BOOST_CHECK( read[i].input == history[i].input );
+		}
+	}
+
+	// writes a history with the given run lengths directly, without the checks of writeInputHistory
+	bool readRuns(unsigned newestFrame, const std::vector<unsigned char>& runs)
+	{
+		RakNet::BitStream stream;
+		stream.Write( newestFrame );
+		stream.Write( (unsigned char)runs.size() );
+		for(unsigned char length : runs)
+		{
+			stream.Write( length );
+			PlayerInputAbs(true, false, length % 2 == 0).writeTo( stream );
+		}
+
+		std::vector<TimedInput> read;
+		return readInputHistory(stream, read);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( InputHistoryTest )
+
+BOOST_AUTO_TEST_CASE( single_frame )
+{
+	checkRoundTrip( makeHistory(1, {PlayerInputAbs(true, false, true)}) );
+}
+
+BOOST_AUTO_TEST_CASE( runs_of_equal_input )
+{
+	const PlayerInputAbs idle;
+	const PlayerInputAbs left(true, false, false);
+	const PlayerInputAbs jump(false, true, true);
+	std::vector<PlayerInputAbs> inputs = {idle, idle, idle, left, left, jump, jump, jump, jump, idle};
+	checkRoundTrip( makeHistory(1000, inputs) );
+
+	// equal inputs are sent as one run, so this is much shorter than one input per frame
+	RakNet::BitStream stream;
+	writeInputHistory(stream, makeHistory(1000, inputs));
+	RakNet::BitStream single;
+	idle.writeTo(single);
+	BOOST_CHECK_EQUAL( stream.GetNumberOfBytesUsed(), int(sizeof(unsigned) + 1 + 4 * (1 + single.GetNumberOfBytesUsed())) );
+}
+
+BOOST_AUTO_TEST_CASE( full_history_without_runs )
+{
+	// every frame differs from the previous one, the worst case for the encoding
+	std::vector<PlayerInputAbs> inputs;
+	for (unsigned i = 0; i < INPUT_HISTORY_LENGTH; ++i)
+		inputs.push_back( PlayerInputAbs(i % 2 == 0, i % 2 == 1, i % 3 == 0) );
+	checkRoundTrip( makeHistory(123456, inputs) );
+}
+
+BOOST_AUTO_TEST_CASE( full_history_of_one_input )
+{
+	std::vector<PlayerInputAbs> inputs(INPUT_HISTORY_LENGTH, PlayerInputAbs(false, true, false));
+	checkRoundTrip( makeHistory(INPUT_HISTORY_LENGTH, inputs) );
+}
+
+BOOST_AUTO_TEST_CASE( rejects_invalid_runs )
+{
+	BOOST_CHECK( readRuns(100, {10, 6}) );
+	BOOST_CHECK( readRuns(15, {16}) );
+
+	// more frames than the history of a client
+	BOOST_CHECK( !readRuns(100, {10, 7}) );
+	BOOST_CHECK( !readRuns(100000, std::vector<unsigned char>(255, 255)) );
+	// empty runs
+	BOOST_CHECK( !readRuns(100, {3, 0, 3}) );
+	// runs going back before frame 0
+	BOOST_CHECK( !readRuns(5, {7}) );
+	BOOST_CHECK( !readRuns(5, {3, 3, 1}) );
+}
+
+BOOST_AUTO_TEST_CASE( truncated_stream )
+{
+	std::vector<PlayerInputAbs> inputs = {PlayerInputAbs(), PlayerInputAbs(true, false, false), PlayerInputAbs(false, false, true)};
+	RakNet::BitStream complete;
+	writeInputHistory(complete, makeHistory(50, inputs));
+
+	for (int bytes = 0; bytes < complete.GetNumberOfBytesUsed(); ++bytes)
+	{
+		RakNet::BitStream stream(complete.GetData(), bytes, false);
+		std::vector<TimedInput> read;
+		BOOST_CHECK_MESSAGE( !readInputHistory(stream, read), "stream truncated to " << bytes << " bytes is accepted" );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,315 @@
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "FileRead.h"
+#include "FileWrite.h"
+#include "FileSystem.h"
+#include "DuelMatchState.h"
+#include "InputSource.h"
+#include "replays/IReplayLoader.h"
+#include "replays/ReplayDefs.h"
+#include "replays/ReplayFormat.h"
+#include "replays/ReplayRecorder.h"
+#include "replays/ReplaySavePoint.h"
+
+// defined in GenericIOTest.cpp
+void init_Physfs();
+
+namespace
+{
+	const int TEST_REPLAY_LENGTH = 3000;
+	const std::string TEST_RULES = "function IsWinning(lscore, rscore) return lscore > 15 end";
+
+	// long runs for the left player, short ones for the right player
+	PlayerInput testInput(PlayerSide side, int step)
+	{
+		int run = side == LEFT_PLAYER ? step / 300 : step / 7;
+		return PlayerInput(run % 2 == 1, run % 3 == 1, run % 5 == 2);
+	}
+
+	DuelMatchState testState(int step)
+	{
+		DuelMatchState state = DuelMatchState();
+		state.worldState.ballPosition = Vector2(step, 2 * step);
+		state.worldState.blobPosition[LEFT_PLAYER] = Vector2(100, step % 400);
+		state.worldState.ballRotation = step / 100.f;
+		state.logicState.leftScore = step / 1000;
+		state.logicState.rightScore = step / 1300;
+		state.logicState.servingPlayer = LEFT_PLAYER;
+		state.playerInput[LEFT_PLAYER] = testInput(LEFT_PLAYER, step);
+		state.playerInput[RIGHT_PLAYER] = testInput(RIGHT_PLAYER, step);
+		return state;
+	}
+
+	void writeTestReplay(const std::string& filename)
+	{
+		init_Physfs();
+		FileSystem::getSingleton().probeDir("rules");
+		FileWrite rules("rules/replay_test.lua");
+		rules.write(TEST_RULES);
+		rules.close();
+
+		ReplayRecorder recorder;
+		recorder.setPlayerNames("left blob", "right blob");
+		recorder.setPlayerColors(Color(255, 0, 0), Color(0, 0, 255));
+		recorder.setGameSpeed(75);
+		recorder.setGameRules("replay_test.lua");
+		for (int step = 0; step < TEST_REPLAY_LENGTH; ++step)
+			recorder.record(testState(step));
+		recorder.finalize(3, 2);
+		recorder.save(std::make_shared<FileWrite>(filename));
+	}
+
+	std::vector<char> readBytes(const std::string& filename)
+	{
+		FileRead file(filename);
+		std::vector<char> data(file.length());
+		file.readRawBytes(data.data(), data.size());
+		return data;
+	}
+
+	void writeBytes(const std::string& filename, const std::vector<char>& data)
+	{
+		FileWrite file(filename);
+		file.write(data.data(), data.size());
+		file.close();
+	}
+
+	ReplaySection makeSection(std::uint32_t offset, std::uint32_t size)
+	{
+		ReplaySection section;
+		section.offset = offset;
+		section.size = size;
+		return section;
+	}
+
+	ReplayHeaderV3 testHeader()
+	{
+		ReplayHeaderV3 header;
+		header.major = 3;
+		header.minor = 1;
+		header.flags = ReplayHeaderV3::EMBEDDED_RULES;
+		header.gameSpeed = 75;
+		header.gameLength = 1234;
+		header.gameDuration = 16;
+		header.gameDate = 0x123456789LL;
+		header.score[LEFT_PLAYER] = 15;
+		header.score[RIGHT_PLAYER] = 7;
+		header.color[LEFT_PLAYER] = 0xff0000;
+		header.color[RIGHT_PLAYER] = 0x00ff00;
+		header.names[LEFT_PLAYER] = makeSection(100, 4);
+		header.names[RIGHT_PLAYER] = makeSection(104, 5);
+		header.rules = makeSection(109, 11);
+		header.input = makeSection(120, 20);
+		header.inputIndex = makeSection(140, 16);
+		header.savePointTable = makeSection(156, 24);
+		header.savePoints = makeSection(180, 20);
+		return header;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( ReplayFormatTest )
+
+BOOST_AUTO_TEST_CASE( header_round_trip )
+{
+	std::vector<std::uint8_t> data;
+	testHeader().write(data);
+	BOOST_REQUIRE_EQUAL( data.size(), std::size_t(ReplayHeaderV3::SIZE) );
+	data.resize(200);
+
+	ReplayHeaderV3 header;
+	BOOST_REQUIRE( header.read(data.data(), data.size()) );
+	const ReplayHeaderV3 expected = testHeader();
+	BOOST_CHECK_EQUAL( header.major, expected.major );
+	BOOST_CHECK_EQUAL( header.minor, expected.minor );
+	BOOST_CHECK_EQUAL( header.flags, expected.flags );
+	BOOST_CHECK_EQUAL( header.gameSpeed, expected.gameSpeed );
+	BOOST_CHECK_EQUAL( header.gameLength, expected.gameLength );
+	BOOST_CHECK_EQUAL( header.gameDuration, expected.gameDuration );
+	BOOST_CHECK_EQUAL( header.gameDate, expected.gameDate );
+	for (int player = LEFT_PLAYER; player < MAX_PLAYERS; ++player)
+	{
+		BOOST_CHECK_EQUAL( header.score[player], expected.score[player] );
+		BOOST_CHECK_EQUAL( header.color[player], expected.color[player] );
+		BOOST_CHECK_EQUAL( header.names[player].offset, expected.names[player].offset );
+		BOOST_CHECK_EQUAL( header.names[player].size, expected.names[player].size );
+	}
+	BOOST_CHECK_EQUAL( header.rules.offset, expected.rules.offset );
+	BOOST_CHECK_EQUAL( header.input.size, expected.input.size );
+	BOOST_CHECK_EQUAL( header.inputIndex.offset, expected.inputIndex.offset );
+	BOOST_CHECK_EQUAL( header.savePointTable.size, expected.savePointTable.size );
+	BOOST_CHECK_EQUAL( header.savePoints.offset, expected.savePoints.offset );
+}
+
+BOOST_AUTO_TEST_CASE( header_rejects_invalid_files )
+{
+	std::vector<std::uint8_t> data;
+	testHeader().write(data);
+	data.resize(200);
+	ReplayHeaderV3 header;
+
+	// too short for the header, and too short for the sections
+	BOOST_CHECK( !header.read(data.data(), ReplayHeaderV3::SIZE - 1) );
+	BOOST_CHECK( !header.read(data.data(), 199) );
+
+	std::vector<std::uint8_t> wrongMagic = data;
+	wrongMagic[2] = '2';
+	BOOST_CHECK( !header.read(wrongMagic.data(), wrongMagic.size()) );
+
+	// a section starting behind the file, and one whose end overflows 32 bits
+	ReplayHeaderV3 outside = testHeader();
+	outside.rules.offset = 201;
+	outside.rules.size = 0;
+	std::vector<std::uint8_t> outsideData;
+	outside.write(outsideData);
+	outsideData.resize(200);
+	BOOST_CHECK( !header.read(outsideData.data(), outsideData.size()) );
+
+	ReplayHeaderV3 overflow = testHeader();
+	overflow.savePoints.size = 0xffffffff;
+	std::vector<std::uint8_t> overflowData;
+	overflow.write(overflowData);
+	overflowData.resize(200);
+	BOOST_CHECK( !header.read(overflowData.data(), overflowData.size()) );
+
+	// tables have to hold whole entries
+	ReplayHeaderV3 partial = testHeader();
+	partial.savePointTable.size = 23;
+	std::vector<std::uint8_t> partialData;
+	partial.write(partialData);
+	partialData.resize(200);
+	BOOST_CHECK( !header.read(partialData.data(), partialData.size()) );
+}
+
+BOOST_AUTO_TEST_CASE( recorder_loader_round_trip )
+{
+	writeTestReplay("replay_test.bvr");
+
+	std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader("replay_test.bvr"));
+	BOOST_REQUIRE( loader );
+	BOOST_CHECK_EQUAL( loader->getVersionMajor(), 3 );
+	BOOST_CHECK_EQUAL( loader->getPlayerName(LEFT_PLAYER), "left blob" );
+	BOOST_CHECK_EQUAL( loader->getPlayerName(RIGHT_PLAYER), "right blob" );
+	BOOST_CHECK( loader->getBlobColor(LEFT_PLAYER) == Color(255, 0, 0) );
+	BOOST_CHECK( loader->getBlobColor(RIGHT_PLAYER) == Color(0, 0, 255) );
+	BOOST_CHECK_EQUAL( loader->getFinalScore(LEFT_PLAYER), 3 );
+	BOOST_CHECK_EQUAL( loader->getFinalScore(RIGHT_PLAYER), 2 );
+	BOOST_CHECK_EQUAL( loader->getSpeed(), 75 );
+	BOOST_CHECK_EQUAL( loader->getRules(), TEST_RULES );
+
+	// finalize appends one second without input
+	BOOST_REQUIRE_EQUAL( loader->getLength(), TEST_REPLAY_LENGTH + 75 );
+
+	InputSource left, right;
+	for (int step = 0; step < loader->getLength(); ++step)
+	{
+		loader->getInputAt(step, &left, &right);
+		PlayerInput expectedLeft = step < TEST_REPLAY_LENGTH ? testInput(LEFT_PLAYER, step) : PlayerInput();
+		PlayerInput expectedRight = step < TEST_REPLAY_LENGTH ? testInput(RIGHT_PLAYER, step) : PlayerInput();
+		if (!(left.getInput() == expectedLeft) || !(right.getInput() == expectedRight))
+		{
+			BOOST_ERROR( "wrong input at step " << step );
+			break;
+		}
+	}
+
+	// a save point every REPLAY_SAVEPOINT_PERIOD steps and one at every change of the score
+	int savePoints = 0;
+	for (int step = 0; step < loader->getLength(); ++step)
+	{
+		int index;
+		bool expected = step < TEST_REPLAY_LENGTH && (step % REPLAY_SAVEPOINT_PERIOD == 0 ||
+				(step > 0 && testState(step).logicState.leftScore != testState(step - 1).logicState.leftScore) ||
+				(step > 0 && testState(step).logicState.rightScore != testState(step - 1).logicState.rightScore));
+		BOOST_CHECK_EQUAL( loader->isSavePoint(step, index), expected );
+		if (!expected)
+			continue;
+
+		BOOST_CHECK_EQUAL( index, savePoints );
+		++savePoints;
+
+		ReplaySavePoint savePoint;
+		loader->readSavePoint(index, savePoint);
+		const DuelMatchState state = testState(step);
+		BOOST_CHECK_EQUAL( savePoint.step, unsigned(step) );
+		BOOST_CHECK( savePoint.state.worldState.ballPosition == state.worldState.ballPosition );
+		BOOST_CHECK( savePoint.state.worldState.blobPosition[LEFT_PLAYER] == state.worldState.blobPosition[LEFT_PLAYER] );
+		BOOST_CHECK_EQUAL( savePoint.state.worldState.ballRotation, state.worldState.ballRotation );
+		BOOST_CHECK_EQUAL( savePoint.state.logicState.leftScore, state.logicState.leftScore );
+		BOOST_CHECK_EQUAL( savePoint.state.logicState.rightScore, state.logicState.rightScore );
+	}
+
+	// seeking finds the last save point before the target
+	int savePosition;
+	BOOST_CHECK_EQUAL( loader->getSavePoint(REPLAY_SAVEPOINT_PERIOD + 10, savePosition), 1 );
+	BOOST_CHECK_EQUAL( savePosition, REPLAY_SAVEPOINT_PERIOD );
+}
+
+BOOST_AUTO_TEST_CASE( loader_rejects_truncated_replay )
+{
+	writeTestReplay("replay_test.bvr");
+	std::vector<char> data = readBytes("replay_test.bvr");
+
+	for (std::size_t size : {std::size_t(0), std::size_t(3), ReplayHeaderV3::SIZE - 1, ReplayHeaderV3::SIZE + 10, data.size() - 1})
+	{
+		writeBytes("replay_truncated.bvr", std::vector<char>(data.begin(), data.begin() + size));
+		BOOST_CHECK_THROW( IReplayLoader::createReplayLoader("replay_truncated.bvr"), std::exception );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( loader_rejects_save_point_outside_of_section )
+{
+	writeTestReplay("replay_test.bvr");
+	std::vector<char> data = readBytes("replay_test.bvr");
+
+	ReplayHeaderV3 header;
+	BOOST_REQUIRE( header.read(reinterpret_cast<const std::uint8_t*>(data.data()), data.size()) );
+	BOOST_REQUIRE( header.savePointTable.size >= 2 * REPLAY_SAVE_POINT_ENTRY_SIZE );
+
+	// the offset of the first save point points behind the section,
+	// the size of the second one reaches beyond it
+	std::vector<std::uint8_t> value;
+	writeReplayUInt32(value, header.savePoints.size + 1);
+	std::copy(value.begin(), value.end(), data.begin() + header.savePointTable.offset + 4);
+	value.clear();
+	writeReplayUInt32(value, header.savePoints.size);
+	std::copy(value.begin(), value.end(), data.begin() + header.savePointTable.offset + REPLAY_SAVE_POINT_ENTRY_SIZE + 8);
+	writeBytes("replay_corrupt.bvr", data);
+
+	std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader("replay_corrupt.bvr"));
+	ReplaySavePoint savePoint;
+	BOOST_CHECK_THROW( loader->readSavePoint(0, savePoint), std::runtime_error );
+	BOOST_CHECK_THROW( loader->readSavePoint(1, savePoint), std::runtime_error );
+	BOOST_CHECK_NO_THROW( loader->readSavePoint(2, savePoint) );
+}
+
+BOOST_AUTO_TEST_CASE( loader_rejects_corrupt_run_length )
+{
+	writeTestReplay("replay_test.bvr");
+	const std::vector<char> data = readBytes("replay_test.bvr");
+
+	ReplayHeaderV3 header;
+	BOOST_REQUIRE( header.read(reinterpret_cast<const std::uint8_t*>(data.data()), data.size()) );
+	BOOST_REQUIRE( header.input.size >= 6 );
+
+	// the length of the first run is longer than 5 bytes, or longer than the game
+	const std::vector<std::vector<char>> lengths = {
+		{char(0xff), char(0xff), char(0xff), char(0xff), char(0xff)},
+		{char(0xff), char(0xff), char(0xff), char(0x7f)} };
+	for (const auto& length : lengths)
+	{
+		std::vector<char> corrupt = data;
+		std::copy(length.begin(), length.end(), corrupt.begin() + header.input.offset + 1);
+		writeBytes("replay_corrupt.bvr", corrupt);
+
+		std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader("replay_corrupt.bvr"));
+		InputSource left, right;
+		BOOST_CHECK_THROW( loader->getInputAt(0, &left, &right), std::runtime_error );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()